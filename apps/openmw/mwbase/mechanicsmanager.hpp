@@ -12,6 +12,7 @@
 namespace osg
 {
     class Vec3f;
+    class Stats;
 }
 
 namespace ESM
@@ -34,6 +35,12 @@ namespace Loading
     class Listener;
 }
 
+namespace MWMechanics
+{
+    class PathRequestQueue;
+    class ExteriorPathgridGraph;
+}
+
 namespace MWBase
 {
     /// \brief Interface for game mechanics manager (implemented in MWMechanics)
@@ -257,6 +264,14 @@ namespace MWBase
             virtual bool isAttackPrepairing(const MWWorld::Ptr& ptr) = 0;
             virtual bool isRunning(const MWWorld::Ptr& ptr) = 0;
             virtual bool isSneaking(const MWWorld::Ptr& ptr) = 0;
+
+            /// @return Queue for searching paths on worker threads, or NULL if paths are to be built right away
+            virtual MWMechanics::PathRequestQueue* getPathRequestQueue() = 0;
+
+            /// @return Graph for routes through several exterior cells. Only use from the main thread.
+            virtual MWMechanics::ExteriorPathgridGraph& getExteriorPathgridGraph() = 0;
+
+            virtual void reportStats(unsigned int frameNumber, osg::Stats* stats) const = 0;
     };
 }
 
@@ -4,6 +4,7 @@
 #include <memory>
 #include <string>
 #include <set>
+#include <vector>
 
 #include "../mwworld/ptr.hpp"
 
@@ -137,6 +138,9 @@ namespace MWBase
                                        PlayMode mode=PlayMode::Normal, float offset=0) = 0;
             ///< Play a 3D sound at \a initialPos. If the sound should be moving, it must be updated using Sound::setPosition.
 
+            virtual void preloadSounds(const std::vector<std::string>& soundIds) = 0;
+            ///< Decode the given sounds in the background, so they can be played without a delay.
+
             virtual void stopSound(Sound *sound) = 0;
             ///< Stop the given sound from playing
 
@@ -175,6 +179,9 @@ namespace MWBase
             virtual void updatePtr(const MWWorld::ConstPtr& old, const MWWorld::ConstPtr& updated) = 0;
 
             virtual void clear() = 0;
+
+            virtual unsigned int getStreamUnderruns() const = 0;
+            ///< Number of times music or a voice ran out of decoded data while playing.
     };
 }
 
@@ -103,14 +103,17 @@ namespace MWBase
             virtual int countSavedGameRecords() const = 0;
             virtual int countSavedGameCells() const = 0;
 
-            virtual void write (ESM::ESMWriter& writer, Loading::Listener& listener) const = 0;
+            virtual void write (ESM::ESMWriter& writer, Loading::Listener& listener) = 0;
 
             virtual void readRecord (ESM::ESMReader& reader, uint32_t type,
                 const std::map<int, int>& contentFileMap) = 0;
 
-            virtual MWWorld::CellStore *getExterior (int x, int y) = 0;
+            virtual MWWorld::CellStore *getExterior (int x, int y, bool load = true) = 0;
+            ///< @param load Load the references of the cell. Otherwise the cell may be in any state, e.g. for
+            /// leaving the loading to the cell preloader.
 
-            virtual MWWorld::CellStore *getInterior (const std::string& name) = 0;
+            virtual MWWorld::CellStore *getInterior (const std::string& name, bool load = true) = 0;
+            ///< @param load see getExterior()
 
             virtual MWWorld::CellStore *getCell (const ESM::CellId& id) = 0;
 
@@ -209,6 +209,45 @@ namespace MWClass
         }
     }
 
+    void Creature::getSoundsToPreload(const MWWorld::Ptr &ptr, std::vector<std::string> &sounds) const
+    {
+        const std::vector<const ESM::SoundGenerator*>* soundGens = getSoundGenerators(ptr);
+        if (!soundGens)
+            return;
+
+        for (std::vector<const ESM::SoundGenerator*>::const_iterator it = soundGens->begin(); it != soundGens->end(); ++it)
+            sounds.push_back((*it)->mSound);
+    }
+
+    const Creature::SoundGeneratorMap& Creature::getSoundGenerators()
+    {
+        static SoundGeneratorMap soundGens;
+        static bool inited = false;
+        if (!inited)
+        {
+            const MWWorld::Store<ESM::SoundGenerator> &store = MWBase::Environment::get().getWorld()->getStore().get<ESM::SoundGenerator>();
+            for (MWWorld::Store<ESM::SoundGenerator>::iterator sound = store.begin(); sound != store.end(); ++sound)
+            {
+                if (!sound->mCreature.empty())
+                    soundGens[Misc::StringUtils::lowerCase(sound->mCreature)].push_back(&*sound);
+            }
+            inited = true;
+        }
+        return soundGens;
+    }
+
+    const std::vector<const ESM::SoundGenerator*>* Creature::getSoundGenerators(const MWWorld::Ptr &ptr)
+    {
+        const MWWorld::LiveCellRef<ESM::Creature>* ref = ptr.get<ESM::Creature>();
+        const std::string& ourId = (ref->mBase->mOriginal.empty()) ? ptr.getCellRef().getRefId() : ref->mBase->mOriginal;
+
+        const SoundGeneratorMap& soundGens = getSoundGenerators();
+        SoundGeneratorMap::const_iterator found = soundGens.find(Misc::StringUtils::lowerCase(ourId));
+        if (found == soundGens.end())
+            return NULL;
+        return &found->second;
+    }
+
     std::string Creature::getName (const MWWorld::ConstPtr& ptr) const
     {
         const MWWorld::LiveCellRef<ESM::Creature> *ref = ptr.get<ESM::Creature>();
@@ -630,23 +669,18 @@ namespace MWClass
 
     std::string Creature::getSoundIdFromSndGen(const MWWorld::Ptr &ptr, const std::string &name) const
     {
-        const MWWorld::Store<ESM::SoundGenerator> &store = MWBase::Environment::get().getWorld()->getStore().get<ESM::SoundGenerator>();
-
         int type = getSndGenTypeFromName(ptr, name);
         if(type >= 0)
         {
             std::vector<const ESM::SoundGenerator*> sounds;
 
-            MWWorld::LiveCellRef<ESM::Creature>* ref = ptr.get<ESM::Creature>();
-
-            const std::string& ourId = (ref->mBase->mOriginal.empty()) ? ptr.getCellRef().getRefId() : ref->mBase->mOriginal;
-
-            MWWorld::Store<ESM::SoundGenerator>::iterator sound = store.begin();
-            while(sound != store.end())
+            if (const std::vector<const ESM::SoundGenerator*>* soundGens = getSoundGenerators(ptr))
             {
-                if (type == sound->mType && !sound->mCreature.empty() && (Misc::StringUtils::ciEqual(ourId, sound->mCreature)))
-                    sounds.push_back(&*sound);
-                ++sound;
+                for (std::vector<const ESM::SoundGenerator*>::const_iterator sound = soundGens->begin(); sound != soundGens->end(); ++sound)
+                {
+                    if (type == (*sound)->mType)
+                        sounds.push_back(*sound);
+                }
             }
             if(!sounds.empty())
                 return sounds[Misc::Rng::rollDice(sounds.size())]->mSound;
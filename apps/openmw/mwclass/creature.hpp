@@ -1,11 +1,15 @@
 #ifndef GAME_MWCLASS_CREATURE_H
 #define GAME_MWCLASS_CREATURE_H
 
+#include <map>
+#include <vector>
+
 #include "actor.hpp"
 
 namespace ESM
 {
     struct GameSetting;
+    struct SoundGenerator;
 }
 
 namespace MWClass
@@ -38,6 +42,13 @@ namespace MWClass
 
             static const GMST& getGmst();
 
+            typedef std::map<std::string, std::vector<const ESM::SoundGenerator*> > SoundGeneratorMap;
+
+            /// Sound generators by lower case creature ID, built once from the store.
+            static const SoundGeneratorMap& getSoundGenerators();
+
+            static const std::vector<const ESM::SoundGenerator*>* getSoundGenerators(const MWWorld::Ptr& ptr);
+
         public:
 
              virtual void insertObjectRendering (const MWWorld::Ptr& ptr, const std::string& model, MWRender::RenderingInterface& renderingInterface) const;
@@ -104,6 +115,9 @@ namespace MWClass
             virtual void getModelsToPreload(const MWWorld::Ptr& ptr, std::vector<std::string>& models) const;
             ///< Get a list of models to preload that this object may use (directly or indirectly). default implementation: list getModel().
 
+            virtual void getSoundsToPreload(const MWWorld::Ptr& ptr, std::vector<std::string>& sounds) const;
+            ///< Get the sound generator sounds of this creature.
+
             virtual bool isBipedal (const MWWorld::ConstPtr &ptr) const;
             virtual bool canFly (const MWWorld::ConstPtr &ptr) const;
             virtual bool canSwim (const MWWorld::ConstPtr &ptr) const;
@@ -97,6 +97,16 @@ namespace MWClass
         return "";
     }
 
+    void Door::getSoundsToPreload(const MWWorld::Ptr &ptr, std::vector<std::string> &sounds) const
+    {
+        const MWWorld::LiveCellRef<ESM::Door> *ref = ptr.get<ESM::Door>();
+
+        if (!ref->mBase->mOpenSound.empty())
+            sounds.push_back(ref->mBase->mOpenSound);
+        if (!ref->mBase->mCloseSound.empty())
+            sounds.push_back(ref->mBase->mCloseSound);
+    }
+
     std::string Door::getName (const MWWorld::ConstPtr& ptr) const
     {
         const MWWorld::LiveCellRef<ESM::Door> *ref = ptr.get<ESM::Door>();
@@ -67,6 +67,8 @@ namespace MWClass
 
             virtual std::string getModel(const MWWorld::ConstPtr &ptr) const;
 
+            virtual void getSoundsToPreload(const MWWorld::Ptr& ptr, std::vector<std::string>& sounds) const;
+
             virtual float getWeight (const MWWorld::ConstPtr& ptr) const;
 
             virtual bool canSell (const MWWorld::ConstPtr& item, int npcServices) const;
@@ -48,7 +48,8 @@
 namespace MWDialogue
 {
     DialogueManager::DialogueManager (const Compiler::Extensions& extensions, Translation::Storage& translationDataStorage) :
-      mTranslationDataStorage(translationDataStorage)
+      mTopicSearchBuilt(false)
+      , mTranslationDataStorage(translationDataStorage)
       , mCompilerContext (MWScript::CompilerContext::Type_Dialogue)
       , mErrorStream(std::cout.rdbuf())
       , mErrorHandler(mErrorStream)
@@ -78,7 +79,14 @@ namespace MWDialogue
     void DialogueManager::parseText (const std::string& text)
     {
         updateActorKnownTopics();
-        std::vector<HyperTextParser::Token> hypertext = HyperTextParser::parseHyperText(text);
+
+        if (!mTopicSearchBuilt)
+        {
+            HyperTextParser::buildTopicSearch(mTopicSearch);
+            mTopicSearchBuilt = true;
+        }
+
+        std::vector<HyperTextParser::Token> hypertext = HyperTextParser::parseHyperText(text, mTopicSearch);
 
         for (std::vector<HyperTextParser::Token>::iterator tok = hypertext.begin(); tok != hypertext.end(); ++tok)
         {
@@ -14,6 +14,9 @@
 
 #include "../mwscript/compilercontext.hpp"
 
+#include "hypertextparser.hpp"
+#include "keywordsearch.hpp"
+
 namespace ESM
 {
     struct Dialogue;
@@ -31,6 +34,11 @@ namespace MWDialogue
 
             std::set<std::string, Misc::StringUtils::CiComp> mActorKnownTopics;
 
+            // All dialogue topics, to find them in the text of responses.
+            // The topics don't change once the content files are loaded, so this is only built once.
+            HyperTextParser::TopicSearch mTopicSearch;
+            bool mTopicSearchBuilt;
+
             Translation::Storage& mTranslationDataStorage;
             MWScript::CompilerContext mCompilerContext;
             std::ostream mErrorStream;
@@ -150,6 +150,19 @@ bool MWDialogue::Filter::testPlayer (const ESM::DialInfo& info) const
 
 bool MWDialogue::Filter::testSelectStructs (const ESM::DialInfo& info) const
 {
+    const std::vector<SelectWrapper> *selects =
+        MWBase::Environment::get().getWorld()->getStore().getDialogueInfoIndex().getSelects (info);
+
+    if (selects)
+    {
+        for (std::vector<SelectWrapper>::const_iterator iter (selects->begin()); iter != selects->end(); ++iter)
+            if (!testSelectStruct (*iter))
+                return false;
+
+        return true;
+    }
+
+    // Not indexed, decode the select structs on the fly
     for (std::vector<ESM::DialInfo::SelectStruct>::const_iterator iter (info.mSelects.begin());
         iter != info.mSelects.end(); ++iter)
         if (!testSelectStruct (*iter))
@@ -178,7 +191,7 @@ bool MWDialogue::Filter::testFunctionLocal(const MWDialogue::SelectWrapper& sele
     if (scriptName.empty())
         return false; // no script
 
-    std::string name = Misc::StringUtils::lowerCase (select.getName());
+    const std::string& name = select.getName();
 
     const Compiler::Locals& localDefs =
         MWBase::Environment::get().getScriptManager()->getLocals (scriptName);
@@ -613,7 +626,30 @@ bool MWDialogue::Filter::hasFactionRankReputationRequirements (const MWWorld::Pt
 
 MWDialogue::Filter::Filter (const MWWorld::Ptr& actor, int choice, bool talkedToPlayer)
 : mActor (actor), mChoice (choice), mTalkedToPlayer (talkedToPlayer)
-{}
+{
+    mSpeaker.mId = Misc::StringUtils::lowerCase (mActor.getCellRef().getRefId());
+    mSpeaker.mIsCreature = (mActor.getTypeName() != typeid (ESM::NPC).name());
+
+    if (!mSpeaker.mIsCreature)
+    {
+        MWWorld::LiveCellRef<ESM::NPC> *cellRef = mActor.get<ESM::NPC>();
+        mSpeaker.mRace = Misc::StringUtils::lowerCase (cellRef->mBase->mRace);
+        mSpeaker.mClass = Misc::StringUtils::lowerCase (cellRef->mBase->mClass);
+        mSpeaker.mFaction = Misc::StringUtils::lowerCase (mActor.getClass().getPrimaryFaction (mActor));
+    }
+}
+
+void MWDialogue::Filter::getCandidates (const ESM::Dialogue& dialogue, std::vector<const ESM::DialInfo *>& infos) const
+{
+    const MWWorld::DialogueInfoIndex& index =
+        MWBase::Environment::get().getWorld()->getStore().getDialogueInfoIndex();
+
+    if (!index.getCandidates (dialogue, mSpeaker, infos))
+    {
+        for (ESM::Dialogue::InfoContainer::const_iterator iter = dialogue.mInfo.begin(); iter!=dialogue.mInfo.end(); ++iter)
+            infos.push_back (&*iter);
+    }
+}
 
 const ESM::DialInfo* MWDialogue::Filter::search (const ESM::Dialogue& dialogue, const bool fallbackToInfoRefusal) const
 {
@@ -627,11 +663,14 @@ const ESM::DialInfo* MWDialogue::Filter::search (const ESM::Dialogue& dialogue,
 
 std::vector<const ESM::DialInfo *> MWDialogue::Filter::listAll (const ESM::Dialogue& dialogue) const
 {
+    std::vector<const ESM::DialInfo *> candidates;
+    getCandidates (dialogue, candidates);
+
     std::vector<const ESM::DialInfo *> infos;
-    for (ESM::Dialogue::InfoContainer::const_iterator iter = dialogue.mInfo.begin(); iter!=dialogue.mInfo.end(); ++iter)
+    for (std::vector<const ESM::DialInfo *>::const_iterator iter = candidates.begin(); iter!=candidates.end(); ++iter)
     {
-        if (testActor (*iter))
-            infos.push_back(&*iter);
+        if (testActor (**iter))
+            infos.push_back(*iter);
     }
     return infos;
 }
@@ -643,14 +682,18 @@ std::vector<const ESM::DialInfo *> MWDialogue::Filter::list (const ESM::Dialogue
 
     bool infoRefusal = false;
 
+    std::vector<const ESM::DialInfo *> candidates;
+    getCandidates (dialogue, candidates);
+
     // Iterate over topic responses to find a matching one
-    for (ESM::Dialogue::InfoContainer::const_iterator iter = dialogue.mInfo.begin();
-        iter!=dialogue.mInfo.end(); ++iter)
+    for (std::vector<const ESM::DialInfo *>::const_iterator iter = candidates.begin();
+        iter!=candidates.end(); ++iter)
     {
-        if (testActor (*iter) && testPlayer (*iter) && testSelectStructs (*iter))
+        const ESM::DialInfo& info = **iter;
+        if (testActor (info) && testPlayer (info) && testSelectStructs (info))
         {
-            if (testDisposition (*iter, invertDisposition)) {
-                infos.push_back(&*iter);
+            if (testDisposition (info, invertDisposition)) {
+                infos.push_back(&info);
                 if (!searchAll)
                     break;
             }
@@ -669,13 +712,19 @@ std::vector<const ESM::DialInfo *> MWDialogue::Filter::list (const ESM::Dialogue
 
         const ESM::Dialogue& infoRefusalDialogue = *dialogues.find ("Info Refusal");
 
-        for (ESM::Dialogue::InfoContainer::const_iterator iter = infoRefusalDialogue.mInfo.begin();
-            iter!=infoRefusalDialogue.mInfo.end(); ++iter)
-            if (testActor (*iter) && testPlayer (*iter) && testSelectStructs (*iter) && testDisposition(*iter, invertDisposition)) {
-                infos.push_back(&*iter);
+        candidates.clear();
+        getCandidates (infoRefusalDialogue, candidates);
+
+        for (std::vector<const ESM::DialInfo *>::const_iterator iter = candidates.begin();
+            iter!=candidates.end(); ++iter)
+        {
+            const ESM::DialInfo& info = **iter;
+            if (testActor (info) && testPlayer (info) && testSelectStructs (info) && testDisposition(info, invertDisposition)) {
+                infos.push_back(&info);
                 if (!searchAll)
                     break;
             }
+        }
     }
 
     return infos;
@@ -683,10 +732,13 @@ std::vector<const ESM::DialInfo *> MWDialogue::Filter::list (const ESM::Dialogue
 
 bool MWDialogue::Filter::responseAvailable (const ESM::Dialogue& dialogue) const
 {
-    for (ESM::Dialogue::InfoContainer::const_iterator iter = dialogue.mInfo.begin();
-        iter!=dialogue.mInfo.end(); ++iter)
+    std::vector<const ESM::DialInfo *> candidates;
+    getCandidates (dialogue, candidates);
+
+    for (std::vector<const ESM::DialInfo *>::const_iterator iter = candidates.begin();
+        iter!=candidates.end(); ++iter)
     {
-        if (testActor (*iter) && testPlayer (*iter) && testSelectStructs (*iter))
+        if (testActor (**iter) && testPlayer (**iter) && testSelectStructs (**iter))
             return true;
     }
 
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "../mwworld/ptr.hpp"
+#include "../mwworld/dialogueinfoindex.hpp"
 
 namespace ESM
 {
@@ -20,6 +21,10 @@ namespace MWDialogue
             MWWorld::Ptr mActor;
             int mChoice;
             bool mTalkedToPlayer;
+            MWWorld::DialogueInfoIndex::Speaker mSpeaker;
+
+            void getCandidates (const ESM::Dialogue& dialogue, std::vector<const ESM::DialInfo *>& infos) const;
+            ///< Get the infos of \a dialogue that could apply to the actor, going by the dialogue info index.
 
             bool testActor (const ESM::DialInfo& info) const;
             ///< Is this the right actor for this \a info?
@@ -14,7 +14,7 @@ namespace MWDialogue
 {
     namespace HyperTextParser
     {
-        std::vector<Token> parseHyperText(const std::string & text)
+        std::vector<Token> parseHyperText(const std::string & text, TopicSearch & topicSearch)
         {
             std::vector<Token> result;
             size_t pos_end, iteration_pos = 0;
@@ -27,7 +27,7 @@ namespace MWDialogue
                 if (pos_begin != std::string::npos && pos_end != std::string::npos)
                 {
                     if (pos_begin != iteration_pos)
-                        tokenizeKeywords(text.substr(iteration_pos, pos_begin - iteration_pos), result);
+                        tokenizeKeywords(text.substr(iteration_pos, pos_begin - iteration_pos), topicSearch, result);
 
                     std::string link = text.substr(pos_begin + 1, pos_end - pos_begin - 1);
                     result.push_back(Token(link, Token::ExplicitLink));
@@ -37,7 +37,7 @@ namespace MWDialogue
                 else
                 {
                     if (iteration_pos != text.size())
-                        tokenizeKeywords(text.substr(iteration_pos), result);
+                        tokenizeKeywords(text.substr(iteration_pos), topicSearch, result);
                     break;
                 }
             }
@@ -45,30 +45,28 @@ namespace MWDialogue
             return result;
         }
 
-        void tokenizeKeywords(const std::string & text, std::vector<Token> & tokens)
+        void tokenizeKeywords(const std::string & text, TopicSearch & topicSearch, std::vector<Token> & tokens)
         {
-            const MWWorld::Store<ESM::Dialogue> & dialogs =
-                MWBase::Environment::get().getWorld()->getStore().get<ESM::Dialogue>();
-
-            std::list<std::string> keywordList;
-            for (MWWorld::Store<ESM::Dialogue>::iterator it = dialogs.begin(); it != dialogs.end(); ++it)
-                keywordList.push_back(Misc::StringUtils::lowerCase(it->mId));
-            keywordList.sort(Misc::StringUtils::ciLess);
+            std::vector<TopicSearch::Match> matches;
+            topicSearch.highlightKeywords(text.begin(), text.end(), matches);
 
-            KeywordSearch<std::string, int /*unused*/> keywordSearch;
-
-            for (std::list<std::string>::const_iterator it = keywordList.begin(); it != keywordList.end(); ++it)
-                keywordSearch.seed(*it, 0 /*unused*/);
-
-            std::vector<KeywordSearch<std::string, int /*unused*/>::Match> matches;
-            keywordSearch.highlightKeywords(text.begin(), text.end(), matches);
-
-            for (std::vector<KeywordSearch<std::string, int /*unused*/>::Match>::const_iterator it = matches.begin(); it != matches.end(); ++it)
+            for (std::vector<TopicSearch::Match>::const_iterator it = matches.begin(); it != matches.end(); ++it)
             {
                 tokens.push_back(Token(std::string(it->mBeg, it->mEnd), Token::ImplicitKeyword));
             }
         }
 
+        void buildTopicSearch(TopicSearch & topicSearch)
+        {
+            const MWWorld::Store<ESM::Dialogue> & dialogs =
+                MWBase::Environment::get().getWorld()->getStore().get<ESM::Dialogue>();
+
+            topicSearch.clear();
+
+            for (MWWorld::Store<ESM::Dialogue>::iterator it = dialogs.begin(); it != dialogs.end(); ++it)
+                topicSearch.seed(Misc::StringUtils::lowerCase(it->mId), 0 /*unused*/);
+        }
+
         size_t removePseudoAsterisks(std::string & phrase)
         {
             size_t pseudoAsterisksCount = 0;
@@ -6,8 +6,13 @@
 
 namespace MWDialogue
 {
+    template <typename string_t, typename value_t>
+    class KeywordSearch;
+
     namespace HyperTextParser
     {
+        typedef KeywordSearch<std::string, int /*unused*/> TopicSearch;
+
         struct Token
         {
             enum Type
@@ -27,8 +32,11 @@ namespace MWDialogue
 
         // In translations (at least Russian) the links are marked with @#, so
         // it should be a function to parse it
-        std::vector<Token> parseHyperText(const std::string & text);
-        void tokenizeKeywords(const std::string & text, std::vector<Token> & tokens);
+        std::vector<Token> parseHyperText(const std::string & text, TopicSearch & topicSearch);
+        void tokenizeKeywords(const std::string & text, TopicSearch & topicSearch, std::vector<Token> & tokens);
+
+        /// Seed \a topicSearch with the IDs of all dialogue topics.
+        void buildTopicSearch(TopicSearch & topicSearch);
         size_t removePseudoAsterisks(std::string & phrase);
     }
 }
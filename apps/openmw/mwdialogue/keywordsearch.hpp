@@ -1,17 +1,24 @@
 #ifndef GAME_MWDIALOGUE_KEYWORDSEARCH_H
 #define GAME_MWDIALOGUE_KEYWORDSEARCH_H
 
-#include <map>
 #include <cctype>
 #include <stdexcept>
 #include <vector>
-#include <algorithm>    // std::reverse
+#include <deque>
+#include <list>
+#include <utility>
+#include <algorithm>
 
 #include <components/misc/stringops.hpp>
 
 namespace MWDialogue
 {
 
+/// @brief Finds keywords in a text, case-insensitively and only at the start of words.
+///
+/// Keywords are kept in a trie that is turned into an Aho-Corasick automaton, so a text is scanned in
+/// a single pass regardless of the number of keywords. Seeding keywords only extends the trie; the
+/// failure links are recomputed on the next search.
 template <typename string_t, typename value_t>
 class KeywordSearch
 {
@@ -26,46 +33,62 @@ public:
         value_t mValue;
     };
 
+    KeywordSearch ()
+    {
+        clear ();
+    }
+
     void seed (string_t keyword, value_t value)
     {
         if (keyword.empty())
             return;
-        seed_impl  (/*std::move*/ (keyword), /*std::move*/ (value), 0, mRoot);
+
+        size_t node = 0;
+        for (Point i = keyword.begin(); i != keyword.end(); ++i)
+        {
+            unsigned char ch = fold (*i);
+            size_t next = findChild (node, ch);
+
+            if (next == sNone)
+            {
+                next = mNodes.size();
+                mNodes.push_back (Node());
+                mNodes.back().mDepth = mNodes[node].mDepth + 1;
+
+                typename Node::Children& children = mNodes[node].mChildren;
+                children.insert (std::lower_bound (children.begin(), children.end(), Edge (ch, 0)), Edge (ch, next));
+            }
+
+            node = next;
+        }
+
+        if (mNodes[node].mKeyword != sNone)
+            throw std::runtime_error ("duplicate keyword inserted");
+
+        mNodes[node].mKeyword = mKeywords.size();
+        mKeywords.push_back (std::make_pair (/*std::move*/ (keyword), /*std::move*/ (value)));
+        mCompiled = false;
     }
 
     void clear ()
     {
-        mRoot.mChildren.clear ();
-        mRoot.mKeyword.clear ();
+        mNodes.clear ();
+        mNodes.push_back (Node());
+        mKeywords.clear ();
+        mCompiled = true;
     }
 
     bool containsKeyword (string_t keyword, value_t& value)
     {
-        typename Entry::childen_t::iterator current;
-        typename Entry::childen_t::iterator next;
+        size_t node = 0;
+        for (Point i = keyword.begin(); i != keyword.end() && node != sNone; ++i)
+            node = findChild (node, fold (*i));
 
-        current = mRoot.mChildren.find (Misc::StringUtils::toLower (*keyword.begin()));
-        if (current == mRoot.mChildren.end())
+        if (node == sNone || mNodes[node].mKeyword == sNone)
             return false;
-        else if (current->second.mKeyword.size() && Misc::StringUtils::ciEqual(current->second.mKeyword, keyword))
-        {
-            value = current->second.mValue;
-            return true;
-        }
 
-        for (Point i = ++keyword.begin(); i != keyword.end(); ++i)
-        {
-            next = current->second.mChildren.find(Misc::StringUtils::toLower (*i));
-            if (next == current->second.mChildren.end())
-                return false;
-            if (Misc::StringUtils::ciEqual(next->second.mKeyword, keyword))
-            {
-                value = next->second.mValue;
-                return true;
-            }
-            current = next;
-        }
-        return false;
+        value = mKeywords[mNodes[node].mKeyword].second;
+        return true;
     }
 
     static bool sortMatches(const Match& left, const Match& right)
@@ -75,94 +98,62 @@ public:
 
     void highlightKeywords (Point beg, Point end, std::vector<Match>& out)
     {
-        std::vector<Match> matches;
-        for (Point i = beg; i != end; ++i)
-        {
-            // check if previous character marked start of new word
-            if (i != beg)
-            {
-                Point prev = i;
-                --prev;
-                if(isalpha(*prev))
-                    continue;
-            }
-
+        if (!mCompiled)
+            compile ();
 
-            // check first character
-            typename Entry::childen_t::iterator candidate = mRoot.mChildren.find (Misc::StringUtils::toLower (*i));
-
-            // no match, on to next character
-            if (candidate == mRoot.mChildren.end ())
-                continue;
+        // longest keyword starting at each position of the text
+        std::vector<size_t> longest (end - beg, sNone);
 
-            // see how far the match goes
-            Point j = i;
-
-            // some keywords might be longer variations of other keywords, so we definitely need a list of candidates
-            // the first element in the pair is length of the match, i.e. depth from the first character on
-            std::vector< typename std::pair<int, typename Entry::childen_t::iterator> > candidates;
+        size_t state = 0;
+        for (Point i = beg; i != end; ++i)
+        {
+            unsigned char ch = fold (*i);
 
-            while ((j + 1) != end)
+            size_t next = findChild (state, ch);
+            while (next == sNone && state != 0)
             {
-                typename Entry::childen_t::iterator next = candidate->second.mChildren.find (Misc::StringUtils::toLower (*++j));
-
-                if (next == candidate->second.mChildren.end ())
-                {
-                    if (candidate->second.mKeyword.size() > 0)
-                        candidates.push_back(std::make_pair((j-i), candidate));
-                    break;
-                }
-
-                candidate = next;
-
-                if (candidate->second.mKeyword.size() > 0)
-                    candidates.push_back(std::make_pair((j-i), candidate));
+                state = mNodes[state].mFailure;
+                next = findChild (state, ch);
             }
+            state = next == sNone ? 0 : next;
 
-            if (candidates.empty())
-                continue; // didn't match enough to disambiguate, on to next character
-
-            // shorter candidates will be added to the vector first. however, we want to check against longer candidates first
-            std::reverse(candidates.begin(), candidates.end());
-
-            for (typename std::vector< std::pair<int, typename Entry::childen_t::iterator> >::iterator it = candidates.begin();
-                 it != candidates.end(); ++it)
+            // every keyword ending here
+            size_t found = mNodes[state].mKeyword != sNone ? state : mNodes[state].mOutput;
+            for (; found != 0; found = mNodes[found].mOutput)
             {
-                candidate = it->second;
-                // try to match the rest of the keyword
-                Point k = i + it->first;
-                typename string_t::const_iterator t = candidate->second.mKeyword.begin () + (k - i);
+                size_t start = (i - beg) + 1 - mNodes[found].mDepth;
 
+                // keywords only start at the beginning of a word
+                if (start != 0 && isalpha (*(beg + (start - 1))))
+                    continue;
 
-                while (k != end && t != candidate->second.mKeyword.end ())
-                {
-                    if (Misc::StringUtils::toLower (*k) != Misc::StringUtils::toLower (*t))
-                        break;
+                // keywords ending further along are always longer, so a later match replaces an earlier one
+                longest[start] = mNodes[found].mKeyword;
+            }
+        }
 
-                    ++k, ++t;
-                }
+        // sorted by start, as there is at most one match per start
+        std::list<Match> matches;
+        for (size_t start = 0; start < longest.size(); ++start)
+        {
+            if (longest[start] == sNone)
+                continue;
 
-                // didn't match full keyword, try the next candidate
-                if (t != candidate->second.mKeyword.end ())
-                    continue;
+            const std::pair<string_t, value_t>& keyword = mKeywords[longest[start]];
 
-                // found a keyword, but there might still be longer keywords that start somewhere _within_ this keyword
-                // we will resolve these overlapping keywords later, choosing the longest one in case of conflict
-                Match match;
-                match.mValue = candidate->second.mValue;
-                match.mBeg = i;
-                match.mEnd = k;
-                matches.push_back(match);
-                break;
-            }
+            Match match;
+            match.mValue = keyword.second;
+            match.mBeg = beg + start;
+            match.mEnd = match.mBeg + keyword.first.size();
+            matches.push_back(match);
         }
 
         // resolve overlapping keywords
         while (!matches.empty())
         {
             int longestKeywordSize = 0;
-            typename std::vector<Match>::iterator longestKeyword = matches.begin();
-            for (typename std::vector<Match>::iterator it = matches.begin(); it != matches.end(); ++it)
+            typename std::list<Match>::iterator longestKeyword = matches.begin();
+            for (typename std::list<Match>::iterator it = matches.begin(); it != matches.end(); ++it)
             {
                 int size = it->mEnd - it->mBeg;
                 if (size > longestKeywordSize)
@@ -171,7 +162,7 @@ public:
                     longestKeyword = it;
                 }
 
-                typename std::vector<Match>::iterator next = it;
+                typename std::list<Match>::iterator next = it;
                 ++next;
 
                 if (next == matches.end())
@@ -184,16 +175,21 @@ public:
             }
 
             Match keyword = *longestKeyword;
-            matches.erase(longestKeyword);
             out.push_back(keyword);
-            // erase anything that overlaps with the keyword we just added to the output
-            for (typename std::vector<Match>::iterator it = matches.begin(); it != matches.end();)
+
+            // erase anything that overlaps with the keyword we just added to the output; matches before it
+            // overlap if they end within it, matches after it if they start within it
+            for (typename std::list<Match>::iterator it = matches.begin(); it != longestKeyword;)
             {
-                if (it->mBeg < keyword.mEnd && it->mEnd > keyword.mBeg)
+                if (it->mEnd > keyword.mBeg)
                     it = matches.erase(it);
                 else
                     ++it;
             }
+
+            typename std::list<Match>::iterator it = matches.erase(longestKeyword);
+            while (it != matches.end() && it->mBeg < keyword.mEnd)
+                it = matches.erase(it);
         }
 
         std::sort(out.begin(), out.end(), sortMatches);
@@ -201,56 +197,86 @@ public:
 
 private:
 
-    struct Entry
+    static const size_t sNone = static_cast<size_t>(-1);
+
+    typedef std::pair<unsigned char, size_t> Edge;
+
+    struct Node
     {
-        typedef std::map <wchar_t, Entry> childen_t;
+        typedef std::vector<Edge> Children;
 
-        string_t mKeyword;
-        value_t mValue;
-        childen_t mChildren;
+        Children mChildren; // sorted by character
+        size_t mDepth;
+        size_t mKeyword; // index into mKeywords of the keyword ending here, if any
+        size_t mFailure; // node of the longest proper suffix that is also in the trie
+        size_t mOutput; // nearest node along the failure links with a keyword, 0 if none
+
+        Node() : mDepth(0), mKeyword(sNone), mFailure(0), mOutput(0) {}
     };
 
-    void seed_impl (string_t keyword, value_t value, size_t depth, Entry  & entry)
+    static unsigned char fold (char c)
     {
-        int ch = Misc::StringUtils::toLower (keyword.at (depth));
+        return static_cast<unsigned char> (Misc::StringUtils::toLower (c));
+    }
 
-        typename Entry::childen_t::iterator j = entry.mChildren.find (ch);
+    size_t findChild (size_t node, unsigned char ch) const
+    {
+        const typename Node::Children& children = mNodes[node].mChildren;
+        typename Node::Children::const_iterator found =
+            std::lower_bound (children.begin(), children.end(), Edge (ch, 0));
 
-        if (j == entry.mChildren.end ())
+        if (found == children.end() || found->first != ch)
+            return sNone;
+
+        return found->second;
+    }
+
+    /// Compute the failure and output links, breadth first so the links of shallower nodes are done first.
+    void compile ()
+    {
+        std::deque<size_t> queue;
+
+        for (typename Node::Children::const_iterator it = mNodes[0].mChildren.begin(); it != mNodes[0].mChildren.end(); ++it)
         {
-            entry.mChildren [ch].mValue = /*std::move*/ (value);
-            entry.mChildren [ch].mKeyword = /*std::move*/ (keyword);
+            mNodes[it->second].mFailure = 0;
+            mNodes[it->second].mOutput = 0;
+            queue.push_back (it->second);
         }
-        else
-        {
-            if (j->second.mKeyword.size () > 0)
-            {
-                if (keyword == j->second.mKeyword)
-                    throw std::runtime_error ("duplicate keyword inserted");
-
-                value_t pushValue = /*std::move*/ (j->second.mValue);
-                string_t pushKeyword = /*std::move*/ (j->second.mKeyword);
 
-                if (depth >= pushKeyword.size ())
-                    throw std::runtime_error ("unexpected");
+        while (!queue.empty())
+        {
+            size_t node = queue.front();
+            queue.pop_front();
 
-                if (depth+1 < pushKeyword.size())
+            for (typename Node::Children::const_iterator it = mNodes[node].mChildren.begin(); it != mNodes[node].mChildren.end(); ++it)
+            {
+                size_t failure = mNodes[node].mFailure;
+                size_t next = findChild (failure, it->first);
+                while (next == sNone && failure != 0)
                 {
-                    seed_impl (/*std::move*/ (pushKeyword), /*std::move*/ (pushValue), depth+1, j->second);
-                    j->second.mKeyword.clear ();
+                    failure = mNodes[failure].mFailure;
+                    next = findChild (failure, it->first);
                 }
+
+                Node& child = mNodes[it->second];
+                child.mFailure = next == sNone ? 0 : next;
+                child.mOutput = mNodes[child.mFailure].mKeyword != sNone ? child.mFailure : mNodes[child.mFailure].mOutput;
+
+                queue.push_back (it->second);
             }
-            if (depth+1 == keyword.size())
-                j->second.mKeyword = value;
-            else // depth+1 < keyword.size()
-                seed_impl (/*std::move*/ (keyword), /*std::move*/ (value), depth+1, j->second);
         }
 
+        mCompiled = true;
     }
 
-    Entry mRoot;
+    std::vector<Node> mNodes; // the root is the first node
+    std::vector<std::pair<string_t, value_t> > mKeywords;
+    bool mCompiled;
 };
 
+template <typename string_t, typename value_t>
+const size_t KeywordSearch<string_t, value_t>::sNone;
+
 }
 
 #endif
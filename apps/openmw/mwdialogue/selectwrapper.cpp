@@ -26,30 +26,10 @@ namespace
 
         throw std::runtime_error ("unknown compare type in dialogue info select");
     }
-
-    template<typename T>
-    bool selectCompareImp (const ESM::DialInfo::SelectStruct& select, T value1)
-    {
-        if (select.mValue.getType()==ESM::VT_Int)
-        {
-            return selectCompareImp (select.mSelectRule[4], value1, select.mValue.getInteger());
-        }
-        else if (select.mValue.getType()==ESM::VT_Float)
-        {
-            return selectCompareImp (select.mSelectRule[4], value1, select.mValue.getFloat());
-        }
-        else
-            throw std::runtime_error (
-                "unsupported variable type in dialogue info select");
-    }
 }
 
-MWDialogue::SelectWrapper::Function MWDialogue::SelectWrapper::decodeFunction() const
+MWDialogue::SelectWrapper::Function MWDialogue::SelectWrapper::decodeFunction (int index)
 {
-    int index = 0;
-
-    std::istringstream (mSelect.mSelectRule.substr(2,2)) >> index;
-
     switch (index)
     {
         case  0: return Function_RankLow;
@@ -97,40 +77,8 @@ MWDialogue::SelectWrapper::Function MWDialogue::SelectWrapper::decodeFunction()
     return Function_False;
 }
 
-MWDialogue::SelectWrapper::SelectWrapper (const ESM::DialInfo::SelectStruct& select) : mSelect (select) {}
-
-MWDialogue::SelectWrapper::Function MWDialogue::SelectWrapper::getFunction() const
-{
-    char type = mSelect.mSelectRule[1];
-
-    switch (type)
-    {
-        case '1': return decodeFunction();
-        case '2': return Function_Global;
-        case '3': return Function_Local;
-        case '4': return Function_Journal;
-        case '5': return Function_Item;
-        case '6': return Function_Dead;
-        case '7': return Function_NotId;
-        case '8': return Function_NotFaction;
-        case '9': return Function_NotClass;
-        case 'A': return Function_NotRace;
-        case 'B': return Function_NotCell;
-        case 'C': return Function_NotLocal;
-    }
-
-    return Function_None;
-}
-
-int MWDialogue::SelectWrapper::getArgument() const
+int MWDialogue::SelectWrapper::decodeArgument (int index)
 {
-    if (mSelect.mSelectRule[1]!='1')
-        return 0;
-
-    int index = 0;
-
-    std::istringstream (mSelect.mSelectRule.substr(2,2)) >> index;
-
     switch (index)
     {
         // AI settings
@@ -187,7 +135,7 @@ int MWDialogue::SelectWrapper::getArgument() const
     return 0;
 }
 
-MWDialogue::SelectWrapper::Type MWDialogue::SelectWrapper::getType() const
+MWDialogue::SelectWrapper::Type MWDialogue::SelectWrapper::decodeType (Function function)
 {
     static const Function integerFunctions[] =
     {
@@ -236,8 +184,6 @@ MWDialogue::SelectWrapper::Type MWDialogue::SelectWrapper::getType() const
         Function_None // end marker
     };
 
-    Function function = getFunction();
-
     for (int i=0; integerFunctions[i]!=Function_None; ++i)
         if (integerFunctions[i]==function)
             return Type_Integer;
@@ -257,7 +203,7 @@ MWDialogue::SelectWrapper::Type MWDialogue::SelectWrapper::getType() const
     return Type_None;
 }
 
-bool MWDialogue::SelectWrapper::isNpcOnly() const
+bool MWDialogue::SelectWrapper::decodeNpcOnly (Function function)
 {
     static const Function functions[] =
     {
@@ -270,8 +216,6 @@ bool MWDialogue::SelectWrapper::isNpcOnly() const
         Function_None // end marker
     };
 
-    Function function = getFunction();
-
     for (int i=0; functions[i]!=Function_None; ++i)
         if (functions[i]==function)
             return true;
@@ -279,22 +223,77 @@ bool MWDialogue::SelectWrapper::isNpcOnly() const
     return false;
 }
 
-bool MWDialogue::SelectWrapper::selectCompare (int value) const
+MWDialogue::SelectWrapper::SelectWrapper (const ESM::DialInfo::SelectStruct& select)
+: mFunction (Function_None), mType (Type_None), mArgument (0), mNpcOnly (false), mComparison (0),
+  mValueType (select.mValue.getType()), mIntValue (0), mFloatValue (0)
+{
+    const std::string& rule = select.mSelectRule;
+
+    if (rule.size()>1)
+    {
+        switch (rule[1])
+        {
+            case '1':
+            {
+                int index = 0;
+                std::istringstream (rule.substr (2, 2)) >> index;
+                mFunction = decodeFunction (index);
+                mArgument = decodeArgument (index);
+                break;
+            }
+
+            case '2': mFunction = Function_Global; break;
+            case '3': mFunction = Function_Local; break;
+            case '4': mFunction = Function_Journal; break;
+            case '5': mFunction = Function_Item; break;
+            case '6': mFunction = Function_Dead; break;
+            case '7': mFunction = Function_NotId; break;
+            case '8': mFunction = Function_NotFaction; break;
+            case '9': mFunction = Function_NotClass; break;
+            case 'A': mFunction = Function_NotRace; break;
+            case 'B': mFunction = Function_NotCell; break;
+            case 'C': mFunction = Function_NotLocal; break;
+        }
+    }
+
+    mType = decodeType (mFunction);
+    mNpcOnly = decodeNpcOnly (mFunction);
+
+    if (rule.size()>4)
+        mComparison = rule[4];
+
+    if (rule.size()>5)
+        mName = Misc::StringUtils::lowerCase (rule.substr (5));
+
+    if (mValueType==ESM::VT_Int)
+        mIntValue = select.mValue.getInteger();
+    else if (mValueType==ESM::VT_Float)
+        mFloatValue = select.mValue.getFloat();
+}
+
+template<typename T>
+bool MWDialogue::SelectWrapper::selectCompareImp (T value) const
 {
-    return selectCompareImp (mSelect, value);
+    if (mValueType==ESM::VT_Int)
+        return ::selectCompareImp (mComparison, value, mIntValue);
+    else if (mValueType==ESM::VT_Float)
+        return ::selectCompareImp (mComparison, value, mFloatValue);
+    else
+        throw std::runtime_error (
+            "unsupported variable type in dialogue info select");
 }
 
-bool MWDialogue::SelectWrapper::selectCompare (float value) const
+bool MWDialogue::SelectWrapper::selectCompare (int value) const
 {
-    return selectCompareImp (mSelect, value);
+    return selectCompareImp (value);
 }
 
-bool MWDialogue::SelectWrapper::selectCompare (bool value) const
+bool MWDialogue::SelectWrapper::selectCompare (float value) const
 {
-    return selectCompareImp (mSelect, static_cast<int> (value));
+    return selectCompareImp (value);
 }
 
-std::string MWDialogue::SelectWrapper::getName() const
+bool MWDialogue::SelectWrapper::selectCompare (bool value) const
 {
-    return Misc::StringUtils::lowerCase (mSelect.mSelectRule.substr (5));
+    return selectCompareImp (static_cast<int> (value));
 }
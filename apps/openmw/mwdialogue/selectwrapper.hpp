@@ -5,10 +5,10 @@
 
 namespace MWDialogue
 {
+    /// @brief A select struct decoded into its function, argument, comparison and value.
+    /// @note Decoding is done once on construction, so the accessors don't need to parse the select rule.
     class SelectWrapper
     {
-            const ESM::DialInfo::SelectStruct& mSelect;
-
         public:
 
             enum Function
@@ -57,19 +57,38 @@ namespace MWDialogue
 
         private:
 
-            Function decodeFunction() const;
+            Function mFunction;
+            Type mType;
+            int mArgument;
+            bool mNpcOnly;
+            char mComparison;
+            ESM::VarType mValueType;
+            int mIntValue;
+            float mFloatValue;
+            std::string mName;
+
+            static Function decodeFunction (int index);
+
+            static int decodeArgument (int index);
+
+            static Type decodeType (Function function);
+
+            static bool decodeNpcOnly (Function function);
+
+            template<typename T>
+            bool selectCompareImp (T value) const;
 
         public:
 
             SelectWrapper (const ESM::DialInfo::SelectStruct& select);
 
-            Function getFunction() const;
+            Function getFunction() const { return mFunction; }
 
-            int getArgument() const;
+            int getArgument() const { return mArgument; }
 
-            Type getType() const;
+            Type getType() const { return mType; }
 
-            bool isNpcOnly() const;
+            bool isNpcOnly() const { return mNpcOnly; }
             ///< \attention Do not call any of the select functions for this select struct!
 
             bool selectCompare (int value) const;
@@ -78,7 +97,7 @@ namespace MWDialogue
 
             bool selectCompare (bool value) const;
 
-            std::string getName() const;
+            const std::string& getName() const { return mName; }
             ///< Return case-smashed name.
     };
 }
@@ -8,10 +8,12 @@
 
 #include "../mwbase/world.hpp"
 #include "../mwbase/environment.hpp"
+#include "../mwbase/mechanicsmanager.hpp"
 
 #include "../mwworld/action.hpp"
 #include "../mwworld/class.hpp"
 #include "../mwworld/cellstore.hpp"
+#include "../mwworld/esmstore.hpp"
 #include "../mwworld/inventorystore.hpp"
 
 #include "pathgrid.hpp"
@@ -29,7 +31,8 @@ MWMechanics::AiPackage::AiPackage() :
     mTimer(AI_REACTION_TIME + 1.0f), // to force initial pathbuild
     mRotateOnTheRunChecks(0),
     mIsShortcutting(false),
-    mShortcutProhibited(false), mShortcutFailPos()
+    mShortcutProhibited(false), mShortcutFailPos(),
+    mDestInLOS(false)
 {
 }
 
@@ -70,6 +73,7 @@ void MWMechanics::AiPackage::reset()
     mIsShortcutting = false;
     mShortcutProhibited = false;
     mShortcutFailPos = ESM::Pathgrid::Point();
+    mDestInLOS = false;
 
     mPathFinder.clearPath();
     mObstacleCheck.clear();
@@ -94,6 +98,9 @@ bool MWMechanics::AiPackage::pathTo(const MWWorld::Ptr& actor, const ESM::Pathgr
     // handle path building and shortcutting
     ESM::Pathgrid::Point start = pos.pos;
 
+    if (mPathFinder.updatePathRequest())
+        onPathBuilt(start, dest);
+
     float distToTarget = distance(start, dest);
     bool isDestReached = (distToTarget <= destTolerance);
 
@@ -115,34 +122,18 @@ bool MWMechanics::AiPackage::pathTo(const MWWorld::Ptr& actor, const ESM::Pathgr
 
         if (!mIsShortcutting)
         {
-            if (wasShortcutting || doesPathNeedRecalc(dest, actor.getCell())) // if need to rebuild path
+            // while a path request is pending, keep following the old path
+            if (!mPathFinder.isPathRequestPending()
+                && (wasShortcutting || doesPathNeedRecalc(dest, actor.getCell()))) // if need to rebuild path
             {
-                mPathFinder.buildSyncedPath(start, dest, actor.getCell(), getPathGridGraph(actor.getCell()));
+                MWBase::MechanicsManager* mechanicsManager = MWBase::Environment::get().getMechanicsManager();
+                mPathFinder.requestSyncedPath(start, dest, actor.getCell(), getPathGridGraph(actor.getCell()),
+                    mechanicsManager->getPathRequestQueue(), &mechanicsManager->getExteriorPathgridGraph());
                 mRotateOnTheRunChecks = 3;
+                mDestInLOS = destInLOS;
 
-                // give priority to go directly on target if there is minimal opportunity
-                if (destInLOS && mPathFinder.getPath().size() > 1)
-                {
-                    // get point just before dest
-                    std::list<ESM::Pathgrid::Point>::const_iterator pPointBeforeDest = mPathFinder.getPath().end();
-                    --pPointBeforeDest;
-                    --pPointBeforeDest;
-
-                    // if start point is closer to the target then last point of path (excluding target itself) then go straight on the target
-                    if (distance(start, dest) <= distance(dest, *pPointBeforeDest))
-                    {
-                        mPathFinder.clearPath();
-                        mPathFinder.addPointToPath(dest);
-                    }
-                }
-            }
-
-            if (!mPathFinder.getPath().empty()) //Path has points in it
-            {
-                ESM::Pathgrid::Point lastPos = mPathFinder.getPath().back(); //Get the end of the proposed path
-
-                if(distance(dest, lastPos) > 100) //End of the path is far from the destination
-                    mPathFinder.addPointToPath(dest); //Adds the final destination to the path, to try to get to where you want to go
+                if (!mPathFinder.isPathRequestPending())
+                    onPathBuilt(start, dest);
             }
         }
 
@@ -176,6 +167,29 @@ bool MWMechanics::AiPackage::pathTo(const MWWorld::Ptr& actor, const ESM::Pathgr
     return false;
 }
 
+void MWMechanics::AiPackage::onPathBuilt(const ESM::Pathgrid::Point& start, const ESM::Pathgrid::Point& dest)
+{
+    // give priority to go directly on target if there is minimal opportunity
+    if (mDestInLOS && mPathFinder.getPath().size() > 1)
+    {
+        // get point just before dest
+        std::deque<ESM::Pathgrid::Point>::const_iterator pPointBeforeDest = mPathFinder.getPath().end();
+        --pPointBeforeDest;
+        --pPointBeforeDest;
+
+        // if start point is closer to the target then last point of path (excluding target itself) then go straight on the target
+        if (distance(start, dest) <= distance(dest, *pPointBeforeDest))
+        {
+            mPathFinder.clearPath();
+            mPathFinder.addPointToPath(dest);
+        }
+    }
+
+    // if the end of the path is far from the destination, add the destination, to try to get to where we want to go
+    if (!mPathFinder.getPath().empty() && distance(dest, mPathFinder.getPath().back()) > 100)
+        mPathFinder.addPointToPath(dest);
+}
+
 void MWMechanics::AiPackage::evadeObstacles(const MWWorld::Ptr& actor, float duration, const ESM::Position& pos)
 {
     zTurn(actor, mPathFinder.getZAngleToNext(pos.pos[0], pos.pos[1]));
@@ -239,7 +253,9 @@ const MWMechanics::PathgridGraph& MWMechanics::AiPackage::getPathGridGraph(const
     CacheMap::iterator found = cache.find(id);
     if (found == cache.end())
     {
-        cache.insert(std::make_pair(id, std::unique_ptr<MWMechanics::PathgridGraph>(new MWMechanics::PathgridGraph(cell))));
+        const ESM::Pathgrid* pathgrid =
+            MWBase::Environment::get().getWorld()->getStore().get<ESM::Pathgrid>().search(*cell->getCell());
+        cache.insert(std::make_pair(id, std::unique_ptr<MWMechanics::PathgridGraph>(new MWMechanics::PathgridGraph(pathgrid))));
     }
     return *cache[id].get();
 }
@@ -120,6 +120,9 @@ namespace MWMechanics
 
             void evadeObstacles(const MWWorld::Ptr& actor, float duration, const ESM::Position& pos);
 
+            /// Adjust a new path of mPathFinder, built or taken over from a path request
+            void onPathBuilt(const ESM::Pathgrid::Point& start, const ESM::Pathgrid::Point& dest);
+
             const PathgridGraph& getPathGridGraph(const MWWorld::CellStore* cell);
 
             // TODO: all this does not belong here, move into temporary storage
@@ -135,6 +138,7 @@ namespace MWMechanics
             bool mIsShortcutting;   // if shortcutting at the moment
             bool mShortcutProhibited; // shortcutting may be prohibited after unsuccessful attempt
             ESM::Pathgrid::Point mShortcutFailPos; // position of last shortcut fail
+            bool mDestInLOS; // if the destination was in line of sight when the path was requested
 
         private:
             bool isNearInactiveCell(const ESM::Position& actorPos);
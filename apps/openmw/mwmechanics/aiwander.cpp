@@ -715,7 +715,7 @@ namespace MWMechanics
         // Every now and then check whether one of the doors is opened. (maybe
         // at the end of playing idle?) If the door is opened then re-calculate
         // allowed nodes starting from the spawn point.
-        std::list<ESM::Pathgrid::Point> paths = pathfinder.getPath();
+        std::deque<ESM::Pathgrid::Point> paths = pathfinder.getPath();
         while(paths.size() >= 2)
         {
             ESM::Pathgrid::Point pt = paths.back();
@@ -880,12 +880,13 @@ namespace MWMechanics
 
     void AiWander::getNeighbouringNodes(ESM::Pathgrid::Point dest, const MWWorld::CellStore* currentCell, ESM::Pathgrid::PointList& points)
     {
-        const ESM::Pathgrid *pathgrid =
-            MWBase::Environment::get().getWorld()->getStore().get<ESM::Pathgrid>().search(*currentCell->getCell());
+        const PathgridGraph& graph = getPathGridGraph(currentCell);
 
-        int index = PathFinder::GetClosestPoint(pathgrid, PathFinder::MakeOsgVec3(dest));
+        int index = graph.getPointIndex().getClosestPoint(PathFinder::MakeOsgVec3(dest));
+        if (index < 0)
+            return;
 
-        getPathGridGraph(currentCell).getNeighbouringPoints(index, points);
+        graph.getNeighbouringPoints(index, points);
     }
 
     void AiWander::getAllowedNodes(const MWWorld::Ptr& actor, const ESM::Cell* cell, AiWanderStorage& storage)
@@ -915,21 +916,25 @@ namespace MWMechanics
             osg::Vec3f npcPos(mInitialActorPosition);
             CoordinateConverter(cell).toLocal(npcPos);
             
+            // the point index of the cell's pathgrid graph is shared by all actors in the cell
+            const PathgridGraph& graph = getPathGridGraph(cellStore);
+
             // Find closest pathgrid point
-            int closestPointIndex = PathFinder::GetClosestPoint(pathgrid, npcPos);
+            int closestPointIndex = graph.getPointIndex().getClosestPoint(npcPos);
 
             // mAllowedNodes for this actor with pathgrid point indexes based on mDistance
             // and if the point is connected to the closest current point
             // NOTE: mPoints and mAllowedNodes are in local coordinates
+            std::vector<int> pointsInRange;
+            graph.getPointIndex().getPointsInRange(npcPos, static_cast<float>(mDistance), pointsInRange);
+
             int pointIndex = 0;
-            for(unsigned int counter = 0; counter < pathgrid->mPoints.size(); counter++)
+            for(std::vector<int>::const_iterator it = pointsInRange.begin(); it != pointsInRange.end(); ++it)
             {
-                osg::Vec3f nodePos(PathFinder::MakeOsgVec3(pathgrid->mPoints[counter]));
-                if((npcPos - nodePos).length2() <= mDistance * mDistance &&
-                   getPathGridGraph(cellStore).isPointConnected(closestPointIndex, counter))
+                if(graph.isPointConnected(closestPointIndex, *it))
                 {
-                    storage.mAllowedNodes.push_back(pathgrid->mPoints[counter]);
-                    pointIndex = counter;
+                    storage.mAllowedNodes.push_back(pathgrid->mPoints[*it]);
+                    pointIndex = *it;
                 }
             }
             if (storage.mAllowedNodes.size() == 1)
@@ -0,0 +1,443 @@
+#include "exteriorpathgrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+#include <components/esm/loadland.hpp>
+
+namespace
+{
+    // pathgrid points closer than this to a cell border are linked to the neighbouring cell
+    const int sBorderDistance = 1024;
+
+    // longest link between pathgrid points of neighbouring cells
+    const float sMaxLinkDistance = 1024.f;
+
+    // cells around the bounding box of the start and end cells that a search may pass through
+    const int sSearchMargin = 1;
+
+    // routes between cells further apart than this are not searched
+    const int sMaxCellDistance = 8;
+
+    // nodes expanded before a search gives up
+    const int sMaxExpansions = 512;
+
+    // cached routes before the cache is cleared
+    const size_t sMaxCachedRoutes = 256;
+
+    float distance2D(const ESM::Pathgrid::Point& a, const ESM::Pathgrid::Point& b)
+    {
+        float x = static_cast<float>(a.mX - b.mX);
+        float y = static_cast<float>(a.mY - b.mY);
+        return std::sqrt(x * x + y * y);
+    }
+
+    int getClosestPoint(const ESM::Pathgrid& pathgrid, const ESM::Pathgrid::Point& point)
+    {
+        int closest = -1;
+        float closestDistance = std::numeric_limits<float>::max();
+
+        for (size_t i = 0; i < pathgrid.mPoints.size(); ++i)
+        {
+            const ESM::Pathgrid::Point& candidate = pathgrid.mPoints[i];
+            float x = static_cast<float>(candidate.mX - point.mX);
+            float y = static_cast<float>(candidate.mY - point.mY);
+            float z = static_cast<float>(candidate.mZ - point.mZ);
+            float distance = x * x + y * y + z * z;
+
+            if (distance < closestDistance)
+            {
+                closestDistance = distance;
+                closest = static_cast<int>(i);
+            }
+        }
+
+        return closest;
+    }
+}
+
+namespace MWMechanics
+{
+    bool ExteriorPathgridGraph::Node::operator==(const Node& other) const
+    {
+        return mCell == other.mCell && mPoint == other.mPoint;
+    }
+
+    bool ExteriorPathgridGraph::Node::operator<(const Node& other) const
+    {
+        if (mCell != other.mCell)
+            return mCell < other.mCell;
+        return mPoint < other.mPoint;
+    }
+
+    ExteriorPathgridGraph::Cell::Cell(const CellIndex& index, const ESM::Pathgrid* pathgrid)
+        : mIndex(index)
+        , mPathgrid(pathgrid)
+        , mGraph(pathgrid)
+    {
+    }
+
+    ExteriorPathgridGraph::ExteriorPathgridGraph(const PathgridLookup& lookup, int maxCostSearches)
+        : mLookup(lookup)
+        , mMinX(0), mMaxX(0), mMinY(0), mMaxY(0)
+        , mMaxCostSearches(maxCostSearches)
+        , mCostSearchesLeft(0)
+        , mCutOff(false)
+    {
+    }
+
+    std::pair<int, int> ExteriorPathgridGraph::getCellIndex(const ESM::Pathgrid::Point& point)
+    {
+        return std::make_pair(
+            static_cast<int>(std::floor(static_cast<float>(point.mX) / ESM::Land::REAL_SIZE)),
+            static_cast<int>(std::floor(static_cast<float>(point.mY) / ESM::Land::REAL_SIZE)));
+    }
+
+    void ExteriorPathgridGraph::clear()
+    {
+        mCells.clear();
+        mRoutes.clear();
+    }
+
+    ExteriorPathgridGraph::Cell* ExteriorPathgridGraph::getCell(const CellIndex& index)
+    {
+        std::map<CellIndex, std::unique_ptr<Cell> >::iterator found = mCells.find(index);
+        if (found != mCells.end())
+            return found->second.get();
+
+        std::unique_ptr<Cell>& cell = mCells[index];
+
+        const ESM::Pathgrid* pathgrid = mLookup(index.first, index.second);
+        if (!pathgrid || pathgrid->mPoints.empty())
+            return NULL;
+
+        cell.reset(new Cell(index, pathgrid));
+
+        for (int i = 0; i < static_cast<int>(pathgrid->mPoints.size()); ++i)
+        {
+            if (isBorderPoint(*cell, i))
+                cell->mBorderPoints.push_back(i);
+        }
+
+        return cell.get();
+    }
+
+    ESM::Pathgrid::Point ExteriorPathgridGraph::toWorld(const Cell& cell, int point) const
+    {
+        ESM::Pathgrid::Point world = cell.mPathgrid->mPoints[point];
+        world.mX += cell.mIndex.first * ESM::Land::REAL_SIZE;
+        world.mY += cell.mIndex.second * ESM::Land::REAL_SIZE;
+        return world;
+    }
+
+    bool ExteriorPathgridGraph::isBorderPoint(const Cell& cell, int point) const
+    {
+        const ESM::Pathgrid::Point& local = cell.mPathgrid->mPoints[point];
+        return local.mX < sBorderDistance || local.mX > ESM::Land::REAL_SIZE - sBorderDistance
+            || local.mY < sBorderDistance || local.mY > ESM::Land::REAL_SIZE - sBorderDistance;
+    }
+
+    float ExteriorPathgridGraph::getCost(Cell& cell, int from, int to)
+    {
+        if (from == to)
+            return 0;
+
+        std::pair<int, int> key(from, to);
+        std::map<std::pair<int, int>, float>::const_iterator found = cell.mCosts.find(key);
+        if (found != cell.mCosts.end())
+            return found->second;
+
+        float cost = -1;
+        if (cell.mGraph.isPointConnected(from, to))
+        {
+            if (mCostSearchesLeft <= 0)
+            {
+                mCutOff = true;
+                return -1;
+            }
+            --mCostSearchesLeft;
+
+            mSegment.clear();
+            cell.mGraph.aStarSearch(from, to, mSegment, mSearchState);
+
+            if (!mSegment.empty())
+            {
+                cost = 0;
+                for (size_t i = 1; i < mSegment.size(); ++i)
+                    cost += PathgridGraph::getCost(mSegment[i - 1], mSegment[i]);
+            }
+        }
+
+        cell.mCosts[key] = cost;
+        return cost;
+    }
+
+    const std::vector<ExteriorPathgridGraph::Link>& ExteriorPathgridGraph::getLinks(Cell& cell, int point)
+    {
+        std::map<int, std::vector<Link> >::iterator found = cell.mLinks.find(point);
+        if (found != cell.mLinks.end())
+            return found->second;
+
+        std::vector<Link>& links = cell.mLinks[point];
+        const ESM::Pathgrid::Point from = toWorld(cell, point);
+
+        for (int x = -1; x <= 1; ++x)
+        {
+            for (int y = -1; y <= 1; ++y)
+            {
+                if (x == 0 && y == 0)
+                    continue;
+
+                CellIndex index(cell.mIndex.first + x, cell.mIndex.second + y);
+                Cell* neighbour = getCell(index);
+                if (!neighbour)
+                    continue;
+
+                // link to the closest border point of the neighbour that is close enough
+                int closest = -1;
+                float closestDistance = sMaxLinkDistance;
+                for (std::vector<int>::const_iterator it = neighbour->mBorderPoints.begin();
+                     it != neighbour->mBorderPoints.end(); ++it)
+                {
+                    float distance = distance2D(from, toWorld(*neighbour, *it));
+                    if (distance <= closestDistance)
+                    {
+                        closest = *it;
+                        closestDistance = distance;
+                    }
+                }
+
+                if (closest != -1)
+                {
+                    Link link;
+                    link.mTo = Node(index, closest);
+                    link.mCost = PathgridGraph::getCost(from, toWorld(*neighbour, closest));
+                    links.push_back(link);
+                }
+            }
+        }
+
+        return links;
+    }
+
+    bool ExteriorPathgridGraph::findRoute(const ESM::Pathgrid::Point& start, const ESM::Pathgrid::Point& end,
+                                          ESM::Pathgrid::PointList& path)
+    {
+        CellIndex startIndex = getCellIndex(start);
+        CellIndex endIndex = getCellIndex(end);
+
+        if (startIndex == endIndex
+            || std::abs(startIndex.first - endIndex.first) > sMaxCellDistance
+            || std::abs(startIndex.second - endIndex.second) > sMaxCellDistance)
+            return false;
+
+        Cell* startCell = getCell(startIndex);
+        Cell* endCell = getCell(endIndex);
+        if (!startCell || !endCell)
+            return false;
+
+        ESM::Pathgrid::Point localStart = start;
+        localStart.mX -= startIndex.first * ESM::Land::REAL_SIZE;
+        localStart.mY -= startIndex.second * ESM::Land::REAL_SIZE;
+
+        ESM::Pathgrid::Point localEnd = end;
+        localEnd.mX -= endIndex.first * ESM::Land::REAL_SIZE;
+        localEnd.mY -= endIndex.second * ESM::Land::REAL_SIZE;
+
+        Node startNode(startIndex, getClosestPoint(*startCell->mPathgrid, localStart));
+        Node goalNode(endIndex, getClosestPoint(*endCell->mPathgrid, localEnd));
+
+        std::pair<Node, Node> key(startNode, goalNode);
+        std::map<std::pair<Node, Node>, ESM::Pathgrid::PointList>::const_iterator found = mRoutes.find(key);
+        if (found == mRoutes.end())
+        {
+            mMinX = std::min(startIndex.first, endIndex.first) - sSearchMargin;
+            mMaxX = std::max(startIndex.first, endIndex.first) + sSearchMargin;
+            mMinY = std::min(startIndex.second, endIndex.second) - sSearchMargin;
+            mMaxY = std::max(startIndex.second, endIndex.second) + sSearchMargin;
+
+            std::vector<Node> nodes;
+            ESM::Pathgrid::PointList route;
+            SearchResult result = search(startNode, goalNode, nodes);
+
+            // not cached, as the search might succeed another time; the costs found so far are kept
+            if (result == Search_CutOff)
+                return false;
+
+            if (result == Search_Found)
+                refine(nodes, route);
+
+            if (mRoutes.size() >= sMaxCachedRoutes)
+                mRoutes.clear();
+            found = mRoutes.insert(std::make_pair(key, route)).first;
+        }
+
+        if (found->second.empty())
+            return false;
+
+        path.insert(path.end(), found->second.begin(), found->second.end());
+        return true;
+    }
+
+    /*
+     * A* over the border points of the cells, plus the start and goal points.
+     *
+     * Within a cell, a point is connected to every border point it can reach through
+     * the cell's pathgrid, with the cost of that path. Border points are also connected
+     * to the closest border point of each neighbouring cell. The heuristic is the cost
+     * of going straight to the goal, which never overestimates since edge costs within
+     * cells are sums of the same metric.
+     */
+    ExteriorPathgridGraph::SearchResult ExteriorPathgridGraph::search(const Node& start, const Node& goal,
+                                                                      std::vector<Node>& route)
+    {
+        struct State
+        {
+            float mGScore;
+            Node mParent;
+            bool mClosed;
+        };
+
+        typedef std::pair<float, Node> OpenEntry;
+        const std::greater<OpenEntry> lowestFirst;
+
+        const ESM::Pathgrid::Point goalPoint = toWorld(*getCell(goal.mCell), goal.mPoint);
+
+        std::map<Node, State> states;
+        std::vector<OpenEntry> openset;
+
+        State startState;
+        startState.mGScore = 0;
+        startState.mClosed = false;
+        states[start] = startState;
+        openset.push_back(OpenEntry(PathgridGraph::getCost(toWorld(*getCell(start.mCell), start.mPoint), goalPoint), start));
+
+        std::vector<std::pair<Node, float> > edges;
+        int expansions = 0;
+        mCostSearchesLeft = mMaxCostSearches;
+        mCutOff = false;
+
+        while (!openset.empty())
+        {
+            std::pop_heap(openset.begin(), openset.end(), lowestFirst);
+            Node current = openset.back().second;
+            openset.pop_back();
+
+            State& currentState = states[current];
+            if (currentState.mClosed)
+                continue; // stale entry
+
+            if (current == goal)
+            {
+                for (Node node = goal; !(node == start); node = states[node].mParent)
+                    route.push_back(node);
+                route.push_back(start);
+                std::reverse(route.begin(), route.end());
+                return Search_Found;
+            }
+
+            if (++expansions > sMaxExpansions)
+                return Search_CutOff;
+
+            currentState.mClosed = true;
+            const float currentGScore = currentState.mGScore;
+
+            Cell& cell = *getCell(current.mCell);
+
+            edges.clear();
+
+            if (current.mCell == goal.mCell)
+            {
+                float cost = getCost(cell, current.mPoint, goal.mPoint);
+                if (cost >= 0)
+                    edges.push_back(std::make_pair(goal, cost));
+            }
+
+            for (std::vector<int>::const_iterator it = cell.mBorderPoints.begin(); it != cell.mBorderPoints.end(); ++it)
+            {
+                if (*it == current.mPoint)
+                    continue;
+
+                float cost = getCost(cell, current.mPoint, *it);
+                if (cost >= 0)
+                    edges.push_back(std::make_pair(Node(current.mCell, *it), cost));
+            }
+
+            // the edges would be incomplete
+            if (mCutOff)
+                return Search_CutOff;
+
+            if (std::binary_search(cell.mBorderPoints.begin(), cell.mBorderPoints.end(), current.mPoint))
+            {
+                const std::vector<Link>& links = getLinks(cell, current.mPoint);
+                for (std::vector<Link>::const_iterator it = links.begin(); it != links.end(); ++it)
+                {
+                    const CellIndex& index = it->mTo.mCell;
+                    if (index.first >= mMinX && index.first <= mMaxX && index.second >= mMinY && index.second <= mMaxY)
+                        edges.push_back(std::make_pair(it->mTo, it->mCost));
+                }
+            }
+
+            for (std::vector<std::pair<Node, float> >::const_iterator it = edges.begin(); it != edges.end(); ++it)
+            {
+                float tentative_g = currentGScore + it->second;
+
+                std::map<Node, State>::iterator dest = states.find(it->first);
+                if (dest == states.end())
+                {
+                    State state;
+                    state.mClosed = false;
+                    state.mGScore = tentative_g;
+                    state.mParent = current;
+                    states[it->first] = state;
+                }
+                else if (dest->second.mClosed || tentative_g >= dest->second.mGScore)
+                    continue;
+                else
+                {
+                    dest->second.mGScore = tentative_g;
+                    dest->second.mParent = current;
+                }
+
+                const ESM::Pathgrid::Point point = toWorld(*getCell(it->first.mCell), it->first.mPoint);
+                openset.push_back(OpenEntry(tentative_g + PathgridGraph::getCost(point, goalPoint), it->first));
+                std::push_heap(openset.begin(), openset.end(), lowestFirst);
+            }
+        }
+
+        return Search_NoRoute;
+    }
+
+    void ExteriorPathgridGraph::refine(const std::vector<Node>& route, ESM::Pathgrid::PointList& path)
+    {
+        path.push_back(toWorld(*getCell(route.front().mCell), route.front().mPoint));
+
+        for (size_t i = 1; i < route.size(); ++i)
+        {
+            const Node& from = route[i - 1];
+            const Node& to = route[i];
+            Cell& cell = *getCell(to.mCell);
+
+            if (from.mCell != to.mCell)
+            {
+                // link to a neighbouring cell
+                path.push_back(toWorld(cell, to.mPoint));
+                continue;
+            }
+
+            mSegment.clear();
+            cell.mGraph.aStarSearch(from.mPoint, to.mPoint, mSegment, mSearchState);
+
+            // the first point of the segment is already on the path
+            for (size_t j = 1; j < mSegment.size(); ++j)
+            {
+                ESM::Pathgrid::Point point = mSegment[j];
+                point.mX += cell.mIndex.first * ESM::Land::REAL_SIZE;
+                point.mY += cell.mIndex.second * ESM::Land::REAL_SIZE;
+                path.push_back(point);
+            }
+        }
+    }
+}
@@ -0,0 +1,136 @@
+#ifndef GAME_MWMECHANICS_EXTERIORPATHGRID_H
+#define GAME_MWMECHANICS_EXTERIORPATHGRID_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <components/esm/loadpgrd.hpp>
+
+#include "pathgrid.hpp"
+
+namespace MWMechanics
+{
+    /// \brief Finds routes through the pathgrids of several exterior cells
+    ///
+    /// Pathgrids are separate per cell. This stitches them together with a hierarchical graph: its nodes are
+    /// the pathgrid points close to a cell border, linked to the nearest point across the border and, within
+    /// a cell, to the other border points reachable through the cell's pathgrid. A route is searched on this
+    /// graph and only then refined into pathgrid points within each cell it passes.
+    ///
+    /// Cells, their border links and the costs between their border points are set up on first use. Routes,
+    /// including failed ones, are cached, unless the search was cut off.
+    ///
+    /// Not thread safe.
+    class ExteriorPathgridGraph
+    {
+        public:
+
+            /// Returns the pathgrid of the exterior cell at the given grid position, or NULL if there is none.
+            typedef std::function<const ESM::Pathgrid* (int x, int y)> PathgridLookup;
+
+            /// @param maxCostSearches Searches within a cell that a single findRoute may run to get the costs
+            /// between border points. Costs are cached, so a cut off route can be found by a later call.
+            ExteriorPathgridGraph(const PathgridLookup& lookup, int maxCostSearches = 64);
+
+            /// Find a route between two points in different exterior cells. The route runs from the pathgrid
+            /// point closest to \a start to the pathgrid point closest to \a end, and is appended to \a path.
+            ///
+            /// The search only considers cells around the start and end cells and gives up after a number of
+            /// steps or searches within cells, so it takes bounded time.
+            ///
+            /// @note All points are in world coordinates.
+            /// @return Was a route found?
+            bool findRoute(const ESM::Pathgrid::Point& start, const ESM::Pathgrid::Point& end,
+                           ESM::Pathgrid::PointList& path);
+
+            /// Get the grid position of the exterior cell containing a point in world coordinates.
+            static std::pair<int, int> getCellIndex(const ESM::Pathgrid::Point& point);
+
+            /// Discard all cells and cached routes.
+            void clear();
+
+        private:
+
+            typedef std::pair<int, int> CellIndex;
+
+            enum SearchResult
+            {
+                Search_Found,
+                Search_NoRoute,
+                Search_CutOff ///< gave up before a route was found or ruled out
+            };
+
+            struct Node
+            {
+                CellIndex mCell;
+                int mPoint;
+
+                Node() : mPoint(-1) {}
+                Node(const CellIndex& cell, int point) : mCell(cell), mPoint(point) {}
+
+                bool operator==(const Node& other) const;
+                bool operator<(const Node& other) const;
+            };
+
+            struct Link
+            {
+                Node mTo;
+                float mCost;
+            };
+
+            struct Cell
+            {
+                Cell(const CellIndex& index, const ESM::Pathgrid* pathgrid);
+
+                CellIndex mIndex;
+                const ESM::Pathgrid* mPathgrid;
+                PathgridGraph mGraph;
+                std::vector<int> mBorderPoints; // sorted
+
+                // path costs between two points, negative if there is no path
+                std::map<std::pair<int, int>, float> mCosts;
+
+                // links of border points to the neighbouring cells
+                std::map<int, std::vector<Link> > mLinks;
+            };
+
+            /// @return NULL if the cell has no pathgrid
+            Cell* getCell(const CellIndex& index);
+
+            ESM::Pathgrid::Point toWorld(const Cell& cell, int point) const;
+
+            bool isBorderPoint(const Cell& cell, int point) const;
+
+            /// Get the path cost between two points of a cell, negative if there is no path.
+            /// @note If the cost is not known yet and no searches are left, sets mCutOff and returns -1.
+            float getCost(Cell& cell, int from, int to);
+
+            const std::vector<Link>& getLinks(Cell& cell, int point);
+
+            SearchResult search(const Node& start, const Node& goal, std::vector<Node>& route);
+
+            /// Append the pathgrid points along \a route to \a path.
+            void refine(const std::vector<Node>& route, ESM::Pathgrid::PointList& path);
+
+            PathgridLookup mLookup;
+            std::map<CellIndex, std::unique_ptr<Cell> > mCells; // NULL for cells without a pathgrid
+
+            // first point of the route is start, last point is goal; empty if there is no route
+            std::map<std::pair<Node, Node>, ESM::Pathgrid::PointList> mRoutes;
+
+            PathgridGraph::SearchState mSearchState;
+            ESM::Pathgrid::PointList mSegment;
+
+            // cells the current search may use
+            int mMinX, mMaxX, mMinY, mMaxY;
+
+            const int mMaxCostSearches;
+            int mCostSearchesLeft; // for the current search
+            bool mCutOff;
+    };
+}
+
+#endif
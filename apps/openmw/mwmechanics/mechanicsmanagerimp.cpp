@@ -9,6 +9,10 @@
 
 #include <components/sceneutil/positionattitudetransform.hpp>
 
+#include <components/settings/settings.hpp>
+
+#include <osg/Stats>
+
 #include "../mwworld/esmstore.hpp"
 #include "../mwworld/inventorystore.hpp"
 #include "../mwworld/class.hpp"
@@ -31,6 +35,11 @@
 namespace
 {
 
+    const ESM::Pathgrid* searchExteriorPathgrid(int x, int y)
+    {
+        return MWBase::Environment::get().getWorld()->getStore().get<ESM::Pathgrid>().search(x, y);
+    }
+
     float getFightDispositionBias(float disposition)
     {
         static const float fFightDispMult = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>().find(
@@ -239,9 +248,13 @@ namespace MWMechanics
     // if stats.getTimeToStartDrowning() == 0 already on game start
     MechanicsManager::MechanicsManager()
     : mWatchedTimeToStartDrowning(-1), mWatchedStatsEmpty (true), mUpdatePlayer (true), mClassSelected (false),
-      mRaceSelected (false), mAI(true)
+      mRaceSelected (false), mAI(true), mExteriorPathgrids(searchExteriorPathgrid)
     {
         //buildPlayer no longer here, needs to be done explicitly after all subsystems are up and running
+
+        int pathThreads = Settings::Manager::getInt("path request threads", "Game");
+        if (pathThreads > 0)
+            mPathRequests.reset(new PathRequestQueue(pathThreads));
     }
 
     void MechanicsManager::add(const MWWorld::Ptr& ptr)
@@ -294,6 +307,9 @@ namespace MWMechanics
 
     void MechanicsManager::update(float duration, bool paused)
     {
+        if (mPathRequests)
+            mPathRequests->update();
+
         if(!mWatched.isEmpty())
         {
             MWBase::WindowManager *winMgr = MWBase::Environment::get().getWindowManager();
@@ -443,6 +459,25 @@ namespace MWMechanics
         return mActors.isSneaking(ptr);
     }
 
+    PathRequestQueue* MechanicsManager::getPathRequestQueue()
+    {
+        return mPathRequests.get();
+    }
+
+    ExteriorPathgridGraph& MechanicsManager::getExteriorPathgridGraph()
+    {
+        return mExteriorPathgrids;
+    }
+
+    void MechanicsManager::reportStats(unsigned int frameNumber, osg::Stats* stats) const
+    {
+        if (!mPathRequests)
+            return;
+
+        stats->setAttribute(frameNumber, "Path Completed", mPathRequests->getNumCompleted());
+        stats->setAttribute(frameNumber, "Path Pending", mPathRequests->getNumPending());
+    }
+
     void MechanicsManager::rest(bool sleep)
     {
         mActors.rest(sleep);
@@ -1,6 +1,8 @@
 #ifndef GAME_MWMECHANICS_MECHANICSMANAGERIMP_H
 #define GAME_MWMECHANICS_MECHANICSMANAGERIMP_H
 
+#include <memory>
+
 #include "../mwbase/mechanicsmanager.hpp"
 
 #include "../mwworld/ptr.hpp"
@@ -9,6 +11,8 @@
 #include "npcstats.hpp"
 #include "objects.hpp"
 #include "actors.hpp"
+#include "pathrequests.hpp"
+#include "exteriorpathgrid.hpp"
 
 namespace MWWorld
 {
@@ -39,6 +43,9 @@ namespace MWMechanics
             Objects mObjects;
             Actors mActors;
 
+            std::unique_ptr<PathRequestQueue> mPathRequests;
+            ExteriorPathgridGraph mExteriorPathgrids;
+
             typedef std::pair<std::string, bool> Owner; // < Owner id, bool isFaction >
             typedef std::map<Owner, int> OwnerMap; // < Owner, number of stolen items with this id from this owner >
             typedef std::map<std::string, OwnerMap> StolenItemsMap;
@@ -223,6 +230,12 @@ namespace MWMechanics
             virtual bool isRunning(const MWWorld::Ptr& ptr);
             virtual bool isSneaking(const MWWorld::Ptr& ptr);
 
+            virtual PathRequestQueue* getPathRequestQueue();
+
+            virtual ExteriorPathgridGraph& getExteriorPathgridGraph();
+
+            virtual void reportStats(unsigned int frameNumber, osg::Stats* stats) const;
+
         private:
             void reportCrime (const MWWorld::Ptr& ptr, const MWWorld::Ptr& victim,
                                       OffenseType type, int arg=0);
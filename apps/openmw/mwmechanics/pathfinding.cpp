@@ -1,6 +1,6 @@
 #include "pathfinding.hpp"
 
-#include <limits>
+#include <components/esm/loadcell.hpp>
 
 #include "../mwbase/world.hpp"
 #include "../mwbase/environment.hpp"
@@ -8,51 +8,15 @@
 #include "../mwworld/cellstore.hpp"
 
 #include "pathgrid.hpp"
-#include "coordinateconverter.hpp"
+#include "exteriorpathgrid.hpp"
 
 namespace
 {
-    // Chooses a reachable end pathgrid point.  start is assumed reachable.
-    std::pair<int, bool> getClosestReachablePoint(const ESM::Pathgrid* grid,
-                                                  const MWMechanics::PathgridGraph *graph,
-                                                  const osg::Vec3f& pos, int start)
+    bool isInOtherExteriorCell(const ESM::Cell* cell, const ESM::Pathgrid::Point& point)
     {
-        assert(grid && !grid->mPoints.empty());
-
-        float closestDistanceBetween = std::numeric_limits<float>::max();
-        float closestDistanceReachable = std::numeric_limits<float>::max();
-        int closestIndex = 0;
-        int closestReachableIndex = 0;
-        // TODO: if this full scan causes performance problems mapping pathgrid
-        //       points to a quadtree may help
-        for(unsigned int counter = 0; counter < grid->mPoints.size(); counter++)
-        {
-            float potentialDistBetween = MWMechanics::PathFinder::DistanceSquared(grid->mPoints[counter], pos);
-            if (potentialDistBetween < closestDistanceReachable)
-            {
-                // found a closer one
-                if (graph->isPointConnected(start, counter))
-                {
-                    closestDistanceReachable = potentialDistBetween;
-                    closestReachableIndex = counter;
-                }
-                if (potentialDistBetween < closestDistanceBetween)
-                {
-                    closestDistanceBetween = potentialDistBetween;
-                    closestIndex = counter;
-                }
-            }
-        }
-
-        // post-condition: start and endpoint must be connected
-        assert(graph->isPointConnected(start, closestReachableIndex));
-
-        // AiWander has logic that depends on whether a path was created, deleting
-        // allowed nodes if not.  Hence a path needs to be created even if the start
-        // and the end points are the same.
-
-        return std::pair<int, bool>
-            (closestReachableIndex, closestReachableIndex == closestIndex);
+        return cell->isExterior()
+            && MWMechanics::ExteriorPathgridGraph::getCellIndex(point)
+                != std::make_pair(cell->getGridX(), cell->getGridY());
     }
 
 }
@@ -129,6 +93,7 @@ namespace MWMechanics
     {
         if(!mPath.empty())
             mPath.clear();
+        cancelPathRequest();
     }
 
     /*
@@ -169,9 +134,11 @@ namespace MWMechanics
      */
     void PathFinder::buildPath(const ESM::Pathgrid::Point &startPoint,
                                const ESM::Pathgrid::Point &endPoint,
-                               const MWWorld::CellStore* cell, const PathgridGraph& pathgridGraph)
+                               const MWWorld::CellStore* cell, const PathgridGraph& pathgridGraph,
+                               ExteriorPathgridGraph* exteriorGraph)
     {
         mPath.clear();
+        cancelPathRequest();
 
         // TODO: consider removing mCell / mPathgrid in favor of mPathgridGraph
         if(mCell != cell || !mPathgrid)
@@ -180,78 +147,20 @@ namespace MWMechanics
             mPathgrid = pathgridGraph.getPathgrid();
         }
 
-        // Refer to AiWander reseach topic on openmw forums for some background.
-        // Maybe there is no pathgrid for this cell.  Just go to destination and let
-        // physics take care of any blockages.
-        if(!mPathgrid || mPathgrid->mPoints.empty())
-        {
-            mPath.push_back(endPoint);
-            return;
-        }
-
-        // NOTE: GetClosestPoint expects local coordinates
-        CoordinateConverter converter(mCell->getCell());
-
-        // NOTE: It is possible that GetClosestPoint returns a pathgrind point index
-        //       that is unreachable in some situations. e.g. actor is standing
-        //       outside an area enclosed by walls, but there is a pathgrid
-        //       point right behind the wall that is closer than any pathgrid
-        //       point outside the wall
-        osg::Vec3f startPointInLocalCoords(converter.toLocalVec3(startPoint));
-        int startNode = GetClosestPoint(mPathgrid, startPointInLocalCoords);
-
-        osg::Vec3f endPointInLocalCoords(converter.toLocalVec3(endPoint));
-        std::pair<int, bool> endNode = getClosestReachablePoint(mPathgrid, &pathgridGraph,
-            endPointInLocalCoords,
-                startNode);
-
-        // if it's shorter for actor to travel from start to end, than to travel from either
-        // start or end to nearest pathgrid point, just travel from start to end.
-        float startToEndLength2 = (endPointInLocalCoords - startPointInLocalCoords).length2();
-        float endTolastNodeLength2 = DistanceSquared(mPathgrid->mPoints[endNode.first], endPointInLocalCoords);
-        float startTo1stNodeLength2 = DistanceSquared(mPathgrid->mPoints[startNode], startPointInLocalCoords);
-        if ((startToEndLength2 < startTo1stNodeLength2) || (startToEndLength2 < endTolastNodeLength2))
+        // If the destination is in another exterior cell, go through the pathgrids of the
+        // cells in between. The route ends at the pathgrid point closest to endPoint.
+        if (exteriorGraph && mPathgrid && !mPathgrid->mPoints.empty() && isInOtherExteriorCell(mCell->getCell(), endPoint))
         {
-            mPath.push_back(endPoint);
-            return;
-        }
-
-        // AiWander has logic that depends on whether a path was created,
-        // deleting allowed nodes if not.  Hence a path needs to be created
-        // even if the start and the end points are the same.
-        // NOTE: aStarSearch will return an empty path if the start and end
-        //       nodes are the same
-        if(startNode == endNode.first)
-        {
-            ESM::Pathgrid::Point temp(mPathgrid->mPoints[startNode]);
-            converter.toWorld(temp);
-            mPath.push_back(temp);
-        }
-        else
-        {
-            mPath = pathgridGraph.aStarSearch(startNode, endNode.first);
-
-            // convert supplied path to world coordinates
-            for (std::list<ESM::Pathgrid::Point>::iterator iter(mPath.begin()); iter != mPath.end(); ++iter)
+            mSearchResult.clear();
+            if (exteriorGraph->findRoute(startPoint, endPoint, mSearchResult))
             {
-                converter.toWorld(*iter);
+                mPath.assign(mSearchResult.begin(), mSearchResult.end());
+                mPath.push_back(endPoint);
+                return;
             }
         }
 
-        // If endNode found is NOT the closest PathGrid point to the endPoint,
-        // assume endPoint is not reachable from endNode. In which case, 
-        // path ends at endNode.
-        //
-        // So only add the destination (which may be different to the closest
-        // pathgrid point) when endNode was the closest point to endPoint.
-        //
-        // This logic can fail in the opposite situate, e.g. endPoint may
-        // have been reachable but happened to be very close to an
-        // unreachable pathgrid point.
-        //
-        // The AI routines will have to deal with such situations.
-        if(endNode.second)
-            mPath.push_back(endPoint);
+        buildPathgridPath(startPoint, endPoint, mCell->getCell(), pathgridGraph, mPath, mSearchResult, NULL);
     }
 
     float PathFinder::getZAngleToNext(float x, float y) const
@@ -302,29 +211,84 @@ namespace MWMechanics
     // see header for the rationale
     void PathFinder::buildSyncedPath(const ESM::Pathgrid::Point &startPoint,
         const ESM::Pathgrid::Point &endPoint,
-        const MWWorld::CellStore* cell, const MWMechanics::PathgridGraph& pathgridGraph)
+        const MWWorld::CellStore* cell, const MWMechanics::PathgridGraph& pathgridGraph,
+        ExteriorPathgridGraph* exteriorGraph)
     {
         if (mPath.size() < 2)
         {
             // if path has one point, then it's the destination.
             // don't need to worry about bad path for this case
-            buildPath(startPoint, endPoint, cell, pathgridGraph);
+            buildPath(startPoint, endPoint, cell, pathgridGraph, exteriorGraph);
         }
         else
         {
             const ESM::Pathgrid::Point oldStart(*getPath().begin());
-            buildPath(startPoint, endPoint, cell, pathgridGraph);
-            if (mPath.size() >= 2)
+            buildPath(startPoint, endPoint, cell, pathgridGraph, exteriorGraph);
+            skipVisitedPoint(oldStart);
+        }
+    }
+
+    void PathFinder::requestSyncedPath(const ESM::Pathgrid::Point &startPoint,
+        const ESM::Pathgrid::Point &endPoint,
+        const MWWorld::CellStore* cell, const PathgridGraph& pathgridGraph,
+        PathRequestQueue* queue, ExteriorPathgridGraph* exteriorGraph)
+    {
+        const ESM::Pathgrid* pathgrid = pathgridGraph.getPathgrid();
+
+        // Without an old path to steer on the actor would stand still until the request is done, and
+        // paths without pathgrid search or through several exterior cells are built on the main thread anyway.
+        if (!queue || mPath.empty() || !pathgrid || pathgrid->mPoints.empty()
+            || (exteriorGraph && isInOtherExteriorCell(cell->getCell(), endPoint)))
+        {
+            buildSyncedPath(startPoint, endPoint, cell, pathgridGraph, exteriorGraph);
+            return;
+        }
+
+        cancelPathRequest();
+        mCell = cell;
+        mPathgrid = pathgrid;
+        mPathRequest = queue->request(startPoint, endPoint, cell->getCell(), pathgridGraph);
+    }
+
+    bool PathFinder::updatePathRequest()
+    {
+        if (!mPathRequest || !mPathRequest->isDone())
+            return false;
+
+        bool synced = mPath.size() >= 2;
+        ESM::Pathgrid::Point oldStart;
+        if (synced)
+            oldStart = mPath.front();
+
+        mPath = mPathRequest->getPath();
+        mPathRequest = NULL;
+
+        if (synced)
+            skipVisitedPoint(oldStart);
+        return true;
+    }
+
+    void PathFinder::cancelPathRequest()
+    {
+        if (mPathRequest)
+        {
+            mPathRequest->abort();
+            mPathRequest = NULL;
+        }
+    }
+
+    void PathFinder::skipVisitedPoint(const ESM::Pathgrid::Point &oldStart)
+    {
+        if (mPath.size() >= 2)
+        {
+            // if 2nd waypoint of new path == 1st waypoint of old, 
+            // delete 1st waypoint of new path.
+            std::deque<ESM::Pathgrid::Point>::iterator iter = ++mPath.begin();
+            if (iter->mX == oldStart.mX
+                && iter->mY == oldStart.mY
+                && iter->mZ == oldStart.mZ)
             {
-                // if 2nd waypoint of new path == 1st waypoint of old, 
-                // delete 1st waypoint of new path.
-                std::list<ESM::Pathgrid::Point>::iterator iter = ++mPath.begin();
-                if (iter->mX == oldStart.mX
-                    && iter->mY == oldStart.mY
-                    && iter->mZ == oldStart.mZ)
-                {
-                    mPath.pop_front();
-                }
+                mPath.pop_front();
             }
         }
     }
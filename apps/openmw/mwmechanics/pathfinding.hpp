@@ -1,12 +1,20 @@
 #ifndef GAME_MWMECHANICS_PATHFINDING_H
 #define GAME_MWMECHANICS_PATHFINDING_H
 
-#include <list>
+#include <deque>
 #include <cassert>
 
 #include <components/esm/defs.hpp>
 #include <components/esm/loadpgrd.hpp>
 
+#include "pathgrid.hpp"
+#include "pathrequests.hpp"
+
+namespace ESM
+{
+    struct Cell;
+}
+
 namespace MWWorld
 {
     class CellStore;
@@ -14,7 +22,7 @@ namespace MWWorld
 
 namespace MWMechanics
 {
-    class PathgridGraph;
+    class ExteriorPathgridGraph;
 
     float distance(const ESM::Pathgrid::Point& point, float x, float y, float);
     float distance(const ESM::Pathgrid::Point& a, const ESM::Pathgrid::Point& b);
@@ -55,8 +63,10 @@ namespace MWMechanics
 
             void clearPath();
 
+            /// @param exteriorGraph If not NULL, used to find a route when \a endPoint is in another exterior cell
             void buildPath(const ESM::Pathgrid::Point &startPoint, const ESM::Pathgrid::Point &endPoint,
-                           const MWWorld::CellStore* cell, const PathgridGraph& pathgridGraph);
+                           const MWWorld::CellStore* cell, const PathgridGraph& pathgridGraph,
+                           ExteriorPathgridGraph* exteriorGraph = NULL);
 
             bool checkPathCompleted(float x, float y, float tolerance = PathTolerance);
             ///< \Returns true if we are within \a tolerance units of the last path point.
@@ -76,7 +86,7 @@ namespace MWMechanics
                 return mPath.size();
             }
 
-            const std::list<ESM::Pathgrid::Point>& getPath() const
+            const std::deque<ESM::Pathgrid::Point>& getPath() const
             {
                 return mPath;
             }
@@ -91,7 +101,26 @@ namespace MWMechanics
                 Which results in NPC "running in a circle" back to the just passed waypoint.
              */
             void buildSyncedPath(const ESM::Pathgrid::Point &startPoint, const ESM::Pathgrid::Point &endPoint,
-                const MWWorld::CellStore* cell, const PathgridGraph& pathgridGraph);
+                const MWWorld::CellStore* cell, const PathgridGraph& pathgridGraph,
+                ExteriorPathgridGraph* exteriorGraph = NULL);
+
+            /// Like buildSyncedPath, but search the pathgrid on a worker thread of \a queue. The current path
+            /// is kept until updatePathRequest() takes over the new one.
+            ///
+            /// @note Builds the path right away if there is no current path to follow meanwhile, no \a queue
+            /// or nothing to search on the pathgrid of \a cell.
+            void requestSyncedPath(const ESM::Pathgrid::Point &startPoint, const ESM::Pathgrid::Point &endPoint,
+                const MWWorld::CellStore* cell, const PathgridGraph& pathgridGraph,
+                PathRequestQueue* queue, ExteriorPathgridGraph* exteriorGraph = NULL);
+
+            /// Replace the path with the result of the last requestSyncedPath() if it is done.
+            /// \return Was the path replaced?
+            bool updatePathRequest();
+
+            bool isPathRequestPending() const
+            {
+                return mPathRequest.valid();
+            }
 
             void addPointToPath(const ESM::Pathgrid::Point &point)
             {
@@ -137,8 +166,7 @@ namespace MWMechanics
                 float distanceBetween = DistanceSquared(grid->mPoints[0], pos);
                 int closestIndex = 0;
 
-                // TODO: if this full scan causes performance problems mapping pathgrid
-                //       points to a quadtree may help
+                // NOTE: PathgridPointIndex answers this without scanning all points
                 for(unsigned int counter = 1; counter < grid->mPoints.size(); counter++)
                 {
                     float potentialDistBetween = DistanceSquared(grid->mPoints[counter], pos);
@@ -153,7 +181,15 @@ namespace MWMechanics
             }
 
         private:
-            std::list<ESM::Pathgrid::Point> mPath;
+            /// Forget the pending path request, if any.
+            void cancelPathRequest();
+
+            /// Drop the first point of a new path if the actor already passed it on its way to \a oldStart.
+            void skipVisitedPoint(const ESM::Pathgrid::Point &oldStart);
+
+            std::deque<ESM::Pathgrid::Point> mPath;
+            ESM::Pathgrid::PointList mSearchResult; // reused by buildPath
+            osg::ref_ptr<PathRequest> mPathRequest;
 
             const ESM::Pathgrid *mPathgrid;
             const MWWorld::CellStore* mCell;
@@ -1,10 +1,8 @@
 #include "pathgrid.hpp"
 
-#include "../mwbase/world.hpp"
-#include "../mwbase/environment.hpp"
-
-#include "../mwworld/cellstore.hpp"
-#include "../mwworld/esmstore.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
 
 namespace
 {
@@ -45,20 +43,58 @@ namespace
         //return distance(a, b);
         return manhattan(a, b);
     }
+
+    MWMechanics::PathgridGraph::SearchState sMainThreadSearchState;
 }
 
 namespace MWMechanics
 {
-    PathgridGraph::PathgridGraph(const MWWorld::CellStore *cell)
-        : mCell(NULL)
-        , mPathgrid(NULL)
-        , mIsExterior(0)
+    PathgridGraph::SearchState::SearchState()
+        : mGeneration(0)
+    {
+    }
+
+    void PathgridGraph::SearchState::begin(size_t size)
+    {
+        if(mPoints.size() < size)
+        {
+            Point point;
+            point.mGeneration = 0;
+            mPoints.resize(size, point);
+        }
+
+        mOpenSet.clear();
+
+        if(++mGeneration == 0)
+        {
+            // the counter wrapped around, entries of old searches could be taken as current
+            for(std::vector<Point>::iterator it = mPoints.begin(); it != mPoints.end(); ++it)
+                it->mGeneration = 0;
+            mGeneration = 1;
+        }
+    }
+
+    PathgridGraph::SearchState::Point& PathgridGraph::SearchState::get(int index)
+    {
+        Point& point = mPoints[index];
+        if(point.mGeneration != mGeneration)
+        {
+            point.mGeneration = mGeneration;
+            point.mClosed = false;
+            point.mGScore = -1;
+            point.mParent = -1;
+        }
+        return point;
+    }
+
+    PathgridGraph::PathgridGraph(const ESM::Pathgrid *pathgrid)
+        : mPathgrid(NULL)
         , mGraph(0)
         , mIsGraphConstructed(false)
         , mSCCId(0)
         , mSCCIndex(0)
     {
-        load(cell);
+        load(pathgrid);
     }
 
     /*
@@ -97,19 +133,15 @@ namespace MWMechanics
      *    +---------------->
      *      high cost
      */
-    bool PathgridGraph::load(const MWWorld::CellStore *cell)
+    bool PathgridGraph::load(const ESM::Pathgrid *pathgrid)
     {
-        if(!cell)
+        if(!pathgrid)
             return false;
 
         if(mIsGraphConstructed)
             return true;
 
-        mCell = cell->getCell();
-        mIsExterior = cell->getCell()->isExterior();
-        mPathgrid = MWBase::Environment::get().getWorld()->getStore().get<ESM::Pathgrid>().search(*cell->getCell());
-        if(!mPathgrid)
-            return false;
+        mPathgrid = pathgrid;
 
 
         mGraph.resize(mPathgrid->mPoints.size());
@@ -127,6 +159,7 @@ namespace MWMechanics
             //mGraph[mPathgrid->mEdges[i].mV1].edges.push_back(neighbour);
         }
         buildConnectedPoints();
+        mPointIndex.build(mPathgrid);
         mIsGraphConstructed = true;
         return true;
     }
@@ -136,6 +169,11 @@ namespace MWMechanics
         return mPathgrid;
     }
 
+    const PathgridPointIndex& PathgridGraph::getPointIndex() const
+    {
+        return mPointIndex;
+    }
+
     // v is the pathgrid point index (some call them vertices)
     void PathgridGraph::recursiveStrongConnect(int v)
     {
@@ -230,6 +268,11 @@ namespace MWMechanics
         }
     }
 
+    float PathgridGraph::getCost(const ESM::Pathgrid::Point& a, const ESM::Pathgrid::Point& b)
+    {
+        return costAStar(a, b);
+    }
+
     /*
      * NOTE: Based on buildPath2(), please check git history if interested
      *       Should consider using a 3rd party library version (e.g. boost)
@@ -238,106 +281,99 @@ namespace MWMechanics
      * Uses mGraph which has pre-computed costs for allowed edges.  It is assumed
      * that mGraph is already constructed.
      *
-     * Should be possible to make this MT safe.
+     * MT safe as long as each thread uses its own search state.
      *
-     * Returns path which may be empty.  path contains pathgrid points in local
-     * cell coordinates (indoors) or world coordinates (external).
+     * Appends the path, if any, to the output list.  path contains pathgrid
+     * points in local cell coordinates (indoors) or world coordinates (external).
      *
      * Input params:
      *   start, goal - pathgrid point indexes (for this cell)
+     *   state - scratch buffers, see SearchState
      *
      * Variables:
-     *   openset - point indexes to be traversed, lowest cost at the front
-     *   closedset - point indexes already traversed
-     *   gScore - past accumulated costs vector indexed by point index
-     *   fScore - future estimated costs vector indexed by point index
+     *   openset - binary heap of point indexes to be traversed, lowest fScore
+     *             first; a point is pushed again instead of being moved up when
+     *             a cheaper way to it is found, and the stale entry is skipped
+     *   closed - point already traversed
+     *   gScore - past accumulated costs indexed by point index
+     *   fScore - gScore plus the estimated cost to the goal
+     *
+     * The heuristic is a metric scaled the same way as the edge costs, so it is
+     * consistent and a point never needs to be traversed twice.
      *
      * TODO: An intersting exercise might be to cache the paths created for a
      *       start/goal pair.  To cache the results the paths need to be in
      *       pathgrid points form (currently they are converted to world
      *       coordinates).  Essentially trading speed w/ memory.
      */
-    std::list<ESM::Pathgrid::Point> PathgridGraph::aStarSearch(const int start,
-                                                               const int goal) const
+    void PathgridGraph::aStarSearch(const int start, const int goal, ESM::Pathgrid::PointList& path,
+                                    SearchState& state) const
     {
-        std::list<ESM::Pathgrid::Point> path;
         if(!isPointConnected(start, goal))
         {
-            return path; // there is no path, return an empty path
+            return; // there is no path
         }
 
-        int graphSize = static_cast<int> (mGraph.size());
-        std::vector<float> gScore (graphSize, -1);
-        std::vector<float> fScore (graphSize, -1);
-        std::vector<int> graphParent (graphSize, -1);
-
-        // gScore & fScore keep costs for each pathgrid point in mPoints
-        gScore[start] = 0;
-        fScore[start] = costAStar(mPathgrid->mPoints[start], mPathgrid->mPoints[goal]);
+        typedef std::pair<float, int> OpenEntry;
+        std::vector<OpenEntry>& openset = state.mOpenSet;
+        const std::greater<OpenEntry> lowestFirst;
 
-        std::list<int> openset;
-        std::list<int> closedset;
-        openset.push_back(start);
+        state.begin(mGraph.size());
+        state.get(start).mGScore = 0;
+        openset.push_back(OpenEntry(costAStar(mPathgrid->mPoints[start], mPathgrid->mPoints[goal]), start));
 
         int current = -1;
 
         while(!openset.empty())
         {
-            current = openset.front(); // front has the lowest cost
-            openset.pop_front();
+            std::pop_heap(openset.begin(), openset.end(), lowestFirst);
+            current = openset.back().second;
+            openset.pop_back();
+
+            SearchState::Point& currentPoint = state.get(current);
+            if(currentPoint.mClosed)
+                continue; // stale entry, the point was already reached more cheaply
 
             if(current == goal)
                 break;
 
-            closedset.push_back(current); // remember we've been here
+            currentPoint.mClosed = true; // remember we've been here
+            const float currentGScore = currentPoint.mGScore;
 
             // check all edges for the current point index
-            for(int j = 0; j < static_cast<int> (mGraph[current].edges.size()); j++)
+            const std::vector<ConnectedPoint>& edges = mGraph[current].edges;
+            for(std::vector<ConnectedPoint>::const_iterator edge = edges.begin(); edge != edges.end(); ++edge)
             {
-                if(std::find(closedset.begin(), closedset.end(), mGraph[current].edges[j].index) ==
-                   closedset.end())
+                SearchState::Point& dest = state.get(edge->index);
+                if(dest.mClosed)
+                    continue; // traversed this edge destination already
+
+                float tentative_g = currentGScore + edge->cost;
+                if(dest.mGScore < 0 || tentative_g < dest.mGScore)
                 {
-                    // not in closedset - i.e. have not traversed this edge destination
-                    int dest = mGraph[current].edges[j].index;
-                    float tentative_g = gScore[current] + mGraph[current].edges[j].cost;
-                    bool isInOpenSet = std::find(openset.begin(), openset.end(), dest) != openset.end();
-                    if(!isInOpenSet
-                        || tentative_g < gScore[dest])
-                    {
-                        graphParent[dest] = current;
-                        gScore[dest] = tentative_g;
-                        fScore[dest] = tentative_g + costAStar(mPathgrid->mPoints[dest],
-                                                               mPathgrid->mPoints[goal]);
-                        if(!isInOpenSet)
-                        {
-                            // add this edge to openset, lowest cost goes to the front
-                            // TODO: if this causes performance problems a hash table may help
-                            std::list<int>::iterator it = openset.begin();
-                            for(it = openset.begin(); it!= openset.end(); ++it)
-                            {
-                                if(fScore[*it] > fScore[dest])
-                                    break;
-                            }
-                            openset.insert(it, dest);
-                        }
-                    }
-                } // if in closedset, i.e. traversed this edge already, try the next edge
+                    dest.mParent = current;
+                    dest.mGScore = tentative_g;
+
+                    openset.push_back(OpenEntry(tentative_g + costAStar(mPathgrid->mPoints[edge->index],
+                                                                        mPathgrid->mPoints[goal]), edge->index));
+                    std::push_heap(openset.begin(), openset.end(), lowestFirst);
+                }
             }
         }
 
         if(current != goal)
-            return path; // for some reason couldn't build a path
+            return; // for some reason couldn't build a path
 
         // reconstruct path to return, using local coordinates
-        while(graphParent[current] != -1)
-        {
-            path.push_front(mPathgrid->mPoints[current]);
-            current = graphParent[current];
-        }
+        size_t first = path.size();
+        for(; current != -1; current = state.get(current).mParent)
+            path.push_back(mPathgrid->mPoints[current]);
 
-        // add first node to path explicitly
-        path.push_front(mPathgrid->mPoints[start]);
-        return path;
+        std::reverse(path.begin() + first, path.end());
     }
-}
 
+    void PathgridGraph::aStarSearch(const int start, const int goal, ESM::Pathgrid::PointList& path) const
+    {
+        aStarSearch(start, goal, path, sMainThreadSearchState);
+    }
+}
@@ -1,31 +1,58 @@
 #ifndef GAME_MWMECHANICS_PATHGRID_H
 #define GAME_MWMECHANICS_PATHGRID_H
 
-#include <list>
+#include <utility>
+#include <vector>
 
 #include <components/esm/loadpgrd.hpp>
 
-namespace ESM
-{
-    struct Cell;
-}
-
-namespace MWWorld
-{
-    class CellStore;
-}
+#include "pathgridindex.hpp"
 
 namespace MWMechanics
 {
     class PathgridGraph
     {
         public:
-            PathgridGraph(const MWWorld::CellStore* cell);
+            /// Scratch buffers of aStarSearch, reused by later searches on any graph
+            ///
+            /// The buffers are not cleared between searches; a generation counter tells which entries
+            /// belong to the current search. A state must not be used by more than one thread at a time.
+            class SearchState
+            {
+                public:
+                    SearchState();
+
+                private:
+                    friend class PathgridGraph;
+
+                    struct Point
+                    {
+                        unsigned int mGeneration; // search this entry was last used by
+                        bool mClosed;
+                        float mGScore; // accumulated cost from the start
+                        int mParent;
+                    };
+
+                    /// Prepare for a search on a graph with \a size points.
+                    void begin(size_t size);
 
-            bool load(const MWWorld::CellStore *cell);
+                    /// Get the entry of a point, resetting it if it is left over from an earlier search.
+                    Point& get(int index);
+
+                    std::vector<Point> mPoints;
+                    std::vector<std::pair<float, int> > mOpenSet; // binary heap of <fScore, point index>
+                    unsigned int mGeneration;
+            };
+
+            PathgridGraph(const ESM::Pathgrid* pathgrid);
+
+            bool load(const ESM::Pathgrid* pathgrid);
 
             const ESM::Pathgrid* getPathgrid() const;
 
+            /// Index for finding pathgrid points by position, shared by all users of this graph
+            const PathgridPointIndex& getPointIndex() const;
+
             // returns true if end point is strongly connected (i.e. reachable
             // from start point) both start and end are pathgrid point indexes
             bool isPointConnected(const int start, const int end) const;
@@ -33,18 +60,25 @@ namespace MWMechanics
             // get neighbouring nodes for index node and put them to "nodes" vector
             void getNeighbouringPoints(const int index, ESM::Pathgrid::PointList &nodes) const;
 
+            // cost of moving between two points, as used for the edges and the
+            // heuristic of aStarSearch
+            static float getCost(const ESM::Pathgrid::Point& a, const ESM::Pathgrid::Point& b);
+
             // the input parameters are pathgrid point indexes
-            // the output list is in local (internal cells) or world (external
-            // cells) coordinates
+            // the points are appended to the output list, in local (internal
+            // cells) or world (external cells) coordinates
             //
-            // NOTE: if start equals end an empty path is returned
-            std::list<ESM::Pathgrid::Point> aStarSearch(const int start,
-                                                        const int end) const;
+            // NOTE: if start equals end the path only contains that point, if
+            // there is no path nothing is appended
+            void aStarSearch(const int start, const int end, ESM::Pathgrid::PointList& path,
+                             SearchState& state) const;
+
+            // same as above, using a search state shared by all searches on the main thread
+            void aStarSearch(const int start, const int end, ESM::Pathgrid::PointList& path) const;
+
         private:
 
-            const ESM::Cell *mCell;
             const ESM::Pathgrid *mPathgrid;
-            bool mIsExterior;
 
             struct ConnectedPoint // edge
             {
@@ -70,6 +104,8 @@ namespace MWMechanics
             std::vector<Node> mGraph;
             bool mIsGraphConstructed;
 
+            PathgridPointIndex mPointIndex;
+
             // variables used to calculate connected components
             int mSCCId;
             int mSCCIndex;
@@ -0,0 +1,200 @@
+#include "pathgridindex.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    // about the spacing of pathgrid points
+    const float sBucketSize = 512.f;
+
+    // pathgrids of large interiors use bigger buckets instead of more of them
+    const int sMaxBuckets = 4096;
+
+    float distanceSquared(const ESM::Pathgrid::Point& point, const osg::Vec3f& pos)
+    {
+        osg::Vec3f delta(static_cast<float>(point.mX) - pos.x(), static_cast<float>(point.mY) - pos.y(),
+                         static_cast<float>(point.mZ) - pos.z());
+        return delta.length2();
+    }
+}
+
+namespace MWMechanics
+{
+    PathgridPointIndex::PathgridPointIndex()
+        : mPathgrid(NULL)
+        , mMinX(0)
+        , mMinY(0)
+        , mBucketSize(sBucketSize)
+        , mColumns(0)
+        , mRows(0)
+    {
+    }
+
+    void PathgridPointIndex::build(const ESM::Pathgrid* pathgrid)
+    {
+        mPathgrid = pathgrid;
+        mBucketStarts.clear();
+        mPoints.clear();
+        mColumns = mRows = 0;
+
+        if (!mPathgrid || mPathgrid->mPoints.empty())
+            return;
+
+        const ESM::Pathgrid::PointList& points = mPathgrid->mPoints;
+
+        int minX = points[0].mX, maxX = points[0].mX;
+        int minY = points[0].mY, maxY = points[0].mY;
+        for (ESM::Pathgrid::PointList::const_iterator it = points.begin(); it != points.end(); ++it)
+        {
+            minX = std::min(minX, it->mX);
+            maxX = std::max(maxX, it->mX);
+            minY = std::min(minY, it->mY);
+            maxY = std::max(maxY, it->mY);
+        }
+
+        mMinX = static_cast<float>(minX);
+        mMinY = static_cast<float>(minY);
+        mBucketSize = sBucketSize;
+        while (true)
+        {
+            mColumns = static_cast<int>((maxX - minX) / mBucketSize) + 1;
+            mRows = static_cast<int>((maxY - minY) / mBucketSize) + 1;
+            if (mColumns * mRows <= sMaxBuckets)
+                break;
+            mBucketSize *= 2;
+        }
+
+        // counting sort of the point indexes by bucket; indexes stay ascending within a bucket
+        std::vector<int> bucketOfPoint(points.size());
+        mBucketStarts.assign(mColumns * mRows + 1, 0);
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            bucketOfPoint[i] = getRow(static_cast<float>(points[i].mY)) * mColumns
+                + getColumn(static_cast<float>(points[i].mX));
+            ++mBucketStarts[bucketOfPoint[i] + 1];
+        }
+
+        for (size_t i = 1; i < mBucketStarts.size(); ++i)
+            mBucketStarts[i] += mBucketStarts[i - 1];
+
+        std::vector<int> next(mBucketStarts.begin(), mBucketStarts.end() - 1);
+        mPoints.resize(points.size());
+        for (size_t i = 0; i < points.size(); ++i)
+            mPoints[next[bucketOfPoint[i]]++] = static_cast<int>(i);
+    }
+
+    int PathgridPointIndex::getColumn(float x) const
+    {
+        int column = static_cast<int>(std::floor((x - mMinX) / mBucketSize));
+        return std::max(0, std::min(column, mColumns - 1));
+    }
+
+    int PathgridPointIndex::getRow(float y) const
+    {
+        int row = static_cast<int>(std::floor((y - mMinY) / mBucketSize));
+        return std::max(0, std::min(row, mRows - 1));
+    }
+
+    int PathgridPointIndex::getClosestPoint(const osg::Vec3f& pos) const
+    {
+        if (mPoints.empty())
+            return -1;
+
+        const ESM::Pathgrid::PointList& points = mPathgrid->mPoints;
+        const int column = getColumn(pos.x());
+        const int row = getRow(pos.y());
+
+        int closestIndex = -1;
+        float closest = std::numeric_limits<float>::max();
+
+        // search rings of buckets around the bucket of pos, until no bucket outside can hold a closer point
+        for (int ring = 0; ; ++ring)
+        {
+            const int minColumn = column - ring;
+            const int maxColumn = column + ring;
+            const int minRow = row - ring;
+            const int maxRow = row + ring;
+
+            for (int r = std::max(minRow, 0); r <= std::min(maxRow, mRows - 1); ++r)
+            {
+                // inner rows of the ring only have a bucket on either end
+                const int step = (r == minRow || r == maxRow) ? 1 : std::max(1, maxColumn - minColumn);
+                for (int c = minColumn; c <= maxColumn; c += step)
+                {
+                    if (c < 0 || c >= mColumns)
+                        continue;
+
+                    const int bucket = r * mColumns + c;
+                    for (int i = mBucketStarts[bucket]; i < mBucketStarts[bucket + 1]; ++i)
+                    {
+                        const int index = mPoints[i];
+                        const float distance = distanceSquared(points[index], pos);
+                        if (distance < closest || (distance == closest && index < closestIndex))
+                        {
+                            closest = distance;
+                            closestIndex = index;
+                        }
+                    }
+                }
+            }
+
+            // distance from pos to the nearest bucket not searched yet
+            float bound = std::numeric_limits<float>::max();
+            bool searchedAll = true;
+            if (minColumn > 0)
+            {
+                bound = std::min(bound, pos.x() - (mMinX + minColumn * mBucketSize));
+                searchedAll = false;
+            }
+            if (maxColumn < mColumns - 1)
+            {
+                bound = std::min(bound, mMinX + (maxColumn + 1) * mBucketSize - pos.x());
+                searchedAll = false;
+            }
+            if (minRow > 0)
+            {
+                bound = std::min(bound, pos.y() - (mMinY + minRow * mBucketSize));
+                searchedAll = false;
+            }
+            if (maxRow < mRows - 1)
+            {
+                bound = std::min(bound, mMinY + (maxRow + 1) * mBucketSize - pos.y());
+                searchedAll = false;
+            }
+
+            // on equal distance a point outside might have a lower index, so keep searching
+            if (searchedAll || (closestIndex >= 0 && bound > 0 && bound * bound > closest))
+                break;
+        }
+
+        return closestIndex;
+    }
+
+    void PathgridPointIndex::getPointsInRange(const osg::Vec3f& pos, float radius, std::vector<int>& points) const
+    {
+        if (mPoints.empty() || radius < 0)
+            return;
+
+        const size_t first = points.size();
+        const float radius2 = radius * radius;
+
+        const int maxRow = getRow(pos.y() + radius);
+        const int maxColumn = getColumn(pos.x() + radius);
+        for (int r = getRow(pos.y() - radius); r <= maxRow; ++r)
+        {
+            for (int c = getColumn(pos.x() - radius); c <= maxColumn; ++c)
+            {
+                const int bucket = r * mColumns + c;
+                for (int i = mBucketStarts[bucket]; i < mBucketStarts[bucket + 1]; ++i)
+                {
+                    if (distanceSquared(mPathgrid->mPoints[mPoints[i]], pos) <= radius2)
+                        points.push_back(mPoints[i]);
+                }
+            }
+        }
+
+        std::sort(points.begin() + first, points.end());
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef GAME_MWMECHANICS_PATHGRIDINDEX_H
+#define GAME_MWMECHANICS_PATHGRIDINDEX_H
+
+#include <vector>
+
+#include <osg/Vec3f>
+
+#include <components/esm/loadpgrd.hpp>
+
+namespace MWMechanics
+{
+    /// \brief Uniform grid over the points of a pathgrid, for finding points by position
+    ///
+    /// The points are sorted into square buckets by their x and y coordinates, so a query only looks at the
+    /// buckets around the position instead of all points. Distances are still measured in 3D.
+    ///
+    /// @note Positions are in the coordinates of the pathgrid, i.e. local coordinates for exterior cells.
+    class PathgridPointIndex
+    {
+        public:
+            PathgridPointIndex();
+
+            /// Sort the points of \a pathgrid into buckets. \a pathgrid may be NULL.
+            void build(const ESM::Pathgrid* pathgrid);
+
+            /// Get the index of the point closest to \a pos, or -1 if there are no points. Of points at the same
+            /// distance, the one with the lowest index is returned.
+            int getClosestPoint(const osg::Vec3f& pos) const;
+
+            /// Append the indexes of all points within \a radius of \a pos to \a points, in ascending order.
+            void getPointsInRange(const osg::Vec3f& pos, float radius, std::vector<int>& points) const;
+
+        private:
+            int getColumn(float x) const;
+            int getRow(float y) const;
+
+            const ESM::Pathgrid* mPathgrid;
+
+            float mMinX;
+            float mMinY;
+            float mBucketSize;
+            int mColumns;
+            int mRows;
+
+            // points of bucket i are mPoints[mBucketStarts[i]] to mPoints[mBucketStarts[i+1]-1]
+            std::vector<int> mBucketStarts;
+            std::vector<int> mPoints;
+    };
+}
+
+#endif
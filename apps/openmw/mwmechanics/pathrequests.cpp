@@ -0,0 +1,240 @@
+#include "pathrequests.hpp"
+
+#include <limits>
+
+#include <OpenThreads/ScopedLock>
+
+#include "pathfinding.hpp"
+#include "coordinateconverter.hpp"
+
+namespace
+{
+    // Chooses a reachable end pathgrid point.  start is assumed reachable.
+    std::pair<int, bool> getClosestReachablePoint(const ESM::Pathgrid* grid,
+                                                  const MWMechanics::PathgridGraph *graph,
+                                                  const osg::Vec3f& pos, int start)
+    {
+        assert(grid && !grid->mPoints.empty());
+
+        float closestDistanceBetween = std::numeric_limits<float>::max();
+        float closestDistanceReachable = std::numeric_limits<float>::max();
+        int closestIndex = 0;
+        int closestReachableIndex = 0;
+        // TODO: if this full scan causes performance problems mapping pathgrid
+        //       points to a quadtree may help
+        for(unsigned int counter = 0; counter < grid->mPoints.size(); counter++)
+        {
+            float potentialDistBetween = MWMechanics::PathFinder::DistanceSquared(grid->mPoints[counter], pos);
+            if (potentialDistBetween < closestDistanceReachable)
+            {
+                // found a closer one
+                if (graph->isPointConnected(start, counter))
+                {
+                    closestDistanceReachable = potentialDistBetween;
+                    closestReachableIndex = counter;
+                }
+                if (potentialDistBetween < closestDistanceBetween)
+                {
+                    closestDistanceBetween = potentialDistBetween;
+                    closestIndex = counter;
+                }
+            }
+        }
+
+        // post-condition: start and endpoint must be connected
+        assert(graph->isPointConnected(start, closestReachableIndex));
+
+        // AiWander has logic that depends on whether a path was created, deleting
+        // allowed nodes if not.  Hence a path needs to be created even if the start
+        // and the end points are the same.
+
+        return std::pair<int, bool>
+            (closestReachableIndex, closestReachableIndex == closestIndex);
+    }
+}
+
+namespace MWMechanics
+{
+    void buildPathgridPath(const ESM::Pathgrid::Point &startPoint,
+                           const ESM::Pathgrid::Point &endPoint,
+                           const ESM::Cell* cell, const PathgridGraph& pathgridGraph,
+                           std::deque<ESM::Pathgrid::Point>& path,
+                           ESM::Pathgrid::PointList& searchResult,
+                           PathgridGraph::SearchState* searchState)
+    {
+        const ESM::Pathgrid* pathgrid = pathgridGraph.getPathgrid();
+
+        // Refer to AiWander reseach topic on openmw forums for some background.
+        // Maybe there is no pathgrid for this cell.  Just go to destination and let
+        // physics take care of any blockages.
+        if(!pathgrid || pathgrid->mPoints.empty())
+        {
+            path.push_back(endPoint);
+            return;
+        }
+
+        // NOTE: GetClosestPoint expects local coordinates
+        CoordinateConverter converter(cell);
+
+        // NOTE: It is possible that GetClosestPoint returns a pathgrind point index
+        //       that is unreachable in some situations. e.g. actor is standing
+        //       outside an area enclosed by walls, but there is a pathgrid
+        //       point right behind the wall that is closer than any pathgrid
+        //       point outside the wall
+        osg::Vec3f startPointInLocalCoords(converter.toLocalVec3(startPoint));
+        int startNode = pathgridGraph.getPointIndex().getClosestPoint(startPointInLocalCoords);
+
+        osg::Vec3f endPointInLocalCoords(converter.toLocalVec3(endPoint));
+        std::pair<int, bool> endNode = getClosestReachablePoint(pathgrid, &pathgridGraph,
+            endPointInLocalCoords,
+                startNode);
+
+        // if it's shorter for actor to travel from start to end, than to travel from either
+        // start or end to nearest pathgrid point, just travel from start to end.
+        float startToEndLength2 = (endPointInLocalCoords - startPointInLocalCoords).length2();
+        float endTolastNodeLength2 = PathFinder::DistanceSquared(pathgrid->mPoints[endNode.first], endPointInLocalCoords);
+        float startTo1stNodeLength2 = PathFinder::DistanceSquared(pathgrid->mPoints[startNode], startPointInLocalCoords);
+        if ((startToEndLength2 < startTo1stNodeLength2) || (startToEndLength2 < endTolastNodeLength2))
+        {
+            path.push_back(endPoint);
+            return;
+        }
+
+        // AiWander has logic that depends on whether a path was created,
+        // deleting allowed nodes if not.  Hence a path needs to be created
+        // even if the start and the end points are the same.
+        // NOTE: aStarSearch will return an empty path if the start and end
+        //       nodes are the same
+        if(startNode == endNode.first)
+        {
+            ESM::Pathgrid::Point temp(pathgrid->mPoints[startNode]);
+            converter.toWorld(temp);
+            path.push_back(temp);
+        }
+        else
+        {
+            searchResult.clear();
+            if (searchState)
+                pathgridGraph.aStarSearch(startNode, endNode.first, searchResult, *searchState);
+            else
+                pathgridGraph.aStarSearch(startNode, endNode.first, searchResult);
+
+            // convert supplied path to world coordinates
+            for (ESM::Pathgrid::PointList::iterator iter(searchResult.begin()); iter != searchResult.end(); ++iter)
+            {
+                converter.toWorld(*iter);
+            }
+
+            path.insert(path.end(), searchResult.begin(), searchResult.end());
+        }
+
+        // If endNode found is NOT the closest PathGrid point to the endPoint,
+        // assume endPoint is not reachable from endNode. In which case, 
+        // path ends at endNode.
+        //
+        // So only add the destination (which may be different to the closest
+        // pathgrid point) when endNode was the closest point to endPoint.
+        //
+        // This logic can fail in the opposite situate, e.g. endPoint may
+        // have been reachable but happened to be very close to an
+        // unreachable pathgrid point.
+        //
+        // The AI routines will have to deal with such situations.
+        if(endNode.second)
+            path.push_back(endPoint);
+    }
+
+    PathRequest::PathRequest(const ESM::Pathgrid::Point& start, const ESM::Pathgrid::Point& end,
+                             const ESM::Cell* cell, const PathgridGraph& pathgridGraph, PathRequestQueue* queue)
+        : mStart(start)
+        , mEnd(end)
+        , mCell(cell)
+        , mPathgridGraph(pathgridGraph)
+        , mQueue(queue)
+    {
+    }
+
+    void PathRequest::doWork()
+    {
+        if (mAborted > 0)
+        {
+            mQueue->onDone(false);
+            return;
+        }
+
+        std::unique_ptr<PathgridGraph::SearchState> state = mQueue->acquireSearchState();
+        ESM::Pathgrid::PointList searchResult;
+        buildPathgridPath(mStart, mEnd, mCell, mPathgridGraph, mPath, searchResult, state.get());
+        mQueue->releaseSearchState(std::move(state));
+
+        mQueue->onDone(true);
+    }
+
+    void PathRequest::abort()
+    {
+        mAborted.exchange(1);
+    }
+
+    const std::deque<ESM::Pathgrid::Point>& PathRequest::getPath() const
+    {
+        return mPath;
+    }
+
+    PathRequestQueue::PathRequestQueue(int numThreads)
+        : mNumCompletedLastFrame(0)
+        , mWorkQueue(new SceneUtil::WorkQueue(numThreads))
+    {
+    }
+
+    PathRequestQueue::~PathRequestQueue()
+    {
+    }
+
+    osg::ref_ptr<PathRequest> PathRequestQueue::request(const ESM::Pathgrid::Point& start, const ESM::Pathgrid::Point& end,
+                                                        const ESM::Cell* cell, const PathgridGraph& pathgridGraph)
+    {
+        osg::ref_ptr<PathRequest> item = new PathRequest(start, end, cell, pathgridGraph, this);
+        ++mNumPending;
+        mWorkQueue->addWorkItem(item);
+        return item;
+    }
+
+    void PathRequestQueue::update()
+    {
+        mNumCompletedLastFrame = mNumCompleted.exchange(0);
+    }
+
+    unsigned int PathRequestQueue::getNumCompleted() const
+    {
+        return mNumCompletedLastFrame;
+    }
+
+    unsigned int PathRequestQueue::getNumPending() const
+    {
+        return mNumPending;
+    }
+
+    std::unique_ptr<PathgridGraph::SearchState> PathRequestQueue::acquireSearchState()
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        if (mSearchStates.empty())
+            return std::unique_ptr<PathgridGraph::SearchState>(new PathgridGraph::SearchState);
+
+        std::unique_ptr<PathgridGraph::SearchState> state = std::move(mSearchStates.back());
+        mSearchStates.pop_back();
+        return state;
+    }
+
+    void PathRequestQueue::releaseSearchState(std::unique_ptr<PathgridGraph::SearchState> state)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        mSearchStates.push_back(std::move(state));
+    }
+
+    void PathRequestQueue::onDone(bool completed)
+    {
+        if (completed)
+            ++mNumCompleted;
+        --mNumPending;
+    }
+}
@@ -0,0 +1,114 @@
+#ifndef GAME_MWMECHANICS_PATHREQUESTS_H
+#define GAME_MWMECHANICS_PATHREQUESTS_H
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <OpenThreads/Atomic>
+#include <OpenThreads/Mutex>
+
+#include <osg/ref_ptr>
+
+#include <components/esm/loadpgrd.hpp>
+#include <components/sceneutil/workqueue.hpp>
+
+#include "pathgrid.hpp"
+
+namespace ESM
+{
+    struct Cell;
+}
+
+namespace MWMechanics
+{
+    class PathRequestQueue;
+
+    /// Build a path through the pathgrid of \a cell into \a path, like PathFinder::buildPath does for a
+    /// destination in the same cell. Only uses its arguments, so it is safe to call from any thread.
+    ///
+    /// @param searchResult Scratch buffer
+    /// @param searchState Scratch buffers of the A* search; NULL to use the ones of the main thread
+    void buildPathgridPath(const ESM::Pathgrid::Point &startPoint, const ESM::Pathgrid::Point &endPoint,
+                           const ESM::Cell* cell, const PathgridGraph& pathgridGraph,
+                           std::deque<ESM::Pathgrid::Point>& path,
+                           ESM::Pathgrid::PointList& searchResult,
+                           PathgridGraph::SearchState* searchState);
+
+    /// \brief Search for a path through the pathgrid of one cell, done on a worker thread
+    ///
+    /// The request is its own future: poll isDone() and then take the result from getPath().
+    ///
+    /// The search only reads the cell record and the pathgrid graph. Both are immutable once created (see
+    /// AiPackage::getPathGridGraph), so the worker can use them while the main thread goes on.
+    class PathRequest : public SceneUtil::WorkItem
+    {
+        public:
+            PathRequest(const ESM::Pathgrid::Point& start, const ESM::Pathgrid::Point& end, const ESM::Cell* cell,
+                        const PathgridGraph& pathgridGraph, PathRequestQueue* queue);
+
+            virtual void doWork();
+
+            /// Skip the search if it has not started yet, for requests nobody waits for anymore.
+            virtual void abort();
+
+            /// The path in world coordinates, as built by PathFinder::buildPath.
+            /// @note Only valid once isDone() returns true.
+            const std::deque<ESM::Pathgrid::Point>& getPath() const;
+
+        private:
+            ESM::Pathgrid::Point mStart;
+            ESM::Pathgrid::Point mEnd;
+            const ESM::Cell* mCell;
+            const PathgridGraph& mPathgridGraph;
+            PathRequestQueue* mQueue;
+
+            OpenThreads::Atomic mAborted;
+
+            std::deque<ESM::Pathgrid::Point> mPath;
+    };
+
+    /// \brief Runs PathRequests on worker threads
+    class PathRequestQueue
+    {
+        public:
+            PathRequestQueue(int numThreads);
+            ~PathRequestQueue();
+
+            /// Queue a search for a path from \a start to \a end in \a cell. All points are in world coordinates.
+            osg::ref_ptr<PathRequest> request(const ESM::Pathgrid::Point& start, const ESM::Pathgrid::Point& end,
+                                              const ESM::Cell* cell, const PathgridGraph& pathgridGraph);
+
+            /// Start counting the requests completed in a new frame. Call once per frame from the main thread.
+            void update();
+
+            /// Number of requests completed during the last frame.
+            unsigned int getNumCompleted() const;
+
+            /// Number of requests queued or in progress.
+            unsigned int getNumPending() const;
+
+        private:
+            friend class PathRequest;
+
+            /// Take a search state that no other worker is using.
+            std::unique_ptr<PathgridGraph::SearchState> acquireSearchState();
+
+            void releaseSearchState(std::unique_ptr<PathgridGraph::SearchState> state);
+
+            /// Called by a request on its worker thread when it is finished or aborted.
+            void onDone(bool completed);
+
+            OpenThreads::Mutex mMutex;
+            std::vector<std::unique_ptr<PathgridGraph::SearchState> > mSearchStates; // not in use by a worker
+
+            OpenThreads::Atomic mNumPending;
+            OpenThreads::Atomic mNumCompleted; // since the last update()
+            unsigned int mNumCompletedLastFrame;
+
+            // declared last, so the worker threads are joined before the members above go away
+            osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+    };
+}
+
+#endif
@@ -0,0 +1,69 @@
+#include "heightfield.hpp"
+
+#include <vector>
+
+#include <BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
+#include <BulletCollision/CollisionDispatch/btCollisionObject.h>
+
+#include <components/esm/loadland.hpp>
+#include <components/esmterrain/storage.hpp>
+
+namespace
+{
+    const std::vector<float>& getDefaultHeights()
+    {
+        static const std::vector<float> defaultHeight (ESM::Land::LAND_SIZE*ESM::Land::LAND_SIZE, ESM::Land::DEFAULT_HEIGHT);
+        return defaultHeight;
+    }
+}
+
+namespace MWPhysics
+{
+
+    HeightField::HeightField(const float* heights, int x, int y, float triSize, float sqrtVerts, float minH, float maxH, const osg::Object* holdObject)
+        : mHoldObject(holdObject)
+        , mX(x)
+        , mY(y)
+    {
+        mShape = new btHeightfieldTerrainShape(
+            sqrtVerts, sqrtVerts, heights, 1,
+            minH, maxH, 2,
+            PHY_FLOAT, false
+        );
+        mShape->setUseDiamondSubdivision(true);
+        mShape->setLocalScaling(btVector3(triSize, triSize, 1));
+
+        btTransform transform(btQuaternion::getIdentity(),
+                              btVector3((x+0.5f) * triSize * (sqrtVerts-1),
+                                        (y+0.5f) * triSize * (sqrtVerts-1),
+                                        (maxH+minH)*0.5f));
+
+        mCollisionObject = new btCollisionObject;
+        mCollisionObject->setCollisionShape(mShape);
+        mCollisionObject->setWorldTransform(transform);
+    }
+
+    HeightField::~HeightField()
+    {
+        delete mCollisionObject;
+        delete mShape;
+    }
+
+    osg::ref_ptr<HeightField> HeightField::create(const ESMTerrain::LandObject* land, int x, int y)
+    {
+        const float verts = ESM::Land::LAND_SIZE;
+        const float worldsize = ESM::Land::REAL_SIZE;
+
+        const ESM::Land::LandData* data = land ? land->getData(ESM::Land::DATA_VHGT) : 0;
+        if (data)
+            return new HeightField(data->mHeights, x, y, worldsize / (verts-1), verts, data->mMinHeight, data->mMaxHeight, land);
+        else
+            return new HeightField(&getDefaultHeights()[0], x, y, worldsize / (verts-1), verts, ESM::Land::DEFAULT_HEIGHT, ESM::Land::DEFAULT_HEIGHT, land);
+    }
+
+    btCollisionObject* HeightField::getCollisionObject()
+    {
+        return mCollisionObject;
+    }
+
+}
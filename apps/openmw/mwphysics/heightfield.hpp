@@ -0,0 +1,50 @@
+#ifndef OPENMW_MWPHYSICS_HEIGHTFIELD_H
+#define OPENMW_MWPHYSICS_HEIGHTFIELD_H
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+#include <osg/Object>
+
+class btCollisionObject;
+class btHeightfieldTerrainShape;
+
+namespace ESMTerrain
+{
+    class LandObject;
+}
+
+namespace MWPhysics
+{
+
+    /// @brief Collision shape for the terrain of one exterior cell.
+    /// @note Creating a HeightField does not touch the collision world, so it is safe to do in a background thread.
+    class HeightField : public osg::Referenced
+    {
+    public:
+        HeightField(const float* heights, int x, int y, float triSize, float sqrtVerts, float minH, float maxH, const osg::Object* holdObject);
+
+        /// Create the height field for cell \a x, \a y from the given land data, or a flat height field at the default height if \a land has no height data.
+        static osg::ref_ptr<HeightField> create(const ESMTerrain::LandObject* land, int x, int y);
+
+        btCollisionObject* getCollisionObject();
+
+        int getX() const { return mX; }
+        int getY() const { return mY; }
+
+    protected:
+        virtual ~HeightField();
+
+    private:
+        btHeightfieldTerrainShape* mShape;
+        btCollisionObject* mCollisionObject;
+        osg::ref_ptr<const osg::Object> mHoldObject;
+        int mX;
+        int mY;
+
+        void operator=(const HeightField&);
+        HeightField(const HeightField&);
+    };
+
+}
+
+#endif
@@ -23,6 +23,7 @@
 #include <components/resource/bulletshapemanager.hpp>
 
 #include <components/esm/loadgmst.hpp>
+#include <components/esm/loadland.hpp>
 #include <components/sceneutil/positionattitudetransform.hpp>
 #include <components/sceneutil/unrefqueue.hpp>
 
@@ -48,6 +49,7 @@
 #include "collisiontype.hpp"
 #include "actor.hpp"
 #include "convert.hpp"
+#include "heightfield.hpp"
 #include "trace.h"
 
 namespace MWPhysics
@@ -506,51 +508,6 @@ namespace MWPhysics
 
     // ---------------------------------------------------------------
 
-    class HeightField
-    {
-    public:
-        HeightField(const float* heights, int x, int y, float triSize, float sqrtVerts, float minH, float maxH, const osg::Object* holdObject)
-        {
-            mShape = new btHeightfieldTerrainShape(
-                sqrtVerts, sqrtVerts, heights, 1,
-                minH, maxH, 2,
-                PHY_FLOAT, false
-            );
-            mShape->setUseDiamondSubdivision(true);
-            mShape->setLocalScaling(btVector3(triSize, triSize, 1));
-
-            btTransform transform(btQuaternion::getIdentity(),
-                                  btVector3((x+0.5f) * triSize * (sqrtVerts-1),
-                                            (y+0.5f) * triSize * (sqrtVerts-1),
-                                            (maxH+minH)*0.5f));
-
-            mCollisionObject = new btCollisionObject;
-            mCollisionObject->setCollisionShape(mShape);
-            mCollisionObject->setWorldTransform(transform);
-
-            mHoldObject = holdObject;
-        }
-        ~HeightField()
-        {
-            delete mCollisionObject;
-            delete mShape;
-        }
-        btCollisionObject* getCollisionObject()
-        {
-            return mCollisionObject;
-        }
-
-    private:
-        btHeightfieldTerrainShape* mShape;
-        btCollisionObject* mCollisionObject;
-        osg::ref_ptr<const osg::Object> mHoldObject;
-
-        void operator=(const HeightField&);
-        HeightField(const HeightField&);
-    };
-
-    // --------------------------------------------------------------
-
     class Object : public PtrHolder
     {
     public:
@@ -718,10 +675,11 @@ namespace MWPhysics
             mCollisionWorld->removeCollisionObject(mWaterCollisionObject.get());
 
         for (HeightFieldMap::iterator it = mHeightFields.begin(); it != mHeightFields.end(); ++it)
-        {
             mCollisionWorld->removeCollisionObject(it->second->getCollisionObject());
-            delete it->second;
-        }
+        for (HeightFieldMap::iterator it = mDeferredHeightFields.begin(); it != mDeferredHeightFields.end(); ++it)
+            mCollisionWorld->removeCollisionObject(it->second->getCollisionObject());
+        mHeightFields.clear();
+        mDeferredHeightFields.clear();
 
         for (ObjectMap::iterator it = mObjects.begin(); it != mObjects.end(); ++it)
         {
@@ -1141,22 +1099,89 @@ namespace MWPhysics
 
     void PhysicsSystem::addHeightField (const float* heights, int x, int y, float triSize, float sqrtVerts, float minH, float maxH, const osg::Object* holdObject)
     {
-        HeightField *heightfield = new HeightField(heights, x, y, triSize, sqrtVerts, minH, maxH, holdObject);
-        mHeightFields[std::make_pair(x,y)] = heightfield;
+        addHeightField(new HeightField(heights, x, y, triSize, sqrtVerts, minH, maxH, holdObject));
+    }
+
+    void PhysicsSystem::addHeightField (osg::ref_ptr<HeightField> heightField, bool deferCollision)
+    {
+        std::pair<int, int> key = std::make_pair(heightField->getX(), heightField->getY());
+        removeHeightField(key.first, key.second);
+
+        if (deferCollision)
+        {
+            // ray casts and projectiles still hit the terrain, only actor sweeps ignore it until activated
+            mCollisionWorld->addCollisionObject(heightField->getCollisionObject(), CollisionType_HeightMap,
+                CollisionType_Projectile);
+            mDeferredHeightFields[key] = heightField;
+            activateHeightFields();
+            return;
+        }
 
-        mCollisionWorld->addCollisionObject(heightfield->getCollisionObject(), CollisionType_HeightMap,
+        mHeightFields[key] = heightField;
+
+        mCollisionWorld->addCollisionObject(heightField->getCollisionObject(), CollisionType_HeightMap,
             CollisionType_Actor|CollisionType_Projectile);
     }
 
     void PhysicsSystem::removeHeightField (int x, int y)
     {
-        HeightFieldMap::iterator heightfield = mHeightFields.find(std::make_pair(x,y));
+        std::pair<int, int> key = std::make_pair(x,y);
+        HeightFieldMap::iterator heightfield = mHeightFields.find(key);
         if(heightfield != mHeightFields.end())
         {
             mCollisionWorld->removeCollisionObject(heightfield->second->getCollisionObject());
-            delete heightfield->second;
+            if (mUnrefQueue.get())
+                mUnrefQueue->push(heightfield->second);
             mHeightFields.erase(heightfield);
         }
+
+        heightfield = mDeferredHeightFields.find(key);
+        if (heightfield != mDeferredHeightFields.end())
+        {
+            mCollisionWorld->removeCollisionObject(heightfield->second->getCollisionObject());
+            if (mUnrefQueue.get())
+                mUnrefQueue->push(heightfield->second);
+            mDeferredHeightFields.erase(heightfield);
+        }
+    }
+
+    bool PhysicsSystem::isHeightFieldActive (int x, int y) const
+    {
+        return mHeightFields.find(std::make_pair(x,y)) != mHeightFields.end();
+    }
+
+    void PhysicsSystem::activateHeightFields()
+    {
+        if (mDeferredHeightFields.empty())
+            return;
+
+        for (ActorMap::const_iterator it = mActors.begin(); it != mActors.end() && !mDeferredHeightFields.empty(); ++it)
+            activateHeightFields(it->second->getPosition());
+    }
+
+    void PhysicsSystem::activateHeightFields (const osg::Vec3f& position)
+    {
+        // Activate collision for any cell whose bounds, expanded by the activation margin, contain the position.
+        // The margin is generous enough that an actor can't cross it within a single frame.
+        static const float activationMargin = ESM::Land::REAL_SIZE / 4.f;
+
+        for (HeightFieldMap::iterator it = mDeferredHeightFields.begin(); it != mDeferredHeightFields.end();)
+        {
+            float minX = it->first.first * ESM::Land::REAL_SIZE - activationMargin;
+            float minY = it->first.second * ESM::Land::REAL_SIZE - activationMargin;
+            float maxX = (it->first.first+1) * ESM::Land::REAL_SIZE + activationMargin;
+            float maxY = (it->first.second+1) * ESM::Land::REAL_SIZE + activationMargin;
+            if (position.x() >= minX && position.x() <= maxX && position.y() >= minY && position.y() <= maxY)
+            {
+                mCollisionWorld->removeCollisionObject(it->second->getCollisionObject());
+                mCollisionWorld->addCollisionObject(it->second->getCollisionObject(), CollisionType_HeightMap,
+                    CollisionType_Actor|CollisionType_Projectile);
+                mHeightFields[it->first] = it->second;
+                mDeferredHeightFields.erase(it++);
+            }
+            else
+                ++it;
+        }
     }
 
     void PhysicsSystem::addObject (const MWWorld::Ptr& ptr, const std::string& mesh, int collisionType)
@@ -1314,6 +1339,7 @@ namespace MWPhysics
         ActorMap::iterator foundActor = mActors.find(ptr);
         if (foundActor != mActors.end())
         {
+            activateHeightFields(ptr.getRefData().getPosition().asVec3());
             foundActor->second->updatePosition();
             mCollisionWorld->updateSingleAabb(foundActor->second->getCollisionObject());
             return;
@@ -1325,6 +1351,9 @@ namespace MWPhysics
         if (!shape)
             return;
 
+        // make sure the terrain under the actor is collidable before it gets placed
+        activateHeightFields(ptr.getRefData().getPosition().asVec3());
+
         Actor* actor = new Actor(ptr, shape, mCollisionWorld);
         mActors.insert(std::make_pair(ptr, actor));
     }
@@ -1420,6 +1449,7 @@ namespace MWPhysics
 
             bool wasOnGround = physicActor->getOnGround();
             osg::Vec3f position = physicActor->getPosition();
+            activateHeightFields(position);
             float oldHeight = position.z();
             bool positionChanged = false;
             for (int i=0; i<numSteps; ++i)
@@ -83,8 +83,16 @@ namespace MWPhysics
 
             void addHeightField (const float* heights, int x, int y, float triSize, float sqrtVerts, float minH, float maxH, const osg::Object* holdObject);
 
+            /// Add a height field that was created in advance, e.g. by the cell preloader.
+            /// @param deferCollision Don't collide actors with the height field until an actor comes within range of its cell.
+            /// Ray casts and projectiles collide with it right away.
+            void addHeightField (osg::ref_ptr<HeightField> heightField, bool deferCollision=false);
+
             void removeHeightField (int x, int y);
 
+            /// Do actors collide with the height field for this cell?
+            bool isHeightFieldActive (int x, int y) const;
+
             bool toggleCollisionMode();
 
             void stepSimulation(float dt);
@@ -174,6 +182,10 @@ namespace MWPhysics
 
             void updateWater();
 
+            /// Let actors collide with the deferred height fields near any actor.
+            void activateHeightFields();
+            void activateHeightFields(const osg::Vec3f& position);
+
             osg::ref_ptr<SceneUtil::UnrefQueue> mUnrefQueue;
 
             btBroadphaseInterface* mBroadphase;
@@ -192,9 +204,12 @@ namespace MWPhysics
             typedef std::map<MWWorld::ConstPtr, Actor*> ActorMap;
             ActorMap mActors;
 
-            typedef std::map<std::pair<int, int>, HeightField*> HeightFieldMap;
+            typedef std::map<std::pair<int, int>, osg::ref_ptr<HeightField> > HeightFieldMap;
             HeightFieldMap mHeightFields;
 
+            // Height fields of distant cells, which actors don't collide with yet
+            HeightFieldMap mDeferredHeightFields;
+
             bool mDebugDrawEnabled;
 
             // Tracks standing collisions happening during a single frame. <actor handle, collided handle>
@@ -852,9 +852,8 @@ namespace MWRender
         return mNodeMap;
     }
 
-    void Animation::resetActiveGroups()
+    void Animation::removeActiveControllers()
     {
-        // remove all previous external controllers from the scene graph
         for (ControllerMap::iterator it = mActiveControllers.begin(); it != mActiveControllers.end(); ++it)
         {
             osg::Node* node = it->first;
@@ -865,6 +864,12 @@ namespace MWRender
         }
 
         mActiveControllers.clear();
+    }
+
+    void Animation::resetActiveGroups()
+    {
+        // remove all previous external controllers from the scene graph
+        removeActiveControllers();
 
         mAccumCtrl = NULL;
 
@@ -1162,7 +1167,7 @@ namespace MWRender
             return sceneMgr->createInstance(model);
     }
 
-    void Animation::setObjectRoot(const std::string &model, bool forceskeleton, bool baseonly, bool isCreature)
+    osg::ref_ptr<osg::StateSet> Animation::resetObjectRoot()
     {
         osg::ref_ptr<osg::StateSet> previousStateset;
         if (mObjectRoot)
@@ -1181,6 +1186,13 @@ namespace MWRender
         mAccumRoot = NULL;
         mAccumCtrl = NULL;
 
+        return previousStateset;
+    }
+
+    void Animation::setObjectRoot(const std::string &model, bool forceskeleton, bool baseonly, bool isCreature)
+    {
+        osg::ref_ptr<osg::StateSet> previousStateset = resetObjectRoot();
+
         if (!forceskeleton)
         {
             osg::ref_ptr<osg::Node> created = getModelInstance(mResourceSystem->getSceneManager(), model, baseonly);
@@ -1226,6 +1238,32 @@ namespace MWRender
         mObjectRoot->addCullCallback(mLightListCallback);
     }
 
+    void Animation::attachObjectRoot(osg::ref_ptr<osg::Group> root)
+    {
+        osg::ref_ptr<osg::StateSet> previousStateset = resetObjectRoot();
+
+        mObjectRoot = root;
+        mSkeleton = dynamic_cast<SceneUtil::Skeleton*>(root.get());
+        mInsert->addChild(mObjectRoot);
+
+        if (previousStateset)
+            mObjectRoot->setStateSet(previousStateset);
+
+        if (!mLightListCallback)
+            mLightListCallback = new SceneUtil::LightListCallback;
+        mObjectRoot->addCullCallback(mLightListCallback);
+    }
+
+    osg::ref_ptr<osg::Group> Animation::detachObjectRoot()
+    {
+        removeActiveControllers();
+        mHeadController = NULL;
+
+        osg::ref_ptr<osg::Group> root = mObjectRoot;
+        resetObjectRoot();
+        return root;
+    }
+
     osg::Group* Animation::getObjectRoot()
     {
         return mObjectRoot.get();
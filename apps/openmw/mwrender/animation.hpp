@@ -281,6 +281,12 @@ protected:
      */
     void resetActiveGroups();
 
+    /// Remove the controllers in mActiveControllers from the scene graph.
+    void removeActiveControllers();
+
+    /// Remove the current root model, returning its StateSet.
+    osg::ref_ptr<osg::StateSet> resetObjectRoot();
+
     size_t detectBlendMask(const osg::Node* node) const;
 
     /* Updates the position of the accum root node for the given time, and
@@ -309,6 +315,16 @@ protected:
      */
     void setObjectRoot(const std::string &model, bool forceskeleton, bool baseonly, bool isCreature);
 
+    /** Sets a root model that was assembled before, e.g. by another Animation, see detachObjectRoot().
+     * The same notes apply as for setObjectRoot().
+     */
+    void attachObjectRoot(osg::ref_ptr<osg::Group> root);
+
+    /** Removes the root model of the object, along with the controllers this Animation added to it,
+     * so another Animation can attach it. Animation sources must be cleared before.
+     */
+    osg::ref_ptr<osg::Group> detachObjectRoot();
+
     /** Adds the keyframe controllers in the specified model as a new animation source.
      * @note Later added animation sources have the highest priority when it comes to finding a particular animation.
      * @param model The file to add the keyframes for. Note that the .nif file extension will be replaced with .kf.
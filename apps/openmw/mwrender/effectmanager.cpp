@@ -53,30 +53,34 @@ void EffectManager::addEffect(const std::string &model, const std::string& textu
 
     mParentNode->addChild(trans);
 
-    mEffects[trans] = effect;
+    effect.mTransform = trans;
+    mEffects.push_back(effect);
 }
 
 void EffectManager::update(float dt)
 {
-    for (EffectMap::iterator it = mEffects.begin(); it != mEffects.end(); )
+    // the order of effects does not matter, so a finished effect is replaced by the last one
+    for (std::size_t i = 0; i < mEffects.size(); )
     {
-        it->second.mAnimTime->addTime(dt);
+        Effect& effect = mEffects[i];
+        effect.mAnimTime->addTime(dt);
 
-        if (it->second.mAnimTime->getTime() >= it->second.mMaxControllerLength)
+        if (effect.mAnimTime->getTime() >= effect.mMaxControllerLength)
         {
-            mParentNode->removeChild(it->first);
-            mEffects.erase(it++);
+            mParentNode->removeChild(effect.mTransform);
+            effect = mEffects.back();
+            mEffects.pop_back();
         }
         else
-            ++it;
+            ++i;
     }
 }
 
 void EffectManager::clear()
 {
-    for (EffectMap::iterator it = mEffects.begin(); it != mEffects.end(); ++it)
+    for (std::size_t i = 0; i < mEffects.size(); ++i)
     {
-        mParentNode->removeChild(it->first);
+        mParentNode->removeChild(mEffects[i].mTransform);
     }
     mEffects.clear();
 }
@@ -1,9 +1,9 @@
 #ifndef OPENMW_MWRENDER_EFFECTMANAGER_H
 #define OPENMW_MWRENDER_EFFECTMANAGER_H
 
-#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <osg/ref_ptr>
 
@@ -42,12 +42,12 @@ namespace MWRender
     private:
         struct Effect
         {
+            osg::ref_ptr<osg::PositionAttitudeTransform> mTransform;
             float mMaxControllerLength;
             std::shared_ptr<EffectAnimationTime> mAnimTime;
         };
 
-        typedef std::map<osg::ref_ptr<osg::PositionAttitudeTransform>, Effect> EffectMap;
-        EffectMap mEffects;
+        std::vector<Effect> mEffects;
 
         osg::ref_ptr<osg::Group> mParentNode;
         Resource::ResourceSystem* mResourceSystem;
@@ -0,0 +1,359 @@
+#include "instancedstatics.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <osg/Geometry>
+#include <osg/MatrixTransform>
+#include <osg/Uniform>
+
+#include <components/resource/scenemanager.hpp>
+#include <components/sceneutil/lightmanager.hpp>
+#include <components/sceneutil/unrefqueue.hpp>
+
+#include "staticgeometry.hpp"
+
+namespace
+{
+    // instances per draw call; each one takes three vec4 uniforms of the vertex shader
+    const int sMaxInstances = 16;
+
+    // a mesh needs this many objects in a cell to be worth batching
+    const unsigned int sMinObjects = 4;
+
+    // objects are batched with other objects in the same square of this size. Larger batches save more draw calls,
+    // but are culled and lit as a whole.
+    const float sBatchSize = 1024.f;
+
+    /// Cull callback that does not traverse the subgraph, so cameras skip it while other visitors do not.
+    /// @note Every node needs its own instance, as cull callbacks are chained through their nested callback.
+    class HideCallback : public osg::NodeCallback
+    {
+    public:
+        virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+        {
+        }
+    };
+
+    void hide(osg::Node* node)
+    {
+        node->addCullCallback(new HideCallback);
+    }
+
+    void unhide(osg::Node* node)
+    {
+        for (osg::Callback* callback = node->getCullCallback(); callback; callback = callback->getNestedCallback())
+        {
+            if (dynamic_cast<HideCallback*>(callback))
+            {
+                node->removeCullCallback(callback);
+                return;
+            }
+        }
+    }
+
+    /// Transform of a batch. The positions of the objects are only known to the shader, so only cull visitors
+    /// traverse the batch. Intersection tests and bounds computations use the subgraphs of the objects instead.
+    class BatchTransform : public osg::MatrixTransform
+    {
+    public:
+        BatchTransform()
+        {
+        }
+
+        BatchTransform(const osg::Matrix& matrix)
+            : osg::MatrixTransform(matrix)
+        {
+        }
+
+        BatchTransform(const BatchTransform& copy, const osg::CopyOp& copyop)
+            : osg::MatrixTransform(copy, copyop)
+        {
+        }
+
+        META_Node(MWRender, BatchTransform)
+
+        virtual void traverse(osg::NodeVisitor& nv)
+        {
+            if (nv.getVisitorType() == osg::NodeVisitor::CULL_VISITOR)
+                osg::MatrixTransform::traverse(nv);
+        }
+    };
+
+    /// Bounds of the instances of a geometry, which can not be computed from its vertices.
+    class InstancesBoundingBoxCallback : public osg::Drawable::ComputeBoundingBoxCallback
+    {
+    public:
+        InstancesBoundingBoxCallback(const osg::BoundingBox& box)
+            : mBox(box)
+        {
+        }
+
+        virtual osg::BoundingBox computeBound(const osg::Drawable&) const
+        {
+            return mBox;
+        }
+
+    private:
+        osg::BoundingBox mBox;
+    };
+
+    osg::Matrix getLocalMatrix(const osg::Node& node)
+    {
+        osg::Matrix matrix;
+        if (const osg::Transform* transform = node.asTransform())
+            transform->computeLocalToWorldMatrix(matrix, NULL);
+        return matrix;
+    }
+}
+
+namespace MWRender
+{
+
+    InstancedStatics::InstancedStatics(Resource::SceneManager* sceneManager, SceneUtil::UnrefQueue* unrefQueue)
+        : mSceneManager(sceneManager)
+        , mUnrefQueue(unrefQueue)
+    {
+    }
+
+    InstancedStatics::~InstancedStatics()
+    {
+    }
+
+    void InstancedStatics::add(const MWWorld::CellStore* cell, osg::Node* node, const std::string& mesh)
+    {
+        Cell& cellData = mCells[cell];
+        if (!cellData.mFinished)
+            cellData.mPending[mesh].push_back(node);
+    }
+
+    void InstancedStatics::finishCell(const MWWorld::CellStore* cell, osg::Group* cellNode)
+    {
+        Cell& cellData = mCells[cell];
+        cellData.mFinished = true;
+        cellData.mCellNode = cellNode;
+
+        for (std::map<std::string, std::vector<osg::ref_ptr<osg::Node> > >::const_iterator it = cellData.mPending.begin();
+             it != cellData.mPending.end(); ++it)
+        {
+            if (it->second.size() < sMinObjects)
+                continue;
+
+            osg::ref_ptr<Template> tmpl = getTemplate(it->first);
+            if (!tmpl->mValid)
+                continue;
+
+            typedef std::map<std::pair<int, int>, std::vector<osg::ref_ptr<osg::Node> > > SquareMap;
+            SquareMap squares;
+            for (std::vector<osg::ref_ptr<osg::Node> >::const_iterator objectIt = it->second.begin(); objectIt != it->second.end(); ++objectIt)
+            {
+                osg::Vec3f pos = getLocalMatrix(**objectIt).getTrans();
+                std::pair<int, int> square(static_cast<int>(std::floor(pos.x() / sBatchSize)),
+                                           static_cast<int>(std::floor(pos.y() / sBatchSize)));
+                squares[square].push_back(*objectIt);
+            }
+
+            for (SquareMap::const_iterator squareIt = squares.begin(); squareIt != squares.end(); ++squareIt)
+            {
+                const std::vector<osg::ref_ptr<osg::Node> >& objects = squareIt->second;
+                if (objects.size() < 2)
+                    continue;
+
+                // split evenly, rather than leaving a small rest
+                size_t numBatches = (objects.size() + sMaxInstances - 1) / sMaxInstances;
+                for (size_t i=0; i<numBatches; ++i)
+                {
+                    std::vector<osg::ref_ptr<osg::Node> > batchObjects(objects.begin() + objects.size() * i / numBatches,
+                                                                      objects.begin() + objects.size() * (i+1) / numBatches);
+                    createBatch(cell, tmpl, batchObjects);
+                }
+            }
+        }
+
+        cellData.mPending.clear();
+    }
+
+    void InstancedStatics::remove(osg::Node* node)
+    {
+        for (std::map<const MWWorld::CellStore*, Cell>::iterator cellIt = mCells.begin(); cellIt != mCells.end(); ++cellIt)
+        {
+            if (cellIt->second.mFinished)
+                continue;
+
+            for (std::map<std::string, std::vector<osg::ref_ptr<osg::Node> > >::iterator it = cellIt->second.mPending.begin();
+                 it != cellIt->second.mPending.end(); ++it)
+            {
+                std::vector<osg::ref_ptr<osg::Node> >::iterator found = std::find(it->second.begin(), it->second.end(), node);
+                if (found != it->second.end())
+                {
+                    it->second.erase(found);
+                    return;
+                }
+            }
+        }
+
+        std::map<const osg::Node*, BatchRef>::iterator found = mBatchOfObject.find(node);
+        if (found == mBatchOfObject.end())
+            return;
+
+        Cell& cellData = mCells[found->second.first];
+        std::list<Batch>::iterator batch = found->second.second;
+        mBatchOfObject.erase(found);
+
+        unhide(node);
+        batch->mObjects.erase(std::find(batch->mObjects.begin(), batch->mObjects.end(), node));
+
+        cellData.mCellNode->removeChild(batch->mNode);
+        if (mUnrefQueue.get())
+            mUnrefQueue->push(batch->mNode);
+
+        if (batch->mObjects.size() < 2)
+        {
+            for (std::vector<osg::ref_ptr<osg::Node> >::iterator it = batch->mObjects.begin(); it != batch->mObjects.end(); ++it)
+            {
+                unhide(*it);
+                mBatchOfObject.erase(it->get());
+            }
+            cellData.mBatches.erase(batch);
+        }
+        else
+        {
+            batch->mNode = createBatchNode(*batch->mTemplate, batch->mObjects);
+            cellData.mCellNode->addChild(batch->mNode);
+        }
+    }
+
+    void InstancedStatics::removeCell(const MWWorld::CellStore* cell)
+    {
+        std::map<const MWWorld::CellStore*, Cell>::iterator found = mCells.find(cell);
+        if (found == mCells.end())
+            return;
+
+        for (std::list<Batch>::const_iterator batch = found->second.mBatches.begin(); batch != found->second.mBatches.end(); ++batch)
+            for (std::vector<osg::ref_ptr<osg::Node> >::const_iterator it = batch->mObjects.begin(); it != batch->mObjects.end(); ++it)
+                mBatchOfObject.erase(it->get());
+
+        mCells.erase(found);
+
+        // forget the geometry of meshes that no batch uses anymore. Rejected meshes stay known, to not inspect them again.
+        for (std::map<std::string, osg::ref_ptr<Template> >::iterator it = mTemplates.begin(); it != mTemplates.end();)
+        {
+            if (it->second->mValid && it->second->referenceCount() == 1)
+                mTemplates.erase(it++);
+            else
+                ++it;
+        }
+    }
+
+    osg::ref_ptr<InstancedStatics::Template> InstancedStatics::getTemplate(const std::string& mesh)
+    {
+        std::map<std::string, osg::ref_ptr<Template> >::const_iterator found = mTemplates.find(mesh);
+        if (found != mTemplates.end())
+            return found->second;
+
+        osg::ref_ptr<Template> tmpl (new Template);
+        osg::ref_ptr<const osg::Node> node = mSceneManager->getTemplate(mesh);
+        std::vector<StaticGeometry> geometries;
+        tmpl->mValid = collectStaticGeometry(*node, geometries) && !geometries.empty();
+
+        if (tmpl->mValid)
+        {
+            for (std::vector<StaticGeometry>::const_iterator it = geometries.begin(); it != geometries.end(); ++it)
+            {
+                // copy the arrays for buffer objects of our own; the mesh may be drawn with display lists elsewhere
+                Part part;
+                part.mGeometry = new osg::Geometry(*it->mGeometry, osg::CopyOp::DEEP_COPY_ARRAYS);
+                part.mGeometry->setStateSet(it->mStateSet ? new osg::StateSet(*it->mStateSet, osg::CopyOp::SHALLOW_COPY) : new osg::StateSet);
+                part.mGeometry->setUseDisplayList(false);
+                part.mGeometry->setUseVertexBufferObjects(true);
+                part.mMatrix = it->mMatrix;
+                mSceneManager->createInstancingShaders(part.mGeometry.get(), sMaxInstances);
+                tmpl->mParts.push_back(part);
+            }
+        }
+
+        mTemplates[mesh] = tmpl;
+        return tmpl;
+    }
+
+    void InstancedStatics::createBatch(const MWWorld::CellStore* cell, osg::ref_ptr<Template> tmpl,
+                                       const std::vector<osg::ref_ptr<osg::Node> >& objects)
+    {
+        Cell& cellData = mCells[cell];
+
+        std::list<Batch>::iterator batch = cellData.mBatches.insert(cellData.mBatches.end(), Batch());
+        batch->mTemplate = tmpl;
+        batch->mObjects = objects;
+        batch->mNode = createBatchNode(*tmpl, objects);
+        cellData.mCellNode->addChild(batch->mNode);
+
+        for (std::vector<osg::ref_ptr<osg::Node> >::const_iterator it = objects.begin(); it != objects.end(); ++it)
+        {
+            hide(*it);
+            mBatchOfObject[it->get()] = BatchRef(cell, batch);
+        }
+    }
+
+    osg::ref_ptr<osg::Node> InstancedStatics::createBatchNode(const Template& tmpl, const std::vector<osg::ref_ptr<osg::Node> >& objects)
+    {
+        std::vector<osg::Matrix> objectMatrices;
+        osg::Vec3d center;
+        for (std::vector<osg::ref_ptr<osg::Node> >::const_iterator it = objects.begin(); it != objects.end(); ++it)
+        {
+            objectMatrices.push_back(getLocalMatrix(**it));
+            center += objectMatrices.back().getTrans();
+        }
+        center /= objects.size();
+
+        // the instances are placed relative to the center of the batch, to keep the floats of the shader precise
+        osg::ref_ptr<osg::MatrixTransform> batchNode (new BatchTransform(osg::Matrix::translate(center)));
+        const osg::Matrix toBatch = osg::Matrix::translate(-center);
+
+        // lights are picked for the batch as a whole. The callback goes below the transform, as it uses the bounds of
+        // its node in the coordinates of the current model view matrix.
+        osg::ref_ptr<osg::Group> lightingNode (new osg::Group);
+        lightingNode->addCullCallback(new SceneUtil::LightListCallback);
+        batchNode->addChild(lightingNode);
+
+        for (std::vector<Part>::const_iterator part = tmpl.mParts.begin(); part != tmpl.mParts.end(); ++part)
+        {
+            osg::ref_ptr<osg::Geometry> geometry (new osg::Geometry(*part->mGeometry, osg::CopyOp::SHALLOW_COPY));
+            for (unsigned int i=0; i<geometry->getNumPrimitiveSets(); ++i)
+            {
+                osg::ref_ptr<osg::PrimitiveSet> primitiveSet (static_cast<osg::PrimitiveSet*>(
+                    geometry->getPrimitiveSet(i)->clone(osg::CopyOp::SHALLOW_COPY)));
+                primitiveSet->setNumInstances(static_cast<int>(objects.size()));
+                geometry->setPrimitiveSet(i, primitiveSet);
+            }
+
+            osg::ref_ptr<osg::Uniform> instanceTransforms (new osg::Uniform(osg::Uniform::FLOAT_VEC4, "instanceTransforms",
+                                                                                   static_cast<int>(objects.size() * 3)));
+            const osg::BoundingBox& partBox = part->mGeometry->getBoundingBox();
+            osg::BoundingBox box;
+            for (size_t i=0; i<objectMatrices.size(); ++i)
+            {
+                osg::Matrix matrix = part->mMatrix * objectMatrices[i] * toBatch;
+                for (int column=0; column<3; ++column)
+                    instanceTransforms->setElement(static_cast<unsigned int>(i * 3 + column), osg::Vec4f(matrix(0, column), matrix(1, column), matrix(2, column), matrix(3, column)));
+
+                if (partBox.valid())
+                {
+                    for (unsigned int corner=0; corner<8; ++corner)
+                        box.expandBy(partBox.corner(corner) * matrix);
+                }
+            }
+
+            osg::ref_ptr<osg::StateSet> stateSet (new osg::StateSet(*part->mGeometry->getStateSet(), osg::CopyOp::SHALLOW_COPY));
+            stateSet->addUniform(instanceTransforms);
+            geometry->setStateSet(stateSet);
+
+            geometry->setComputeBoundingBoxCallback(new InstancesBoundingBoxCallback(box));
+            geometry->dirtyBound();
+
+            lightingNode->addChild(geometry);
+        }
+
+        return batchNode;
+    }
+
+}
@@ -0,0 +1,128 @@
+#ifndef OPENMW_MWRENDER_INSTANCEDSTATICS_H
+#define OPENMW_MWRENDER_INSTANCEDSTATICS_H
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <osg/ref_ptr>
+#include <osg/Referenced>
+#include <osg/Matrix>
+
+namespace osg
+{
+    class Node;
+    class Group;
+    class Geometry;
+    class NodeCallback;
+}
+
+namespace Resource
+{
+    class SceneManager;
+}
+
+namespace SceneUtil
+{
+    class UnrefQueue;
+}
+
+namespace MWWorld
+{
+    class CellStore;
+}
+
+namespace MWRender
+{
+
+    /// \brief Draws static objects of a cell that share a mesh with instanced draw calls
+    ///
+    /// When a cell has finished loading, the objects added for it are grouped by mesh and by their position into
+    /// batches of nearby objects. Each batch draws the geometry of the mesh once per object, with one draw call per
+    /// geometry of the mesh instead of one per geometry and object.
+    ///
+    /// The objects keep their own subgraphs, so intersection tests and bounds computations are not affected, but
+    /// cameras skip them while they are part of a batch. A batch can not move its objects: call remove() before
+    /// moving an object, and it is drawn on its own from then on.
+    ///
+    /// Meshes with animations, particles, switches or other parts that change over time are never batched.
+    class InstancedStatics
+    {
+    public:
+        InstancedStatics(Resource::SceneManager* sceneManager, SceneUtil::UnrefQueue* unrefQueue);
+        ~InstancedStatics();
+
+        /// Consider the object of \a node for batching once \a cell has finished loading.
+        /// Does nothing if the cell has finished loading already.
+        void add(const MWWorld::CellStore* cell, osg::Node* node, const std::string& mesh);
+
+        /// Batch the objects added for \a cell. The batches are attached to \a cellNode.
+        void finishCell(const MWWorld::CellStore* cell, osg::Group* cellNode);
+
+        /// Stop batching the object of \a node. The batch it was part of is rebuilt without it.
+        void remove(osg::Node* node);
+
+        /// Forget all objects of \a cell. Its batches are removed along with the cell node.
+        void removeCell(const MWWorld::CellStore* cell);
+
+    private:
+        // a geometry of a mesh, ready for instanced drawing
+        struct Part
+        {
+            osg::ref_ptr<osg::Geometry> mGeometry;
+            osg::Matrix mMatrix; // relative to the root of the mesh
+        };
+
+        struct Template : public osg::Referenced
+        {
+            Template() : mValid(false) {}
+
+            bool mValid;
+            std::vector<Part> mParts;
+        };
+
+        struct Batch
+        {
+            osg::ref_ptr<Template> mTemplate;
+            std::vector<osg::ref_ptr<osg::Node> > mObjects;
+            osg::ref_ptr<osg::Node> mNode;
+        };
+
+        struct Cell
+        {
+            Cell() : mFinished(false) {}
+
+            bool mFinished;
+            osg::ref_ptr<osg::Group> mCellNode;
+
+            // objects waiting for the cell to finish, by mesh
+            std::map<std::string, std::vector<osg::ref_ptr<osg::Node> > > mPending;
+
+            std::list<Batch> mBatches;
+        };
+
+        osg::ref_ptr<Template> getTemplate(const std::string& mesh);
+
+        void createBatch(const MWWorld::CellStore* cell, osg::ref_ptr<Template> tmpl,
+                         const std::vector<osg::ref_ptr<osg::Node> >& objects);
+
+        osg::ref_ptr<osg::Node> createBatchNode(const Template& tmpl, const std::vector<osg::ref_ptr<osg::Node> >& objects);
+
+        Resource::SceneManager* mSceneManager;
+        osg::ref_ptr<SceneUtil::UnrefQueue> mUnrefQueue;
+
+        std::map<std::string, osg::ref_ptr<Template> > mTemplates;
+
+        std::map<const MWWorld::CellStore*, Cell> mCells;
+
+        typedef std::pair<const MWWorld::CellStore*, std::list<Batch>::iterator> BatchRef;
+        std::map<const osg::Node*, BatchRef> mBatchOfObject;
+
+        InstancedStatics(const InstancedStatics&);
+        void operator=(const InstancedStatics&);
+    };
+
+}
+
+#endif
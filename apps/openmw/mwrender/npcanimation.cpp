@@ -1,5 +1,7 @@
 #include "npcanimation.hpp"
 
+#include <sstream>
+
 #include <osg/UserDataContainer>
 #include <osg/MatrixTransform>
 #include <osg/Depth>
@@ -24,6 +26,7 @@
 #include "../mwworld/inventorystore.hpp"
 #include "../mwworld/class.hpp"
 #include "../mwworld/player.hpp"
+#include "../mwworld/cellstore.hpp"
 
 #include "../mwmechanics/npcstats.hpp"
 #include "../mwmechanics/actorutil.hpp"
@@ -34,6 +37,7 @@
 #include "../mwbase/soundmanager.hpp"
 
 #include "camera.hpp"
+#include "npcpartspool.hpp"
 #include "rotatecontroller.hpp"
 #include "renderbin.hpp"
 #include "vismask.hpp"
@@ -77,6 +81,28 @@ std::string getVampireHead(const std::string& race, bool female)
     return "meshes\\" + bodyPart->mModel;
 }
 
+const struct {
+    int mSlot;
+    int mBasePriority;
+} sSlotList[] = {
+    // FIXME: Priority is based on the number of reserved slots. There should be a better way.
+    { MWWorld::InventoryStore::Slot_Robe,         12 },
+    { MWWorld::InventoryStore::Slot_Skirt,         3 },
+    { MWWorld::InventoryStore::Slot_Helmet,        0 },
+    { MWWorld::InventoryStore::Slot_Cuirass,       0 },
+    { MWWorld::InventoryStore::Slot_Greaves,       0 },
+    { MWWorld::InventoryStore::Slot_LeftPauldron,  0 },
+    { MWWorld::InventoryStore::Slot_RightPauldron, 0 },
+    { MWWorld::InventoryStore::Slot_Boots,         0 },
+    { MWWorld::InventoryStore::Slot_LeftGauntlet,  0 },
+    { MWWorld::InventoryStore::Slot_RightGauntlet, 0 },
+    { MWWorld::InventoryStore::Slot_Shirt,         0 },
+    { MWWorld::InventoryStore::Slot_Pants,         0 },
+    { MWWorld::InventoryStore::Slot_CarriedLeft,   0 },
+    { MWWorld::InventoryStore::Slot_CarriedRight,  0 }
+};
+const size_t sSlotListSize = sizeof(sSlotList)/sizeof(sSlotList[0]);
+
 }
 
 
@@ -274,7 +300,7 @@ NpcAnimation::~NpcAnimation()
 }
 
 NpcAnimation::NpcAnimation(const MWWorld::Ptr& ptr, osg::ref_ptr<osg::Group> parentNode, Resource::ResourceSystem* resourceSystem,
-                           bool disableSounds, ViewMode viewMode, float firstPersonFieldOfView)
+                           bool disableSounds, ViewMode viewMode, float firstPersonFieldOfView, NpcPartsPool* partsPool)
   : ActorAnimation(ptr, parentNode, resourceSystem),
     mViewMode(viewMode),
     mShowWeapons(false),
@@ -283,10 +309,15 @@ NpcAnimation::NpcAnimation(const MWWorld::Ptr& ptr, osg::ref_ptr<osg::Group> par
     mFirstPersonFieldOfView(firstPersonFieldOfView),
     mSoundsDisabled(disableSounds),
     mAccurateAiming(false),
-    mAimingFactor(0.f)
+    mAimingFactor(0.f),
+    mPartsPool(partsPool)
 {
     mNpc = mPtr.get<ESM::NPC>()->mBase;
 
+    // so the first build already looks for parts of the right type in the pool
+    if (mPartsPool)
+        mNpcType = getNpcType();
+
     mHeadAnimationTime = std::shared_ptr<HeadAnimationTime>(new HeadAnimationTime(mPtr));
     mWeaponAnimationTime = std::shared_ptr<WeaponAnimationTime>(new WeaponAnimationTime(this));
 
@@ -476,7 +507,14 @@ void NpcAnimation::updateNpcBase()
 
     smodel = Misc::ResourceHelpers::correctActorModelPath(smodel, mResourceSystem->getVFS());
 
-    setObjectRoot(smodel, true, true, false);
+    std::shared_ptr<NpcParts> pooledParts;
+    if (mPartsPool && mViewMode == VM_Normal)
+        pooledParts = mPartsPool->take(getPartsKey());
+
+    if (pooledParts)
+        attachParts(*pooledParts);
+    else
+        setObjectRoot(smodel, true, true, false);
 
     if(mViewMode != VM_FirstPerson)
     {
@@ -506,24 +544,39 @@ void NpcAnimation::updateNpcBase()
         mObjectRoot->addCullCallback(new OverrideFieldOfViewCallback(mFirstPersonFieldOfView));
     }
 
-    updateParts();
+    if (pooledParts)
+    {
+        // everything but the weapon is in place already
+        showWeapons(mShowWeapons);
+        showCarriedLeft(mShowCarriedLeft);
+
+        if (mAlpha != 1.f)
+            mResourceSystem->getSceneManager()->recreateShaders(mObjectRoot);
+    }
+    else
+        updateParts();
 
     mWeaponAnimationTime->updateStartTime();
 }
 
-void NpcAnimation::updateParts()
+NpcAnimation::NpcType NpcAnimation::getNpcType() const
 {
-    if (!mObjectRoot.get())
-        return;
-
     const MWWorld::Class &cls = mPtr.getClass();
 
-    NpcType curType = Type_Normal;
+    NpcType type = Type_Normal;
     if (cls.getCreatureStats(mPtr).getMagicEffects().get(ESM::MagicEffect::Vampirism).getMagnitude() > 0)
-        curType = Type_Vampire;
+        type = Type_Vampire;
     if (cls.getNpcStats(mPtr).isWerewolf())
-        curType = Type_Werewolf;
+        type = Type_Werewolf;
+    return type;
+}
 
+void NpcAnimation::updateParts()
+{
+    if (!mObjectRoot.get())
+        return;
+
+    NpcType curType = getNpcType();
     if (curType != mNpcType)
     {
         mNpcType = curType;
@@ -531,42 +584,20 @@ void NpcAnimation::updateParts()
         return;
     }
 
-    static const struct {
-        int mSlot;
-        int mBasePriority;
-    } slotlist[] = {
-        // FIXME: Priority is based on the number of reserved slots. There should be a better way.
-        { MWWorld::InventoryStore::Slot_Robe,         12 },
-        { MWWorld::InventoryStore::Slot_Skirt,         3 },
-        { MWWorld::InventoryStore::Slot_Helmet,        0 },
-        { MWWorld::InventoryStore::Slot_Cuirass,       0 },
-        { MWWorld::InventoryStore::Slot_Greaves,       0 },
-        { MWWorld::InventoryStore::Slot_LeftPauldron,  0 },
-        { MWWorld::InventoryStore::Slot_RightPauldron, 0 },
-        { MWWorld::InventoryStore::Slot_Boots,         0 },
-        { MWWorld::InventoryStore::Slot_LeftGauntlet,  0 },
-        { MWWorld::InventoryStore::Slot_RightGauntlet, 0 },
-        { MWWorld::InventoryStore::Slot_Shirt,         0 },
-        { MWWorld::InventoryStore::Slot_Pants,         0 },
-        { MWWorld::InventoryStore::Slot_CarriedLeft,   0 },
-        { MWWorld::InventoryStore::Slot_CarriedRight,  0 }
-    };
-    static const size_t slotlistsize = sizeof(slotlist)/sizeof(slotlist[0]);
-
     bool wasArrowAttached = (mAmmunition.get() != NULL);
     mAmmunition.reset();
 
     const MWWorld::InventoryStore& inv = mPtr.getClass().getInventoryStore(mPtr);
-    for(size_t i = 0;i < slotlistsize && mViewMode != VM_HeadOnly;i++)
+    for(size_t i = 0;i < sSlotListSize && mViewMode != VM_HeadOnly;i++)
     {
-        MWWorld::ConstContainerStoreIterator store = inv.getSlot(slotlist[i].mSlot);
+        MWWorld::ConstContainerStoreIterator store = inv.getSlot(sSlotList[i].mSlot);
 
-        removePartGroup(slotlist[i].mSlot);
+        removePartGroup(sSlotList[i].mSlot);
 
         if(store == inv.end())
             continue;
 
-        if(slotlist[i].mSlot == MWWorld::InventoryStore::Slot_Helmet)
+        if(sSlotList[i].mSlot == MWWorld::InventoryStore::Slot_Helmet)
             removeIndividualPart(ESM::PRT_Hair);
 
         int prio = 1;
@@ -574,18 +605,18 @@ void NpcAnimation::updateParts()
         osg::Vec4f glowColor = getEnchantmentColor(*store);
         if(store->getTypeName() == typeid(ESM::Clothing).name())
         {
-            prio = ((slotlist[i].mBasePriority+1)<<1) + 0;
+            prio = ((sSlotList[i].mBasePriority+1)<<1) + 0;
             const ESM::Clothing *clothes = store->get<ESM::Clothing>()->mBase;
-            addPartGroup(slotlist[i].mSlot, prio, clothes->mParts.mParts, enchantedGlow, &glowColor);
+            addPartGroup(sSlotList[i].mSlot, prio, clothes->mParts.mParts, enchantedGlow, &glowColor);
         }
         else if(store->getTypeName() == typeid(ESM::Armor).name())
         {
-            prio = ((slotlist[i].mBasePriority+1)<<1) + 1;
+            prio = ((sSlotList[i].mBasePriority+1)<<1) + 1;
             const ESM::Armor *armor = store->get<ESM::Armor>()->mBase;
-            addPartGroup(slotlist[i].mSlot, prio, armor->mParts.mParts, enchantedGlow, &glowColor);
+            addPartGroup(sSlotList[i].mSlot, prio, armor->mParts.mParts, enchantedGlow, &glowColor);
         }
 
-        if(slotlist[i].mSlot == MWWorld::InventoryStore::Slot_Robe)
+        if(sSlotList[i].mSlot == MWWorld::InventoryStore::Slot_Robe)
         {
             ESM::PartReferenceType parts[] = {
                 ESM::PRT_Groin, ESM::PRT_Skirt, ESM::PRT_RLeg, ESM::PRT_LLeg,
@@ -594,13 +625,13 @@ void NpcAnimation::updateParts()
             };
             size_t parts_size = sizeof(parts)/sizeof(parts[0]);
             for(size_t p = 0;p < parts_size;++p)
-                reserveIndividualPart(parts[p], slotlist[i].mSlot, prio);
+                reserveIndividualPart(parts[p], sSlotList[i].mSlot, prio);
         }
-        else if(slotlist[i].mSlot == MWWorld::InventoryStore::Slot_Skirt)
+        else if(sSlotList[i].mSlot == MWWorld::InventoryStore::Slot_Skirt)
         {
-            reserveIndividualPart(ESM::PRT_Groin, slotlist[i].mSlot, prio);
-            reserveIndividualPart(ESM::PRT_RLeg, slotlist[i].mSlot, prio);
-            reserveIndividualPart(ESM::PRT_LLeg, slotlist[i].mSlot, prio);
+            reserveIndividualPart(ESM::PRT_Groin, sSlotList[i].mSlot, prio);
+            reserveIndividualPart(ESM::PRT_RLeg, sSlotList[i].mSlot, prio);
+            reserveIndividualPart(ESM::PRT_LLeg, sSlotList[i].mSlot, prio);
         }
     }
 
@@ -777,6 +808,13 @@ bool NpcAnimation::addOrReplaceIndividualPart(ESM::PartReferenceType type, int g
         }
     }
 
+    assignControllerSources(type);
+
+    return true;
+}
+
+void NpcAnimation::assignControllerSources(ESM::PartReferenceType type)
+{
     osg::Node* node = mObjectParts[type]->getNode();
     if (node->getNumChildrenRequiringUpdateTraversal() > 0)
     {
@@ -817,8 +855,6 @@ bool NpcAnimation::addOrReplaceIndividualPart(ESM::PartReferenceType type, int g
         SceneUtil::AssignControllerSourcesVisitor assignVisitor(src);
         node->accept(assignVisitor);
     }
-
-    return true;
 }
 
 void NpcAnimation::addPartGroup(int group, int priority, const std::vector<ESM::PartReference> &parts, bool enchantedGlow, osg::Vec4f* glowColor)
@@ -1047,6 +1083,93 @@ void NpcAnimation::setFirstPersonOffset(const osg::Vec3f &offset)
     mFirstPersonOffset = offset;
 }
 
+std::string NpcAnimation::getPartsKey() const
+{
+    std::ostringstream key;
+    key << Misc::StringUtils::lowerCase(mNpc->mRace) << '|' << mNpc->isMale() << '|' << mNpcType << '|' << mViewMode
+        << '|' << mHeadModel << '|' << mHairModel;
+
+    // carried lights are attenuated differently in exteriors, see addExtraLight
+    key << '|' << (mPtr.isInCell() && mPtr.getCell()->getCell()->isExterior());
+
+    // the weapon is not part of the key, as it is never kept in the pool
+    const MWWorld::InventoryStore& inv = mPtr.getClass().getInventoryStore(mPtr);
+    for (size_t i = 0; i < sSlotListSize; ++i)
+    {
+        if (sSlotList[i].mSlot == MWWorld::InventoryStore::Slot_CarriedRight)
+            continue;
+
+        key << '|';
+        MWWorld::ConstContainerStoreIterator item = inv.getSlot(sSlotList[i].mSlot);
+        if (item != inv.end())
+            key << Misc::StringUtils::lowerCase(item->getCellRef().getRefId());
+    }
+    return key.str();
+}
+
+void NpcAnimation::attachParts(const NpcParts& parts)
+{
+    attachObjectRoot(parts.mObjectRoot);
+
+    for (int i = 0; i < ESM::PRT_Count; ++i)
+    {
+        mObjectParts[i] = parts.mObjectParts[i];
+        mPartslots[i] = parts.mPartslots[i];
+        mPartPriorities[i] = parts.mPartPriorities[i];
+
+        if (!mObjectParts[i])
+            continue;
+
+        assignControllerSources((ESM::PartReferenceType)i);
+
+        if (!parts.mSoundIds[i].empty() && !mSoundsDisabled)
+        {
+            mSoundIds[i] = parts.mSoundIds[i];
+            MWBase::Environment::get().getSoundManager()->playSound3D(mPtr, mSoundIds[i],
+                1.0f, 1.0f, MWSound::Type::Sfx, MWSound::PlayMode::Loop
+            );
+        }
+    }
+}
+
+void NpcAnimation::recycle()
+{
+    if (!mPartsPool || mViewMode != VM_Normal || !mObjectRoot || !mShowCarriedLeft)
+        return;
+
+    // transparency and spell glows change the root's state
+    if (mAlpha != 1.f || mObjectRoot->getStateSet())
+        return;
+
+    const std::string key = getPartsKey();
+
+    clearAnimSources();
+    mEffects.clear();
+    mAmmunition.reset();
+    removeIndividualPart(ESM::PRT_Weapon);
+
+    std::shared_ptr<NpcParts> parts (new NpcParts);
+    for (int i = 0; i < ESM::PRT_Count; ++i)
+    {
+        if (!mSoundIds[i].empty() && !mSoundsDisabled)
+            MWBase::Environment::get().getSoundManager()->stopSound3D(mPtr, mSoundIds[i]);
+        parts->mSoundIds[i].swap(mSoundIds[i]);
+
+        parts->mObjectParts[i].swap(mObjectParts[i]);
+        parts->mPartslots[i] = mPartslots[i];
+        parts->mPartPriorities[i] = mPartPriorities[i];
+        mPartslots[i] = -1;
+        mPartPriorities[i] = 0;
+    }
+
+    parts->mObjectRoot = detachObjectRoot();
+
+    if (SceneUtil::Skeleton* skeleton = dynamic_cast<SceneUtil::Skeleton*>(parts->mObjectRoot.get()))
+        skeleton->setActive(SceneUtil::Skeleton::Active);
+
+    mPartsPool->add(key, parts);
+}
+
 void NpcAnimation::updatePtr(const MWWorld::Ptr &updated)
 {
     Animation::updatePtr(updated);
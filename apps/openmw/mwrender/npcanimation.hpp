@@ -19,6 +19,8 @@ namespace MWRender
 
 class NeckController;
 class HeadAnimationTime;
+class NpcPartsPool;
+struct NpcParts;
 
 class NpcAnimation : public ActorAnimation, public WeaponAnimation, public MWWorld::InventoryStoreListener
 {
@@ -72,8 +74,21 @@ private:
     bool mAccurateAiming;
     float mAimingFactor;
 
+    NpcPartsPool* mPartsPool;
+
     void updateNpcBase();
 
+    NpcType getNpcType() const;
+
+    /// Identify the look of the NPC, i.e. the skeleton and the parts attached to it.
+    std::string getPartsKey() const;
+
+    /// Use a skeleton with parts that another NpcAnimation of the same look assembled.
+    void attachParts(const NpcParts& parts);
+
+    /// Set the sources of the controllers of a part that was just attached.
+    void assignControllerSources(ESM::PartReferenceType type);
+
     PartHolderPtr insertBoundedPart(const std::string &model, const std::string &bonename,
                                         const std::string &bonefilter, bool enchantedGlow, osg::Vec4f* glowColor=NULL);
 
@@ -105,9 +120,11 @@ public:
      *                         Those need to be manually rendered anyway.
      * @param disableSounds    Same as \a disableListener but for playing items sounds
      * @param viewMode
+     * @param partsPool      Reuse skeletons from this pool, and allow recycle() to return them to it. May be NULL.
      */
     NpcAnimation(const MWWorld::Ptr& ptr, osg::ref_ptr<osg::Group> parentNode, Resource::ResourceSystem* resourceSystem,
-                 bool disableSounds = false, ViewMode viewMode=VM_Normal, float firstPersonFieldOfView=55.f);
+                 bool disableSounds = false, ViewMode viewMode=VM_Normal, float firstPersonFieldOfView=55.f,
+                 NpcPartsPool* partsPool=NULL);
     virtual ~NpcAnimation();
 
     virtual void enableHeadAnimation(bool enable);
@@ -144,6 +161,11 @@ public:
     /// Rebuilds the NPC, updating their root model, animation sources, and equipment.
     void rebuild();
 
+    /// Give the skeleton and the parts attached to it to the pool, for an NPC of the same look to reuse.
+    /// Call from the main thread when the NPC leaves the scene; the NpcAnimation is of no use afterwards.
+    /// Does nothing if there is no pool, or if the skeleton is not in a state to be reused.
+    void recycle();
+
     /// Get the inventory slot that the given node path leads into, or -1 if not found.
     int getSlot(const osg::NodePath& path) const;
 
@@ -0,0 +1,100 @@
+#include "npcpartspool.hpp"
+
+#include <osg/Group>
+
+#include <components/sceneutil/unrefqueue.hpp>
+
+namespace
+{
+    // roughly the NPCs of a few town cells
+    const unsigned int sMaxSize = 64;
+}
+
+namespace MWRender
+{
+
+    NpcParts::NpcParts()
+    {
+        for (int i=0; i<ESM::PRT_Count; ++i)
+        {
+            mPartslots[i] = -1;
+            mPartPriorities[i] = 0;
+        }
+    }
+
+    NpcPartsPool::NpcPartsPool(SceneUtil::UnrefQueue* unrefQueue)
+        : mUnrefQueue(unrefQueue)
+    {
+    }
+
+    NpcPartsPool::~NpcPartsPool()
+    {
+        clear();
+    }
+
+    void NpcPartsPool::add(const std::string& key, std::shared_ptr<NpcParts> parts)
+    {
+        mParts.push_back(std::make_pair(key, parts));
+        mPartsByKey.insert(std::make_pair(key, --mParts.end()));
+
+        while (mParts.size() > sMaxSize)
+        {
+            const PartsList::iterator oldest = mParts.begin();
+
+            std::pair<std::multimap<std::string, PartsList::iterator>::iterator,
+                      std::multimap<std::string, PartsList::iterator>::iterator> range = mPartsByKey.equal_range(oldest->first);
+            for (std::multimap<std::string, PartsList::iterator>::iterator it = range.first; it != range.second; ++it)
+            {
+                if (it->second == oldest)
+                {
+                    mPartsByKey.erase(it);
+                    break;
+                }
+            }
+
+            drop(oldest->second);
+            mParts.erase(oldest);
+        }
+    }
+
+    std::shared_ptr<NpcParts> NpcPartsPool::take(const std::string& key)
+    {
+        std::multimap<std::string, PartsList::iterator>::iterator found = mPartsByKey.find(key);
+        if (found == mPartsByKey.end())
+            return std::shared_ptr<NpcParts>();
+
+        std::shared_ptr<NpcParts> parts = found->second->second;
+        mParts.erase(found->second);
+        mPartsByKey.erase(found);
+        return parts;
+    }
+
+    void NpcPartsPool::clear()
+    {
+        for (PartsList::iterator it = mParts.begin(); it != mParts.end(); ++it)
+            drop(it->second);
+
+        mParts.clear();
+        mPartsByKey.clear();
+    }
+
+    unsigned int NpcPartsPool::getSize() const
+    {
+        return static_cast<unsigned int>(mParts.size());
+    }
+
+    void NpcPartsPool::drop(std::shared_ptr<NpcParts> parts)
+    {
+        if (!mUnrefQueue.get())
+            return;
+
+        // the PartHolders detach the parts from the skeleton here, but leave deleting them to a worker thread
+        for (int i=0; i<ESM::PRT_Count; ++i)
+        {
+            if (parts->mObjectParts[i])
+                mUnrefQueue->push(parts->mObjectParts[i]->getNode());
+        }
+        mUnrefQueue->push(parts->mObjectRoot);
+    }
+
+}
@@ -0,0 +1,75 @@
+#ifndef OPENMW_MWRENDER_NPCPARTSPOOL_H
+#define OPENMW_MWRENDER_NPCPARTSPOOL_H
+
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <osg/ref_ptr>
+
+#include <components/esm/loadarmo.hpp> // ESM::PRT_Count
+
+#include "animation.hpp"
+
+namespace SceneUtil
+{
+    class UnrefQueue;
+}
+
+namespace MWRender
+{
+
+    /// A skeleton with the body parts and equipment of an NPC attached to it
+    struct NpcParts
+    {
+        NpcParts();
+
+        osg::ref_ptr<osg::Group> mObjectRoot;
+
+        PartHolderPtr mObjectParts[ESM::PRT_Count];
+        std::string mSoundIds[ESM::PRT_Count];
+        int mPartslots[ESM::PRT_Count];
+        int mPartPriorities[ESM::PRT_Count];
+    };
+
+    /// \brief Keeps the assembled skeletons of NPCs that left the scene, for NPCs of the same look to reuse
+    ///
+    /// Assembling an NPC instantiates and attaches a dozen or more meshes, so reusing the skeletons of NPCs that went
+    /// out of view saves most of the cost of NPCs coming back, e.g. when a cell is loaded again.
+    ///
+    /// The look of an NPC is given by a key, see NpcAnimation. When the pool is full, the parts that were kept the
+    /// longest are dropped.
+    class NpcPartsPool
+    {
+    public:
+        NpcPartsPool(SceneUtil::UnrefQueue* unrefQueue);
+        ~NpcPartsPool();
+
+        /// Keep \a parts for an NPC of the look \a key. The parts must not be attached to a scene graph.
+        void add(const std::string& key, std::shared_ptr<NpcParts> parts);
+
+        /// Take parts of the look \a key out of the pool, or NULL if there are none.
+        std::shared_ptr<NpcParts> take(const std::string& key);
+
+        void clear();
+
+        unsigned int getSize() const;
+
+    private:
+        void drop(std::shared_ptr<NpcParts> parts);
+
+        typedef std::list<std::pair<std::string, std::shared_ptr<NpcParts> > > PartsList;
+        PartsList mParts; // oldest first
+
+        std::multimap<std::string, PartsList::iterator> mPartsByKey;
+
+        osg::ref_ptr<SceneUtil::UnrefQueue> mUnrefQueue;
+
+        NpcPartsPool(const NpcPartsPool&);
+        void operator=(const NpcPartsPool&);
+    };
+
+}
+
+#endif
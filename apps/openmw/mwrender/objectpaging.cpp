@@ -0,0 +1,628 @@
+#include "objectpaging.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <osg/Geometry>
+#include <osg/LOD>
+#include <osg/MatrixTransform>
+#include <osg/Stats>
+#include <osg/TriangleIndexFunctor>
+
+#include <components/esm/loadcell.hpp>
+#include <components/esm/loadland.hpp>
+#include <components/esm/loadstat.hpp>
+#include <components/resource/scenemanager.hpp>
+#include <components/sceneutil/unrefqueue.hpp>
+#include <components/sceneutil/workqueue.hpp>
+
+#include "../mwbase/environment.hpp"
+#include "../mwbase/world.hpp"
+
+#include "../mwworld/contentrefreader.hpp"
+#include "../mwworld/esmstore.hpp"
+
+#include "staticgeometry.hpp"
+
+namespace
+{
+    // beyond this distance from a chunk, small objects are left out
+    const float sCoarseDistance = 2.f * ESM::Land::REAL_SIZE;
+
+    // objects with a smaller bounding radius count as small
+    const float sSmallObjectRadius = 250.f;
+
+    /// Transform of a chunk. The chunk has no objects to find, so only cull visitors traverse it; intersection tests
+    /// and bounds computations for the scene only see the objects of active cells.
+    class ChunkTransform : public osg::MatrixTransform
+    {
+    public:
+        ChunkTransform()
+        {
+        }
+
+        ChunkTransform(const osg::Matrix& matrix)
+            : osg::MatrixTransform(matrix)
+        {
+        }
+
+        ChunkTransform(const ChunkTransform& copy, const osg::CopyOp& copyop)
+            : osg::MatrixTransform(copy, copyop)
+        {
+        }
+
+        META_Node(MWRender, ChunkTransform)
+
+        virtual void traverse(osg::NodeVisitor& nv)
+        {
+            if (nv.getVisitorType() == osg::NodeVisitor::CULL_VISITOR)
+                osg::MatrixTransform::traverse(nv);
+        }
+    };
+
+    enum Layout
+    {
+        Layout_Normals = 1,
+        Layout_Colors = 1<<1,
+        Layout_FirstTexCoord = 1<<2 // one bit per texture unit from here
+    };
+
+    // tangents generated by the ShaderVisitor
+    const unsigned int sTangentUnit = 7;
+
+    /// Get the arrays a geometry has, or -1 if they are not in a form the GeometryMerger can handle.
+    int getLayout(const osg::Geometry& geometry)
+    {
+        if (!dynamic_cast<const osg::Vec3Array*>(geometry.getVertexArray()))
+            return -1;
+
+        int layout = 0;
+        if (const osg::Array* normals = geometry.getNormalArray())
+        {
+            if (!dynamic_cast<const osg::Vec3Array*>(normals) || normals->getBinding() != osg::Array::BIND_PER_VERTEX)
+                return -1;
+            layout |= Layout_Normals;
+        }
+
+        if (const osg::Array* colors = geometry.getColorArray())
+        {
+            if (!dynamic_cast<const osg::Vec4Array*>(colors) || colors->getBinding() != osg::Array::BIND_PER_VERTEX)
+                return -1;
+            layout |= Layout_Colors;
+        }
+
+        for (unsigned int unit=0; unit<geometry.getNumTexCoordArrays(); ++unit)
+        {
+            const osg::Array* texCoords = geometry.getTexCoordArray(unit);
+            if (!texCoords)
+                continue;
+
+            bool valid = (unit == sTangentUnit) ? dynamic_cast<const osg::Vec4Array*>(texCoords) != NULL
+                                                : dynamic_cast<const osg::Vec2Array*>(texCoords) != NULL;
+            if (!valid || unit > sTangentUnit)
+                return -1;
+            layout |= (Layout_FirstTexCoord << unit);
+        }
+
+        return layout;
+    }
+
+    struct CollectTriangles
+    {
+        CollectTriangles()
+            : mIndices(NULL)
+            , mBase(0)
+        {
+        }
+
+        void operator()(unsigned int i1, unsigned int i2, unsigned int i3)
+        {
+            if (i1 == i2 || i2 == i3 || i1 == i3)
+                return;
+            mIndices->push_back(mBase + i1);
+            mIndices->push_back(mBase + i2);
+            mIndices->push_back(mBase + i3);
+        }
+
+        std::vector<GLuint>* mIndices;
+        unsigned int mBase;
+    };
+
+    /// Merges geometries with the same layout into one, transforming their vertices.
+    class GeometryMerger
+    {
+    public:
+        GeometryMerger(int layout)
+            : mVertices(new osg::Vec3Array)
+        {
+            if (layout & Layout_Normals)
+                mNormals = new osg::Vec3Array;
+            if (layout & Layout_Colors)
+                mColors = new osg::Vec4Array;
+            for (unsigned int unit=0; unit<sTangentUnit; ++unit)
+                if (layout & (Layout_FirstTexCoord << unit))
+                    mTexCoords[unit] = new osg::Vec2Array;
+            if (layout & (Layout_FirstTexCoord << sTangentUnit))
+                mTangents = new osg::Vec4Array;
+        }
+
+        void add(const osg::Geometry& geometry, const osg::Matrix& matrix)
+        {
+            const unsigned int base = mVertices->size();
+
+            const osg::Vec3Array& vertices = static_cast<const osg::Vec3Array&>(*geometry.getVertexArray());
+            for (osg::Vec3Array::const_iterator it = vertices.begin(); it != vertices.end(); ++it)
+                mVertices->push_back(*it * matrix);
+
+            if (mNormals)
+            {
+                const osg::Vec3Array& normals = static_cast<const osg::Vec3Array&>(*geometry.getNormalArray());
+                for (osg::Vec3Array::const_iterator it = normals.begin(); it != normals.end(); ++it)
+                {
+                    osg::Vec3f normal = osg::Matrix::transform3x3(*it, matrix);
+                    normal.normalize();
+                    mNormals->push_back(normal);
+                }
+            }
+
+            if (mColors)
+            {
+                const osg::Vec4Array& colors = static_cast<const osg::Vec4Array&>(*geometry.getColorArray());
+                mColors->insert(mColors->end(), colors.begin(), colors.end());
+            }
+
+            for (std::map<unsigned int, osg::ref_ptr<osg::Vec2Array> >::iterator it = mTexCoords.begin(); it != mTexCoords.end(); ++it)
+            {
+                const osg::Vec2Array& texCoords = static_cast<const osg::Vec2Array&>(*geometry.getTexCoordArray(it->first));
+                it->second->insert(it->second->end(), texCoords.begin(), texCoords.end());
+            }
+
+            if (mTangents)
+            {
+                const osg::Vec4Array& tangents = static_cast<const osg::Vec4Array&>(*geometry.getTexCoordArray(sTangentUnit));
+                for (osg::Vec4Array::const_iterator it = tangents.begin(); it != tangents.end(); ++it)
+                {
+                    osg::Vec3f tangent = osg::Matrix::transform3x3(osg::Vec3f(it->x(), it->y(), it->z()), matrix);
+                    tangent.normalize();
+                    mTangents->push_back(osg::Vec4f(tangent, it->w()));
+                }
+            }
+
+            // arrays shorter than the vertex array would leave the merged arrays misaligned
+            const unsigned int end = mVertices->size();
+            if ((mNormals && mNormals->size() != end) || (mColors && mColors->size() != end) || (mTangents && mTangents->size() != end))
+            {
+                resize(base);
+                return;
+            }
+            for (std::map<unsigned int, osg::ref_ptr<osg::Vec2Array> >::const_iterator it = mTexCoords.begin(); it != mTexCoords.end(); ++it)
+            {
+                if (it->second->size() != end)
+                {
+                    resize(base);
+                    return;
+                }
+            }
+
+            osg::TriangleIndexFunctor<CollectTriangles> collectTriangles;
+            collectTriangles.mIndices = &mIndices;
+            collectTriangles.mBase = base;
+            geometry.accept(collectTriangles);
+        }
+
+        osg::ref_ptr<osg::Geometry> finish(const osg::StateSet* stateSet)
+        {
+            if (mIndices.empty())
+                return NULL;
+
+            osg::ref_ptr<osg::Geometry> geometry (new osg::Geometry);
+            geometry->setVertexArray(mVertices);
+            if (mNormals)
+                geometry->setNormalArray(mNormals, osg::Array::BIND_PER_VERTEX);
+            if (mColors)
+                geometry->setColorArray(mColors, osg::Array::BIND_PER_VERTEX);
+            for (std::map<unsigned int, osg::ref_ptr<osg::Vec2Array> >::const_iterator it = mTexCoords.begin(); it != mTexCoords.end(); ++it)
+                geometry->setTexCoordArray(it->first, it->second, osg::Array::BIND_PER_VERTEX);
+            if (mTangents)
+                geometry->setTexCoordArray(sTangentUnit, mTangents, osg::Array::BIND_PER_VERTEX);
+
+            geometry->addPrimitiveSet(new osg::DrawElementsUInt(GL_TRIANGLES, static_cast<unsigned int>(mIndices.size()), &mIndices[0]));
+
+            // the StateSet is shared with the meshes, but nothing modifies it
+            geometry->setStateSet(const_cast<osg::StateSet*>(stateSet));
+
+            geometry->setUseDisplayList(false);
+            geometry->setUseVertexBufferObjects(true);
+            return geometry;
+        }
+
+    private:
+        void resize(unsigned int size)
+        {
+            mVertices->resize(size);
+            if (mNormals)
+                mNormals->resize(size);
+            if (mColors)
+                mColors->resize(size);
+            for (std::map<unsigned int, osg::ref_ptr<osg::Vec2Array> >::iterator it = mTexCoords.begin(); it != mTexCoords.end(); ++it)
+                it->second->resize(size);
+            if (mTangents)
+                mTangents->resize(size);
+        }
+
+        osg::ref_ptr<osg::Vec3Array> mVertices;
+        osg::ref_ptr<osg::Vec3Array> mNormals;
+        osg::ref_ptr<osg::Vec4Array> mColors;
+        std::map<unsigned int, osg::ref_ptr<osg::Vec2Array> > mTexCoords;
+        osg::ref_ptr<osg::Vec4Array> mTangents;
+        std::vector<GLuint> mIndices;
+    };
+
+    struct MergeKey
+    {
+        MergeKey(const osg::StateSet* stateSet, int layout)
+            : mStateSet(stateSet)
+            , mLayout(layout)
+        {
+        }
+
+        const osg::StateSet* mStateSet;
+        int mLayout;
+
+        /// Geometries with StateSets of the same contents are merged, even if the StateSets are not shared.
+        bool operator<(const MergeKey& other) const
+        {
+            if (mLayout != other.mLayout)
+                return mLayout < other.mLayout;
+            if (mStateSet == other.mStateSet || !mStateSet || !other.mStateSet)
+                return mStateSet < other.mStateSet;
+            return mStateSet->compare(*other.mStateSet, true) < 0;
+        }
+    };
+
+    typedef std::map<MergeKey, std::shared_ptr<GeometryMerger> > MergerMap;
+
+    void addToMergers(const MWRender::StaticGeometry& geometry, const osg::Matrix& matrix, int layout, MergerMap& mergers)
+    {
+        std::shared_ptr<GeometryMerger>& merger = mergers[MergeKey(geometry.mStateSet.get(), layout)];
+        if (!merger)
+            merger.reset(new GeometryMerger(layout));
+        merger->add(*geometry.mGeometry, geometry.mMatrix * matrix);
+    }
+
+    osg::ref_ptr<osg::Group> finishMergers(const MergerMap& mergers)
+    {
+        osg::ref_ptr<osg::Group> group (new osg::Group);
+        for (MergerMap::const_iterator it = mergers.begin(); it != mergers.end(); ++it)
+        {
+            osg::ref_ptr<osg::Geometry> geometry = it->second->finish(it->first.mStateSet);
+            if (geometry)
+                group->addChild(geometry);
+        }
+        return group;
+    }
+}
+
+namespace MWRender
+{
+
+    /// Worker thread item: read the statics of a cell and merge their geometry.
+    class BuildChunkItem : public SceneUtil::WorkItem
+    {
+    public:
+        /// Constructor to be called from the main thread.
+        BuildChunkItem(const ESM::Cell* cell, Resource::SceneManager* sceneManager)
+            : mAborted(false)
+            , mReader(cell, MWBase::Environment::get().getWorld()->getEsmReader(), true)
+            , mStore(MWBase::Environment::get().getWorld()->getStore())
+            , mSceneManager(sceneManager)
+            , mOrigin((cell->getGridX() + 0.5f) * ESM::Land::REAL_SIZE,
+                      (cell->getGridY() + 0.5f) * ESM::Land::REAL_SIZE, 0.f)
+        {
+        }
+
+        virtual void doWork()
+        {
+            if (mAborted)
+                return;
+
+            MWWorld::ContentRefReader::RefList refs;
+            mReader.read(refs);
+
+            MergerMap detailed;
+            MergerMap coarse;
+            bool hasSmallObjects = false;
+
+            std::map<std::string, Mesh> meshes;
+            for (MWWorld::ContentRefReader::RefList::const_iterator it = refs.begin(); it != refs.end(); ++it)
+            {
+                if (mAborted)
+                    return;
+
+                const ESM::CellRef& ref = it->first;
+                if (it->second) // deleted
+                    continue;
+
+                const ESM::Static* stat = mStore.get<ESM::Static>().search(ref.mRefID);
+                if (!stat || stat->mModel.empty())
+                    continue;
+
+                std::map<std::string, Mesh>::iterator found = meshes.find(stat->mModel);
+                if (found == meshes.end())
+                    found = meshes.insert(std::make_pair(stat->mModel, loadMesh("meshes\\" + stat->mModel))).first;
+                const Mesh& mesh = found->second;
+                if (mesh.mGeometries.empty())
+                    continue;
+
+                // same transform as for the objects of active cells, see Scene::updateObjectRotation
+                const ESM::Position& pos = ref.mPos;
+                osg::Quat rotation = osg::Quat(pos.rot[2], osg::Vec3f(0,0,-1)) * osg::Quat(pos.rot[1], osg::Vec3f(0,-1,0))
+                        * osg::Quat(pos.rot[0], osg::Vec3f(-1,0,0));
+                osg::Matrix matrix = osg::Matrix::scale(ref.mScale, ref.mScale, ref.mScale) * osg::Matrix::rotate(rotation)
+                        * osg::Matrix::translate(osg::Vec3f(pos.pos[0], pos.pos[1], pos.pos[2]) - mOrigin);
+
+                const bool isSmall = mesh.mRadius * ref.mScale < sSmallObjectRadius;
+                hasSmallObjects |= isSmall;
+
+                for (size_t i=0; i<mesh.mGeometries.size(); ++i)
+                {
+                    addToMergers(mesh.mGeometries[i], matrix, mesh.mLayouts[i], detailed);
+                    if (!isSmall)
+                        addToMergers(mesh.mGeometries[i], matrix, mesh.mLayouts[i], coarse);
+                }
+            }
+
+            if (detailed.empty())
+                return;
+
+            osg::ref_ptr<osg::MatrixTransform> chunk (new ChunkTransform(osg::Matrix::translate(mOrigin)));
+            if (hasSmallObjects)
+            {
+                osg::ref_ptr<osg::LOD> lod (new osg::LOD);
+                lod->addChild(finishMergers(detailed), 0.f, sCoarseDistance);
+                lod->addChild(finishMergers(coarse), sCoarseDistance, std::numeric_limits<float>::max());
+                chunk->addChild(lod);
+            }
+            else
+                chunk->addChild(finishMergers(detailed));
+
+            mNode = chunk;
+        }
+
+        virtual void abort()
+        {
+            mAborted = true;
+        }
+
+        /// The merged statics of the cell, or NULL if it has none.
+        /// @note Only to be used once the item is done.
+        osg::ref_ptr<osg::Node> getNode() const
+        {
+            return mNode;
+        }
+
+    private:
+        struct Mesh
+        {
+            Mesh()
+                : mRadius(0.f)
+            {
+            }
+
+            osg::ref_ptr<const osg::Node> mNode; // keeps the geometries alive
+            std::vector<StaticGeometry> mGeometries; // empty if the mesh is not static
+            std::vector<int> mLayouts;
+            float mRadius;
+        };
+
+        Mesh loadMesh(const std::string& model)
+        {
+            Mesh mesh;
+            try
+            {
+                mesh.mNode = mSceneManager->getTemplate(model);
+            }
+            catch (std::exception& e)
+            {
+                std::cerr << "Failed to load '" << model << "' for object paging: " << e.what() << std::endl;
+                return mesh;
+            }
+
+            std::vector<StaticGeometry> geometries;
+            if (!collectStaticGeometry(*mesh.mNode, geometries))
+                return mesh;
+
+            // bounds of our own, as computing the bounds of the shared mesh would not be thread safe
+            osg::BoundingBox box;
+            for (std::vector<StaticGeometry>::const_iterator it = geometries.begin(); it != geometries.end(); ++it)
+            {
+                int layout = getLayout(*it->mGeometry);
+                if (layout < 0)
+                    continue;
+
+                const osg::Vec3Array& vertices = static_cast<const osg::Vec3Array&>(*it->mGeometry->getVertexArray());
+                for (osg::Vec3Array::const_iterator vertex = vertices.begin(); vertex != vertices.end(); ++vertex)
+                    box.expandBy(*vertex * it->mMatrix);
+
+                mesh.mGeometries.push_back(*it);
+                mesh.mLayouts.push_back(layout);
+            }
+
+            if (box.valid())
+                mesh.mRadius = box.radius();
+            return mesh;
+        }
+
+        volatile bool mAborted;
+
+        MWWorld::ContentRefReader mReader;
+        const MWWorld::ESMStore& mStore;
+        Resource::SceneManager* mSceneManager;
+        osg::Vec3f mOrigin;
+
+        osg::ref_ptr<osg::Node> mNode;
+    };
+
+    ObjectPaging::ObjectPaging(osg::Group* parent, Resource::SceneManager* sceneManager, SceneUtil::WorkQueue* workQueue,
+                               SceneUtil::UnrefQueue* unrefQueue)
+        : mRootNode(new osg::Group)
+        , mSceneManager(sceneManager)
+        , mWorkQueue(workQueue)
+        , mUnrefQueue(unrefQueue)
+        , mCellRange(0)
+        , mEnabled(true)
+        , mHasCenter(false)
+        , mNumBuilding(0)
+    {
+        mRootNode->setName("Object Paging Root");
+        parent->addChild(mRootNode);
+    }
+
+    ObjectPaging::~ObjectPaging()
+    {
+        clear();
+
+        for (unsigned int i=0; i<mRootNode->getNumParents(); ++i)
+            mRootNode->getParent(i)->removeChild(mRootNode);
+    }
+
+    void ObjectPaging::update(const osg::Vec3f& viewPoint)
+    {
+        if (!mEnabled)
+            return;
+
+        for (std::map<CellIndex, Chunk>::iterator it = mChunks.begin(); it != mChunks.end(); ++it)
+        {
+            Chunk& chunk = it->second;
+            if (!chunk.mWorkItem || !chunk.mWorkItem->isDone())
+                continue;
+
+            chunk.mNode = chunk.mWorkItem->getNode();
+            chunk.mWorkItem = NULL;
+            --mNumBuilding;
+
+            if (chunk.mNode)
+            {
+                updateNodeMask(it->first, chunk.mNode);
+                mRootNode->addChild(chunk.mNode);
+            }
+        }
+
+        CellIndex center(static_cast<int>(std::floor(viewPoint.x() / ESM::Land::REAL_SIZE)),
+                         static_cast<int>(std::floor(viewPoint.y() / ESM::Land::REAL_SIZE)));
+        if (mHasCenter && center == mCenter)
+            return;
+        mHasCenter = true;
+        mCenter = center;
+
+        // keep chunks one cell beyond the range, so walking back and forth over a cell border does not rebuild them
+        for (std::map<CellIndex, Chunk>::iterator it = mChunks.begin(); it != mChunks.end();)
+        {
+            if (std::abs(it->first.first - center.first) > mCellRange + 1 || std::abs(it->first.second - center.second) > mCellRange + 1)
+                removeChunk(it++);
+            else
+                ++it;
+        }
+
+        // nearest cells first
+        std::multimap<int, CellIndex> requests;
+        for (int x = center.first - mCellRange; x <= center.first + mCellRange; ++x)
+        {
+            for (int y = center.second - mCellRange; y <= center.second + mCellRange; ++y)
+            {
+                CellIndex cell(x, y);
+                if (mChunks.find(cell) == mChunks.end())
+                    requests.insert(std::make_pair(std::max(std::abs(x - center.first), std::abs(y - center.second)), cell));
+            }
+        }
+
+        // read the cell records directly, as going through the world would put CellStores into its cache
+        const MWWorld::Store<ESM::Cell>& cells = MWBase::Environment::get().getWorld()->getStore().get<ESM::Cell>();
+        for (std::multimap<int, CellIndex>::const_iterator it = requests.begin(); it != requests.end(); ++it)
+        {
+            Chunk& chunk = mChunks[it->second];
+
+            // no record for ocean cells, so no statics either
+            const ESM::Cell* cell = cells.search(it->second.first, it->second.second);
+            if (!cell)
+                continue;
+
+            chunk.mWorkItem = new BuildChunkItem(cell, mSceneManager);
+            mWorkQueue->addWorkItem(chunk.mWorkItem);
+            ++mNumBuilding;
+        }
+    }
+
+    void ObjectPaging::setViewDistance(float distance)
+    {
+        int range = static_cast<int>(std::ceil(distance / ESM::Land::REAL_SIZE));
+        if (range != mCellRange)
+        {
+            mCellRange = range;
+            mHasCenter = false;
+        }
+    }
+
+    void ObjectPaging::setCellActive(int x, int y, bool active)
+    {
+        CellIndex cell(x, y);
+        if (active)
+            mActiveCells.insert(cell);
+        else
+            mActiveCells.erase(cell);
+
+        std::map<CellIndex, Chunk>::const_iterator found = mChunks.find(cell);
+        if (found != mChunks.end() && found->second.mNode)
+            updateNodeMask(cell, found->second.mNode);
+    }
+
+    void ObjectPaging::enable(bool enabled)
+    {
+        mEnabled = enabled;
+        mRootNode->setNodeMask(enabled ? ~0 : 0);
+    }
+
+    void ObjectPaging::clear()
+    {
+        while (!mChunks.empty())
+            removeChunk(mChunks.begin());
+        mHasCenter = false;
+    }
+
+    void ObjectPaging::reportStats(unsigned int frameNumber, osg::Stats* stats) const
+    {
+        stats->setAttribute(frameNumber, "Object Chunk", mChunks.size() - mNumBuilding);
+        stats->setAttribute(frameNumber, "Object Chunk Building", mNumBuilding);
+    }
+
+    void ObjectPaging::removeChunk(std::map<CellIndex, Chunk>::iterator it)
+    {
+        Chunk& chunk = it->second;
+        if (chunk.mWorkItem)
+        {
+            // no need to wait, the queue keeps the item alive until it is done
+            chunk.mWorkItem->abort();
+            --mNumBuilding;
+        }
+
+        if (chunk.mNode)
+        {
+            mRootNode->removeChild(chunk.mNode);
+            if (mUnrefQueue.get())
+                mUnrefQueue->push(chunk.mNode);
+        }
+
+        mChunks.erase(it);
+    }
+
+    void ObjectPaging::updateNodeMask(const CellIndex& cell, osg::Node* node) const
+    {
+        node->setNodeMask(mActiveCells.count(cell) ? 0 : ~0);
+    }
+
+}
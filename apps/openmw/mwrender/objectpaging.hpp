@@ -0,0 +1,101 @@
+#ifndef OPENMW_MWRENDER_OBJECTPAGING_H
+#define OPENMW_MWRENDER_OBJECTPAGING_H
+
+#include <map>
+#include <set>
+#include <utility>
+
+#include <osg/ref_ptr>
+#include <osg/Vec3f>
+
+namespace osg
+{
+    class Group;
+    class Node;
+    class Stats;
+}
+
+namespace Resource
+{
+    class SceneManager;
+}
+
+namespace SceneUtil
+{
+    class WorkQueue;
+    class UnrefQueue;
+}
+
+namespace MWRender
+{
+    class BuildChunkItem;
+
+    /// \brief Draws the statics of exterior cells that are not active
+    ///
+    /// For each cell within the viewing distance, a worker thread reads the references of the cell from the content
+    /// files and merges the geometry of its statics by StateSet into a few large drawables, so a distant town costs a
+    /// handful of draw calls. Objects that are small compared to a cell are left out when the cell is far away.
+    ///
+    /// The chunks only show the statics as placed by the content files. Active cells are drawn by Objects instead;
+    /// their chunks stay loaded, but hidden, for when the cell becomes inactive again.
+    class ObjectPaging
+    {
+    public:
+        ObjectPaging(osg::Group* parent, Resource::SceneManager* sceneManager, SceneUtil::WorkQueue* workQueue,
+                     SceneUtil::UnrefQueue* unrefQueue);
+        ~ObjectPaging();
+
+        /// Request the chunks around \a viewPoint, drop those out of range and attach the ones that are done.
+        /// Call once per frame.
+        void update(const osg::Vec3f& viewPoint);
+
+        /// Set the distance up to which cells are drawn.
+        void setViewDistance(float distance);
+
+        /// Is the exterior cell at \a x, \a y active, i.e. are its objects drawn by Objects?
+        void setCellActive(int x, int y, bool active);
+
+        /// Show or hide all chunks, e.g. in interiors.
+        void enable(bool enabled);
+
+        /// Drop all chunks.
+        void clear();
+
+        void reportStats(unsigned int frameNumber, osg::Stats* stats) const;
+
+    private:
+        typedef std::pair<int, int> CellIndex;
+
+        struct Chunk
+        {
+            osg::ref_ptr<BuildChunkItem> mWorkItem; // while building
+            osg::ref_ptr<osg::Node> mNode; // NULL for cells without statics
+        };
+
+        void removeChunk(std::map<CellIndex, Chunk>::iterator it);
+
+        void updateNodeMask(const CellIndex& cell, osg::Node* node) const;
+
+        osg::ref_ptr<osg::Group> mRootNode;
+        Resource::SceneManager* mSceneManager;
+        osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+        osg::ref_ptr<SceneUtil::UnrefQueue> mUnrefQueue;
+
+        int mCellRange;
+        bool mEnabled;
+
+        bool mHasCenter;
+        CellIndex mCenter;
+
+        std::map<CellIndex, Chunk> mChunks;
+        std::set<CellIndex> mActiveCells;
+
+        unsigned int mNumBuilding;
+
+        ObjectPaging(const ObjectPaging&);
+        void operator=(const ObjectPaging&);
+    };
+
+}
+
+#endif
@@ -7,6 +7,8 @@
 
 #include <components/sceneutil/positionattitudetransform.hpp>
 #include <components/sceneutil/unrefqueue.hpp>
+#include <components/resource/resourcesystem.hpp>
+#include <components/settings/settings.hpp>
 
 #include "../mwworld/ptr.hpp"
 #include "../mwworld/class.hpp"
@@ -14,6 +16,8 @@
 #include "animation.hpp"
 #include "npcanimation.hpp"
 #include "creatureanimation.hpp"
+#include "instancedstatics.hpp"
+#include "npcpartspool.hpp"
 #include "vismask.hpp"
 
 
@@ -24,12 +28,17 @@ Objects::Objects(Resource::ResourceSystem* resourceSystem, osg::ref_ptr<osg::Gro
     : mRootNode(rootNode)
     , mResourceSystem(resourceSystem)
     , mUnrefQueue(unrefQueue)
+    , mNpcPartsPool(new NpcPartsPool(unrefQueue))
 {
+    if (Settings::Manager::getBool("instance static objects", "Shaders"))
+        mInstancedStatics.reset(new InstancedStatics(resourceSystem->getSceneManager(), unrefQueue));
 }
 
 Objects::~Objects()
 {
+    mInstancedStatics.reset();
     mObjects.clear();
+    mNpcPartsPool.reset();
 
     for (CellMap::iterator iter = mCellSceneNodes.begin(); iter != mCellSceneNodes.end(); ++iter)
         iter->second->getParent(0)->removeChild(iter->second);
@@ -38,7 +47,7 @@ Objects::~Objects()
 
 void Objects::insertBegin(const MWWorld::Ptr& ptr)
 {
-    assert(mObjects.find(ptr) == mObjects.end());
+    assert(!findHandle(ptr).isValid());
 
     osg::ref_ptr<osg::Group> cellnode;
 
@@ -70,13 +79,16 @@ void Objects::insertBegin(const MWWorld::Ptr& ptr)
     ptr.getRefData().setBaseNode(insert);
 }
 
-void Objects::insertModel(const MWWorld::Ptr &ptr, const std::string &mesh, bool animated, bool allowLight)
+void Objects::insertModel(const MWWorld::Ptr &ptr, const std::string &mesh, bool animated, bool allowLight, bool instanced)
 {
     insertBegin(ptr);
 
     osg::ref_ptr<ObjectAnimation> anim (new ObjectAnimation(ptr, mesh, mResourceSystem, animated, allowLight));
 
-    mObjects.insert(std::make_pair(ptr, anim));
+    insertEnd(ptr, anim);
+
+    if (instanced && mInstancedStatics)
+        mInstancedStatics->add(ptr.getCell(), ptr.getRefData().getBaseNode(), mesh);
 }
 
 void Objects::insertCreature(const MWWorld::Ptr &ptr, const std::string &mesh, bool weaponsShields)
@@ -92,8 +104,8 @@ void Objects::insertCreature(const MWWorld::Ptr &ptr, const std::string &mesh, b
     else
         anim = new CreatureAnimation(ptr, mesh, mResourceSystem);
 
-    if (mObjects.insert(std::make_pair(ptr, anim)).second)
-        ptr.getClass().getContainerStore(ptr).setContListener(static_cast<ActorAnimation*>(anim.get()));
+    insertEnd(ptr, anim);
+    ptr.getClass().getContainerStore(ptr).setContListener(static_cast<ActorAnimation*>(anim.get()));
 }
 
 void Objects::insertNPC(const MWWorld::Ptr &ptr)
@@ -101,13 +113,29 @@ void Objects::insertNPC(const MWWorld::Ptr &ptr)
     insertBegin(ptr);
     ptr.getRefData().getBaseNode()->setNodeMask(Mask_Actor);
 
-    osg::ref_ptr<NpcAnimation> anim (new NpcAnimation(ptr, osg::ref_ptr<osg::Group>(ptr.getRefData().getBaseNode()), mResourceSystem));
+    osg::ref_ptr<NpcAnimation> anim (new NpcAnimation(ptr, osg::ref_ptr<osg::Group>(ptr.getRefData().getBaseNode()), mResourceSystem,
+                                                      false, NpcAnimation::VM_Normal, 55.f, mNpcPartsPool.get()));
 
-    if (mObjects.insert(std::make_pair(ptr, anim)).second)
-    {
-        ptr.getClass().getInventoryStore(ptr).setInvListener(anim.get(), ptr);
-        ptr.getClass().getInventoryStore(ptr).setContListener(anim.get());
-    }
+    insertEnd(ptr, anim);
+    ptr.getClass().getInventoryStore(ptr).setInvListener(anim.get(), ptr);
+    ptr.getClass().getInventoryStore(ptr).setContListener(anim.get());
+}
+
+void Objects::insertEnd(const MWWorld::Ptr& ptr, osg::ref_ptr<Animation> anim)
+{
+    ptr.getRefData().setRenderHandle(mObjects.insert(anim));
+}
+
+Misc::SlotHandle Objects::findHandle(const MWWorld::ConstPtr& ptr) const
+{
+    Misc::SlotHandle handle = ptr.getRefData().getRenderHandle();
+
+    // copies of the object share the handle
+    const osg::ref_ptr<Animation>* anim = mObjects.find(handle);
+    if (anim && MWWorld::ConstPtr((*anim)->getPtr()) == ptr)
+        return handle;
+
+    return Misc::SlotHandle();
 }
 
 bool Objects::removeObject (const MWWorld::Ptr& ptr)
@@ -115,20 +143,16 @@ bool Objects::removeObject (const MWWorld::Ptr& ptr)
     if(!ptr.getRefData().getBaseNode())
         return true;
 
-    PtrAnimationMap::iterator iter = mObjects.find(ptr);
-    if(iter != mObjects.end())
+    Misc::SlotHandle handle = findHandle(ptr);
+    if (handle.isValid())
     {
-        if (mUnrefQueue.get())
-            mUnrefQueue->push(iter->second);
+        if (mInstancedStatics)
+            mInstancedStatics->remove(ptr.getRefData().getBaseNode());
 
-        mObjects.erase(iter);
+        releaseAnimation(ptr, *mObjects.find(handle));
 
-        if (ptr.getClass().isNpc())
-        {
-            MWWorld::InventoryStore& store = ptr.getClass().getInventoryStore(ptr);
-            store.setInvListener(NULL, ptr);
-            store.setContListener(NULL);
-        }
+        mObjects.erase(handle);
+        ptr.getRefData().setRenderHandle(Misc::SlotHandle());
 
         ptr.getRefData().getBaseNode()->getParent(0)->removeChild(ptr.getRefData().getBaseNode());
 
@@ -139,27 +163,40 @@ bool Objects::removeObject (const MWWorld::Ptr& ptr)
 }
 
 
+void Objects::releaseAnimation(const MWWorld::Ptr& ptr, osg::ref_ptr<Animation> anim)
+{
+    if (ptr.getClass().isNpc() && ptr.getRefData().getCustomData())
+    {
+        MWWorld::InventoryStore& invStore = ptr.getClass().getInventoryStore(ptr);
+        invStore.setInvListener(NULL, ptr);
+        invStore.setContListener(NULL);
+
+        if (NpcAnimation* npcAnim = dynamic_cast<NpcAnimation*>(anim.get()))
+            npcAnim->recycle();
+    }
+
+    if (mUnrefQueue.get())
+        mUnrefQueue->push(anim);
+}
+
 void Objects::removeCell(const MWWorld::CellStore* store)
 {
-    for(PtrAnimationMap::iterator iter = mObjects.begin();iter != mObjects.end();)
+    if (mInstancedStatics)
+        mInstancedStatics->removeCell(store);
+
+    // erasing moves the last animation into the position of the erased one
+    for (std::size_t i = 0; i < mObjects.size();)
     {
-        MWWorld::Ptr ptr = iter->second->getPtr();
+        MWWorld::Ptr ptr = mObjects[i]->getPtr();
         if(ptr.getCell() == store)
         {
-            if (mUnrefQueue.get())
-                mUnrefQueue->push(iter->second);
+            releaseAnimation(ptr, mObjects[i]);
 
-            if (ptr.getClass().isNpc() && ptr.getRefData().getCustomData())
-            {
-                MWWorld::InventoryStore& invStore = ptr.getClass().getInventoryStore(ptr);
-                invStore.setInvListener(NULL, ptr);
-                invStore.setContListener(NULL);
-            }
-
-            mObjects.erase(iter++);
+            mObjects.erase(mObjects.getHandle(i));
+            ptr.getRefData().setRenderHandle(Misc::SlotHandle());
         }
         else
-            ++iter;
+            ++i;
     }
 
     CellMap::iterator cell = mCellSceneNodes.find(store);
@@ -172,12 +209,31 @@ void Objects::removeCell(const MWWorld::CellStore* store)
     }
 }
 
+void Objects::finishCell(const MWWorld::CellStore* store)
+{
+    if (!mInstancedStatics)
+        return;
+
+    CellMap::iterator found = mCellSceneNodes.find(store);
+    if (found != mCellSceneNodes.end())
+        mInstancedStatics->finishCell(store, found->second);
+}
+
+void Objects::unbatchObject(const MWWorld::Ptr& ptr)
+{
+    if (mInstancedStatics && ptr.getRefData().getBaseNode())
+        mInstancedStatics->remove(ptr.getRefData().getBaseNode());
+}
+
 void Objects::updatePtr(const MWWorld::Ptr &old, const MWWorld::Ptr &cur)
 {
     osg::Node* objectNode = cur.getRefData().getBaseNode();
     if (!objectNode)
         return;
 
+    if (mInstancedStatics)
+        mInstancedStatics->remove(objectNode);
+
     MWWorld::CellStore *newCell = cur.getCell();
 
     osg::Group* cellnode;
@@ -201,30 +257,28 @@ void Objects::updatePtr(const MWWorld::Ptr &old, const MWWorld::Ptr &cur)
         objectNode->getParent(0)->removeChild(objectNode);
     cellnode->addChild(objectNode);
 
-    PtrAnimationMap::iterator iter = mObjects.find(old);
-    if(iter != mObjects.end())
+    Misc::SlotHandle handle = findHandle(old);
+    if (handle.isValid())
     {
-        osg::ref_ptr<Animation> anim = iter->second;
-        mObjects.erase(iter);
-        anim->updatePtr(cur);
-        mObjects[cur] = anim;
+        (*mObjects.find(handle))->updatePtr(cur);
+        cur.getRefData().setRenderHandle(handle);
     }
 }
 
 Animation* Objects::getAnimation(const MWWorld::Ptr &ptr)
 {
-    PtrAnimationMap::const_iterator iter = mObjects.find(ptr);
-    if(iter != mObjects.end())
-        return iter->second;
+    Misc::SlotHandle handle = findHandle(ptr);
+    if (handle.isValid())
+        return *mObjects.find(handle);
 
     return NULL;
 }
 
 const Animation* Objects::getAnimation(const MWWorld::ConstPtr &ptr) const
 {
-    PtrAnimationMap::const_iterator iter = mObjects.find(ptr);
-    if(iter != mObjects.end())
-        return iter->second;
+    Misc::SlotHandle handle = findHandle(ptr);
+    if (handle.isValid())
+        return *mObjects.find(handle);
 
     return NULL;
 }
@@ -8,6 +8,8 @@
 #include <osg/ref_ptr>
 #include <osg/Object>
 
+#include <components/misc/slotmap.hpp>
+
 #include "../mwworld/ptr.hpp"
 
 namespace osg
@@ -33,6 +35,8 @@ namespace SceneUtil
 namespace MWRender{
 
 class Animation;
+class InstancedStatics;
+class NpcPartsPool;
 
 class PtrHolder : public osg::Object
 {
@@ -57,11 +61,12 @@ public:
 };
 
 class Objects{
-    typedef std::map<MWWorld::ConstPtr,osg::ref_ptr<Animation> > PtrAnimationMap;
+    // found by the render handle of the object's RefData
+    typedef Misc::SlotMap<osg::ref_ptr<Animation> > AnimationMap;
 
     typedef std::map<const MWWorld::CellStore*, osg::ref_ptr<osg::Group> > CellMap;
     CellMap mCellSceneNodes;
-    PtrAnimationMap mObjects;
+    AnimationMap mObjects;
 
     osg::ref_ptr<osg::Group> mRootNode;
 
@@ -69,15 +74,30 @@ class Objects{
 
     osg::ref_ptr<SceneUtil::UnrefQueue> mUnrefQueue;
 
+    std::unique_ptr<InstancedStatics> mInstancedStatics;
+
+    std::unique_ptr<NpcPartsPool> mNpcPartsPool;
+
     void insertBegin(const MWWorld::Ptr& ptr);
 
+    /// Add the animation of an object that was just inserted.
+    void insertEnd(const MWWorld::Ptr& ptr, osg::ref_ptr<Animation> anim);
+
+    /// Get the handle of the object's animation, or an invalid handle if the object has none.
+    Misc::SlotHandle findHandle(const MWWorld::ConstPtr& ptr) const;
+
+    /// Drop the animation of an object that leaves the scene.
+    void releaseAnimation(const MWWorld::Ptr& ptr, osg::ref_ptr<Animation> anim);
+
 public:
     Objects(Resource::ResourceSystem* resourceSystem, osg::ref_ptr<osg::Group> rootNode, SceneUtil::UnrefQueue* unrefQueue);
     ~Objects();
 
     /// @param animated Attempt to load separate keyframes from a .kf file matching the model file?
     /// @param allowLight If false, no lights will be created, and particles systems will be removed.
-    void insertModel(const MWWorld::Ptr& ptr, const std::string &model, bool animated=false, bool allowLight=true);
+    /// @param instanced May the object be drawn together with other objects using the same model (see InstancedStatics)?
+    ///  Only for objects that do not change their appearance.
+    void insertModel(const MWWorld::Ptr& ptr, const std::string &model, bool animated=false, bool allowLight=true, bool instanced=false);
 
     void insertNPC(const MWWorld::Ptr& ptr);
     void insertCreature (const MWWorld::Ptr& ptr, const std::string& model, bool weaponsShields);
@@ -90,6 +110,12 @@ public:
 
     void removeCell(const MWWorld::CellStore* store);
 
+    /// Called when all objects of a cell have been inserted.
+    void finishCell(const MWWorld::CellStore* store);
+
+    /// Draw the object on its own from now on, e.g. because it is about to be moved.
+    void unbatchObject(const MWWorld::Ptr& ptr);
+
     /// Updates containing cell for object rendering data
     void updatePtr(const MWWorld::Ptr &old, const MWWorld::Ptr &cur);
 
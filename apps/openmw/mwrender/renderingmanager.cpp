@@ -3,6 +3,7 @@
 #include <stdexcept>
 #include <limits>
 #include <cstdlib>
+#include <sstream>
 
 #include <osg/Light>
 #include <osg/LightModel>
@@ -24,6 +25,7 @@
 #include <components/resource/keyframemanager.hpp>
 
 #include <components/settings/settings.hpp>
+#include <components/misc/stringops.hpp>
 
 #include <components/sceneutil/util.hpp>
 #include <components/sceneutil/lightmanager.hpp>
@@ -35,6 +37,7 @@
 
 #include <components/terrain/terraingrid.hpp>
 #include <components/terrain/quadtreeworld.hpp>
+#include <components/terrain/compositemapcache.hpp>
 
 #include <components/esm/loadcell.hpp>
 #include <components/fallback/fallback.hpp>
@@ -49,6 +52,7 @@
 #include "camera.hpp"
 #include "water.hpp"
 #include "terrainstorage.hpp"
+#include "objectpaging.hpp"
 #include "util.hpp"
 
 namespace MWRender
@@ -223,6 +227,10 @@ namespace MWRender
         else
             mTerrain.reset(new Terrain::TerrainGrid(sceneRoot, mRootNode, mResourceSystem, mTerrainStorage, Mask_Terrain, Mask_PreCompile));
         mTerrain->setDefaultViewer(mViewer->getCamera());
+        mTerrain->setBatchLayers(Settings::Manager::getBool("batch layers", "Terrain"));
+
+        if (distantTerrain && Settings::Manager::getBool("object paging", "Terrain"))
+            mObjectPaging.reset(new ObjectPaging(sceneRoot, mResourceSystem->getSceneManager(), mWorkQueue.get(), mUnrefQueue.get()));
 
         mCamera.reset(new Camera(mViewer->getCamera()));
 
@@ -283,6 +291,8 @@ namespace MWRender
         mFieldOfView = Settings::Manager::getFloat("field of view", "Camera");
         mFirstPersonFieldOfView = Settings::Manager::getFloat("first person field of view", "Camera");
         mStateUpdater->setFogEnd(mViewDistance);
+        if (mObjectPaging)
+            mObjectPaging->setViewDistance(mViewDistance);
 
         mRootNode->getOrCreateStateSet()->addUniform(new osg::Uniform("near", mNearClip));
         mRootNode->getOrCreateStateSet()->addUniform(new osg::Uniform("far", mViewDistance));
@@ -323,6 +333,30 @@ namespace MWRender
         return mTerrain.get();
     }
 
+    void RenderingManager::setupTerrainCache(const std::string &cachePath, const std::vector<std::string> &contentFiles)
+    {
+        if (!Settings::Manager::getBool("composite map cache", "Terrain"))
+            return;
+
+        // FNV-1a over the load order, so that changing the content files doesn't pick up stale composite maps
+        unsigned long long hash = 14695981039346656037ull;
+        for (std::vector<std::string>::const_iterator it = contentFiles.begin(); it != contentFiles.end(); ++it)
+        {
+            std::string name = Misc::StringUtils::lowerCase(*it);
+            // include the terminating null character to separate the names
+            for (std::size_t i=0; i<=name.size(); ++i)
+            {
+                hash ^= static_cast<unsigned char>(name.c_str()[i]);
+                hash *= 1099511628211ull;
+            }
+        }
+
+        std::ostringstream stream;
+        stream << cachePath << "/compositemaps/" << std::hex << hash;
+
+        mTerrain->setCompositeMapCache(new Terrain::CompositeMapCache(stream.str(), mWorkQueue.get()));
+    }
+
     void RenderingManager::preloadCommonAssets()
     {
         osg::ref_ptr<PreloadCommonAssetsWorkItem> workItem (new PreloadCommonAssetsWorkItem(mResourceSystem));
@@ -416,10 +450,16 @@ namespace MWRender
     {
         mPathgrid->addCell(store);
 
+        mObjects->finishCell(store);
+
         mWater->changeCell(store);
 
         if (store->getCell()->isExterior())
+        {
             mTerrain->loadCell(store->getCell()->getGridX(), store->getCell()->getGridY());
+            if (mObjectPaging)
+                mObjectPaging->setCellActive(store->getCell()->getGridX(), store->getCell()->getGridY(), true);
+        }
     }
     void RenderingManager::removeCell(const MWWorld::CellStore *store)
     {
@@ -427,7 +467,11 @@ namespace MWRender
         mObjects->removeCell(store);
 
         if (store->getCell()->isExterior())
+        {
             mTerrain->unloadCell(store->getCell()->getGridX(), store->getCell()->getGridY());
+            if (mObjectPaging)
+                mObjectPaging->setCellActive(store->getCell()->getGridX(), store->getCell()->getGridY(), false);
+        }
 
         mWater->removeCell(store);
     }
@@ -435,6 +479,8 @@ namespace MWRender
     void RenderingManager::enableTerrain(bool enable)
     {
         mTerrain->enable(enable);
+        if (mObjectPaging)
+            mObjectPaging->enable(enable);
     }
 
     void RenderingManager::setSkyEnabled(bool enabled)
@@ -508,6 +554,10 @@ namespace MWRender
         osg::Vec3f focal, cameraPos;
         mCamera->getPosition(focal, cameraPos);
         mCurrentCameraPos = cameraPos;
+
+        if (mObjectPaging)
+            mObjectPaging->update(cameraPos);
+
         if (mWater->isUnderwater(cameraPos))
         {
             float viewDistance = mViewDistance;
@@ -556,16 +606,19 @@ namespace MWRender
             mCamera->rotateCamera(-ptr.getRefData().getPosition().rot[0], -ptr.getRefData().getPosition().rot[2], false);
         }
 
+        mObjects->unbatchObject(ptr);
         ptr.getRefData().getBaseNode()->setAttitude(rot);
     }
 
     void RenderingManager::moveObject(const MWWorld::Ptr &ptr, const osg::Vec3f &pos)
     {
+        mObjects->unbatchObject(ptr);
         ptr.getRefData().getBaseNode()->setPosition(pos);
     }
 
     void RenderingManager::scaleObject(const MWWorld::Ptr &ptr, const osg::Vec3f &scale)
     {
+        mObjects->unbatchObject(ptr);
         ptr.getRefData().getBaseNode()->setScale(scale);
 
         if (ptr == mCamera->getTrackingPtr()) // update height of camera
@@ -941,6 +994,8 @@ namespace MWRender
             stats->setAttribute(frameNumber, "UnrefQueue", mUnrefQueue->getNumItems());
 
             mTerrain->reportStats(frameNumber, stats);
+            if (mObjectPaging)
+                mObjectPaging->reportStats(frameNumber, stats);
         }
     }
 
@@ -957,6 +1012,8 @@ namespace MWRender
             {
                 mViewDistance = Settings::Manager::getFloat("viewing distance", "Camera");
                 mStateUpdater->setFogEnd(mViewDistance);
+                if (mObjectPaging)
+                    mObjectPaging->setViewDistance(mViewDistance);
                 updateProjectionMatrix();
             }
             else if (it->first == "General" && (it->second == "texture filter" ||
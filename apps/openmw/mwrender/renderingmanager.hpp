@@ -67,6 +67,7 @@ namespace MWRender
     class Water;
     class TerrainStorage;
     class LandManager;
+    class ObjectPaging;
 
     class RenderingManager : public MWRender::RenderingInterface
     {
@@ -83,6 +84,10 @@ namespace MWRender
         SceneUtil::UnrefQueue* getUnrefQueue();
         Terrain::World* getTerrain();
 
+        /// Store rendered terrain composite maps below \a cachePath, if enabled in the settings.
+        /// @param contentFiles The composite maps are kept separately for each list of content files.
+        void setupTerrainCache(const std::string& cachePath, const std::vector<std::string>& contentFiles);
+
         osg::Uniform* mUniformNear;
         osg::Uniform* mUniformFar;
 
@@ -232,6 +237,7 @@ namespace MWRender
         std::unique_ptr<Water> mWater;
         std::unique_ptr<Terrain::World> mTerrain;
         TerrainStorage* mTerrainStorage;
+        std::unique_ptr<ObjectPaging> mObjectPaging;
         std::unique_ptr<SkyManager> mSky;
         std::unique_ptr<EffectManager> mEffectManager;
         osg::ref_ptr<NpcAnimation> mPlayerAnimation;
@@ -161,7 +161,9 @@ void RippleSimulation::removeEmitter (const MWWorld::ConstPtr& ptr)
     {
         if (it->mPtr == ptr)
         {
-            mEmitters.erase(it);
+            // the order of emitters does not matter, so move the last one into the gap
+            *it = mEmitters.back();
+            mEmitters.pop_back();
             return;
         }
     }
@@ -181,14 +183,16 @@ void RippleSimulation::updateEmitterPtr (const MWWorld::ConstPtr& old, const MWW
 
 void RippleSimulation::removeCell(const MWWorld::CellStore *store)
 {
-    for (std::vector<Emitter>::iterator it = mEmitters.begin(); it != mEmitters.end();)
+    for (std::size_t i = 0; i < mEmitters.size();)
     {
-        if ((it->mPtr.isInCell() && it->mPtr.getCell() == store) && it->mPtr != MWMechanics::getPlayer())
+        const MWWorld::ConstPtr& ptr = mEmitters[i].mPtr;
+        if ((ptr.isInCell() && ptr.getCell() == store) && ptr != MWMechanics::getPlayer())
         {
-            it = mEmitters.erase(it);
+            mEmitters[i] = mEmitters.back();
+            mEmitters.pop_back();
         }
         else
-            ++it;
+            ++i;
     }
 }
 
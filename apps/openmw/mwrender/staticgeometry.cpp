@@ -0,0 +1,113 @@
+#include "staticgeometry.hpp"
+
+#include <typeinfo>
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/MatrixTransform>
+#include <osg/PositionAttitudeTransform>
+
+namespace
+{
+    bool hasCallbacks(const osg::StateSet& stateSet)
+    {
+        if (stateSet.getUpdateCallback() || stateSet.getEventCallback())
+            return true;
+
+        const osg::StateSet::AttributeList& attributes = stateSet.getAttributeList();
+        for (osg::StateSet::AttributeList::const_iterator it = attributes.begin(); it != attributes.end(); ++it)
+            if (it->second.first->getUpdateCallback() || it->second.first->getEventCallback())
+                return true;
+
+        const osg::StateSet::TextureAttributeList& textureAttributes = stateSet.getTextureAttributeList();
+        for (unsigned int unit=0; unit<textureAttributes.size(); ++unit)
+        {
+            for (osg::StateSet::AttributeList::const_iterator it = textureAttributes[unit].begin(); it != textureAttributes[unit].end(); ++it)
+                if (it->second.first->getUpdateCallback() || it->second.first->getEventCallback())
+                    return true;
+        }
+
+        const osg::StateSet::UniformList& uniforms = stateSet.getUniformList();
+        for (osg::StateSet::UniformList::const_iterator it = uniforms.begin(); it != uniforms.end(); ++it)
+            if (it->second.first->getUpdateCallback() || it->second.first->getEventCallback())
+                return true;
+
+        return false;
+    }
+
+    bool collect(const osg::Node& node, const osg::Matrix& matrix, const osg::StateSet* stateSet,
+                 std::vector<MWRender::StaticGeometry>& geometries)
+    {
+        if (node.getNodeMask() == 0)
+            return true;
+
+        if (node.getUpdateCallback() || node.getEventCallback() || node.getCullCallback())
+            return false;
+
+        // state of the parents, overridden by the state of this node. Unless both have state, the StateSet is used
+        // as it is, so geometries with the same state still share the same StateSet.
+        osg::ref_ptr<const osg::StateSet> mergedStateSet = stateSet;
+        if (const osg::StateSet* ownStateSet = node.getStateSet())
+        {
+            if (hasCallbacks(*ownStateSet))
+                return false;
+
+            if (stateSet)
+            {
+                osg::ref_ptr<osg::StateSet> merged (new osg::StateSet(*stateSet, osg::CopyOp::SHALLOW_COPY));
+                merged->merge(*ownStateSet);
+                mergedStateSet = merged;
+            }
+            else
+                mergedStateSet = ownStateSet;
+        }
+
+        if (typeid(node) == typeid(osg::Geometry))
+        {
+            const osg::Geometry& geometry = static_cast<const osg::Geometry&>(node);
+            if (geometry.getDrawCallback() || geometry.getComputeBoundingBoxCallback())
+                return false;
+
+            MWRender::StaticGeometry staticGeometry;
+            staticGeometry.mGeometry = &geometry;
+            staticGeometry.mStateSet = mergedStateSet;
+            staticGeometry.mMatrix = matrix;
+            geometries.push_back(staticGeometry);
+            return true;
+        }
+
+        osg::Matrix childMatrix (matrix);
+        if (dynamic_cast<const osg::MatrixTransform*>(&node) || typeid(node) == typeid(osg::PositionAttitudeTransform))
+        {
+            const osg::Transform& transform = static_cast<const osg::Transform&>(node);
+            if (transform.getReferenceFrame() != osg::Transform::RELATIVE_RF)
+                return false;
+            transform.computeLocalToWorldMatrix(childMatrix, NULL);
+        }
+        else if (typeid(node) != typeid(osg::Group) && typeid(node) != typeid(osg::Geode))
+            return false;
+
+        const osg::Group& group = static_cast<const osg::Group&>(node);
+        for (unsigned int i=0; i<group.getNumChildren(); ++i)
+        {
+            if (!collect(*group.getChild(i), childMatrix, mergedStateSet.get(), geometries))
+                return false;
+        }
+        return true;
+    }
+}
+
+namespace MWRender
+{
+
+    bool collectStaticGeometry(const osg::Node& node, std::vector<StaticGeometry>& geometries)
+    {
+        std::vector<StaticGeometry> collected;
+        if (!collect(node, osg::Matrix(), NULL, collected))
+            return false;
+
+        geometries.insert(geometries.end(), collected.begin(), collected.end());
+        return true;
+    }
+
+}
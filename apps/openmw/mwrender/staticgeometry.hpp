@@ -0,0 +1,35 @@
+#ifndef OPENMW_MWRENDER_STATICGEOMETRY_H
+#define OPENMW_MWRENDER_STATICGEOMETRY_H
+
+#include <vector>
+
+#include <osg/ref_ptr>
+#include <osg/Matrix>
+
+namespace osg
+{
+    class Node;
+    class Geometry;
+    class StateSet;
+}
+
+namespace MWRender
+{
+
+    /// A geometry of a mesh, with the state and transform it inherits from the nodes above it
+    struct StaticGeometry
+    {
+        osg::ref_ptr<const osg::Geometry> mGeometry;
+        osg::ref_ptr<const osg::StateSet> mStateSet; ///< may be NULL
+        osg::Matrix mMatrix; ///< relative to the root of the mesh
+    };
+
+    /// Collect the geometries of the mesh \a node, for drawing them other than as part of the mesh.
+    /// @return Is the mesh made of plain geometry that never changes? False for meshes with animations, particles,
+    /// switches, level of detail or callbacks.
+    /// @note Thread safe, as long as \a node is not modified meanwhile.
+    bool collectStaticGeometry(const osg::Node& node, std::vector<StaticGeometry>& geometries);
+
+}
+
+#endif
@@ -6,8 +6,18 @@
 #include <iostream>
 #include <algorithm>
 
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
+
 #include <components/vfs/manager.hpp>
 
+namespace
+{
+    // namespace scope, so they are initialized before any decoder exists
+    OpenThreads::Mutex sInitMutex;
+    bool sInitDone = false;
+}
+
 namespace MWSound
 {
 
@@ -430,13 +440,14 @@ FFmpeg_Decoder::FFmpeg_Decoder(const VFS::Manager* vfs)
     memset(&mPacket, 0, sizeof(mPacket));
 
     /* We need to make sure ffmpeg is initialized. Optionally silence warning
-     * output from the lib */
-    static bool done_init = false;
-    if(!done_init)
+     * output from the lib. The sound manager creates decoders on the main
+     * thread, but the lock keeps this safe no matter who creates them. */
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(sInitMutex);
+    if(!sInitDone)
     {
         av_register_all();
         av_log_set_level(AV_LOG_ERROR);
-        done_init = true;
+        sInitDone = true;
     }
 }
 
@@ -1,66 +1,118 @@
 #include "loudness.hpp"
 
 #include <stdint.h>
+#include <cmath>
+#include <cstring>
 #include <limits>
 #include <algorithm>
 
+#include <OpenThreads/ScopedLock>
+
 #include "soundmanagerimp.hpp"
 
 namespace MWSound
 {
 
-void Sound_Loudness::analyzeLoudness(const std::vector< char >& data)
+void Sound_Loudness::setFormat(int sampleRate, ChannelConfig chans, SampleType type)
 {
-    mQueue.insert( mQueue.end(), data.begin(), data.end() );
-    if (!mQueue.size())
-        return;
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+    mSampleRate = sampleRate;
+    mChannelConfig = chans;
+    mSampleType = type;
+    mSamples.clear();
+    mSegmentSum = 0.f;
+    mSegmentFrames = 0;
+    mRemainder.clear();
+    mComplete = false;
+}
 
-    int samplesPerSegment = static_cast<int>(mSampleRate / mSamplesPerSec);
-    int numSamples = bytesToFrames(mQueue.size(), mChannelConfig, mSampleType);
-    int advance = framesToBytes(1, mChannelConfig, mSampleType);
+void Sound_Loudness::analyzeLoudness(const char* data, size_t size)
+{
+    if (mSampleRate <= 0 || mSamplesPerSec <= 0.f)
+        return;
 
+    const int samplesPerSegment = std::max(1, static_cast<int>(mSampleRate / mSamplesPerSec));
+    const size_t advance = framesToBytes(1, mChannelConfig, mSampleType);
 
-    int segment=0;
-    int sample=0;
-    while (segment < numSamples/samplesPerSegment)
+    std::vector<float> newSamples;
+    auto addFrame = [&](const char* frame)
     {
-        float sum=0;
-        int samplesAdded = 0;
-        while (sample < numSamples && sample < (segment+1)*samplesPerSegment)
+        // get sample on a scale from -1 to 1
+        float value = 0;
+        if (mSampleType == SampleType_UInt8)
+            value = ((char)(*frame^0x80))/128.f;
+        else if (mSampleType == SampleType_Int16)
+        {
+            int16_t sample;
+            std::memcpy(&sample, frame, sizeof(sample));
+            value = sample / float(std::numeric_limits<int16_t>::max());
+        }
+        else if (mSampleType == SampleType_Float32)
+        {
+            std::memcpy(&value, frame, sizeof(value));
+            value = std::max(-1.f, std::min(1.f, value)); // Float samples *should* be scaled to [-1,1] already.
+        }
+
+        mSegmentSum += value*value;
+        if (++mSegmentFrames == samplesPerSegment)
         {
-            // get sample on a scale from -1 to 1
-            float value = 0;
-            if (mSampleType == SampleType_UInt8)
-                value = ((char)(mQueue[sample*advance]^0x80))/128.f;
-            else if (mSampleType == SampleType_Int16)
-            {
-                value = *reinterpret_cast<const int16_t*>(&mQueue[sample*advance]);
-                value /= float(std::numeric_limits<int16_t>::max());
-            }
-            else if (mSampleType == SampleType_Float32)
-            {
-                value = *reinterpret_cast<const float*>(&mQueue[sample*advance]);
-                value = std::max(-1.f, std::min(1.f, value)); // Float samples *should* be scaled to [-1,1] already.
-            }
-
-            sum += value*value;
-            ++samplesAdded;
-            ++sample;
+            newSamples.push_back(std::sqrt(mSegmentSum / mSegmentFrames)); // root mean square
+            mSegmentSum = 0.f;
+            mSegmentFrames = 0;
         }
+    };
 
-        float rms = 0; // root mean square
-        if (samplesAdded > 0)
-            rms = std::sqrt(sum / samplesAdded);
-        mSamples.push_back(rms);
-        ++segment;
+    // Complete a frame that was split between two chunks
+    if (!mRemainder.empty())
+    {
+        size_t needed = std::min(advance - mRemainder.size(), size);
+        mRemainder.insert(mRemainder.end(), data, data + needed);
+        data += needed;
+        size -= needed;
+        if (mRemainder.size() < advance)
+            return;
+        addFrame(&mRemainder[0]);
+        mRemainder.clear();
     }
 
-    mQueue.erase(mQueue.begin(), mQueue.begin() + sample*advance);
+    for (; size >= advance; data += advance, size -= advance)
+        addFrame(data);
+
+    mRemainder.assign(data, data + size);
+
+    if (!newSamples.empty())
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        mSamples.insert(mSamples.end(), newSamples.begin(), newSamples.end());
+    }
+}
+
+void Sound_Loudness::finishAnalysis()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+    if (mSegmentFrames > 0)
+        mSamples.push_back(std::sqrt(mSegmentSum / mSegmentFrames));
+    mSegmentSum = 0.f;
+    mSegmentFrames = 0;
+    mRemainder.clear();
+    mComplete = true;
 }
 
+bool Sound_Loudness::isComplete() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+    return mComplete;
+}
+
+std::vector<float> Sound_Loudness::getSamples() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+    return mSamples;
+}
 
 float Sound_Loudness::getLoudnessAtTime(float sec) const
 {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
     if(mSamplesPerSec <= 0.0f || mSamples.empty() || sec < 0.0f)
         return 0.0f;
 
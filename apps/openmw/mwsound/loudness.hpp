@@ -2,13 +2,16 @@
 #define GAME_SOUND_LOUDNESS_H
 
 #include <vector>
-#include <deque>
+
+#include <OpenThreads/Mutex>
 
 #include "sound_decoder.hpp"
 
 namespace MWSound
 {
 
+/// @brief Loudness envelope of a sound, used to drive lip movement.
+/// @note The envelope may be analyzed by the streaming thread while the main thread queries it, so access is guarded by a mutex.
 class Sound_Loudness {
     float mSamplesPerSec;
     int mSampleRate;
@@ -18,33 +21,76 @@ class Sound_Loudness {
     // Loudness sample info
     std::vector<float> mSamples;
 
-    std::deque<char> mQueue;
+    // Sum of squares and number of frames of the segment currently being analyzed
+    float mSegmentSum;
+    int mSegmentFrames;
+
+    // Incomplete frame left over from the last chunk of data
+    std::vector<char> mRemainder;
+
+    bool mComplete;
+
+    mutable OpenThreads::Mutex mMutex;
 
 public:
     /**
      * @param samplesPerSecond How many loudness values per second of audio to compute.
+    */
+    Sound_Loudness(float samplesPerSecond)
+        : mSamplesPerSec(samplesPerSecond)
+        , mSampleRate(0)
+        , mChannelConfig(ChannelConfig_Mono)
+        , mSampleType(SampleType_UInt8)
+        , mSegmentSum(0.f)
+        , mSegmentFrames(0)
+        , mComplete(false)
+    { }
+
+    /**
+     * Create an already analyzed envelope, e.g. one read from a cache.
+     * @param samplesPerSecond How many loudness values per second of audio were computed.
+     * @param samples the loudness values
+    */
+    Sound_Loudness(float samplesPerSecond, const std::vector<float>& samples)
+        : mSamplesPerSec(samplesPerSecond)
+        , mSampleRate(0)
+        , mChannelConfig(ChannelConfig_Mono)
+        , mSampleType(SampleType_UInt8)
+        , mSamples(samples)
+        , mSegmentSum(0.f)
+        , mSegmentFrames(0)
+        , mComplete(true)
+    { }
+
+    /**
+     * Set the format of the audio to analyze. Must be called before analyzeLoudness().
      * @param sampleRate the sample rate of the sound buffer
      * @param chans channel layout of the buffer
      * @param type sample type of the buffer
     */
-    Sound_Loudness(float samplesPerSecond, int sampleRate, ChannelConfig chans, SampleType type)
-        : mSamplesPerSec(samplesPerSecond)
-        , mSampleRate(sampleRate)
-        , mChannelConfig(chans)
-        , mSampleType(type)
-    { }
+    void setFormat(int sampleRate, ChannelConfig chans, SampleType type);
 
     /**
-     * Analyzes the energy (closely related to loudness) of a sound buffer.
-     * The buffer will be divided into segments according to \a valuesPerSecond,
+     * Analyzes the energy (closely related to loudness) of a chunk of audio.
+     * The audio is divided into segments according to the samples per second,
      * and for each segment a loudness value in the range of [0,1] will be computed.
-     * The computed values are then added to the mSamples vector. This method should be called continuously
-     * with chunks of audio until the whole audio file is processed.
-     * If the size of \a data does not exactly fit a number of loudness samples, the remainder
-     * will be kept in the mQueue and used in the next call to analyzeLoudness.
+     * This method should be called continuously with chunks of audio while the file is streamed.
+     * A segment that isn't complete at the end of \a data is carried over to the next call.
      * @param data the sound buffer to analyze, containing raw samples
+     * @param size the size of \a data in bytes
      */
-    void analyzeLoudness(const std::vector<char>& data);
+    void analyzeLoudness(const char* data, size_t size);
+
+    /// Flush the last, partial segment and mark the envelope as complete. Call once the end of the stream is reached.
+    void finishAnalysis();
+
+    /// Has the whole sound been analyzed?
+    bool isComplete() const;
+
+    float getSamplesPerSecond() const { return mSamplesPerSec; }
+
+    /// Get a copy of the loudness values analyzed so far.
+    std::vector<float> getSamples() const;
 
     /**
      * Get loudness at a particular time. Before calling this, the stream has to be analyzed up to that point in time (see analyzeLoudness()).
@@ -10,16 +10,20 @@
 
 #include <components/vfs/manager.hpp>
 
+#include <OpenThreads/Atomic>
 #include <OpenThreads/Thread>
 #include <OpenThreads/Condition>
 #include <OpenThreads/Mutex>
 #include <OpenThreads/ScopedLock>
 
+#include <components/sceneutil/workqueue.hpp>
+
 #include "openal_output.hpp"
 #include "sound_decoder.hpp"
 #include "sound.hpp"
 #include "soundmanagerimp.hpp"
 #include "loudness.hpp"
+#include "ringbuffer.hpp"
 
 #include "efx-presets.h"
 
@@ -38,7 +42,6 @@ namespace
 // Should this be defined publically somewhere?
 const float UnitsPerMeter = 69.99125109f;
 
-const int sLoudnessFPS = 20; // loudness values per second of audio
 
 ALCenum checkALCError(ALCdevice *device, const char *func, int line)
 {
@@ -262,12 +265,112 @@ static ALenum getALFormat(ChannelConfig chans, SampleType type)
 }
 
 
+//
+// Decoded PCM of a stream, shared between the stream and the decoder pool.
+//
+struct OpenAL_StreamData : public osg::Referenced
+{
+    DecoderPtr mDecoder;
+    RingBuffer mRing;
+    std::vector<char> mScratch;
+
+    std::shared_ptr<Sound_Loudness> mLoudness;
+    bool mAnalyzeLoudness;
+
+    OpenThreads::Atomic mEndOfStream;
+    OpenThreads::Atomic mFillPending;
+    OpenThreads::Atomic mAborted;
+
+    // Signalled after each fill so the stream thread can queue the new data right away
+    OpenThreads::Condition *mWakeCondition;
+
+    OpenAL_StreamData(DecoderPtr decoder, size_t chunkSize, size_t ringSize, OpenThreads::Condition *wake)
+      : mDecoder(std::move(decoder)), mRing(ringSize), mScratch(chunkSize)
+      , mAnalyzeLoudness(false), mWakeCondition(wake)
+    { }
+
+    /// Decode until the ring can't take another chunk. Called from a decoder pool thread.
+    void fill()
+    {
+        try {
+            while(!mAborted && !mEndOfStream && mRing.getWriteSpace() >= mScratch.size())
+            {
+                size_t got = mDecoder->read(mScratch.data(), mScratch.size());
+                if (mAnalyzeLoudness)
+                {
+                    // only analyze the decoded audio, not the padding
+                    mLoudness->analyzeLoudness(mScratch.data(), got);
+                    if (got < mScratch.size())
+                        mLoudness->finishAnalysis();
+                }
+                mRing.write(mScratch.data(), got);
+                if(got < mScratch.size())
+                    mEndOfStream.exchange(1);
+            }
+        }
+        catch(std::exception &e) {
+            std::cerr<< "Error decoding stream \""<<mDecoder->getName()<<"\": "<<e.what() <<std::endl;
+            mEndOfStream.exchange(1);
+        }
+        mFillPending.exchange(0);
+        mWakeCondition->broadcast();
+    }
+};
+
+class OpenAL_StreamFillItem : public SceneUtil::WorkItem
+{
+public:
+    OpenAL_StreamFillItem(OpenAL_StreamData *data)
+        : mData(data)
+        , mState(State_Queued)
+    {
+    }
+
+    virtual void doWork()
+    {
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mStateMutex);
+            if(mState != State_Queued)
+                return;
+            mState = State_Decoding;
+        }
+
+        mData->fill();
+    }
+
+    /// Stop a worker from picking up this item if it hasn't started on it yet.
+    /// @return true if the item will not touch the decoder anymore.
+    bool claim()
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mStateMutex);
+        if(mState != State_Queued)
+            return false;
+        mState = State_Claimed;
+        return true;
+    }
+
+private:
+    enum State {
+        State_Queued,
+        State_Decoding,
+        State_Claimed
+    };
+
+    osg::ref_ptr<OpenAL_StreamData> mData;
+
+    OpenThreads::Mutex mStateMutex;
+    State mState;
+};
+
+
 //
 // A streaming OpenAL sound.
 //
 class OpenAL_SoundStream
 {
     static const ALfloat sBufferLength;
+    // Seconds of audio the decoder pool may decode ahead of playback
+    static const ALfloat sDecodeAhead;
 
 private:
     ALuint mSource;
@@ -282,23 +385,35 @@ private:
     ALint mSilence;
 
     DecoderPtr mDecoder;
+    std::vector<char> mBufferData;
+
+    osg::ref_ptr<OpenAL_StreamData> mData;
+    osg::ref_ptr<OpenAL_StreamFillItem> mFillItem;
+    SceneUtil::WorkQueue *mDecoderQueue;
+
+    // Sample offset of the decoder when the stream started, and the number of samples queued since then
+    size_t mStartOffset;
+    size_t mSamplesQueued;
 
-    std::unique_ptr<Sound_Loudness> mLoudnessAnalyzer;
+    std::shared_ptr<Sound_Loudness> mLoudness;
 
+    bool mHasStarted;
     volatile bool mIsFinished;
 
     void updateAll(bool local);
 
+    void requestFill();
+
     OpenAL_SoundStream(const OpenAL_SoundStream &rhs);
     OpenAL_SoundStream& operator=(const OpenAL_SoundStream &rhs);
 
     friend class OpenAL_Output;
 
 public:
-    OpenAL_SoundStream(ALuint src, DecoderPtr decoder);
+    OpenAL_SoundStream(ALuint src, DecoderPtr decoder, SceneUtil::WorkQueue *decoderQueue);
     ~OpenAL_SoundStream();
 
-    bool init(bool getLoudnessData=false);
+    bool init(OpenThreads::Condition *wake, std::shared_ptr<Sound_Loudness> loudness=nullptr);
 
     bool isPlaying();
     double getStreamDelay() const;
@@ -306,10 +421,11 @@ public:
 
     float getCurrentLoudness() const;
 
-    bool process();
+    bool process(OpenThreads::Atomic &underruns);
     ALint refillQueue();
 };
 const ALfloat OpenAL_SoundStream::sBufferLength = 0.125f;
+const ALfloat OpenAL_SoundStream::sDecodeAhead = 1.0f;
 
 
 //
@@ -319,12 +435,15 @@ struct OpenAL_Output::StreamThread : public OpenThreads::Thread {
     typedef std::vector<OpenAL_SoundStream*> StreamVec;
     StreamVec mStreams;
 
+    // Number of times a stream's source ran dry before the stream was finished
+    OpenThreads::Atomic mUnderruns;
+
     volatile bool mQuitNow;
     OpenThreads::Mutex mMutex;
     OpenThreads::Condition mCondVar;
 
     StreamThread()
-      : mQuitNow(false)
+      : mUnderruns(0), mQuitNow(false)
     {
         start();
     }
@@ -345,7 +464,7 @@ struct OpenAL_Output::StreamThread : public OpenThreads::Thread {
             StreamVec::iterator iter = mStreams.begin();
             while(iter != mStreams.end())
             {
-                if((*iter)->process() == false)
+                if((*iter)->process(mUnderruns) == false)
                     iter = mStreams.erase(iter);
                 else
                     ++iter;
@@ -378,16 +497,22 @@ struct OpenAL_Output::StreamThread : public OpenThreads::Thread {
         mStreams.clear();
     }
 
+    unsigned int getUnderruns() const
+    {
+        return mUnderruns;
+    }
+
 private:
     StreamThread(const StreamThread &rhs);
     StreamThread& operator=(const StreamThread &rhs);
 };
 
 
-OpenAL_SoundStream::OpenAL_SoundStream(ALuint src, DecoderPtr decoder)
+OpenAL_SoundStream::OpenAL_SoundStream(ALuint src, DecoderPtr decoder, SceneUtil::WorkQueue *decoderQueue)
   : mSource(src), mCurrentBufIdx(0), mFormat(AL_NONE), mSampleRate(0)
   , mBufferSize(0), mFrameSize(0), mSilence(0), mDecoder(std::move(decoder))
-  , mLoudnessAnalyzer(nullptr)
+  , mDecoderQueue(decoderQueue), mStartOffset(0), mSamplesQueued(0)
+  , mLoudness(nullptr), mHasStarted(false)
 {
     mBuffers.fill(0);
 }
@@ -398,10 +523,16 @@ OpenAL_SoundStream::~OpenAL_SoundStream()
         alDeleteBuffers(mBuffers.size(), mBuffers.data());
     alGetError();
 
+    // Make sure no pool thread is still using the decoder before closing it
+    if(mData)
+        mData->mAborted.exchange(1);
+    if(mFillItem && !mFillItem->claim())
+        mFillItem->waitTillDone();
+
     mDecoder->close();
 }
 
-bool OpenAL_SoundStream::init(bool getLoudnessData)
+bool OpenAL_SoundStream::init(OpenThreads::Condition *wake, std::shared_ptr<Sound_Loudness> loudness)
 {
     alGenBuffers(mBuffers.size(), mBuffers.data());
     ALenum err = getALError();
@@ -414,6 +545,7 @@ bool OpenAL_SoundStream::init(bool getLoudnessData)
     try {
         mDecoder->getInfo(&mSampleRate, &chans, &type);
         mFormat = getALFormat(chans, type);
+        mStartOffset = mDecoder->getSampleOffset();
     }
     catch(std::exception &e) {
         std::cerr<< "Failed to get stream info: "<<e.what() <<std::endl;
@@ -430,14 +562,38 @@ bool OpenAL_SoundStream::init(bool getLoudnessData)
     mFrameSize = framesToBytes(1, chans, type);
     mBufferSize = static_cast<ALuint>(sBufferLength*mSampleRate);
     mBufferSize *= mFrameSize;
+    mBufferData.resize(mBufferSize);
 
-    if (getLoudnessData)
-        mLoudnessAnalyzer.reset(new Sound_Loudness(sLoudnessFPS, mSampleRate, chans, type));
+    size_t ringSize = static_cast<size_t>(sDecodeAhead*mSampleRate) * mFrameSize;
+    mData = new OpenAL_StreamData(mDecoder, mBufferSize, std::max<size_t>(ringSize, mBufferSize*2), wake);
+
+    // An envelope that is already complete (e.g. cached from an earlier playback) needs no analysis
+    mLoudness = std::move(loudness);
+    mData->mLoudness = mLoudness;
+    mData->mAnalyzeLoudness = mLoudness && !mLoudness->isComplete();
+    if (mData->mAnalyzeLoudness)
+        mLoudness->setFormat(mSampleRate, chans, type);
 
     mIsFinished = false;
+
+    // Start decoding right away, so the data is ready by the time the stream thread gets to it
+    requestFill();
     return true;
 }
 
+void OpenAL_SoundStream::requestFill()
+{
+    if(mData->mFillPending || mData->mEndOfStream)
+        return;
+    // No fill is in flight, so the free space is exact and can't shrink before the item below runs
+    if(mData->mRing.getFreeSpace() < mBufferSize)
+        return;
+
+    mData->mFillPending.exchange(1);
+    mFillItem = new OpenAL_StreamFillItem(mData.get());
+    mDecoderQueue->addWorkItem(mFillItem);
+}
+
 bool OpenAL_SoundStream::isPlaying()
 {
     ALint state;
@@ -476,6 +632,10 @@ double OpenAL_SoundStream::getStreamOffset() const
     ALint offset;
     double t;
 
+    // The decoder belongs to the decoder pool while streaming, so use the amount of queued data
+    // rather than the decoder offset.
+    size_t queuedOffset = mStartOffset + mSamplesQueued;
+
     alGetSourcei(mSource, AL_SAMPLE_OFFSET, &offset);
     alGetSourcei(mSource, AL_SOURCE_STATE, &state);
     if(state == AL_PLAYING || state == AL_PAUSED)
@@ -483,13 +643,13 @@ double OpenAL_SoundStream::getStreamOffset() const
         ALint queued;
         alGetSourcei(mSource, AL_BUFFERS_QUEUED, &queued);
         ALint inqueue = mBufferSize/mFrameSize*queued - offset;
-        t = (double)(mDecoder->getSampleOffset() - inqueue) / (double)mSampleRate;
+        t = (double)(queuedOffset - inqueue) / (double)mSampleRate;
     }
     else
     {
-        /* Underrun, or not started yet. The decoder offset is where we'll play
+        /* Underrun, or not started yet. The queued offset is where we'll play
          * next. */
-        t = (double)mDecoder->getSampleOffset() / (double)mSampleRate;
+        t = (double)queuedOffset / (double)mSampleRate;
     }
 
     getALError();
@@ -498,33 +658,34 @@ double OpenAL_SoundStream::getStreamOffset() const
 
 float OpenAL_SoundStream::getCurrentLoudness() const
 {
-    if (!mLoudnessAnalyzer.get())
+    if (!mLoudness)
         return 0.f;
 
     float time = getStreamOffset();
-    return mLoudnessAnalyzer->getLoudnessAtTime(time);
+    return mLoudness->getLoudnessAtTime(time);
 }
 
-bool OpenAL_SoundStream::process()
+bool OpenAL_SoundStream::process(OpenThreads::Atomic &underruns)
 {
-    try {
-        if(refillQueue() > 0)
+    if(refillQueue() > 0)
+    {
+        ALint state;
+        alGetSourcei(mSource, AL_SOURCE_STATE, &state);
+        if(state != AL_PLAYING && state != AL_PAUSED)
         {
-            ALint state;
-            alGetSourcei(mSource, AL_SOURCE_STATE, &state);
-            if(state != AL_PLAYING && state != AL_PAUSED)
-            {
-                // Ensure all processed buffers are removed so we don't replay them.
-                refillQueue();
+            // The source played everything it had while the stream still had more to come
+            if(mHasStarted)
+                ++underruns;
 
-                alSourcePlay(mSource);
-            }
+            // Ensure all processed buffers are removed so we don't replay them.
+            refillQueue();
+
+            alSourcePlay(mSource);
+            mHasStarted = true;
         }
     }
-    catch(std::exception&) {
-        std::cout<< "Error updating stream \""<<mDecoder->getName()<<"\"" <<std::endl;
-        mIsFinished = true;
-    }
+
+    requestFill();
     return !mIsFinished;
 }
 
@@ -541,27 +702,27 @@ ALint OpenAL_SoundStream::refillQueue()
 
     ALint queued;
     alGetSourcei(mSource, AL_BUFFERS_QUEUED, &queued);
-    if(!mIsFinished && (ALuint)queued < mBuffers.size())
+    for(;!mIsFinished && (ALuint)queued < mBuffers.size();++queued)
     {
-        std::vector<char> data(mBufferSize);
-        for(;!mIsFinished && (ALuint)queued < mBuffers.size();++queued)
-        {
-            size_t got = mDecoder->read(data.data(), data.size());
-            if(got < data.size())
-            {
-                mIsFinished = true;
-                std::fill(data.begin()+got, data.end(), mSilence);
-            }
-            if(got > 0)
-            {
-                if (mLoudnessAnalyzer.get())
-                    mLoudnessAnalyzer->analyzeLoudness(data);
+        // Check for the end of the stream first, the ring is complete once it is set
+        bool endOfStream = mData->mEndOfStream > 0;
+        size_t avail = mData->mRing.getReadSpace();
+        if(avail < mBufferSize && !endOfStream)
+            break;
 
-                ALuint bufid = mBuffers[mCurrentBufIdx];
-                alBufferData(bufid, mFormat, data.data(), data.size(), mSampleRate);
-                alSourceQueueBuffers(mSource, 1, &bufid);
-                mCurrentBufIdx = (mCurrentBufIdx+1) % mBuffers.size();
-            }
+        size_t got = mData->mRing.read(mBufferData.data(), mBufferData.size());
+        if(got < mBufferData.size())
+        {
+            mIsFinished = true;
+            std::fill(mBufferData.begin()+got, mBufferData.end(), mSilence);
+        }
+        if(got > 0)
+        {
+            ALuint bufid = mBuffers[mCurrentBufIdx];
+            alBufferData(bufid, mFormat, mBufferData.data(), mBufferData.size(), mSampleRate);
+            alSourceQueueBuffers(mSource, 1, &bufid);
+            mCurrentBufIdx = (mCurrentBufIdx+1) % mBuffers.size();
+            mSamplesQueued += mBufferSize/mFrameSize;
         }
     }
 
@@ -946,50 +1107,30 @@ void OpenAL_Output::setHrtf(const std::string &hrtfname, HrtfMode hrtfmode)
 }
 
 
-std::pair<Sound_Handle,size_t> OpenAL_Output::loadSound(const std::string &fname)
+std::pair<Sound_Handle,size_t> OpenAL_Output::loadSound(const Sound_Data &sounddata)
 {
     getALError();
 
-    std::vector<char> data;
-    ALenum format;
-    int srate;
+    const void *data = sounddata.mData.data();
+    size_t datalen = sounddata.mData.size();
+    int srate = sounddata.mSampleRate;
+    ALenum format = datalen ? getALFormat(sounddata.mChannelConfig, sounddata.mSampleType) : AL_NONE;
 
-    try {
-        DecoderPtr decoder = mManager.getDecoder();
-        // Workaround: Bethesda at some point converted some of the files to mp3, but the references were kept as .wav.
-        if(decoder->mResourceMgr->exists(fname))
-            decoder->open(fname);
-        else
-        {
-            std::string file = fname;
-            std::string::size_type pos = file.rfind('.');
-            if(pos != std::string::npos)
-                file = file.substr(0, pos)+".mp3";
-            decoder->open(file);
-        }
-
-        ChannelConfig chans;
-        SampleType type;
-        decoder->getInfo(&srate, &chans, &type);
-        format = getALFormat(chans, type);
-        if(format) decoder->readAll(data);
-    }
-    catch(std::exception &e) {
-        std::cerr<< "Failed to load audio from "<<fname<<": "<<e.what() <<std::endl;
-    }
-
-    if(data.empty())
+    std::vector<char> silence;
+    if(!format)
     {
         // If we failed to get any usable audio, substitute with silence.
         format = AL_FORMAT_MONO8;
         srate = 8000;
-        data.assign(8000, -128);
+        silence.assign(8000, -128);
+        data = silence.data();
+        datalen = silence.size();
     }
 
     ALint size;
     ALuint buf = 0;
     alGenBuffers(1, &buf);
-    alBufferData(buf, format, data.data(), data.size(), srate);
+    alBufferData(buf, format, data, datalen, srate);
     alGetBufferi(buf, AL_SIZE, &size);
     if(getALError() != AL_NO_ERROR)
     {
@@ -1229,6 +1370,23 @@ void OpenAL_Output::updateSound(Sound *sound)
     getALError();
 }
 
+float OpenAL_Output::getSoundOffset(Sound *sound)
+{
+    if(!sound->mHandle) return 0.0f;
+    ALuint source = GET_PTRID(sound->mHandle);
+    ALfloat offset = 0.0f;
+
+    alGetSourcef(source, AL_SEC_OFFSET, &offset);
+    getALError();
+
+    return offset;
+}
+
+size_t OpenAL_Output::getNumFreeSources() const
+{
+    return mFreeSources.size();
+}
+
 
 bool OpenAL_Output::streamSound(DecoderPtr decoder, Stream *sound)
 {
@@ -1246,8 +1404,8 @@ bool OpenAL_Output::streamSound(DecoderPtr decoder, Stream *sound)
     if(getALError() != AL_NO_ERROR)
         return false;
 
-    OpenAL_SoundStream *stream = new OpenAL_SoundStream(source, std::move(decoder));
-    if(!stream->init())
+    OpenAL_SoundStream *stream = new OpenAL_SoundStream(source, std::move(decoder), mDecoderQueue.get());
+    if(!stream->init(&mStreamThread->mCondVar))
     {
         delete stream;
         return false;
@@ -1260,7 +1418,7 @@ bool OpenAL_Output::streamSound(DecoderPtr decoder, Stream *sound)
     return true;
 }
 
-bool OpenAL_Output::streamSound3D(DecoderPtr decoder, Stream *sound, bool getLoudnessData)
+bool OpenAL_Output::streamSound3D(DecoderPtr decoder, Stream *sound, std::shared_ptr<Sound_Loudness> loudness)
 {
     if(mFreeSources.empty())
     {
@@ -1276,8 +1434,8 @@ bool OpenAL_Output::streamSound3D(DecoderPtr decoder, Stream *sound, bool getLou
     if(getALError() != AL_NO_ERROR)
         return false;
 
-    OpenAL_SoundStream *stream = new OpenAL_SoundStream(source, std::move(decoder));
-    if(!stream->init(getLoudnessData))
+    OpenAL_SoundStream *stream = new OpenAL_SoundStream(source, std::move(decoder), mDecoderQueue.get());
+    if(!stream->init(&mStreamThread->mCondVar, std::move(loudness)))
     {
         delete stream;
         return false;
@@ -1335,6 +1493,11 @@ float OpenAL_Output::getStreamLoudness(Stream *sound)
     return stream->getCurrentLoudness();
 }
 
+unsigned int OpenAL_Output::getStreamUnderruns()
+{
+    return mStreamThread->getUnderruns();
+}
+
 bool OpenAL_Output::isStreamPlaying(Stream *sound)
 {
     if(!sound->mHandle) return false;
@@ -1466,6 +1629,7 @@ OpenAL_Output::OpenAL_Output(SoundManager &mgr)
   , mListenerPos(0.0f, 0.0f, 0.0f), mListenerEnv(Env_Normal)
   , mWaterFilter(0), mWaterEffect(0), mDefaultEffect(0), mEffectSlot(0)
   , mStreamThread(new StreamThread)
+  , mDecoderQueue(new SceneUtil::WorkQueue(sNumDecoderThreads))
 {
 }
 
@@ -6,12 +6,19 @@
 #include <map>
 #include <deque>
 
+#include <osg/ref_ptr>
+
 #include "alc.h"
 #include "al.h"
 #include "alext.h"
 
 #include "sound_output.hpp"
 
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
 namespace MWSound
 {
     class SoundManager;
@@ -50,6 +57,11 @@ namespace MWSound
         struct StreamThread;
         std::unique_ptr<StreamThread> mStreamThread;
 
+        /// Decodes stream data ahead of playback, so a slow decoder can't hold up the other streams.
+        /// @note Declared after the stream thread, so pending decodes are finished before it goes away.
+        static const int sNumDecoderThreads = 2;
+        osg::ref_ptr<SceneUtil::WorkQueue> mDecoderQueue;
+
         void initCommon2D(ALuint source, const osg::Vec3f &pos, ALfloat gain, ALfloat pitch, bool loop, bool useenv);
         void initCommon3D(ALuint source, const osg::Vec3f &pos, ALfloat mindist, ALfloat maxdist, ALfloat gain, ALfloat pitch, bool loop, bool useenv);
 
@@ -66,7 +78,7 @@ namespace MWSound
         virtual std::vector<std::string> enumerateHrtf();
         virtual void setHrtf(const std::string &hrtfname, HrtfMode hrtfmode);
 
-        virtual std::pair<Sound_Handle,size_t> loadSound(const std::string &fname);
+        virtual std::pair<Sound_Handle,size_t> loadSound(const Sound_Data &data);
         virtual size_t unloadSound(Sound_Handle data);
 
         virtual bool playSound(Sound *sound, Sound_Handle data, float offset);
@@ -74,14 +86,17 @@ namespace MWSound
         virtual void finishSound(Sound *sound);
         virtual bool isSoundPlaying(Sound *sound);
         virtual void updateSound(Sound *sound);
+        virtual float getSoundOffset(Sound *sound);
+        virtual size_t getNumFreeSources() const;
 
         virtual bool streamSound(DecoderPtr decoder, Stream *sound);
-        virtual bool streamSound3D(DecoderPtr decoder, Stream *sound, bool getLoudnessData);
+        virtual bool streamSound3D(DecoderPtr decoder, Stream *sound, std::shared_ptr<Sound_Loudness> loudness);
         virtual void finishStream(Stream *sound);
         virtual double getStreamDelay(Stream *sound);
         virtual double getStreamOffset(Stream *sound);
         virtual float getStreamLoudness(Stream *sound);
         virtual bool isStreamPlaying(Stream *sound);
+        virtual unsigned int getStreamUnderruns();
         virtual void updateStream(Stream *sound);
 
         virtual void startUpdate();
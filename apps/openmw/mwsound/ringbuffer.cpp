@@ -0,0 +1,73 @@
+#include "ringbuffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace MWSound
+{
+
+RingBuffer::RingBuffer(size_t minCapacity)
+    : mMask(0)
+    , mReadPos(0)
+    , mWritePos(0)
+{
+    size_t capacity = 1;
+    while (capacity < minCapacity)
+        capacity <<= 1;
+    mData.resize(capacity);
+    mMask = static_cast<unsigned int>(capacity - 1);
+}
+
+size_t RingBuffer::getReadSpace() const
+{
+    unsigned int readPos = mReadPos;
+    unsigned int writePos = mWritePos;
+    return writePos - readPos;
+}
+
+size_t RingBuffer::getWriteSpace() const
+{
+    unsigned int writePos = mWritePos;
+    unsigned int readPos = mReadPos;
+    return mData.size() - (writePos - readPos);
+}
+
+size_t RingBuffer::getFreeSpace() const
+{
+    // the producer can only add data meanwhile, so the free space can only have shrunk since
+    return mData.size() - getReadSpace();
+}
+
+size_t RingBuffer::write(const char *data, size_t size)
+{
+    size = std::min(size, getWriteSpace());
+    // Loading the position again puts a barrier between the consumer's position and our writes
+    unsigned int writePos = mWritePos;
+
+    size_t offset = writePos & mMask;
+    size_t first = std::min(size, mData.size() - offset);
+    std::memcpy(&mData[offset], data, first);
+    std::memcpy(&mData[0], data + first, size - first);
+
+    // Loading the atomic acts as a barrier, so the data is visible before the new position is
+    mWritePos.exchange(mWritePos + static_cast<unsigned int>(size));
+    return size;
+}
+
+size_t RingBuffer::read(char *data, size_t size)
+{
+    size = std::min(size, getReadSpace());
+    // Loading the position again puts a barrier between the producer's position and our reads
+    unsigned int readPos = mReadPos;
+
+    size_t offset = readPos & mMask;
+    size_t first = std::min(size, mData.size() - offset);
+    std::memcpy(data, &mData[offset], first);
+    std::memcpy(data + first, &mData[0], size - first);
+
+    // Don't hand the space back to the producer until we're done copying out of it
+    mReadPos.exchange(mReadPos + static_cast<unsigned int>(size));
+    return size;
+}
+
+}
@@ -0,0 +1,48 @@
+#ifndef GAME_SOUND_RINGBUFFER_H
+#define GAME_SOUND_RINGBUFFER_H
+
+#include <vector>
+#include <cstddef>
+
+#include <OpenThreads/Atomic>
+
+namespace MWSound
+{
+
+/// @brief A byte ring buffer for a single producer and a single consumer thread.
+/// @note Reading and writing don't lock; each side only ever advances its own position. Loading an
+/// OpenThreads::Atomic issues a full memory barrier, which orders the data accesses against the positions.
+/// Positions are free-running counters, so the capacity is rounded up to a power of two.
+class RingBuffer {
+    std::vector<char> mData;
+    unsigned int mMask;
+
+    OpenThreads::Atomic mReadPos;
+    OpenThreads::Atomic mWritePos;
+
+    RingBuffer(const RingBuffer &rhs);
+    RingBuffer& operator=(const RingBuffer &rhs);
+
+public:
+    RingBuffer(size_t minCapacity);
+
+    size_t getCapacity() const { return mData.size(); }
+
+    /// Number of bytes that can be read. Only call from the consumer.
+    size_t getReadSpace() const;
+    /// Number of bytes that can be written. Only call from the producer.
+    size_t getWriteSpace() const;
+
+    /// Number of bytes the producer can at most write; the producer may fill some of it meanwhile.
+    /// Exact while the producer is known to be idle. Only call from the consumer.
+    size_t getFreeSpace() const;
+
+    /// Write up to \a size bytes, returns the number of bytes written. Only call from the producer.
+    size_t write(const char *data, size_t size);
+    /// Read up to \a size bytes, returns the number of bytes read. Only call from the consumer.
+    size_t read(char *data, size_t size);
+};
+
+}
+
+#endif
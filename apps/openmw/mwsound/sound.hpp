@@ -26,6 +26,9 @@ namespace MWSound
 
         float mFadeOutTime;
 
+        // Seconds into a sound that keeps playing without an output source, or negative if it isn't virtual
+        float mVirtualOffset;
+
     protected:
         Sound_Instance mHandle;
 
@@ -36,6 +39,7 @@ namespace MWSound
         void setVolume(float volume) { mVolume = volume; }
         void setBaseVolume(float volume) { mBaseVolume = volume; }
         void setFadeout(float duration) { mFadeOutTime = duration; }
+        void setVirtualOffset(float offset) { mVirtualOffset = offset; }
         void updateFade(float duration)
         {
             if(mFadeOutTime > 0.0f)
@@ -58,6 +62,8 @@ namespace MWSound
         bool getIsLooping() const { return mFlags&MWSound::PlayMode::Loop; }
         bool getDistanceCull() const { return mFlags&MWSound::PlayMode::RemoveAtDistance; }
         bool getIs3D() const { return mFlags&Play_3D; }
+        bool getIsVirtual() const { return mVirtualOffset >= 0.0f; }
+        float getVirtualOffset() const { return mVirtualOffset; }
 
         void init(const osg::Vec3f& pos, float vol, float basevol, float pitch, float mindist, float maxdist, int flags)
         {
@@ -69,6 +75,7 @@ namespace MWSound
             mMaxDistance = maxdist;
             mFlags = flags;
             mFadeOutTime = 0.0f;
+            mVirtualOffset = -1.0f;
             mHandle = nullptr;
         }
 
@@ -82,13 +89,14 @@ namespace MWSound
             mMaxDistance = 1000.0f;
             mFlags = flags;
             mFadeOutTime = 0.0f;
+            mVirtualOffset = -1.0f;
             mHandle = nullptr;
         }
 
         SoundBase()
           : mPos(0.0f, 0.0f, 0.0f), mVolume(1.0f), mBaseVolume(1.0f), mPitch(1.0f)
           , mMinDistance(1.0f), mMaxDistance(1000.0f), mFlags(0), mFadeOutTime(0.0f)
-          , mHandle(nullptr)
+          , mVirtualOffset(-1.0f), mHandle(nullptr)
         { }
     };
 
@@ -16,11 +16,13 @@ namespace MWSound
         float mMinDist, mMaxDist;
 
         Sound_Handle mHandle;
+        // Length of the loaded data in seconds
+        float mDuration;
 
         size_t mUses;
 
         Sound_Buffer(std::string resname, float volume, float mindist, float maxdist)
-          : mResourceName(resname), mVolume(volume), mMinDist(mindist), mMaxDist(maxdist), mHandle(0), mUses(0)
+          : mResourceName(resname), mVolume(volume), mMinDist(mindist), mMaxDist(maxdist), mHandle(0), mDuration(0.0f), mUses(0)
         { }
     };
 }
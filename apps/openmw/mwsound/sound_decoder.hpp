@@ -30,6 +30,18 @@ namespace MWSound
     size_t framesToBytes(size_t frames, ChannelConfig config, SampleType type);
     size_t bytesToFrames(size_t bytes, ChannelConfig config, SampleType type);
 
+    /// Fully decoded audio of a sound effect, ready to be loaded into a buffer by the output.
+    struct Sound_Data
+    {
+        std::vector<char> mData;
+        int mSampleRate;
+        ChannelConfig mChannelConfig;
+        SampleType mSampleType;
+
+        Sound_Data() : mSampleRate(0), mChannelConfig(ChannelConfig_Mono), mSampleType(SampleType_UInt8)
+        { }
+    };
+
     struct Sound_Decoder
     {
         const VFS::Manager* mResourceMgr;
@@ -11,6 +11,8 @@ namespace MWSound
 {
     class SoundManager;
     struct Sound_Decoder;
+    struct Sound_Data;
+    class Sound_Loudness;
     class Sound;
     class Stream;
 
@@ -36,7 +38,7 @@ namespace MWSound
         virtual std::vector<std::string> enumerateHrtf() = 0;
         virtual void setHrtf(const std::string &hrtfname, HrtfMode hrtfmode) = 0;
 
-        virtual std::pair<Sound_Handle,size_t> loadSound(const std::string &fname) = 0;
+        virtual std::pair<Sound_Handle,size_t> loadSound(const Sound_Data &data) = 0;
         virtual size_t unloadSound(Sound_Handle data) = 0;
 
         virtual bool playSound(Sound *sound, Sound_Handle data, float offset) = 0;
@@ -44,14 +46,19 @@ namespace MWSound
         virtual void finishSound(Sound *sound) = 0;
         virtual bool isSoundPlaying(Sound *sound) = 0;
         virtual void updateSound(Sound *sound) = 0;
+        /// Playback position of a sound in seconds.
+        virtual float getSoundOffset(Sound *sound) = 0;
+        virtual size_t getNumFreeSources() const = 0;
 
         virtual bool streamSound(DecoderPtr decoder, Stream *sound) = 0;
-        virtual bool streamSound3D(DecoderPtr decoder, Stream *sound, bool getLoudnessData) = 0;
+        virtual bool streamSound3D(DecoderPtr decoder, Stream *sound, std::shared_ptr<Sound_Loudness> loudness) = 0;
         virtual void finishStream(Stream *sound) = 0;
         virtual double getStreamDelay(Stream *sound) = 0;
         virtual double getStreamOffset(Stream *sound) = 0;
         virtual float getStreamLoudness(Stream *sound) = 0;
         virtual bool isStreamPlaying(Stream *sound) = 0;
+        /// Number of times a stream ran out of decoded data while playing.
+        virtual unsigned int getStreamUnderruns() = 0;
         virtual void updateStream(Stream *sound) = 0;
 
         virtual void startUpdate() = 0;
@@ -2,12 +2,21 @@
 
 #include <iostream>
 #include <algorithm>
+#include <cmath>
 #include <map>
 #include <numeric>
+#include <stdexcept>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
 
 #include <osg/Matrixf>
 
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
+
 #include <components/misc/rng.hpp>
+#include <components/sceneutil/workqueue.hpp>
 
 #include <components/vfs/manager.hpp>
 
@@ -24,6 +33,7 @@
 #include "sound_buffer.hpp"
 #include "sound_decoder.hpp"
 #include "sound.hpp"
+#include "loudness.hpp"
 
 #include "openal_output.hpp"
 #include "ffmpeg_decoder.hpp"
@@ -34,7 +44,92 @@ namespace MWSound
     // For combining PlayMode and Type flags
     inline int operator|(PlayMode a, Type b) { return static_cast<int>(a) | static_cast<int>(b); }
 
-    SoundManager::SoundManager(const VFS::Manager* vfs, const std::map<std::string, std::string>& fallbackMap, bool useSound)
+    const float sLoudnessFPS = 20.f; // loudness values per second of audio
+
+    const char sLoudnessCacheMagic[8] = {'O','M','W','L','O','U','D','1'};
+
+    // A virtual sound only takes over a source from a sound that is this much farther away (squared distance)
+    const float sSourceStealFactor = 1.5f;
+
+    // Decode a whole sound effect into memory. Safe to call from a worker thread.
+    static void decodeSound(DecoderPtr decoder, const std::string &fname, Sound_Data &out)
+    {
+        try {
+            // Workaround: Bethesda at some point converted some of the files to mp3, but the references were kept as .wav.
+            if(decoder->mResourceMgr->exists(fname))
+                decoder->open(fname);
+            else
+            {
+                std::string file = fname;
+                std::string::size_type pos = file.rfind('.');
+                if(pos != std::string::npos)
+                    file = file.substr(0, pos)+".mp3";
+                decoder->open(file);
+            }
+
+            decoder->getInfo(&out.mSampleRate, &out.mChannelConfig, &out.mSampleType);
+            decoder->readAll(out.mData);
+        }
+        catch(std::exception &e) {
+            std::cerr<< "Failed to load audio from "<<fname<<": "<<e.what() <<std::endl;
+            out.mData.clear();
+        }
+    }
+
+    /// Worker thread item: decode a sound effect ahead of it being played.
+    class DecodeSoundItem : public SceneUtil::WorkItem
+    {
+    public:
+        DecodeSoundItem(DecoderPtr decoder, const std::string &fname)
+            : mDecoder(decoder)
+            , mFileName(fname)
+            , mState(State_Queued)
+        {
+        }
+
+        virtual void doWork()
+        {
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mStateMutex);
+                if(mState != State_Queued)
+                    return;
+                mState = State_Decoding;
+            }
+
+            decodeSound(mDecoder, mFileName, mData);
+            mDecoder.reset();
+        }
+
+        /// Stop a worker from picking up this item if it hasn't started on it yet.
+        /// @return true if the caller is now responsible for decoding the sound.
+        bool claim()
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mStateMutex);
+            if(mState != State_Queued)
+                return false;
+            mState = State_Claimed;
+            return true;
+        }
+
+        /// @note Only valid once the item is done and wasn't claimed.
+        const Sound_Data &getData() const { return mData; }
+
+    private:
+        enum State {
+            State_Queued,
+            State_Decoding,
+            State_Claimed
+        };
+
+        DecoderPtr mDecoder;
+        std::string mFileName;
+        Sound_Data mData;
+
+        OpenThreads::Mutex mStateMutex;
+        State mState;
+    };
+
+    SoundManager::SoundManager(const VFS::Manager* vfs, const std::map<std::string, std::string>& fallbackMap, bool useSound, const std::string& cachePath)
         : mVFS(vfs)
         , mFallback(fallbackMap)
         , mOutput(new DEFAULT_OUTPUT(*this))
@@ -55,6 +150,7 @@ namespace MWSound
         , mPausedSoundTypes(0)
         , mUnderwaterSound(nullptr)
         , mNearWaterSound(nullptr)
+        , mLoudnessCacheChanged(false)
     {
         mMasterVolume = Settings::Manager::getFloat("master volume", "Sound");
         mMasterVolume = std::min(std::max(mMasterVolume, 0.0f), 1.0f);
@@ -111,11 +207,26 @@ namespace MWSound
                 std::cout <<"  "<<name<<"\n";
             std::cout.flush();
         }
+
+        mWorkQueue = new SceneUtil::WorkQueue(1);
+
+        if(Settings::Manager::getBool("voice loudness cache", "Sound"))
+        {
+            mLoudnessCacheFile = cachePath + "/voiceloudness.bin";
+            readLoudnessCache();
+        }
     }
 
     SoundManager::~SoundManager()
     {
+        mDecodingBuffers.clear();
+        // waits for the sound currently being decoded, if any
+        mWorkQueue = nullptr;
+
         clear();
+        updateVoiceLoudness();
+        if(mLoudnessCacheChanged)
+            writeLoudnessCache();
         for(Sound_Buffer &sfx : *mSoundBuffers)
         {
             if(sfx.mHandle)
@@ -182,8 +293,8 @@ namespace MWSound
     }
 
     // Lookup a soundId for its sound data (resource name, local volume,
-    // minRange, and maxRange), and ensure it's ready for use.
-    Sound_Buffer *SoundManager::loadSound(const std::string &soundId)
+    // minRange, and maxRange), creating the record if needed.
+    Sound_Buffer *SoundManager::findSoundBuffer(const std::string &soundId)
     {
 #ifdef __GNUC__
 #define LIKELY(x) __builtin_expect((bool)(x), true)
@@ -199,68 +310,273 @@ namespace MWSound
                 insertSound(Misc::StringUtils::lowerCase(sound.mId), &sound);
         }
 
-        Sound_Buffer *sfx;
         NameBufferMap::const_iterator snd = mBufferNameMap.find(soundId);
         if(LIKELY(snd != mBufferNameMap.end()))
-            sfx = snd->second;
-        else
-        {
-            MWBase::World *world = MWBase::Environment::get().getWorld();
-            const ESM::Sound *sound = world->getStore().get<ESM::Sound>().search(soundId);
-            if(!sound) return nullptr;
-            sfx = insertSound(soundId, sound);
-        }
+            return snd->second;
 #undef LIKELY
 #undef UNLIKELY
 
+        MWBase::World *world = MWBase::Environment::get().getWorld();
+        const ESM::Sound *sound = world->getStore().get<ESM::Sound>().search(soundId);
+        if(!sound) return nullptr;
+        return insertSound(soundId, sound);
+    }
+
+    // Lookup a soundId for its sound data (resource name, local volume,
+    // minRange, and maxRange), and ensure it's ready for use.
+    Sound_Buffer *SoundManager::loadSound(const std::string &soundId)
+    {
+        Sound_Buffer *sfx = findSoundBuffer(soundId);
+        if(!sfx) return nullptr;
+
         if(!sfx->mHandle)
         {
-            size_t size;
-            std::tie(sfx->mHandle, size) = mOutput->loadSound(sfx->mResourceName);
-            if(!sfx->mHandle) return nullptr;
-
-            mBufferCacheSize += size;
-            if(mBufferCacheSize > mBufferCacheMax)
+            osg::ref_ptr<DecodeSoundItem> item;
+            DecodeItemMap::iterator decoding = mDecodingBuffers.find(sfx);
+            if(decoding != mDecodingBuffers.end())
             {
-                do {
-                    if(mUnusedBuffers.empty())
-                    {
-                        std::cerr<< "No unused sound buffers to free, using "<<mBufferCacheSize<<" bytes!" <<std::endl;
-                        break;
-                    }
-                    Sound_Buffer *unused = mUnusedBuffers.back();
-
-                    size = mOutput->unloadSound(unused->mHandle);
-                    mBufferCacheSize -= size;
-                    unused->mHandle = 0;
+                item = decoding->second;
+                mDecodingBuffers.erase(decoding);
+            }
 
-                    mUnusedBuffers.pop_back();
-                } while(mBufferCacheSize > mBufferCacheMin);
+            if(item && !item->claim())
+            {
+                // A worker is already decoding it, which won't take longer than doing it here
+                item->waitTillDone();
+                if(!loadSoundData(sfx, item->getData()))
+                    return nullptr;
+            }
+            else
+            {
+                Sound_Data data;
+                decodeSound(getDecoder(), sfx->mResourceName, data);
+                if(!loadSoundData(sfx, data))
+                    return nullptr;
             }
-            mUnusedBuffers.push_front(sfx);
         }
 
         return sfx;
     }
 
-    DecoderPtr SoundManager::loadVoice(const std::string &voicefile)
+    bool SoundManager::loadSoundData(Sound_Buffer *sfx, const Sound_Data &data)
+    {
+        size_t size;
+        std::tie(sfx->mHandle, size) = mOutput->loadSound(data);
+        if(!sfx->mHandle) return false;
+        if(data.mSampleRate > 0)
+            sfx->mDuration = bytesToFrames(data.mData.size(), data.mChannelConfig, data.mSampleType)
+                             / static_cast<float>(data.mSampleRate);
+
+        mBufferCacheSize += size;
+        if(mBufferCacheSize > mBufferCacheMax)
+        {
+            do {
+                if(mUnusedBuffers.empty())
+                {
+                    std::cerr<< "No unused sound buffers to free, using "<<mBufferCacheSize<<" bytes!" <<std::endl;
+                    break;
+                }
+                Sound_Buffer *unused = mUnusedBuffers.back();
+
+                size = mOutput->unloadSound(unused->mHandle);
+                mBufferCacheSize -= size;
+                unused->mHandle = 0;
+
+                mUnusedBuffers.pop_back();
+            } while(mBufferCacheSize > mBufferCacheMin);
+        }
+        mUnusedBuffers.push_front(sfx);
+        return true;
+    }
+
+    void SoundManager::preloadSounds(const std::vector<std::string> &soundIds)
+    {
+        if(!mOutput->isInitialized() || !mWorkQueue)
+            return;
+
+        for(const std::string &soundId : soundIds)
+        {
+            Sound_Buffer *sfx = findSoundBuffer(Misc::StringUtils::lowerCase(soundId));
+            if(!sfx || sfx->mHandle || mDecodingBuffers.find(sfx) != mDecodingBuffers.end())
+                continue;
+
+            osg::ref_ptr<DecodeSoundItem> item (new DecodeSoundItem(getDecoder(), sfx->mResourceName));
+            mWorkQueue->addWorkItem(item);
+            mDecodingBuffers.insert(std::make_pair(sfx, item));
+        }
+    }
+
+    // Hand sounds that finished decoding in the background over to the output
+    void SoundManager::updateDecodedSounds()
+    {
+        DecodeItemMap::iterator iter = mDecodingBuffers.begin();
+        while(iter != mDecodingBuffers.end())
+        {
+            if(!iter->second->isDone())
+            {
+                ++iter;
+                continue;
+            }
+
+            Sound_Buffer *sfx = iter->first;
+            if(!sfx->mHandle)
+                loadSoundData(sfx, iter->second->getData());
+            iter = mDecodingBuffers.erase(iter);
+        }
+    }
+
+    DecoderPtr SoundManager::loadVoice(std::string &voicefile)
     {
         DecoderPtr decoder = getDecoder();
         // Workaround: Bethesda at some point converted some of the files to mp3, but the references were kept as .wav.
-        if(mVFS->exists(voicefile))
-            decoder->open(voicefile);
-        else
+        if(!mVFS->exists(voicefile))
         {
-            std::string file = voicefile;
-            std::string::size_type pos = file.rfind('.');
+            std::string::size_type pos = voicefile.rfind('.');
             if(pos != std::string::npos)
-                file = file.substr(0, pos)+".mp3";
-            decoder->open(file);
+                voicefile = voicefile.substr(0, pos)+".mp3";
         }
+        decoder->open(voicefile);
 
         return decoder;
     }
 
+    std::shared_ptr<Sound_Loudness> SoundManager::getVoiceLoudness(const std::string &voicefile)
+    {
+        VoiceLoudnessMap::iterator found = mVoiceLoudness.find(voicefile);
+        if(found != mVoiceLoudness.end())
+        {
+            // the data files may have changed since the cache was written
+            if(!found->second.mVerified)
+                found->second.mVerified = (found->second.mFileSize == getFileSize(voicefile));
+            if(found->second.mVerified)
+                return found->second.mLoudness;
+
+            mVoiceLoudness.erase(found);
+            mLoudnessCacheChanged = true;
+        }
+
+        std::shared_ptr<Sound_Loudness> loudness = std::make_shared<Sound_Loudness>(sLoudnessFPS);
+        mAnalyzingVoices.push_back(std::make_pair(voicefile, loudness));
+        return loudness;
+    }
+
+    // Move envelopes that finished analyzing into the cache, and drop those of voices that were cut off
+    void SoundManager::updateVoiceLoudness()
+    {
+        AnalyzingVoiceList::iterator iter = mAnalyzingVoices.begin();
+        while(iter != mAnalyzingVoices.end())
+        {
+            if(iter->second->isComplete())
+            {
+                VoiceLoudness& entry = mVoiceLoudness[iter->first];
+                entry.mLoudness = iter->second;
+                entry.mFileSize = mLoudnessCacheFile.empty() ? 0 : getFileSize(iter->first);
+                entry.mVerified = true;
+                mLoudnessCacheChanged = true;
+                iter = mAnalyzingVoices.erase(iter);
+            }
+            else if(iter->second.use_count() == 1)
+                iter = mAnalyzingVoices.erase(iter);
+            else
+                ++iter;
+        }
+    }
+
+    uint64_t SoundManager::getFileSize(const std::string &name) const
+    {
+        try {
+            Files::IStreamPtr stream = mVFS->get(name);
+            stream->seekg(0, std::ios::end);
+            std::streamoff size = stream->tellg();
+            return size > 0 ? static_cast<uint64_t>(size) : 0;
+        }
+        catch(std::exception&) {
+            return 0;
+        }
+    }
+
+    void SoundManager::readLoudnessCache()
+    {
+        boost::filesystem::path path (mLoudnessCacheFile);
+        boost::system::error_code ec;
+        if(!boost::filesystem::exists(path, ec))
+            return;
+
+        boost::filesystem::ifstream stream (path, std::ios::binary);
+        char magic[sizeof(sLoudnessCacheMagic)];
+        uint32_t count = 0;
+        if(!stream.read(magic, sizeof(magic)) || !std::equal(magic, magic+sizeof(magic), sLoudnessCacheMagic)
+                || !stream.read(reinterpret_cast<char*>(&count), sizeof(count)))
+        {
+            std::cerr<< "Ignoring invalid voice loudness cache "<<mLoudnessCacheFile <<std::endl;
+            return;
+        }
+
+        for(uint32_t i=0; i<count; ++i)
+        {
+            uint32_t nameLength = 0;
+            uint32_t numSamples = 0;
+            float samplesPerSecond = 0.f;
+            VoiceLoudness entry;
+            entry.mFileSize = 0;
+            entry.mVerified = false;
+            if(!stream.read(reinterpret_cast<char*>(&nameLength), sizeof(nameLength)) || nameLength > 4096)
+                break;
+            std::string name (nameLength, '\0');
+            stream.read(&name[0], nameLength);
+            stream.read(reinterpret_cast<char*>(&entry.mFileSize), sizeof(entry.mFileSize));
+            stream.read(reinterpret_cast<char*>(&samplesPerSecond), sizeof(samplesPerSecond));
+            if(!stream.read(reinterpret_cast<char*>(&numSamples), sizeof(numSamples)) || numSamples > (1u<<24))
+                break;
+            std::vector<float> samples (numSamples);
+            if(numSamples && !stream.read(reinterpret_cast<char*>(&samples[0]), numSamples*sizeof(float)))
+                break;
+
+            entry.mLoudness = std::make_shared<Sound_Loudness>(samplesPerSecond, samples);
+            mVoiceLoudness[name] = entry;
+        }
+    }
+
+    void SoundManager::writeLoudnessCache() const
+    {
+        if(mLoudnessCacheFile.empty())
+            return;
+
+        try {
+            boost::filesystem::path path (mLoudnessCacheFile);
+            boost::filesystem::create_directories(path.parent_path());
+
+            // write to a temporary file first, so a crash doesn't leave a truncated cache behind
+            boost::filesystem::path tmpPath (path.string() + ".tmp");
+            {
+                boost::filesystem::ofstream stream (tmpPath, std::ios::binary);
+                stream.write(sLoudnessCacheMagic, sizeof(sLoudnessCacheMagic));
+                uint32_t count = mVoiceLoudness.size();
+                stream.write(reinterpret_cast<const char*>(&count), sizeof(count));
+                for(const VoiceLoudnessMap::value_type &entry : mVoiceLoudness)
+                {
+                    uint32_t nameLength = entry.first.size();
+                    std::vector<float> samples = entry.second.mLoudness->getSamples();
+                    uint32_t numSamples = samples.size();
+                    float samplesPerSecond = entry.second.mLoudness->getSamplesPerSecond();
+                    stream.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
+                    stream.write(entry.first.data(), nameLength);
+                    stream.write(reinterpret_cast<const char*>(&entry.second.mFileSize), sizeof(entry.second.mFileSize));
+                    stream.write(reinterpret_cast<const char*>(&samplesPerSecond), sizeof(samplesPerSecond));
+                    stream.write(reinterpret_cast<const char*>(&numSamples), sizeof(numSamples));
+                    if(numSamples)
+                        stream.write(reinterpret_cast<const char*>(&samples[0]), numSamples*sizeof(float));
+                }
+                if(!stream)
+                    throw std::runtime_error("failed to write "+tmpPath.string());
+            }
+            boost::filesystem::rename(tmpPath, path);
+        }
+        catch(std::exception &e) {
+            std::cerr<< "Failed to write voice loudness cache: "<<e.what() <<std::endl;
+        }
+    }
+
     Sound *SoundManager::getSoundRef()
     {
         Sound *ret;
@@ -293,7 +609,7 @@ namespace MWSound
         return ret;
     }
 
-    Stream *SoundManager::playVoice(DecoderPtr decoder, const osg::Vec3f &pos, bool playlocal)
+    Stream *SoundManager::playVoice(DecoderPtr decoder, const std::string &voicefile, const osg::Vec3f &pos, bool playlocal)
     {
         MWBase::World* world = MWBase::Environment::get().getWorld();
         static const float fAudioMinDistanceMult = world->getStore().get<ESM::GameSetting>().find("fAudioMinDistanceMult")->getFloat();
@@ -315,7 +631,7 @@ namespace MWSound
         {
             sound->init(pos, 1.0f, basevol, 1.0f, minDistance, maxDistance,
                         PlayMode::Normal|Type::Voice|Play_3D);
-            played = mOutput->streamSound3D(decoder, sound, true);
+            played = mOutput->streamSound3D(decoder, sound, getVoiceLoudness(voicefile));
         }
         if(!played)
         {
@@ -473,7 +789,7 @@ namespace MWSound
         const osg::Vec3f pos = world->getActorHeadTransform(ptr).getTrans();
 
         stopSay(ptr);
-        Stream *sound = playVoice(decoder, pos, (ptr == MWMechanics::getPlayer()));
+        Stream *sound = playVoice(decoder, voicefile, pos, (ptr == MWMechanics::getPlayer()));
         if(!sound) return;
 
         mActiveSaySounds.insert(std::make_pair(ptr, sound));
@@ -502,7 +818,7 @@ namespace MWSound
         DecoderPtr decoder = loadVoice(voicefile);
 
         stopSay(MWWorld::ConstPtr());
-        Stream *sound = playVoice(decoder, osg::Vec3f(), true);
+        Stream *sound = playVoice(decoder, voicefile, osg::Vec3f(), true);
         if(!sound) return;
 
         mActiveSaySounds.insert(std::make_pair(MWWorld::ConstPtr(), sound));
@@ -566,6 +882,71 @@ namespace MWSound
     }
 
 
+    bool SoundManager::startSound(Sound *sound, Sound_Buffer *sfx, float offset)
+    {
+        // Sounds that can't be heard yet, or that don't get a source, play virtually until they do
+        const float maxdist = sound->getMaxDistance();
+        if(mOutput->getNumFreeSources() == 0 ||
+           (sound->getIs3D() && (mListenerPos - sound->getPosition()).length2() > maxdist*maxdist))
+        {
+            sound->setVirtualOffset(std::max(offset, 0.0f));
+            return true;
+        }
+
+        if(sound->getIs3D())
+            return mOutput->playSound3D(sound, sfx->mHandle, offset);
+        return mOutput->playSound(sound, sfx->mHandle, offset);
+    }
+
+    void SoundManager::finishSound(Sound *sound)
+    {
+        mOutput->finishSound(sound);
+        sound->setVirtualOffset(-1.0f);
+    }
+
+    bool SoundManager::isSoundPlaying(Sound *sound) const
+    {
+        return sound->getIsVirtual() || mOutput->isSoundPlaying(sound);
+    }
+
+    void SoundManager::virtualizeSound(Sound *sound)
+    {
+        float offset = mOutput->getSoundOffset(sound);
+        mOutput->finishSound(sound);
+        sound->setVirtualOffset(offset);
+    }
+
+    bool SoundManager::reviveSound(Sound *sound, Sound_Buffer *sfx)
+    {
+        float offset = sound->getVirtualOffset();
+        sound->setVirtualOffset(-1.0f);
+
+        bool played;
+        if(sound->getIs3D())
+            played = mOutput->playSound3D(sound, sfx->mHandle, offset);
+        else
+            played = mOutput->playSound(sound, sfx->mHandle, offset);
+        if(!played)
+            sound->setVirtualOffset(offset);
+        return played;
+    }
+
+    void SoundManager::addActiveSound(const MWWorld::ConstPtr &ptr, Sound *sound, Sound_Buffer *sfx)
+    {
+        if(sfx->mUses++ == 0)
+        {
+            SoundList::iterator iter = std::find(mUnusedBuffers.begin(), mUnusedBuffers.end(), sfx);
+            if(iter != mUnusedBuffers.end())
+                mUnusedBuffers.erase(iter);
+        }
+
+        ActiveSound active;
+        active.mPtr = ptr;
+        active.mSound = sound;
+        active.mBuffer = sfx;
+        mActiveSounds.push_back(active);
+    }
+
     Sound *SoundManager::playSound(const std::string& soundId, float volume, float pitch, Type type, PlayMode mode, float offset)
     {
         if(!mOutput->isInitialized())
@@ -576,19 +957,13 @@ namespace MWSound
 
         Sound *sound = getSoundRef();
         sound->init(volume * sfx->mVolume, volumeFromType(type), pitch, mode|type|Play_2D);
-        if(!mOutput->playSound(sound, sfx->mHandle, offset))
+        if(!startSound(sound, sfx, offset))
         {
             mUnusedSounds.push_back(sound);
             return nullptr;
         }
 
-        if(sfx->mUses++ == 0)
-        {
-            SoundList::iterator iter = std::find(mUnusedBuffers.begin(), mUnusedBuffers.end(), sfx);
-            if(iter != mUnusedBuffers.end())
-                mUnusedBuffers.erase(iter);
-        }
-        mActiveSounds[MWWorld::ConstPtr()].push_back(std::make_pair(sound, sfx));
+        addActiveSound(MWWorld::ConstPtr(), sound, sfx);
         return sound;
     }
 
@@ -610,32 +985,19 @@ namespace MWSound
         // Only one copy of given sound can be played at time on ptr, so stop previous copy
         stopSound3D(ptr, soundId);
 
-        bool played;
         Sound *sound = getSoundRef();
         if(!(mode&PlayMode::NoPlayerLocal) && ptr == MWMechanics::getPlayer())
-        {
             sound->init(volume * sfx->mVolume, volumeFromType(type), pitch, mode|type|Play_2D);
-            played = mOutput->playSound(sound, sfx->mHandle, offset);
-        }
         else
-        {
             sound->init(objpos, volume * sfx->mVolume, volumeFromType(type), pitch,
                         sfx->mMinDist, sfx->mMaxDist, mode|type|Play_3D);
-            played = mOutput->playSound3D(sound, sfx->mHandle, offset);
-        }
-        if(!played)
+        if(!startSound(sound, sfx, offset))
         {
             mUnusedSounds.push_back(sound);
             return nullptr;
         }
 
-        if(sfx->mUses++ == 0)
-        {
-            SoundList::iterator iter = std::find(mUnusedBuffers.begin(), mUnusedBuffers.end(), sfx);
-            if(iter != mUnusedBuffers.end())
-                mUnusedBuffers.erase(iter);
-        }
-        mActiveSounds[ptr].push_back(std::make_pair(sound, sfx));
+        addActiveSound(ptr, sound, sfx);
         return sound;
     }
 
@@ -653,49 +1015,42 @@ namespace MWSound
         Sound *sound = getSoundRef();
         sound->init(initialPos, volume * sfx->mVolume, volumeFromType(type), pitch,
                     sfx->mMinDist, sfx->mMaxDist, mode|type|Play_3D);
-        if(!mOutput->playSound3D(sound, sfx->mHandle, offset))
+        if(!startSound(sound, sfx, offset))
         {
             mUnusedSounds.push_back(sound);
             return nullptr;
         }
 
-        if(sfx->mUses++ == 0)
-        {
-            SoundList::iterator iter = std::find(mUnusedBuffers.begin(), mUnusedBuffers.end(), sfx);
-            if(iter != mUnusedBuffers.end())
-                mUnusedBuffers.erase(iter);
-        }
-        mActiveSounds[MWWorld::ConstPtr()].push_back(std::make_pair(sound, sfx));
+        addActiveSound(MWWorld::ConstPtr(), sound, sfx);
         return sound;
     }
 
     void SoundManager::stopSound(Sound *sound)
     {
         if(sound)
-            mOutput->finishSound(sound);
+            finishSound(sound);
     }
 
     void SoundManager::stopSound3D(const MWWorld::ConstPtr &ptr, const std::string& soundId)
     {
-        SoundMap::iterator snditer = mActiveSounds.find(ptr);
-        if(snditer != mActiveSounds.end())
+        Sound_Buffer *sfx = nullptr;
+        for(ActiveSound &snd : mActiveSounds)
         {
-            Sound_Buffer *sfx = loadSound(Misc::StringUtils::lowerCase(soundId));
-            for(SoundBufferRefPair &snd : snditer->second)
-            {
-                if(snd.second == sfx)
-                    mOutput->finishSound(snd.first);
-            }
+            if(snd.mPtr != ptr)
+                continue;
+            if(!sfx)
+                sfx = loadSound(Misc::StringUtils::lowerCase(soundId));
+            if(snd.mBuffer == sfx)
+                finishSound(snd.mSound);
         }
     }
 
     void SoundManager::stopSound3D(const MWWorld::ConstPtr &ptr)
     {
-        SoundMap::iterator snditer = mActiveSounds.find(ptr);
-        if(snditer != mActiveSounds.end())
+        for(ActiveSound &snd : mActiveSounds)
         {
-            for(SoundBufferRefPair &snd : snditer->second)
-                mOutput->finishSound(snd.first);
+            if(snd.mPtr == ptr)
+                finishSound(snd.mSound);
         }
         SaySoundMap::iterator sayiter = mActiveSaySounds.find(ptr);
         if(sayiter != mActiveSaySounds.end())
@@ -704,13 +1059,10 @@ namespace MWSound
 
     void SoundManager::stopSound(const MWWorld::CellStore *cell)
     {
-        for(SoundMap::value_type &snd : mActiveSounds)
+        for(ActiveSound &snd : mActiveSounds)
         {
-            if(!snd.first.isEmpty() && snd.first != MWMechanics::getPlayer() && snd.first.getCell() == cell)
-            {
-                for(SoundBufferRefPair &sndbuf : snd.second)
-                    mOutput->finishSound(sndbuf.first);
-            }
+            if(!snd.mPtr.isEmpty() && snd.mPtr != MWMechanics::getPlayer() && snd.mPtr.getCell() == cell)
+                finishSound(snd.mSound);
         }
         for(SaySoundMap::value_type &snd : mActiveSaySounds)
         {
@@ -721,43 +1073,44 @@ namespace MWSound
 
     void SoundManager::stopSound(const std::string& soundId)
     {
-        SoundMap::iterator snditer = mActiveSounds.find(MWWorld::ConstPtr());
-        if(snditer != mActiveSounds.end())
+        Sound_Buffer *sfx = nullptr;
+        for(ActiveSound &snd : mActiveSounds)
         {
-            Sound_Buffer *sfx = loadSound(Misc::StringUtils::lowerCase(soundId));
-            for(SoundBufferRefPair &sndbuf : snditer->second)
-            {
-                if(sndbuf.second == sfx)
-                    mOutput->finishSound(sndbuf.first);
-            }
+            if(!snd.mPtr.isEmpty())
+                continue;
+            if(!sfx)
+                sfx = loadSound(Misc::StringUtils::lowerCase(soundId));
+            if(snd.mBuffer == sfx)
+                finishSound(snd.mSound);
         }
     }
 
     void SoundManager::fadeOutSound3D(const MWWorld::ConstPtr &ptr,
             const std::string& soundId, float duration)
     {
-        SoundMap::iterator snditer = mActiveSounds.find(ptr);
-        if(snditer != mActiveSounds.end())
+        Sound_Buffer *sfx = nullptr;
+        for(ActiveSound &snd : mActiveSounds)
         {
-            Sound_Buffer *sfx = loadSound(Misc::StringUtils::lowerCase(soundId));
-            for(SoundBufferRefPair &sndbuf : snditer->second)
-            {
-                if(sndbuf.second == sfx)
-                    sndbuf.first->setFadeout(duration);
-            }
+            if(snd.mPtr != ptr)
+                continue;
+            if(!sfx)
+                sfx = loadSound(Misc::StringUtils::lowerCase(soundId));
+            if(snd.mBuffer == sfx)
+                snd.mSound->setFadeout(duration);
         }
     }
 
     bool SoundManager::getSoundPlaying(const MWWorld::ConstPtr &ptr, const std::string& soundId) const
     {
-        SoundMap::const_iterator snditer = mActiveSounds.find(ptr);
-        if(snditer != mActiveSounds.end())
+        Sound_Buffer *sfx = nullptr;
+        for(const ActiveSound &snd : mActiveSounds)
         {
-            Sound_Buffer *sfx = lookupSound(Misc::StringUtils::lowerCase(soundId));
-            return std::find_if(snditer->second.cbegin(), snditer->second.cend(),
-                [this,sfx](const SoundBufferRefPair &snd) -> bool
-                { return snd.second == sfx && mOutput->isSoundPlaying(snd.first); }
-            ) != snditer->second.cend();
+            if(snd.mPtr != ptr)
+                continue;
+            if(!sfx)
+                sfx = lookupSound(Misc::StringUtils::lowerCase(soundId));
+            if(snd.mBuffer == sfx && isSoundPlaying(snd.mSound))
+                return true;
         }
         return false;
     }
@@ -893,7 +1246,7 @@ namespace MWSound
         {
             if (volume == 0.0f)
             {
-                mOutput->finishSound(mNearWaterSound);
+                finishSound(mNearWaterSound);
                 mNearWaterSound = nullptr;
             }
             else
@@ -904,22 +1257,18 @@ namespace MWSound
                 if(LastCell != curcell)
                 {
                     LastCell = curcell;
-                    SoundMap::const_iterator snditer = mActiveSounds.find(MWWorld::Ptr());
-                    if(snditer != mActiveSounds.end())
-                    {
-                        SoundBufferRefPairList::const_iterator pairiter = std::find_if(
-                            snditer->second.begin(), snditer->second.end(),
-                            [this](const SoundBufferRefPairList::value_type &item) -> bool
-                            { return mNearWaterSound == item.first; }
-                        );
-                        if (pairiter != snditer->second.end() && pairiter->second != sfx)
-                            soundIdChanged = true;
-                    }
+                    ActiveSoundList::const_iterator snditer = std::find_if(
+                        mActiveSounds.begin(), mActiveSounds.end(),
+                        [this](const ActiveSound &item) -> bool
+                        { return item.mPtr.isEmpty() && mNearWaterSound == item.mSound; }
+                    );
+                    if (snditer != mActiveSounds.end() && snditer->mBuffer != sfx)
+                        soundIdChanged = true;
                 }
 
                 if(soundIdChanged)
                 {
-                    mOutput->finishSound(mNearWaterSound);
+                    finishSound(mNearWaterSound);
                     mNearWaterSound = playSound(soundId, volume, 1.0f, Type::Sfx, PlayMode::Loop);
                 }
                 else if (sfx)
@@ -952,7 +1301,7 @@ namespace MWSound
             env = Env_Underwater;
         else if(mUnderwaterSound)
         {
-            mOutput->finishSound(mUnderwaterSound);
+            finishSound(mUnderwaterSound);
             mUnderwaterSound = nullptr;
         }
 
@@ -967,56 +1316,67 @@ namespace MWSound
         updateMusic(duration);
 
         // Check if any sounds are finished playing, and trash them
-        SoundMap::iterator snditer = mActiveSounds.begin();
+        ActiveSoundList::iterator snditer = mActiveSounds.begin();
         while(snditer != mActiveSounds.end())
         {
-            MWWorld::ConstPtr ptr = snditer->first;
-            SoundBufferRefPairList::iterator sndidx = snditer->second.begin();
-            while(sndidx != snditer->second.end())
+            Sound *sound = snditer->mSound;
+            Sound_Buffer *sfx = snditer->mBuffer;
+            if(!snditer->mPtr.isEmpty() && sound->getIs3D())
             {
-                Sound *sound;
-                Sound_Buffer *sfx;
+                const ESM::Position &pos = snditer->mPtr.getRefData().getPosition();
+                const osg::Vec3f objpos(pos.asVec3());
+                sound->setPosition(objpos);
 
-                std::tie(sound, sfx) = *sndidx;
-                if(!ptr.isEmpty() && sound->getIs3D())
+                if(sound->getDistanceCull())
                 {
-                    const ESM::Position &pos = ptr.getRefData().getPosition();
-                    const osg::Vec3f objpos(pos.asVec3());
-                    sound->setPosition(objpos);
-
-                    if(sound->getDistanceCull())
-                    {
-                        if((mListenerPos - objpos).length2() > 2000*2000)
-                            mOutput->finishSound(sound);
-                    }
+                    if((mListenerPos - objpos).length2() > 2000*2000)
+                        finishSound(sound);
                 }
+            }
 
-                if(!mOutput->isSoundPlaying(sound))
-                {
-                    mOutput->finishSound(sound);
-                    mUnusedSounds.push_back(sound);
-                    if(sound == mUnderwaterSound)
-                        mUnderwaterSound = nullptr;
-                    if(sound == mNearWaterSound)
-                        mNearWaterSound = nullptr;
-                    if(sfx->mUses-- == 1)
-                        mUnusedBuffers.push_front(sfx);
-                    sndidx = snditer->second.erase(sndidx);
-                }
-                else
-                {
-                    sound->updateFade(duration);
+            if(sound->getIsVirtual())
+            {
+                // Keep track of where a virtual sound would be, so it can resume from there
+                float offset = sound->getVirtualOffset();
+                if(!(mPausedSoundTypes&sound->getPlayType()))
+                    offset += duration * sound->getPitch();
+                if(sound->getIsLooping() && sfx->mDuration > 0.0f)
+                    offset = std::fmod(offset, sfx->mDuration);
+                else if(offset >= sfx->mDuration)
+                    offset = -1.0f;
+                sound->setVirtualOffset(offset);
+            }
+
+            if(!isSoundPlaying(sound))
+            {
+                finishSound(sound);
+                mUnusedSounds.push_back(sound);
+                if(sound == mUnderwaterSound)
+                    mUnderwaterSound = nullptr;
+                if(sound == mNearWaterSound)
+                    mNearWaterSound = nullptr;
+                if(sfx->mUses-- == 1)
+                    mUnusedBuffers.push_front(sfx);
+                snditer = mActiveSounds.erase(snditer);
+                continue;
+            }
+
+            sound->updateFade(duration);
 
+            if(!sound->getIsVirtual())
+            {
+                // Sounds out of hearing range give up their source
+                const float maxdist = sound->getMaxDistance();
+                if(sound->getIs3D() && (mListenerPos - sound->getPosition()).length2() > maxdist*maxdist)
+                    virtualizeSound(sound);
+                else
                     mOutput->updateSound(sound);
-                    ++sndidx;
-                }
             }
-            if(snditer->second.empty())
-                snditer = mActiveSounds.erase(snditer);
-            else
-                ++snditer;
+            ++snditer;
         }
 
+        updateVirtualSounds();
+
         SaySoundMap::iterator sayiter = mActiveSaySounds.begin();
         while(sayiter != mActiveSaySounds.end())
         {
@@ -1078,6 +1438,49 @@ namespace MWSound
     }
 
 
+    // Hand free sources to the closest virtual sounds that can be heard. If there are none left,
+    // take them over from sounds that are much farther away.
+    void SoundManager::updateVirtualSounds()
+    {
+        typedef std::pair<float,size_t> DistanceIndex;
+        std::vector<DistanceIndex> waiting;
+        std::vector<DistanceIndex> playing;
+        for(size_t i = 0;i < mActiveSounds.size();++i)
+        {
+            Sound *sound = mActiveSounds[i].mSound;
+            float dist2 = 0.0f;
+            if(sound->getIs3D())
+                dist2 = (mListenerPos - sound->getPosition()).length2();
+
+            if(!sound->getIsVirtual())
+            {
+                if(sound->getIs3D())
+                    playing.push_back(std::make_pair(dist2, i));
+            }
+            else if(!(mPausedSoundTypes&sound->getPlayType()) &&
+                    dist2 <= sound->getMaxDistance()*sound->getMaxDistance())
+                waiting.push_back(std::make_pair(dist2, i));
+        }
+        if(waiting.empty())
+            return;
+
+        std::sort(waiting.begin(), waiting.end());
+        std::sort(playing.begin(), playing.end());
+        for(const DistanceIndex &entry : waiting)
+        {
+            if(mOutput->getNumFreeSources() == 0)
+            {
+                // Require a clear margin, so two sounds at similar distances don't keep trading a source
+                if(playing.empty() || playing.back().first <= entry.first*sSourceStealFactor)
+                    break;
+                virtualizeSound(mActiveSounds[playing.back().second].mSound);
+                playing.pop_back();
+            }
+            const ActiveSound &snd = mActiveSounds[entry.second];
+            reviveSound(snd.mSound, snd.mBuffer);
+        }
+    }
+
     void SoundManager::updateMusic(float duration)
     {
         if (!mNextMusic.empty())
@@ -1100,6 +1503,9 @@ namespace MWSound
         if(!mOutput->isInitialized())
             return;
 
+        updateDecodedSounds();
+        updateVoiceLoudness();
+
         if (MWBase::Environment::get().getStateManager()->getState()!=
             MWBase::StateManager::State_NoGame)
         {
@@ -1121,14 +1527,11 @@ namespace MWSound
         if(!mOutput->isInitialized())
             return;
         mOutput->startUpdate();
-        for(SoundMap::value_type &snd : mActiveSounds)
+        for(ActiveSound &snd : mActiveSounds)
         {
-            for(SoundBufferRefPair &sndbuf : snd.second)
-            {
-                Sound *sound = sndbuf.first;
-                sound->setBaseVolume(volumeFromType(sound->getPlayType()));
-                mOutput->updateSound(sound);
-            }
+            Sound *sound = snd.mSound;
+            sound->setBaseVolume(volumeFromType(sound->getPlayType()));
+            mOutput->updateSound(sound);
         }
         for(SaySoundMap::value_type &snd : mActiveSaySounds)
         {
@@ -1160,12 +1563,10 @@ namespace MWSound
 
     void SoundManager::updatePtr(const MWWorld::ConstPtr &old, const MWWorld::ConstPtr &updated)
     {
-        SoundMap::iterator snditer = mActiveSounds.find(old);
-        if(snditer != mActiveSounds.end())
+        for(ActiveSound &snd : mActiveSounds)
         {
-            SoundBufferRefPairList sndlist = std::move(snditer->second);
-            mActiveSounds.erase(snditer);
-            mActiveSounds.emplace(updated, std::move(sndlist));
+            if(snd.mPtr == old)
+                snd.mPtr = updated;
         }
         SaySoundMap::iterator sayiter = mActiveSaySounds.find(old);
         if(sayiter != mActiveSaySounds.end())
@@ -1245,16 +1646,13 @@ namespace MWSound
     {
         stopMusic();
 
-        for(SoundMap::value_type &snd : mActiveSounds)
+        for(ActiveSound &snd : mActiveSounds)
         {
-            for(SoundBufferRefPair &sndbuf : snd.second)
-            {
-                mOutput->finishSound(sndbuf.first);
-                mUnusedSounds.push_back(sndbuf.first);
-                Sound_Buffer *sfx = sndbuf.second;
-                if(sfx->mUses-- == 1)
-                    mUnusedBuffers.push_front(sfx);
-            }
+            finishSound(snd.mSound);
+            mUnusedSounds.push_back(snd.mSound);
+            Sound_Buffer *sfx = snd.mBuffer;
+            if(sfx->mUses-- == 1)
+                mUnusedBuffers.push_front(sfx);
         }
         mActiveSounds.clear();
         mUnderwaterSound = nullptr;
@@ -1274,4 +1672,9 @@ namespace MWSound
         }
         mActiveTracks.clear();
     }
+
+    unsigned int SoundManager::getStreamUnderruns() const
+    {
+        return mOutput->getStreamUnderruns();
+    }
 }
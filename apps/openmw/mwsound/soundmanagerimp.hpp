@@ -7,6 +7,10 @@
 #include <deque>
 #include <map>
 #include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+#include <osg/ref_ptr>
 
 #include <components/settings/settings.hpp>
 
@@ -24,6 +28,11 @@ namespace ESM
     struct Sound;
 }
 
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
 namespace MWSound
 {
     class Sound_Output;
@@ -31,6 +40,9 @@ namespace MWSound
     class Sound;
     class Stream;
     class Sound_Buffer;
+    struct Sound_Data;
+    class Sound_Loudness;
+    class DecodeSoundItem;
 
     enum Environment {
         Env_Normal,
@@ -82,16 +94,46 @@ namespace MWSound
         typedef std::deque<Sound_Buffer*> SoundList;
         SoundList mUnusedBuffers;
 
+        // Decodes preloaded sound buffers in the background
+        osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+
+        typedef std::unordered_map<Sound_Buffer*,osg::ref_ptr<DecodeSoundItem> > DecodeItemMap;
+        DecodeItemMap mDecodingBuffers;
+
+        struct VoiceLoudness
+        {
+            std::shared_ptr<Sound_Loudness> mLoudness;
+            uint64_t mFileSize;
+            bool mVerified; // false if read from the cache file and not yet checked against the VFS
+        };
+        // Analyzed loudness of voice files, by VFS path, so repeated lines don't need to be analyzed again
+        typedef std::unordered_map<std::string,VoiceLoudness> VoiceLoudnessMap;
+        VoiceLoudnessMap mVoiceLoudness;
+
+        // Loudness of voice files being streamed for the first time, analyzed by the output as they play
+        typedef std::vector<std::pair<std::string,std::shared_ptr<Sound_Loudness> > > AnalyzingVoiceList;
+        AnalyzingVoiceList mAnalyzingVoices;
+
+        // File to persist mVoiceLoudness in, empty if disabled
+        std::string mLoudnessCacheFile;
+        bool mLoudnessCacheChanged;
+
         std::unique_ptr<std::deque<Sound>> mSounds;
         std::vector<Sound*> mUnusedSounds;
 
         std::unique_ptr<std::deque<Stream>> mStreams;
         std::vector<Stream*> mUnusedStreams;
 
-        typedef std::pair<MWBase::Sound*,Sound_Buffer*> SoundBufferRefPair;
-        typedef std::vector<SoundBufferRefPair> SoundBufferRefPairList;
-        typedef std::map<MWWorld::ConstPtr,SoundBufferRefPairList> SoundMap;
-        SoundMap mActiveSounds;
+        struct ActiveSound
+        {
+            MWWorld::ConstPtr mPtr; // empty if the sound doesn't follow an object
+            Sound *mSound;
+            Sound_Buffer *mBuffer;
+        };
+        // Flat list of playing sounds, updated in a single pass each frame. Sounds that can't be heard
+        // or that didn't get an output source stay in the list as virtual sounds.
+        typedef std::vector<ActiveSound> ActiveSoundList;
+        ActiveSoundList mActiveSounds;
 
         typedef std::map<MWWorld::ConstPtr,Stream*> SaySoundMap;
         SaySoundMap mActiveSaySounds;
@@ -117,19 +159,40 @@ namespace MWSound
         Sound_Buffer *lookupSound(const std::string &soundId) const;
         Sound_Buffer *loadSound(const std::string &soundId);
 
-        // returns a decoder to start streaming
-        DecoderPtr loadVoice(const std::string &voicefile);
+        // Finds the buffer record for a soundId, without loading its data
+        Sound_Buffer *findSoundBuffer(const std::string &soundId);
+        bool loadSoundData(Sound_Buffer *sfx, const Sound_Data &data);
+        void updateDecodedSounds();
+
+        // returns a decoder to start streaming, and replaces voicefile with the name of the file that was opened
+        DecoderPtr loadVoice(std::string &voicefile);
+
+        std::shared_ptr<Sound_Loudness> getVoiceLoudness(const std::string &voicefile);
+        void updateVoiceLoudness();
+        uint64_t getFileSize(const std::string &name) const;
+        void readLoudnessCache();
+        void writeLoudnessCache() const;
 
         Sound *getSoundRef();
         Stream *getStreamRef();
 
-        Stream *playVoice(DecoderPtr decoder, const osg::Vec3f &pos, bool playlocal);
+        // Plays a sound through the output, or virtually if it can't be heard or there are no free sources
+        bool startSound(Sound *sound, Sound_Buffer *sfx, float offset);
+        void finishSound(Sound *sound);
+        bool isSoundPlaying(Sound *sound) const;
+        // Releases the output source of a sound, remembering where it was
+        void virtualizeSound(Sound *sound);
+        bool reviveSound(Sound *sound, Sound_Buffer *sfx);
+        void addActiveSound(const MWWorld::ConstPtr &ptr, Sound *sound, Sound_Buffer *sfx);
+
+        Stream *playVoice(DecoderPtr decoder, const std::string &voicefile, const osg::Vec3f &pos, bool playlocal);
 
         void streamMusicFull(const std::string& filename);
         void advanceMusic(const std::string& filename);
         void startRandomTitle();
 
         void updateSounds(float duration);
+        void updateVirtualSounds();
         void updateRegionSound(float duration);
         void updateWaterSound(float duration);
         void updateMusic(float duration);
@@ -146,7 +209,7 @@ namespace MWSound
         friend class OpenAL_Output;
 
     public:
-        SoundManager(const VFS::Manager* vfs, const std::map<std::string, std::string>& fallbackMap, bool useSound);
+        SoundManager(const VFS::Manager* vfs, const std::map<std::string, std::string>& fallbackMap, bool useSound, const std::string& cachePath);
         virtual ~SoundManager();
 
         virtual void processChangedSettings(const Settings::CategorySettingVector& settings);
@@ -210,6 +273,9 @@ namespace MWSound
         ///< Play a 3D sound at \a initialPos. If the sound should be moving, it must be updated using Sound::setPosition.
         ///< @param offset Number of seconds into the sound to start playback.
 
+        virtual void preloadSounds(const std::vector<std::string>& soundIds);
+        ///< Decode the given sounds in the background, so they can be played without a delay.
+
         virtual void stopSound(Sound *sound);
         ///< Stop the given sound from playing
         /// @note no-op if \a sound is null
@@ -248,6 +314,9 @@ namespace MWSound
         virtual void updatePtr (const MWWorld::ConstPtr& old, const MWWorld::ConstPtr& updated);
 
         virtual void clear();
+
+        virtual unsigned int getStreamUnderruns() const;
+        ///< Number of times music or a voice ran out of decoded data while playing.
     };
 }
 
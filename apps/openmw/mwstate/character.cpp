@@ -84,6 +84,10 @@ MWState::Character::Character (const boost::filesystem::path& saves, const std::
         {
             boost::filesystem::path slotPath = *iter;
 
+            // Left over from a save that was interrupted while being written
+            if (slotPath.extension() == ".tmp")
+                continue;
+
             try
             {
                 addSlot (slotPath, game);
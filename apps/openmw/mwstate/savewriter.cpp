@@ -0,0 +1,62 @@
+#include "savewriter.hpp"
+
+#include <stdexcept>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <components/esm/savecompression.hpp>
+
+MWState::SaveWriter::SaveWriter (const boost::filesystem::path& path, bool compress)
+: mPath (path), mCompress (compress)
+{}
+
+std::ostream& MWState::SaveWriter::getStream()
+{
+    return mStream;
+}
+
+const boost::filesystem::path& MWState::SaveWriter::getPath() const
+{
+    return mPath;
+}
+
+const std::string& MWState::SaveWriter::getError() const
+{
+    return mError;
+}
+
+void MWState::SaveWriter::doWork()
+{
+    boost::filesystem::path tempPath = mPath;
+    tempPath += ".tmp";
+
+    try
+    {
+        {
+            boost::filesystem::ofstream filestream (tempPath, std::ios::binary);
+
+            if (mCompress)
+            {
+                // compress from the stream a chunk at a time, rather than copying the whole save out of it
+                std::streamoff size = mStream.tellp();
+                mStream.seekg (0);
+                ESM::SaveCompression::write (filestream, mStream, static_cast<size_t> (size));
+            }
+            else
+                filestream << mStream.rdbuf();
+
+            if (filestream.fail())
+                throw std::runtime_error("Write operation failed (file stream)");
+        }
+
+        boost::filesystem::rename (tempPath, mPath);
+    }
+    catch (const std::exception& e)
+    {
+        mError = e.what();
+
+        boost::system::error_code ec;
+        boost::filesystem::remove (tempPath, ec);
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef GAME_STATE_SAVEWRITER_H
+#define GAME_STATE_SAVEWRITER_H
+
+#include <sstream>
+#include <string>
+
+#include <boost/filesystem/path.hpp>
+
+#include <components/sceneutil/workqueue.hpp>
+
+namespace MWState
+{
+    /// @brief Compresses a saved game serialised in memory and writes it to disk, on a background thread.
+    /// @note The file is written under a temporary name first, so an existing save is only replaced once
+    /// the new one was written completely.
+    class SaveWriter : public SceneUtil::WorkItem
+    {
+            boost::filesystem::path mPath;
+            bool mCompress;
+            std::stringstream mStream;
+            std::string mError;
+
+        public:
+
+            SaveWriter (const boost::filesystem::path& path, bool compress);
+
+            /// Stream to serialise the saved game into. Only use it before the item is queued.
+            std::ostream& getStream();
+
+            const boost::filesystem::path& getPath() const;
+
+            /// Reason the save could not be written, or empty on success. Only valid once the item is done.
+            const std::string& getError() const;
+
+            virtual void doWork();
+    };
+}
+
+#endif
@@ -9,6 +9,8 @@
 
 #include <components/settings/settings.hpp>
 
+#include <components/sceneutil/workqueue.hpp>
+
 #include <osg/Image>
 
 #include <osgDB/Registry>
@@ -37,6 +39,8 @@
 
 #include "../mwscript/globalscripts.hpp"
 
+#include "savewriter.hpp"
+
 void MWState::StateManager::cleanup (bool force)
 {
     if (mState!=State_NoGame || force)
@@ -85,10 +89,67 @@ std::map<int, int> MWState::StateManager::buildContentFileIndexMap (const ESM::E
 
 MWState::StateManager::StateManager (const boost::filesystem::path& saves, const std::string& game)
 : mQuitRequest (false), mAskLoadRecent(false), mState (State_NoGame), mCharacterManager (saves, game), mTimePlayed (0)
+, mSaveQueue (new SceneUtil::WorkQueue (1)), mPendingSaveCharacter (NULL)
 {
 
 }
 
+MWState::StateManager::~StateManager()
+{
+    // Don't lose a save that is still being written
+    if (mPendingSave)
+    {
+        mPendingSave->waitTillDone();
+        if (!mPendingSave->getError().empty())
+            std::cerr << "Failed to save game: " << mPendingSave->getError() << std::endl;
+    }
+}
+
+void MWState::StateManager::waitForSave()
+{
+    if (mPendingSave)
+        mPendingSave->waitTillDone();
+}
+
+void MWState::StateManager::finishSave (bool deleteFailedSlot)
+{
+    if (!mPendingSave)
+        return;
+
+    osg::ref_ptr<SaveWriter> save = mPendingSave;
+    Character *character = mPendingSaveCharacter;
+    mPendingSave = NULL;
+    mPendingSaveCharacter = NULL;
+
+    save->waitTillDone();
+
+    if (save->getError().empty())
+        return;
+
+    std::stringstream error;
+    error << "Failed to save game: " << save->getError();
+
+    std::cerr << error.str() << std::endl;
+
+    std::vector<std::string> buttons;
+    buttons.push_back("#{sOk}");
+    MWBase::Environment::get().getWindowManager()->interactiveMessageBox(error.str(), buttons);
+
+    // If no file was written, clean up the slot
+    if (deleteFailedSlot && character && !boost::filesystem::exists(save->getPath()))
+    {
+        for (Character::SlotIterator it = character->begin(); it != character->end(); ++it)
+        {
+            if (it->mPath == save->getPath())
+            {
+                character->deleteSlot(&*it);
+                character->cleanup();
+                break;
+            }
+        }
+    }
+}
+
 void MWState::StateManager::requestQuit()
 {
     mQuitRequest = true;
@@ -173,6 +234,10 @@ void MWState::StateManager::endGame()
 
 void MWState::StateManager::saveGame (const std::string& description, const Slot *slot)
 {
+    // Only one save is written at a time, and a new slot's file name must not clash with a pending one.
+    // The caller holds a slot pointer, so leave the slot of a failed save alone.
+    finishSave (false);
+
     MWState::Character* character = getCurrentCharacter();
 
     try
@@ -223,8 +288,9 @@ void MWState::StateManager::saveGame (const std::string& description, const Slot
         MWBase::Environment::get().getMechanicsManager()->persistAnimationStates();
 
         // Write to a memory stream first. If there is an exception during the save process, we don't want to trash the
-        // existing save file we are overwriting.
-        std::stringstream stream;
+        // existing save file we are overwriting. Compressing and writing the file is done in the background.
+        osg::ref_ptr<SaveWriter> saveWriter = new SaveWriter (slot->mPath, Settings::Manager::getBool ("compress", "Saves"));
+        std::ostream& stream = saveWriter->getStream();
 
         ESM::ESMWriter writer;
 
@@ -284,11 +350,9 @@ void MWState::StateManager::saveGame (const std::string& description, const Slot
             throw std::runtime_error("Write operation failed (memory stream)");
 
         // All good, write to file
-        boost::filesystem::ofstream filestream (slot->mPath, std::ios::binary);
-        filestream << stream.rdbuf();
-
-        if (filestream.fail())
-            throw std::runtime_error("Write operation failed (file stream)");
+        mPendingSave = saveWriter;
+        mPendingSaveCharacter = character;
+        mSaveQueue->addWorkItem (saveWriter);
 
         Settings::Manager::setString ("character", "Saves",
             slot->mPath.parent_path().filename().string());
@@ -362,6 +426,8 @@ void MWState::StateManager::loadGame(const std::string& filepath)
 
 void MWState::StateManager::loadGame (const Character *character, const std::string& filepath)
 {
+    finishSave();
+
     try
     {
         cleanup();
@@ -560,6 +626,12 @@ void MWState::StateManager::quickLoad()
 
 void MWState::StateManager::deleteGame(const MWState::Character *character, const MWState::Slot *slot)
 {
+    waitForSave();
+
+    // The character may be deleted along with its last slot
+    if (character == mPendingSaveCharacter)
+        mPendingSaveCharacter = NULL;
+
     mCharacterManager.deleteSlot(character, slot);
 }
 
@@ -582,6 +654,9 @@ void MWState::StateManager::update (float duration)
 {
     mTimePlayed += duration;
 
+    if (mPendingSave && mPendingSave->isDone())
+        finishSave();
+
     // Note: It would be nicer to trigger this from InputManager, i.e. the very beginning of the frame update.
     if (mAskLoadRecent)
     {
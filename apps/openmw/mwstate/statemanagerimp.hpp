@@ -7,10 +7,19 @@
 
 #include <boost/filesystem/path.hpp>
 
+#include <osg/ref_ptr>
+
 #include "charactermanager.hpp"
 
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
 namespace MWState
 {
+    class SaveWriter;
+
     class StateManager : public MWBase::StateManager
     {
             bool mQuitRequest;
@@ -19,10 +28,21 @@ namespace MWState
             CharacterManager mCharacterManager;
             double mTimePlayed;
 
+            osg::ref_ptr<SceneUtil::WorkQueue> mSaveQueue;
+            osg::ref_ptr<SaveWriter> mPendingSave;
+            Character *mPendingSaveCharacter;
+
         private:
 
             void cleanup (bool force = false);
 
+            void waitForSave();
+            ///< Wait for the save being written in the background, if any, to be done.
+
+            void finishSave (bool deleteFailedSlot = true);
+            ///< Wait for the save being written in the background, if any, and report if it failed.
+            /// \param deleteFailedSlot Delete the slot of a failed save if it has no file. Invalidates slot pointers.
+
             bool verifyProfile (const ESM::SavedGame& profile) const;
 
             void writeScreenshot (std::vector<char>& imageData) const;
@@ -33,6 +53,8 @@ namespace MWState
 
             StateManager (const boost::filesystem::path& saves, const std::string& game);
 
+            virtual ~StateManager();
+
             virtual void requestQuit();
 
             virtual bool hasQuitRequest() const;
@@ -55,6 +77,7 @@ namespace MWState
             ///< Write a saved game to \a slot or create a new slot if \a slot == 0.
             ///
             /// \note Slot must belong to the current character.
+            /// \note The game state is serialised right away, the file is written in the background.
 
             ///Saves a file, using supplied filename, overwritting if needed
             /** This is mostly used for quicksaving and autosaving, for they use the same name over and over again
@@ -2,6 +2,8 @@
 
 #include <iostream>
 
+#include <OpenThreads/ScopedLock>
+
 #include <components/resource/scenemanager.hpp>
 #include <components/resource/resourcesystem.hpp>
 #include <components/resource/bulletshapemanager.hpp>
@@ -16,9 +18,12 @@
 
 #include "../mwbase/environment.hpp"
 #include "../mwbase/world.hpp"
+#include "../mwbase/soundmanager.hpp"
 
 #include "../mwrender/landmanager.hpp"
 
+#include "../mwphysics/heightfield.hpp"
+
 #include "cellstore.hpp"
 #include "manualref.hpp"
 #include "class.hpp"
@@ -28,19 +33,22 @@ namespace MWWorld
 
     struct ListModelsVisitor
     {
-        ListModelsVisitor(std::vector<std::string>& out)
+        ListModelsVisitor(std::vector<std::string>& out, std::vector<std::string>& sounds)
             : mOut(out)
+            , mSounds(sounds)
         {
         }
 
         virtual bool operator()(const MWWorld::Ptr& ptr)
         {
             ptr.getClass().getModelsToPreload(ptr, mOut);
+            ptr.getClass().getSoundsToPreload(ptr, mSounds);
 
             return true;
         }
 
         std::vector<std::string>& mOut;
+        std::vector<std::string>& mSounds;
     };
 
     /// Worker thread item: preload models in a cell.
@@ -62,7 +70,7 @@ namespace MWWorld
         {
             mTerrainView = mTerrain->createView();
 
-            ListModelsVisitor visitor (mMeshes);
+            ListModelsVisitor visitor (mMeshes, mSounds);
             if (cell->getState() == MWWorld::CellStore::State_Loaded)
             {
                 cell->forEach(visitor);
@@ -78,6 +86,7 @@ namespace MWWorld
                     std::string model = ref.getPtr().getClass().getModel(ref.getPtr());
                     if (!model.empty())
                         mMeshes.push_back(model);
+                    ref.getPtr().getClass().getSoundsToPreload(ref.getPtr(), mSounds);
                 }
             }
         }
@@ -94,8 +103,17 @@ namespace MWWorld
             {
                 try
                 {
+                    osg::ref_ptr<const ESMTerrain::LandObject> land = mLandManager->getLand(mX, mY);
+                    mPreloadedObjects.push_back(land);
+
+                    // build the collision shape first, it's needed as soon as the cell becomes active
+                    osg::ref_ptr<MWPhysics::HeightField> heightField = MWPhysics::HeightField::create(land.get(), mX, mY);
+                    {
+                        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mHeightFieldMutex);
+                        mHeightField = heightField;
+                    }
+
                     mTerrain->cacheCell(mTerrainView.get(), mX, mY);
-                    mPreloadedObjects.push_back(mLandManager->getLand(mX, mY));
                 }
                 catch(std::exception& e)
                 {
@@ -147,12 +165,27 @@ namespace MWWorld
             }
         }
 
+        /// Sound IDs used by objects in the cell, to be preloaded by the sound manager.
+        const std::vector<std::string>& getSounds() const
+        {
+            return mSounds;
+        }
+
+        /// Get the height field built by this item, or NULL if it isn't available yet.
+        /// @note Safe to call from the main thread while the item is still being worked on.
+        osg::ref_ptr<MWPhysics::HeightField> getHeightField()
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mHeightFieldMutex);
+            return mHeightField;
+        }
+
     private:
         typedef std::vector<std::string> MeshList;
         bool mIsExterior;
         int mX;
         int mY;
         MeshList mMeshes;
+        std::vector<std::string> mSounds;
         Resource::SceneManager* mSceneManager;
         Resource::BulletShapeManager* mBulletShapeManager;
         Resource::KeyframeManager* mKeyframeManager;
@@ -164,10 +197,39 @@ namespace MWWorld
 
         osg::ref_ptr<Terrain::View> mTerrainView;
 
+        OpenThreads::Mutex mHeightFieldMutex;
+        osg::ref_ptr<MWPhysics::HeightField> mHeightField;
+
         // keep a ref to the loaded objects to make sure it stays loaded as long as this cell is in the preloaded state
         std::vector<osg::ref_ptr<const osg::Object> > mPreloadedObjects;
     };
 
+    /// Worker thread item: read the references of a cell from the content files.
+    class ReadRefsItem : public SceneUtil::WorkItem
+    {
+    public:
+        /// Constructor to be called from the main thread.
+        ReadRefsItem(const MWWorld::CellStore* cell)
+            : mReader(cell->createContentRefReader())
+        {
+        }
+
+        virtual void doWork()
+        {
+            mReader.read(mRefs);
+        }
+
+        /// @note Only to be used once the item is done.
+        ContentRefReader::RefList& getRefs()
+        {
+            return mRefs;
+        }
+
+    private:
+        ContentRefReader mReader;
+        ContentRefReader::RefList mRefs;
+    };
+
     /// Worker thread item: update the resource system's cache, effectively deleting unused entries.
     class UpdateCacheItem : public SceneUtil::WorkItem
     {
@@ -223,6 +285,11 @@ namespace MWWorld
             it->second.mWorkItem->waitTillDone();
 
         mPreloadCells.clear();
+
+        for (ReadRefsMap::iterator it = mReadRefsCells.begin(); it != mReadRefsCells.end();++it)
+            it->second.mWorkItem->waitTillDone();
+
+        mReadRefsCells.clear();
     }
 
     void CellPreloader::preload(CellStore *cell, double timestamp)
@@ -234,7 +301,16 @@ namespace MWWorld
         }
         if (cell->getState() == CellStore::State_Unloaded)
         {
-            std::cerr << "Error: can't preload objects for unloaded cell" << std::endl;
+            // read the references in the background first, updateCache() continues with the objects once they're done
+            ReadRefsMap::iterator found = mReadRefsCells.find(cell);
+            if (found != mReadRefsCells.end())
+                found->second.mTimeStamp = timestamp;
+            else
+            {
+                osg::ref_ptr<ReadRefsItem> item (new ReadRefsItem(cell));
+                mWorkQueue->addWorkItem(item);
+                mReadRefsCells[cell] = PreloadEntry(timestamp, item);
+            }
             return;
         }
 
@@ -273,11 +349,21 @@ namespace MWWorld
         osg::ref_ptr<PreloadItem> item (new PreloadItem(cell, mResourceSystem->getSceneManager(), mBulletShapeManager, mResourceSystem->getKeyframeManager(), mTerrain, mLandManager, mPreloadInstances));
         mWorkQueue->addWorkItem(item);
 
+        // sounds are decoded by the sound manager's own worker
+        MWBase::Environment::get().getSoundManager()->preloadSounds(item->getSounds());
+
         mPreloadCells[cell] = PreloadEntry(timestamp, item);
     }
 
     void CellPreloader::notifyLoaded(CellStore *cell)
     {
+        ReadRefsMap::iterator reading = mReadRefsCells.find(cell);
+        if (reading != mReadRefsCells.end())
+        {
+            mUnrefQueue->push(reading->second.mWorkItem);
+            mReadRefsCells.erase(reading);
+        }
+
         PreloadMap::iterator found = mPreloadCells.find(cell);
         if (found != mPreloadCells.end())
         {
@@ -292,6 +378,14 @@ namespace MWWorld
         }
     }
 
+    osg::ref_ptr<MWPhysics::HeightField> CellPreloader::getHeightField(const CellStore *cell)
+    {
+        PreloadMap::iterator found = mPreloadCells.find(cell);
+        if (found == mPreloadCells.end() || !found->second.mWorkItem)
+            return NULL;
+        return static_cast<PreloadItem*>(found->second.mWorkItem.get())->getHeightField();
+    }
+
     void CellPreloader::clear()
     {
         for (PreloadMap::iterator it = mPreloadCells.begin(); it != mPreloadCells.end();)
@@ -304,10 +398,39 @@ namespace MWWorld
 
             mPreloadCells.erase(it++);
         }
+
+        for (ReadRefsMap::iterator it = mReadRefsCells.begin(); it != mReadRefsCells.end(); ++it)
+            mUnrefQueue->push(it->second.mWorkItem);
+
+        mReadRefsCells.clear();
     }
 
     void CellPreloader::updateCache(double timestamp)
     {
+        for (ReadRefsMap::iterator it = mReadRefsCells.begin(); it != mReadRefsCells.end();)
+        {
+            if (!it->second.mWorkItem->isDone())
+            {
+                ++it;
+                continue;
+            }
+
+            CellStore* cell = it->first;
+            double requested = it->second.mTimeStamp;
+
+            // the cell may have been loaded in the meantime, which reads the references on its own
+            if (cell->getState() == CellStore::State_Unloaded)
+            {
+                cell->setContentRefs(static_cast<ReadRefsItem*>(it->second.mWorkItem.get())->getRefs());
+                cell->preload();
+            }
+
+            mUnrefQueue->push(it->second.mWorkItem);
+            mReadRefsCells.erase(it++);
+
+            preload(cell, requested);
+        }
+
         for (PreloadMap::iterator it = mPreloadCells.begin(); it != mPreloadCells.end();)
         {
             if (mPreloadCells.size() >= mMinCacheSize && it->second.mTimeStamp < timestamp - mExpiryDelay)
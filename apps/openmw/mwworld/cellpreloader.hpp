@@ -28,6 +28,11 @@ namespace MWRender
     class LandManager;
 }
 
+namespace MWPhysics
+{
+    class HeightField;
+}
+
 namespace MWWorld
 {
     class CellStore;
@@ -39,11 +44,15 @@ namespace MWWorld
         ~CellPreloader();
 
         /// Ask a background thread to preload rendering meshes and collision shapes for objects in this cell.
-        /// @note The cell itself must be in State_Loaded or State_Preloaded.
+        /// @note The references of a cell in State_Unloaded are read in a background thread first.
         void preload(MWWorld::CellStore* cell, double timestamp);
 
         void notifyLoaded(MWWorld::CellStore* cell);
 
+        /// Get the terrain collision shape built in the background for this exterior cell.
+        /// @return NULL if the cell wasn't preloaded or its height field isn't ready yet.
+        osg::ref_ptr<MWPhysics::HeightField> getHeightField(const MWWorld::CellStore* cell);
+
         void clear();
 
         /// Removes preloaded cells that have not had a preload request for a while.
@@ -103,6 +112,11 @@ namespace MWWorld
         // Cells that are currently being preloaded, or have already finished preloading
         PreloadMap mPreloadCells;
 
+        typedef std::map<MWWorld::CellStore*, PreloadEntry> ReadRefsMap;
+
+        // Unloaded cells that are waiting for their references to be read before preloading them
+        ReadRefsMap mReadRefsCells;
+
         std::vector<osg::ref_ptr<Terrain::View> > mTerrainViews;
         std::vector<osg::Vec3f> mTerrainPreloadPositions;
         osg::ref_ptr<SceneUtil::WorkItem> mTerrainPreloadItem;
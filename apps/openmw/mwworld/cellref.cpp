@@ -17,6 +17,7 @@ namespace MWWorld
 
     void CellRef::unsetRefNum()
     {
+        mDirty = true;
         mCellRef.mRefNum.unset();
     }
 
@@ -50,6 +51,7 @@ namespace MWWorld
         if (scale != mCellRef.mScale)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mScale = scale;
         }
     }
@@ -62,6 +64,7 @@ namespace MWWorld
     void CellRef::setPosition(const ESM::Position &position)
     {
         mChanged = true;
+        mDirty = true;
         mCellRef.mPos = position;
     }
 
@@ -75,6 +78,7 @@ namespace MWWorld
         if (charge != mCellRef.mEnchantmentCharge)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mEnchantmentCharge = charge;
         }
     }
@@ -89,12 +93,14 @@ namespace MWWorld
         if (charge != mCellRef.mChargeInt)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mChargeInt = charge;
         }
     }
 
     void CellRef::applyChargeRemainderToBeSubtracted(float chargeRemainder)
     {
+        mDirty = true;
         mCellRef.mChargeIntRemainder += std::abs(chargeRemainder);
         if (mCellRef.mChargeIntRemainder > 1.0f)
         {
@@ -121,6 +127,7 @@ namespace MWWorld
         if (charge != mCellRef.mChargeFloat)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mChargeFloat = charge;
         }
     }
@@ -140,6 +147,7 @@ namespace MWWorld
         if (!mCellRef.mGlobalVariable.empty())
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mGlobalVariable.erase();
         }
     }
@@ -149,6 +157,7 @@ namespace MWWorld
         if (factionRank != mCellRef.mFactionRank)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mFactionRank = factionRank;
         }
     }
@@ -163,6 +172,7 @@ namespace MWWorld
         if (owner != mCellRef.mOwner)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mOwner = owner;
         }
     }
@@ -177,6 +187,7 @@ namespace MWWorld
         if (soul != mCellRef.mSoul)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mSoul = soul;
         }
     }
@@ -191,6 +202,7 @@ namespace MWWorld
         if (faction != mCellRef.mFaction)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mFaction = faction;
         }
     }
@@ -205,6 +217,7 @@ namespace MWWorld
         if (lockLevel != mCellRef.mLockLevel)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mLockLevel = lockLevel;
         }
     }
@@ -224,6 +237,7 @@ namespace MWWorld
         if (trap != mCellRef.mTrap)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mTrap = trap;
         }
     }
@@ -238,6 +252,7 @@ namespace MWWorld
         if (value != mCellRef.mGoldValue)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mGoldValue = value;
         }
     }
@@ -252,4 +267,14 @@ namespace MWWorld
         return mChanged;
     }
 
+    bool CellRef::isDirty() const
+    {
+        return mDirty;
+    }
+
+    void CellRef::clearDirty()
+    {
+        mDirty = false;
+    }
+
 }
@@ -20,6 +20,7 @@ namespace MWWorld
             : mCellRef(ref)
         {
             mChanged = false;
+            mDirty = true;
         }
 
         // Note: Currently unused for items in containers
@@ -111,8 +112,13 @@ namespace MWWorld
         // Has this CellRef changed since it was originally loaded?
         bool hasChanged() const;
 
+        // Has this CellRef changed since the last call to clearDirty()?
+        bool isDirty() const;
+        void clearDirty();
+
     private:
         bool mChanged;
+        bool mDirty;
         ESM::CellRef mCellRef;
     };
 
@@ -1,20 +1,41 @@
 #ifndef GAME_MWWORLD_CELLREFLIST_H
 #define GAME_MWWORLD_CELLREFLIST_H
 
-#include <list>
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "livecellref.hpp"
+#include "segmentedlist.hpp"
 
 namespace MWWorld
 {
     /// \brief Collection of references of one type
+    ///
+    /// References are kept in a SegmentedList, so their addresses (and therefore Ptrs) stay valid while
+    /// references are added. References that came from a content file are indexed by their RefNum.
     template <typename X>
     struct CellRefList
     {
         typedef LiveCellRef<X> LiveRef;
-        typedef std::list<LiveRef> List;
+        typedef SegmentedList<LiveRef> List;
         List mList;
 
+        CellRefList() {}
+
+        CellRefList (const CellRefList& other) : mList (other.mList)
+        {
+            rebuildIndex();
+        }
+
+        CellRefList& operator= (const CellRefList& other)
+        {
+            mList = other.mList;
+            rebuildIndex();
+            return *this;
+        }
+
         /// Search for the given reference in the given reclist from
         /// ESMStore. Insert the reference into the list if a match is
         /// found. If not, throw an exception.
@@ -24,22 +45,95 @@ namespace MWWorld
         /// all methods are known.
         void load (ESM::CellRef &ref, bool deleted, const MWWorld::ESMStore &esmStore);
 
+        /// @note References must be added with this function rather than directly to mList, to keep the
+        /// RefNum index up to date.
         LiveRef &insert (const LiveRef &item)
         {
             mList.push_back(item);
-            return mList.back();
+            LiveRef& ref = mList.back();
+
+            addToIndex(ref);
+            return ref;
+        }
+
+        /// Find the reference that came from a content file with the given refNum.
+        /// @return NULL if there is no such reference
+        LiveRef *find (const ESM::RefNum &refNum)
+        {
+            typename Index::iterator found = mIndex.find(refNum);
+            if (found == mIndex.end())
+                return NULL;
+
+            // The RefNum of a reference can be unset after it was added.
+            if (!(*found->second == refNum))
+            {
+                mIndex.erase(found);
+                return NULL;
+            }
+
+            return found->second;
         }
 
         /// Remove all references with the given refNum from this list.
         void remove (const ESM::RefNum &refNum)
         {
+            if (refNum.hasContentFile() && !mDuplicates.count(refNum))
+            {
+                // at most one reference, which the index knows about
+                if (LiveRef* ref = find(refNum))
+                {
+                    mList.erase(mList.iteratorTo(*ref));
+                    mIndex.erase(refNum);
+                }
+                return;
+            }
+
             for (typename List::iterator it = mList.begin(); it != mList.end();)
             {
                 if (*it == refNum)
-                    mList.erase(it++);
+                    it = mList.erase(it);
                 else
                     ++it;
             }
+
+            mIndex.erase(refNum);
+            mDuplicates.erase(refNum);
+        }
+
+    private:
+
+        struct RefNumHash
+        {
+            std::size_t operator() (const ESM::RefNum& refNum) const
+            {
+                return std::hash<unsigned int>()(refNum.mIndex) ^ (std::hash<int>()(refNum.mContentFile) << 1);
+            }
+        };
+
+        typedef std::unordered_map<ESM::RefNum, LiveRef *, RefNumHash> Index;
+        Index mIndex;
+
+        // RefNums shared by more than one reference, which remove() has to scan for
+        std::unordered_set<ESM::RefNum, RefNumHash> mDuplicates;
+
+        void addToIndex (LiveRef& ref)
+        {
+            const ESM::RefNum& refNum = ref.mRef.getRefNum();
+            if (!refNum.hasContentFile())
+                return;
+
+            // keep the first reference with a duplicate RefNum
+            if (!mIndex.insert(std::make_pair(refNum, &ref)).second)
+                mDuplicates.insert(refNum);
+        }
+
+        void rebuildIndex()
+        {
+            mIndex.clear();
+            mDuplicates.clear();
+
+            for (typename List::iterator it = mList.begin(); it != mList.end(); ++it)
+                addToIndex(*it);
         }
     };
 }
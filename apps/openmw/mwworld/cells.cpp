@@ -1,11 +1,15 @@
 #include "cells.hpp"
 
 #include <iostream>
+#include <algorithm>
+#include <memory>
+#include <sstream>
 
 #include <components/esm/esmreader.hpp>
 #include <components/esm/esmwriter.hpp>
 #include <components/esm/defs.hpp>
 #include <components/esm/cellstate.hpp>
+#include <components/esm/savedgame.hpp>
 #include <components/loadinglistener/loadinglistener.hpp>
 #include <components/settings/settings.hpp>
 
@@ -17,6 +21,17 @@
 #include "containerstore.hpp"
 #include "cellstore.hpp"
 
+namespace
+{
+    void writeCellStateRecord (ESM::ESMWriter& writer, const std::vector<char>& data)
+    {
+        writer.startRecord (ESM::REC_CSTA);
+        if (!data.empty())
+            writer.write (&data[0], data.size());
+        writer.endRecord (ESM::REC_CSTA);
+    }
+}
+
 MWWorld::CellStore *MWWorld::Cells::getCellStore (const ESM::Cell *cell)
 {
     if (cell->mData.mFlags & ESM::Cell::Interior)
@@ -51,6 +66,9 @@ void MWWorld::Cells::clear()
 {
     mInteriors.clear();
     mExteriors.clear();
+    mPendingStates.clear();
+    mPendingContentFileMap.clear();
+    mSavedStates.clear();
     std::fill(mIdCache.begin(), mIdCache.end(), std::make_pair("", (MWWorld::CellStore*)0));
     mIdCacheIndex = 0;
 }
@@ -70,30 +88,59 @@ MWWorld::Ptr MWWorld::Cells::getPtrAndCache (const std::string& name, CellStore&
     return ptr;
 }
 
-void MWWorld::Cells::writeCell (ESM::ESMWriter& writer, CellStore& cell) const
+void MWWorld::Cells::writeCell (ESM::ESMWriter& writer, CellStore& cell)
 {
-    if (cell.getState()!=CellStore::State_Loaded)
-        cell.load ();
+    std::map<const CellStore *, PendingState>::const_iterator pending = mPendingStates.find (&cell);
+
+    if (pending!=mPendingStates.end())
+    {
+        if (mPendingUnchanged)
+        {
+            // Nothing can have changed since the state was read, so there is no need to parse it
+            writeCellStateRecord (writer, pending->second.mData);
+            return;
+        }
 
-    ESM::CellState cellState;
+        restoreState (cell);
+    }
 
-    cell.saveState (cellState);
+    // Only cells that changed since they were last written need to be written again
+    std::vector<char>& data = mSavedStates[&cell];
 
-    writer.startRecord (ESM::REC_CSTA);
-    cellState.mId.save (writer);
-    cellState.save (writer);
-    cell.writeFog(writer);
-    cell.writeReferences (writer);
-    writer.endRecord (ESM::REC_CSTA);
+    if (data.empty() || cell.isDirty())
+    {
+        if (cell.getState()!=CellStore::State_Loaded)
+            cell.load ();
+
+        ESM::CellState cellState;
+
+        cell.saveState (cellState);
+
+        std::ostringstream stream;
+        ESM::ESMWriter buffer;
+        buffer.saveRecords (stream);
+        cellState.mId.save (buffer);
+        cellState.save (buffer);
+        cell.writeFog(buffer);
+        cell.writeReferences (buffer);
+        buffer.close();
+
+        std::string written = stream.str();
+        data.assign (written.begin(), written.end());
+
+        cell.clearDirty();
+    }
+
+    writeCellStateRecord (writer, data);
 }
 
 MWWorld::Cells::Cells (const MWWorld::ESMStore& store, std::vector<ESM::ESMReader>& reader)
 : mStore (store), mReader (reader),
   mIdCache (Settings::Manager::getInt("pointers cache size", "Cells"), std::pair<std::string, CellStore *> ("", (CellStore*)0)),
-  mIdCacheIndex (0)
+  mIdCacheIndex (0), mPendingFormat (0), mPendingUnchanged (false)
 {}
 
-MWWorld::CellStore *MWWorld::Cells::getExterior (int x, int y)
+MWWorld::CellStore *MWWorld::Cells::getExterior (int x, int y, bool load)
 {
     std::map<std::pair<int, int>, CellStore>::iterator result =
         mExteriors.find (std::make_pair (x, y));
@@ -124,6 +171,11 @@ MWWorld::CellStore *MWWorld::Cells::getExterior (int x, int y)
             std::make_pair (x, y), CellStore (cell, mStore, mReader))).first;
     }
 
+    if (!load)
+        return &result->second;
+
+    restoreState (result->second);
+
     if (result->second.getState()!=CellStore::State_Loaded)
     {
         result->second.load ();
@@ -132,7 +184,7 @@ MWWorld::CellStore *MWWorld::Cells::getExterior (int x, int y)
     return &result->second;
 }
 
-MWWorld::CellStore *MWWorld::Cells::getInterior (const std::string& name)
+MWWorld::CellStore *MWWorld::Cells::getInterior (const std::string& name, bool load)
 {
     std::string lowerName = Misc::StringUtils::lowerCase(name);
     std::map<std::string, CellStore>::iterator result = mInteriors.find (lowerName);
@@ -144,6 +196,11 @@ MWWorld::CellStore *MWWorld::Cells::getInterior (const std::string& name)
         result = mInteriors.insert (std::make_pair (lowerName, CellStore (cell, mStore, mReader))).first;
     }
 
+    if (!load)
+        return &result->second;
+
+    restoreState (result->second);
+
     if (result->second.getState()!=CellStore::State_Loaded)
     {
         result->second.load ();
@@ -163,6 +220,9 @@ MWWorld::CellStore *MWWorld::Cells::getCell (const ESM::CellId& id)
 MWWorld::Ptr MWWorld::Cells::getPtr (const std::string& name, CellStore& cell,
     bool searchInContainers)
 {
+    if (!mayContain (cell, name))
+        return Ptr();
+
     if (cell.getState()==CellStore::State_Unloaded)
         cell.preload ();
 
@@ -291,7 +351,7 @@ int MWWorld::Cells::countSavedGameRecords() const
     return count;
 }
 
-void MWWorld::Cells::write (ESM::ESMWriter& writer, Loading::Listener& progress) const
+void MWWorld::Cells::write (ESM::ESMWriter& writer, Loading::Listener& progress)
 {
     for (std::map<std::pair<int, int>, CellStore>::iterator iter (mExteriors.begin());
         iter!=mExteriors.end(); ++iter)
@@ -333,11 +393,112 @@ public:
     }
 };
 
+MWWorld::CellStore *MWWorld::Cells::getCellStoreForState (const ESM::CellId& id)
+{
+    if (id.mPaged)
+    {
+        const ESM::Cell *cell = mStore.get<ESM::Cell>().search (id.mIndex.mX, id.mIndex.mY);
+
+        // Cells that aren't predefined are made on the fly
+        if (!cell)
+            return getExterior (id.mIndex.mX, id.mIndex.mY);
+
+        return getCellStore (cell);
+    }
+
+    return getCellStore (mStore.get<ESM::Cell>().find (id.mWorldspace));
+}
+
+void MWWorld::Cells::readCellState (ESM::ESMReader& reader, CellStore& cellStore,
+    const std::map<int, int>& contentFileMap)
+{
+    ESM::CellState state;
+    state.load (reader);
+    cellStore.loadState (state);
+
+    if (state.mHasFogOfWar)
+        cellStore.readFog(reader);
+
+    if (cellStore.getState()!=CellStore::State_Loaded)
+        cellStore.load ();
+
+    GetCellStoreCallback callback(*this);
+
+    cellStore.readReferences (reader, contentFileMap, &callback);
+}
+
+void MWWorld::Cells::restoreState (CellStore& cellStore)
+{
+    std::map<const CellStore *, PendingState>::iterator found = mPendingStates.find (&cellStore);
+    if (found==mPendingStates.end())
+        return;
+
+    // Restoring may move references into other cells, which can restore those in turn
+    std::vector<char> data;
+    data.swap (found->second.mData);
+    mPendingStates.erase (found);
+
+    // Wrap the record in a file of its own, so it is read with the format of the saved game it came from
+    std::shared_ptr<std::stringstream> stream (new std::stringstream);
+
+    ESM::ESMWriter writer;
+    writer.setFormat (mPendingFormat);
+    writer.setVersion (0);
+    writer.setType (0);
+    writer.setAuthor ("");
+    writer.setDescription ("");
+    writer.setRecordCount (1);
+    writer.save (*stream);
+    writer.startRecord (ESM::REC_CSTA);
+    if (!data.empty())
+        writer.write (&data[0], data.size());
+    writer.endRecord (ESM::REC_CSTA);
+    writer.close();
+
+    ESM::ESMReader reader;
+    reader.open (stream, cellStore.getCell()->getDescription());
+    reader.getRecName();
+    reader.getRecHeader();
+
+    ESM::CellId id;
+    id.load (reader);
+
+    readCellState (reader, cellStore, mPendingContentFileMap);
+
+    // The record can be written back as it is until the cell changes
+    if (mPendingUnchanged)
+    {
+        mSavedStates[&cellStore].swap (data);
+        cellStore.clearDirty();
+    }
+}
+
+bool MWWorld::Cells::mayContain (CellStore& cellStore, const std::string& name)
+{
+    std::map<const CellStore *, PendingState>::const_iterator pending = mPendingStates.find (&cellStore);
+
+    if (pending!=mPendingStates.end() && cellStore.getState()!=CellStore::State_Loaded)
+    {
+        // A cell that was not restored yet has its references from the content files and those in its saved state
+        if (cellStore.getState()==CellStore::State_Unloaded)
+            cellStore.preload ();
+
+        if (!cellStore.hasId (name)
+            && !std::binary_search (pending->second.mRefIds.begin(), pending->second.mRefIds.end(), name))
+            return false;
+    }
+
+    restoreState (cellStore);
+    return true;
+}
+
 bool MWWorld::Cells::readRecord (ESM::ESMReader& reader, uint32_t type,
     const std::map<int, int>& contentFileMap)
 {
     if (type==ESM::REC_CSTA)
     {
+        ESM::ESM_Context start = reader.getContext();
+
         ESM::CellState state;
         state.mId.load (reader);
 
@@ -345,7 +506,7 @@ bool MWWorld::Cells::readRecord (ESM::ESMReader& reader, uint32_t type,
 
         try
         {
-            cellStore = getCell (state.mId);
+            cellStore = getCellStoreForState (state.mId);
         }
         catch (...)
         {
@@ -355,18 +516,53 @@ bool MWWorld::Cells::readRecord (ESM::ESMReader& reader, uint32_t type,
             return true;
         }
 
+        // Only the cell state itself is needed right away, the references are restored when the cell is used
         state.load (reader);
         cellStore->loadState (state);
 
-        if (state.mHasFogOfWar)
-            cellStore->readFog(reader);
+        // Note the references of the cell, and whether it moved references into other cells, from the
+        // subrecord headers without parsing the references themselves
+        PendingState pendingState;
+        bool hasMovedRefs = false;
+        reader.restoreContext (start);
+        while (reader.hasMoreSubs())
+        {
+            reader.getSubName();
+            if (reader.retSubName()=="NAME")
+                pendingState.mRefIds.push_back (Misc::StringUtils::lowerCase (reader.getHString()));
+            else
+            {
+                if (reader.retSubName()=="MVRF")
+                    hasMovedRefs = true;
+                reader.skipHSub();
+            }
+        }
+        std::sort (pendingState.mRefIds.begin(), pendingState.mRefIds.end());
+
+        // A loaded cell may already have had references moved into it, and a cell that moved references
+        // into other cells has to be restored for those to appear there
+        reader.restoreContext (start);
+        reader.getRawRecord (pendingState.mData);
 
-        if (cellStore->getState()!=CellStore::State_Loaded)
-            cellStore->load ();
+        if (mPendingStates.empty())
+        {
+            mPendingContentFileMap = contentFileMap;
+            mPendingFormat = reader.getFormat();
+
+            mPendingUnchanged = mPendingFormat==ESM::SavedGame::sCurrentFormat
+                && contentFileMap.size()==reader.getGameFiles().size();
+            for (std::map<int, int>::const_iterator iter (contentFileMap.begin());
+                iter!=contentFileMap.end(); ++iter)
+                if (iter->first!=iter->second)
+                    mPendingUnchanged = false;
+        }
 
-        GetCellStoreCallback callback(*this);
+        PendingState& pending = mPendingStates[cellStore];
+        pending.mData.swap (pendingState.mData);
+        pending.mRefIds.swap (pendingState.mRefIds);
 
-        cellStore->readReferences (reader, contentFileMap, &callback);
+        if (hasMovedRefs || cellStore->getState()==CellStore::State_Loaded)
+            restoreState (*cellStore);
 
         return true;
     }
@@ -4,6 +4,7 @@
 #include <map>
 #include <list>
 #include <string>
+#include <vector>
 
 #include "ptr.hpp"
 
@@ -34,6 +35,23 @@ namespace MWWorld
             std::vector<std::pair<std::string, CellStore *> > mIdCache;
             std::size_t mIdCacheIndex;
 
+            struct PendingState
+            {
+                std::vector<char> mData; ///< unparsed record data
+                std::vector<std::string> mRefIds; ///< sorted lower case IDs of the saved references
+            };
+
+            // Cell states from the last loaded saved game that have not been needed yet. They are only
+            // restored when the cell is used.
+            std::map<const CellStore *, PendingState> mPendingStates;
+            std::map<int, int> mPendingContentFileMap;
+            int mPendingFormat;
+            bool mPendingUnchanged; ///< Can the pending data be written back as it is?
+
+            // Cell states as they were last written to or read from a saved game, for writing them again
+            // as long as the cell is not dirty.
+            std::map<const CellStore *, std::vector<char> > mSavedStates;
+
             Cells (const Cells&);
             Cells& operator= (const Cells&);
 
@@ -41,7 +59,21 @@ namespace MWWorld
 
             Ptr getPtrAndCache (const std::string& name, CellStore& cellStore);
 
-            void writeCell (ESM::ESMWriter& writer, CellStore& cell) const;
+            void writeCell (ESM::ESMWriter& writer, CellStore& cell);
+
+            CellStore *getCellStoreForState (const ESM::CellId& id);
+            ///< Like getCell, but without loading the cell.
+
+            void readCellState (ESM::ESMReader& reader, CellStore& cellStore,
+                const std::map<int, int>& contentFileMap);
+            ///< Read the rest of a cell state record, after its cell ID.
+
+            void restoreState (CellStore& cellStore);
+            ///< Parse the pending saved game state of \a cellStore, if any.
+
+            bool mayContain (CellStore& cellStore, const std::string& name);
+            ///< Can a reference to \a name be in \a cellStore? Only restores the saved state of the cell if so.
+            /// @note name must be lower case
 
         public:
 
@@ -49,9 +81,12 @@ namespace MWWorld
 
             Cells (const MWWorld::ESMStore& store, std::vector<ESM::ESMReader>& reader);
 
-            CellStore *getExterior (int x, int y);
+            CellStore *getExterior (int x, int y, bool load = true);
+            ///< @param load Load the references of the cell (and restore its saved state), otherwise the
+            /// cell may be in any state.
 
-            CellStore *getInterior (const std::string& name);
+            CellStore *getInterior (const std::string& name, bool load = true);
+            ///< @param load see getExterior()
 
             CellStore *getCell (const ESM::CellId& id);
 
@@ -74,7 +109,7 @@ namespace MWWorld
 
             int countSavedGameRecords() const;
 
-            void write (ESM::ESMWriter& writer, Loading::Listener& progress) const;
+            void write (ESM::ESMWriter& writer, Loading::Listener& progress);
 
             bool readRecord (ESM::ESMReader& reader, uint32_t type,
                 const std::map<int, int>& contentFileMap);
@@ -97,6 +97,30 @@ namespace
         }
     }
 
+    template<typename T>
+    bool isDirtyCollection (const MWWorld::CellRefList<T>& collection)
+    {
+        for (typename MWWorld::CellRefList<T>::List::const_iterator
+            iter (collection.mList.begin());
+            iter!=collection.mList.end(); ++iter)
+            if (iter->mData.isDirty() || iter->mRef.isDirty())
+                return true;
+
+        return false;
+    }
+
+    template<typename T>
+    void clearDirtyCollection (MWWorld::CellRefList<T>& collection)
+    {
+        for (typename MWWorld::CellRefList<T>::List::iterator
+            iter (collection.mList.begin());
+            iter!=collection.mList.end(); ++iter)
+        {
+            iter->mData.clearDirty();
+            iter->mRef.clearDirty();
+        }
+    }
+
     template<typename RecordType, typename T>
     void readReferenceCollection (ESM::ESMReader& reader,
         MWWorld::CellRefList<T>& collection, const ESM::CellRef& cref, const std::map<int, int>& contentFileMap)
@@ -129,14 +153,12 @@ namespace
 
         if (state.mRef.mRefNum.hasContentFile())
         {
-            for (typename MWWorld::CellRefList<T>::List::iterator iter (collection.mList.begin());
-                iter!=collection.mList.end(); ++iter)
-                if (iter->mRef.getRefNum()==state.mRef.mRefNum)
-                {
-                    // overwrite existing reference
-                    iter->load (state);
-                    return;
-                }
+            if (MWWorld::LiveCellRef<T> *existing = collection.find (state.mRef.mRefNum))
+            {
+                // overwrite existing reference
+                existing->load (state);
+                return;
+            }
 
             std::cerr << "Warning: Dropping reference to " << state.mRef.mRefID << " (invalid content file link)" << std::endl;
             return;
@@ -145,7 +167,7 @@ namespace
         // new reference
         MWWorld::LiveCellRef<T> ref (record);
         ref.load (state);
-        collection.mList.push_back (ref);
+        collection.insert (ref);
     }
 
     struct SearchByRefNumVisitor
@@ -181,18 +203,17 @@ namespace MWWorld
 
         if (const X *ptr = store.search (ref.mRefID))
         {
-            typename std::list<LiveRef>::iterator iter =
-                std::find(mList.begin(), mList.end(), ref.mRefNum);
+            LiveRef *existing = find (ref.mRefNum);
 
             LiveRef liveCellRef (ref, ptr);
 
             if (deleted)
                 liveCellRef.mData.setDeletedByContentFile(true);
 
-            if (iter != mList.end())
-                *iter = liveCellRef;
+            if (existing)
+                *existing = liveCellRef;
             else
-                mList.push_back (liveCellRef);
+                insert (liveCellRef);
         }
         else
         {
@@ -221,6 +242,7 @@ namespace MWWorld
             load();
 
         mHasState = true;
+        mDirty = true;
         MovedRefTracker::iterator found = mMovedToAnotherCell.find(object.getBase());
         if (found != mMovedToAnotherCell.end())
         {
@@ -261,6 +283,8 @@ namespace MWWorld
             return copied;
         }
 
+        mDirty = true;
+
         MovedRefTracker::iterator found = mMovedHere.find(object.getBase());
         if (found != mMovedHere.end())
         {
@@ -329,7 +353,7 @@ namespace MWWorld
     }
 
     CellStore::CellStore (const ESM::Cell *cell, const MWWorld::ESMStore& esmStore, std::vector<ESM::ESMReader>& readerList)
-        : mStore(esmStore), mReader(readerList), mCell (cell), mState (State_Unloaded), mHasState (false), mLastRespawn(0,0)
+        : mStore(esmStore), mReader(readerList), mCell (cell), mState (State_Unloaded), mHasState (false), mDirty (true), mHasContentRefs (false), mLastRespawn(0,0)
     {
         mWaterLevel = cell->mWater;
     }
@@ -354,6 +378,59 @@ namespace MWWorld
         return mHasState;
     }
 
+    bool CellStore::isDirty() const
+    {
+        return mDirty ||
+            isDirtyCollection (mActivators) ||
+            isDirtyCollection (mPotions) ||
+            isDirtyCollection (mAppas) ||
+            isDirtyCollection (mArmors) ||
+            isDirtyCollection (mBooks) ||
+            isDirtyCollection (mClothes) ||
+            isDirtyCollection (mContainers) ||
+            isDirtyCollection (mCreatures) ||
+            isDirtyCollection (mDoors) ||
+            isDirtyCollection (mIngreds) ||
+            isDirtyCollection (mCreatureLists) ||
+            isDirtyCollection (mItemLists) ||
+            isDirtyCollection (mLights) ||
+            isDirtyCollection (mLockpicks) ||
+            isDirtyCollection (mMiscItems) ||
+            isDirtyCollection (mNpcs) ||
+            isDirtyCollection (mProbes) ||
+            isDirtyCollection (mRepairs) ||
+            isDirtyCollection (mStatics) ||
+            isDirtyCollection (mWeapons) ||
+            isDirtyCollection (mBodyParts);
+    }
+
+    void CellStore::clearDirty()
+    {
+        mDirty = false;
+
+        clearDirtyCollection (mActivators);
+        clearDirtyCollection (mPotions);
+        clearDirtyCollection (mAppas);
+        clearDirtyCollection (mArmors);
+        clearDirtyCollection (mBooks);
+        clearDirtyCollection (mClothes);
+        clearDirtyCollection (mContainers);
+        clearDirtyCollection (mCreatures);
+        clearDirtyCollection (mDoors);
+        clearDirtyCollection (mIngreds);
+        clearDirtyCollection (mCreatureLists);
+        clearDirtyCollection (mItemLists);
+        clearDirtyCollection (mLights);
+        clearDirtyCollection (mLockpicks);
+        clearDirtyCollection (mMiscItems);
+        clearDirtyCollection (mNpcs);
+        clearDirtyCollection (mProbes);
+        clearDirtyCollection (mRepairs);
+        clearDirtyCollection (mStatics);
+        clearDirtyCollection (mWeapons);
+        clearDirtyCollection (mBodyParts);
+    }
+
     bool CellStore::hasId (const std::string& id) const
     {
         if (mState==State_Unloaded)
@@ -428,6 +505,7 @@ namespace MWWorld
     {
         mWaterLevel = level;
         mHasState = true;
+        mDirty = true;
     }
 
     int CellStore::count() const
@@ -458,113 +536,68 @@ namespace MWWorld
         }
     }
 
-    void CellStore::listRefs()
+    ContentRefReader CellStore::createContentRefReader() const
     {
-        std::vector<ESM::ESMReader>& esm = mReader;
+        return ContentRefReader (mCell, mReader, true);
+    }
 
-        assert (mCell);
+    void CellStore::setContentRefs (ContentRefReader::RefList& refs)
+    {
+        mContentRefs.swap (refs);
+        mHasContentRefs = true;
+    }
 
-        if (mCell->mContextList.empty())
-            return; // this is a dynamically generated cell -> skipping.
+    void CellStore::readContentRefs()
+    {
+        assert (mCell);
 
-        // Load references from all plugins that do something with this cell.
-        for (size_t i = 0; i < mCell->mContextList.size(); i++)
-        {
-            try
-            {
-                // Reopen the ESM reader and seek to the right position.
-                int index = mCell->mContextList.at(i).index;
-                mCell->restore (esm[index], i);
+        if (mHasContentRefs)
+            return;
 
-                ESM::CellRef ref;
+        mContentRefs.clear();
 
-                // Get each reference in turn
-                bool deleted = false;
-                while (mCell->getNextRef (esm[index], ref, deleted))
-                {
-                    if (deleted)
-                        continue;
+        if (!mCell->mContextList.empty()) // otherwise this is a dynamically generated cell
+        {
+            ContentRefReader reader (mCell, mReader);
+            reader.read (mContentRefs);
+        }
 
-                    // Don't list reference if it was moved to a different cell.
-                    ESM::MovedCellRefTracker::const_iterator iter =
-                        std::find(mCell->mMovedRefs.begin(), mCell->mMovedRefs.end(), ref.mRefNum);
-                    if (iter != mCell->mMovedRefs.end()) {
-                        continue;
-                    }
+        mHasContentRefs = true;
+    }
 
-                    mIds.push_back (Misc::StringUtils::lowerCase (ref.mRefID));
-                }
-            }
-            catch (std::exception& e)
-            {
-                std::cerr << "An error occurred listing references for cell " << getCell()->getDescription() << ": " << e.what() << std::endl;
-            }
-        }
+    void CellStore::listRefs()
+    {
+        bool readInAdvance = mHasContentRefs;
+        readContentRefs();
 
-        // List moved references, from separately tracked list.
-        for (ESM::CellRefTracker::const_iterator it = mCell->mLeasedRefs.begin(); it != mCell->mLeasedRefs.end(); ++it)
+        for (ContentRefReader::RefList::const_iterator it = mContentRefs.begin(); it != mContentRefs.end(); ++it)
         {
-            const ESM::CellRef &ref = it->first;
-            bool deleted = it->second;
-
-            if (!deleted)
-                mIds.push_back(Misc::StringUtils::lowerCase(ref.mRefID));
+            if (!it->second)
+                mIds.push_back (Misc::StringUtils::lowerCase (it->first.mRefID));
         }
 
         std::sort (mIds.begin(), mIds.end());
+
+        // References read in advance are about to be loaded, but many cells are only ever preloaded for
+        // looking up IDs
+        if (!readInAdvance)
+        {
+            ContentRefReader::RefList().swap (mContentRefs);
+            mHasContentRefs = false;
+        }
     }
 
     void CellStore::loadRefs()
     {
-        std::vector<ESM::ESMReader>& esm = mReader;
-
-        assert (mCell);
-
-        if (mCell->mContextList.empty())
-            return; // this is a dynamically generated cell -> skipping.
+        readContentRefs();
 
         std::map<ESM::RefNum, std::string> refNumToID; // used to detect refID modifications
 
-        // Load references from all plugins that do something with this cell.
-        for (size_t i = 0; i < mCell->mContextList.size(); i++)
-        {
-            try
-            {
-                // Reopen the ESM reader and seek to the right position.
-                int index = mCell->mContextList.at(i).index;
-                mCell->restore (esm[index], i);
-
-                ESM::CellRef ref;
-                ref.mRefNum.mContentFile = ESM::RefNum::RefNum_NoContentFile;
-
-                // Get each reference in turn
-                bool deleted = false;
-                while(mCell->getNextRef(esm[index], ref, deleted))
-                {
-                    // Don't load reference if it was moved to a different cell.
-                    ESM::MovedCellRefTracker::const_iterator iter =
-                        std::find(mCell->mMovedRefs.begin(), mCell->mMovedRefs.end(), ref.mRefNum);
-                    if (iter != mCell->mMovedRefs.end()) {
-                        continue;
-                    }
-
-                    loadRef (ref, deleted, refNumToID);
-                }
-            }
-            catch (std::exception& e)
-            {
-                std::cerr << "An error occurred loading references for cell " << getCell()->getDescription() << ": " << e.what() << std::endl;
-            }
-        }
-
-        // Load moved references, from separately tracked list.
-        for (ESM::CellRefTracker::const_iterator it = mCell->mLeasedRefs.begin(); it != mCell->mLeasedRefs.end(); ++it)
-        {
-            ESM::CellRef &ref = const_cast<ESM::CellRef&>(it->first);
-            bool deleted = it->second;
+        for (ContentRefReader::RefList::iterator it = mContentRefs.begin(); it != mContentRefs.end(); ++it)
+            loadRef (it->first, it->second, refNumToID);
 
-            loadRef (ref, deleted, refNumToID);
-        }
+        ContentRefReader::RefList().swap (mContentRefs);
+        mHasContentRefs = false;
 
         updateMergedRefs();
     }
@@ -673,6 +706,7 @@ namespace MWWorld
     void CellStore::loadState (const ESM::CellState& state)
     {
         mHasState = true;
+        mDirty = true;
 
         if (mCell->mData.mFlags & ESM::Cell::Interior && mCell->mData.mFlags & ESM::Cell::HasWater)
             mWaterLevel = state.mWaterLevel;
@@ -703,6 +737,7 @@ namespace MWWorld
 
     void CellStore::readFog(ESM::ESMReader &reader)
     {
+        mDirty = true;
         mFogState.reset(new ESM::FogState());
         mFogState->load(reader);
     }
@@ -935,6 +970,7 @@ namespace MWWorld
 
     void CellStore::setFog(ESM::FogState *fog)
     {
+        mDirty = true;
         mFogState.reset(fog);
     }
 
@@ -959,6 +995,7 @@ namespace MWWorld
             if (MWBase::Environment::get().getWorld()->getTimeStamp() - mLastRespawn > 24*30*iMonthsToRespawn)
             {
                 mLastRespawn = MWBase::Environment::get().getWorld()->getTimeStamp();
+                mDirty = true;
                 for (CellRefList<ESM::Container>::List::iterator it (mContainers.mList.begin()); it!=mContainers.mList.end(); ++it)
                 {
                     Ptr ptr = getCurrentPtr(&*it);
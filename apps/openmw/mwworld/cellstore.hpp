@@ -10,6 +10,7 @@
 
 #include "livecellref.hpp"
 #include "cellreflist.hpp"
+#include "contentrefreader.hpp"
 
 #include <components/esm/loadacti.hpp>
 #include <components/esm/loadalch.hpp>
@@ -70,9 +71,14 @@ namespace MWWorld
             const ESM::Cell *mCell;
             State mState;
             bool mHasState;
+            bool mDirty; ///< Has the state of the cell itself changed since the last call to clearDirty()?
             std::vector<std::string> mIds;
             float mWaterLevel;
 
+            // References from the content files, read in advance of loading the cell
+            ContentRefReader::RefList mContentRefs;
+            bool mHasContentRefs;
+
             MWWorld::TimeStamp mLastRespawn;
 
             // List of refs owned by this cell
@@ -190,6 +196,7 @@ namespace MWWorld
             LiveCellRefBase* insert(const LiveCellRef<T>* ref)
             {
                 mHasState = true;
+                mDirty = true;
                 CellRefList<T>& list = get<T>();
                 LiveCellRefBase* ret = &list.insert(*ref);
                 updateMergedRefs();
@@ -211,6 +218,12 @@ namespace MWWorld
             bool hasState() const;
             ///< Does this cell have state that needs to be stored in a saved game file?
 
+            bool isDirty() const;
+            ///< Has the state of this cell or of any of its references changed since the last call to
+            /// clearDirty()? Used to skip writing unchanged cells again when saving.
+
+            void clearDirty();
+
             bool hasId (const std::string& id) const;
             ///< May return true for deleted IDs when in preload state. Will return false, if cell is
             /// unloaded.
@@ -247,6 +260,13 @@ namespace MWWorld
             void preload ();
             ///< Build ID list from content file.
 
+            ContentRefReader createContentRefReader() const;
+            ///< Create a reader for the references of this cell that can be used from a worker thread.
+
+            void setContentRefs (ContentRefReader::RefList& refs);
+            ///< Use references read in advance, e.g. in a worker thread, for preloading and loading this cell.
+            /// The contents of \a refs are swapped out.
+
             /// Call visitor (MWWorld::Ptr) for each reference. visitor must return a bool. Returning
             /// false will abort the iteration.
             /// \note Prefer using forEachConst when possible.
@@ -377,6 +397,9 @@ namespace MWWorld
 
         private:
 
+            void readContentRefs();
+            ///< Read the references from the content files, unless they were read in advance.
+
             /// Run through references and store IDs
             void listRefs();
 
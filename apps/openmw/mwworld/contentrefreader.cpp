@@ -0,0 +1,86 @@
+#include "contentrefreader.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include <components/esm/loadcell.hpp>
+#include <components/to_utf8/to_utf8.hpp>
+
+namespace MWWorld
+{
+    ContentRefReader::ContentRefReader (const ESM::Cell *cell, std::vector<ESM::ESMReader>& readers, bool threadSafe)
+        : mCell (cell), mDescription (cell->getDescription()), mReaders (&readers)
+    {
+        if (threadSafe)
+        {
+            for (std::vector<ESM::ESM_Context>::const_iterator iter (mCell->mContextList.begin());
+                iter!=mCell->mContextList.end(); ++iter)
+            {
+                if (mOwnReaders.find (iter->index)!=mOwnReaders.end())
+                    continue;
+
+                const ESM::ESMReader& shared = readers[iter->index];
+                if (!mEncoder && shared.getEncoder())
+                    mEncoder.reset (new ToUTF8::Utf8Encoder (*shared.getEncoder()));
+
+                // Keep the header and settings, but not the stream. The copy opens the file again when
+                // the context is restored.
+                ESM::ESMReader& reader = mOwnReaders.insert (std::make_pair (iter->index, shared)).first->second;
+                reader.close();
+                reader.setEncoder (mEncoder.get());
+            }
+
+            mReaders = NULL;
+        }
+
+        mMovedRefs.reserve (mCell->mMovedRefs.size());
+        for (ESM::MovedCellRefTracker::const_iterator iter (mCell->mMovedRefs.begin());
+            iter!=mCell->mMovedRefs.end(); ++iter)
+            mMovedRefs.push_back (iter->mRefNum);
+
+        std::sort (mMovedRefs.begin(), mMovedRefs.end());
+    }
+
+    ESM::ESMReader& ContentRefReader::getReader (int index)
+    {
+        if (mReaders)
+            return (*mReaders)[index];
+
+        return mOwnReaders[index];
+    }
+
+    void ContentRefReader::read (RefList& refs)
+    {
+        // Load references from all plugins that do something with this cell.
+        for (size_t i = 0; i < mCell->mContextList.size(); i++)
+        {
+            try
+            {
+                // Reopen the ESM reader and seek to the right position.
+                ESM::ESMReader& reader = getReader (mCell->mContextList[i].index);
+                mCell->restore (reader, i);
+
+                ESM::CellRef ref;
+                ref.mRefNum.mContentFile = ESM::RefNum::RefNum_NoContentFile;
+
+                // Get each reference in turn
+                bool deleted = false;
+                while (mCell->getNextRef (reader, ref, deleted))
+                {
+                    // Skip references that were moved to a different cell.
+                    if (std::binary_search (mMovedRefs.begin(), mMovedRefs.end(), ref.mRefNum))
+                        continue;
+
+                    refs.push_back (std::make_pair (ref, deleted));
+                }
+            }
+            catch (std::exception& e)
+            {
+                std::cerr << "An error occurred reading references for cell " << mDescription << ": " << e.what() << std::endl;
+            }
+        }
+
+        // Moved references, from separately tracked list.
+        refs.insert (refs.end(), mCell->mLeasedRefs.begin(), mCell->mLeasedRefs.end());
+    }
+}
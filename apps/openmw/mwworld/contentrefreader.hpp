@@ -0,0 +1,55 @@
+#ifndef GAME_MWWORLD_CONTENTREFREADER_H
+#define GAME_MWWORLD_CONTENTREFREADER_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <components/esm/cellref.hpp>
+#include <components/esm/esmreader.hpp>
+
+namespace ESM
+{
+    struct Cell;
+}
+
+namespace ToUTF8
+{
+    class Utf8Encoder;
+}
+
+namespace MWWorld
+{
+    /// \brief Reads the references of a cell from the content files
+    ///
+    /// Includes references moved into the cell by a content file and skips the ones moved out of it.
+    class ContentRefReader
+    {
+        public:
+
+            typedef std::vector<std::pair<ESM::CellRef, bool> > RefList; ///< <reference, deleted>
+
+            /// @param readers The readers for all content files, by content file index
+            /// @param threadSafe Read with copies of the readers that open the content files on their own, so
+            /// read() can be called from another thread. The copies are made here, so the constructor must still
+            /// be called from the main thread.
+            ContentRefReader (const ESM::Cell *cell, std::vector<ESM::ESMReader>& readers, bool threadSafe = false);
+
+            void read (RefList& refs);
+            ///< Append the references of the cell to \a refs, in content file order.
+
+        private:
+
+            ESM::ESMReader& getReader (int index);
+
+            const ESM::Cell *mCell;
+            std::string mDescription;
+            std::vector<ESM::ESMReader> *mReaders;
+            std::map<int, ESM::ESMReader> mOwnReaders;
+            std::shared_ptr<ToUTF8::Utf8Encoder> mEncoder; // for mOwnReaders, as encoders keep a conversion buffer
+            std::vector<ESM::RefNum> mMovedRefs; // sorted
+    };
+}
+
+#endif
@@ -0,0 +1,122 @@
+#include "dialogueinfoindex.hpp"
+
+#include <algorithm>
+
+#include <components/esm/loaddial.hpp>
+#include <components/misc/stringops.hpp>
+
+#include "../mwdialogue/selectwrapper.hpp"
+
+#include "store.hpp"
+
+namespace
+{
+    typedef std::pair<size_t, const ESM::DialInfo *> Entry;
+    typedef std::vector<Entry> EntryList;
+
+    void addBucket (const std::unordered_map<std::string, EntryList>& buckets, const std::string& key,
+        std::vector<Entry>& out)
+    {
+        if (key.empty())
+            return;
+
+        std::unordered_map<std::string, EntryList>::const_iterator found = buckets.find (key);
+        if (found != buckets.end())
+            out.insert (out.end(), found->second.begin(), found->second.end());
+    }
+}
+
+struct MWWorld::DialogueInfoIndex::SelectMap
+{
+    std::unordered_map<const ESM::DialInfo *, std::vector<MWDialogue::SelectWrapper> > mByInfo;
+};
+
+MWWorld::DialogueInfoIndex::DialogueInfoIndex()
+    : mSelects (new SelectMap)
+{
+}
+
+MWWorld::DialogueInfoIndex::~DialogueInfoIndex()
+{
+}
+
+void MWWorld::DialogueInfoIndex::build (const Store<ESM::Dialogue>& dialogues)
+{
+    mDialogues.clear();
+    mSelects->mByInfo.clear();
+
+    for (Store<ESM::Dialogue>::iterator iter = dialogues.begin(); iter != dialogues.end(); ++iter)
+    {
+        DialogueEntry& entry = mDialogues[&*iter];
+
+        size_t index = 0;
+        for (ESM::Dialogue::InfoContainer::const_iterator info = iter->mInfo.begin();
+            info != iter->mInfo.end(); ++info, ++index)
+        {
+            Entry value (index, &*info);
+
+            std::vector<MWDialogue::SelectWrapper>& selects = mSelects->mByInfo[&*info];
+            selects.reserve (info->mSelects.size());
+            for (std::vector<ESM::DialInfo::SelectStruct>::const_iterator select = info->mSelects.begin();
+                select != info->mSelects.end(); ++select)
+                selects.push_back (MWDialogue::SelectWrapper (*select));
+
+            if (!info->mActor.empty())
+                entry.mByActor[Misc::StringUtils::lowerCase (info->mActor)].push_back (value);
+            else if (!info->mRace.empty())
+                entry.mByRace[Misc::StringUtils::lowerCase (info->mRace)].push_back (value);
+            else if (!info->mClass.empty())
+                entry.mByClass[Misc::StringUtils::lowerCase (info->mClass)].push_back (value);
+            else if (!info->mFactionLess && !info->mFaction.empty())
+                entry.mByFaction[Misc::StringUtils::lowerCase (info->mFaction)].push_back (value);
+            else
+                entry.mAny.push_back (value);
+        }
+    }
+}
+
+void MWWorld::DialogueInfoIndex::clear()
+{
+    mDialogues.clear();
+    mSelects->mByInfo.clear();
+}
+
+bool MWWorld::DialogueInfoIndex::getCandidates (const ESM::Dialogue& dialogue, const Speaker& speaker,
+    std::vector<const ESM::DialInfo *>& infos) const
+{
+    std::unordered_map<const ESM::Dialogue *, DialogueEntry>::const_iterator found = mDialogues.find (&dialogue);
+    if (found == mDialogues.end())
+        return false;
+
+    const DialogueEntry& entry = found->second;
+
+    EntryList candidates;
+    addBucket (entry.mByActor, speaker.mId, candidates);
+
+    // Creatures only ever use infos specific to their ID
+    if (!speaker.mIsCreature)
+    {
+        addBucket (entry.mByRace, speaker.mRace, candidates);
+        addBucket (entry.mByClass, speaker.mClass, candidates);
+        addBucket (entry.mByFaction, speaker.mFaction, candidates);
+        candidates.insert (candidates.end(), entry.mAny.begin(), entry.mAny.end());
+
+        std::sort (candidates.begin(), candidates.end());
+    }
+
+    infos.reserve (infos.size() + candidates.size());
+    for (EntryList::const_iterator iter = candidates.begin(); iter != candidates.end(); ++iter)
+        infos.push_back (iter->second);
+
+    return true;
+}
+
+const std::vector<MWDialogue::SelectWrapper> *MWWorld::DialogueInfoIndex::getSelects (const ESM::DialInfo& info) const
+{
+    std::unordered_map<const ESM::DialInfo *, std::vector<MWDialogue::SelectWrapper> >::const_iterator found =
+        mSelects->mByInfo.find (&info);
+    if (found == mSelects->mByInfo.end())
+        return 0;
+
+    return &found->second;
+}
@@ -0,0 +1,87 @@
+#ifndef GAME_MWWORLD_DIALOGUEINFOINDEX_H
+#define GAME_MWWORLD_DIALOGUEINFOINDEX_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace ESM
+{
+    struct DialInfo;
+    struct Dialogue;
+}
+
+namespace MWDialogue
+{
+    class SelectWrapper;
+}
+
+namespace MWWorld
+{
+    template <class T>
+    class Store;
+
+    /// @brief Buckets the infos of each dialogue by the static speaker conditions they have (actor ID,
+    /// race, class and faction), so the dialogue filter only needs to evaluate infos that can possibly
+    /// apply to a given speaker. Also keeps the decoded select structs of each info.
+    class DialogueInfoIndex
+    {
+        public:
+
+            /// Static properties of the speaker. All strings must be lower case.
+            struct Speaker
+            {
+                std::string mId;
+                std::string mRace;
+                std::string mClass;
+                std::string mFaction;
+                bool mIsCreature;
+
+                Speaker() : mIsCreature(false) {}
+            };
+
+            DialogueInfoIndex();
+            ~DialogueInfoIndex();
+
+            void build (const Store<ESM::Dialogue>& dialogues);
+
+            void clear();
+
+            /// Get the infos of \a dialogue that may apply to \a speaker, in their original order.
+            /// @note The returned infos have not been tested; all conditions still need to be checked.
+            /// @return false if the dialogue isn't indexed, in which case all its infos need to be tested.
+            bool getCandidates (const ESM::Dialogue& dialogue, const Speaker& speaker,
+                std::vector<const ESM::DialInfo *>& infos) const;
+
+            /// Get the select structs of \a info, decoded when the index was built.
+            /// @return 0 if the info isn't indexed.
+            const std::vector<MWDialogue::SelectWrapper> *getSelects (const ESM::DialInfo& info) const;
+
+        private:
+
+            // Position of the info in its dialogue, so merged buckets can be put back into order
+            typedef std::pair<size_t, const ESM::DialInfo *> Entry;
+            typedef std::vector<Entry> EntryList;
+            typedef std::unordered_map<std::string, EntryList> Buckets;
+
+            // Each info is only put in the bucket of its most specific condition; testing the rest is
+            // left to the filter.
+            struct DialogueEntry
+            {
+                Buckets mByActor;
+                Buckets mByRace;
+                Buckets mByClass;
+                Buckets mByFaction;
+                EntryList mAny;
+            };
+
+            // Defined in the source file, so users of this header don't depend on MWDialogue
+            struct SelectMap;
+
+            std::unordered_map<const ESM::Dialogue *, DialogueEntry> mDialogues;
+            std::unique_ptr<SelectMap> mSelects;
+    };
+}
+
+#endif
@@ -141,6 +141,8 @@ void ESMStore::setUp()
     mMagicEffects.setUp();
     mAttributes.setUp();
     mDialogs.setUp();
+
+    mDialogueInfoIndex.build(mDialogs);
 }
 
     int ESMStore::countSavedGameRecords() const
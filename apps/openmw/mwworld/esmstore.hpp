@@ -6,6 +6,7 @@
 
 #include <components/esm/records.hpp>
 #include "store.hpp"
+#include "dialogueinfoindex.hpp"
 
 namespace Loading
 {
@@ -65,6 +66,9 @@ namespace MWWorld
         // Special entry which is hardcoded and not loaded from an ESM
         Store<ESM::Attribute>   mAttributes;
 
+        // Infos of each dialogue by speaker condition, rebuilt in setUp()
+        DialogueInfoIndex mDialogueInfoIndex;
+
         // Lookup of all IDs. Makes looking up references faster. Just
         // maps the id name to the record type.
         std::map<std::string, int> mIds;
@@ -160,6 +164,11 @@ namespace MWWorld
 
         void load(ESM::ESMReader &esm, Loading::Listener* listener);
 
+        const DialogueInfoIndex& getDialogueInfoIndex() const
+        {
+            return mDialogueInfoIndex;
+        }
+
         template <class T>
         const Store<T> &get() const {
             throw std::runtime_error("Storage for this type not exist");
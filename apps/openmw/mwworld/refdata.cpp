@@ -24,11 +24,13 @@ namespace MWWorld
     void RefData::copy (const RefData& refData)
     {
         mBaseNode = refData.mBaseNode;
+        mRenderHandle = refData.mRenderHandle;
         mLocals = refData.mLocals;
         mEnabled = refData.mEnabled;
         mCount = refData.mCount;
         mPosition = refData.mPosition;
         mChanged = refData.mChanged;
+        mDirty = true;
         mDeletedByContentFile = refData.mDeletedByContentFile;
         mFlags = refData.mFlags;
 
@@ -40,13 +42,14 @@ namespace MWWorld
     void RefData::cleanup()
     {
         mBaseNode = 0;
+        mRenderHandle = Misc::SlotHandle();
 
         delete mCustomData;
         mCustomData = 0;
     }
 
     RefData::RefData()
-    : mBaseNode(0), mDeletedByContentFile(false), mEnabled (true), mCount (1), mCustomData (0), mChanged(false), mFlags(0)
+    : mBaseNode(0), mDeletedByContentFile(false), mEnabled (true), mCount (1), mCustomData (0), mChanged(false), mDirty(true), mFlags(0)
     {
         for (int i=0; i<3; ++i)
         {
@@ -59,7 +62,7 @@ namespace MWWorld
     : mBaseNode(0), mDeletedByContentFile(false), mEnabled (true),
       mCount (1), mPosition (cellRef.mPos),
       mCustomData (0),
-      mChanged(false), mFlags(0) // Loading from ESM/ESP files -> assume unchanged
+      mChanged(false), mDirty(true), mFlags(0) // Loading from ESM/ESP files -> assume unchanged
     {
     }
 
@@ -70,7 +73,7 @@ namespace MWWorld
       mPosition (objectState.mPosition),
       mAnimationState(objectState.mAnimationState),
       mCustomData (0),
-      mChanged(true), mFlags(objectState.mFlags) // Loading from a savegame -> assume changed
+      mChanged(true), mDirty(true), mFlags(objectState.mFlags) // Loading from a savegame -> assume changed
     {
         // "Note that the ActivationFlag_UseEnabled is saved to the reference,
         // which will result in permanently suppressed activation if the reference script is removed.
@@ -136,6 +139,16 @@ namespace MWWorld
         mBaseNode = base;
     }
 
+    Misc::SlotHandle RefData::getRenderHandle() const
+    {
+        return mRenderHandle;
+    }
+
+    void RefData::setRenderHandle(Misc::SlotHandle handle)
+    {
+        mRenderHandle = handle;
+    }
+
     SceneUtil::PositionAttitudeTransform* RefData::getBaseNode()
     {
         return mBaseNode;
@@ -154,7 +167,10 @@ namespace MWWorld
     void RefData::setLocals (const ESM::Script& script)
     {
         if (mLocals.configure (script) && !mLocals.isEmpty())
+        {
             mChanged = true;
+            mDirty = true;
+        }
     }
 
     void RefData::setCount (int count)
@@ -163,12 +179,14 @@ namespace MWWorld
             MWBase::Environment::get().getWorld()->removeRefScript(this);
 
         mChanged = true;
+        mDirty = true;
 
         mCount = count;
     }
 
     void RefData::setDeletedByContentFile(bool deleted)
     {
+        mDirty = true;
         mDeletedByContentFile = deleted;
     }
 
@@ -184,6 +202,7 @@ namespace MWWorld
 
     MWScript::Locals& RefData::getLocals()
     {
+        mDirty = true;
         return mLocals;
     }
 
@@ -197,6 +216,7 @@ namespace MWWorld
         if (!mEnabled)
         {
             mChanged = true;
+            mDirty = true;
             mEnabled = true;
         }
     }
@@ -206,6 +226,7 @@ namespace MWWorld
         if (mEnabled)
         {
             mChanged = true;
+            mDirty = true;
             mEnabled = false;
         }
     }
@@ -213,6 +234,7 @@ namespace MWWorld
     void RefData::setPosition(const ESM::Position& pos)
     {
         mChanged = true;
+        mDirty = true;
         mPosition = pos;
     }
 
@@ -224,12 +246,14 @@ namespace MWWorld
     void RefData::setCustomData (CustomData *data)
     {
         mChanged = true; // We do not currently track CustomData, so assume anything with a CustomData is changed
+        mDirty = true;
         delete mCustomData;
         mCustomData = data;
     }
 
     CustomData *RefData::getCustomData()
     {
+        mDirty = true;
         return mCustomData;
     }
 
@@ -243,9 +267,20 @@ namespace MWWorld
         return mChanged || !mAnimationState.empty();
     }
 
+    bool RefData::isDirty() const
+    {
+        return mDirty;
+    }
+
+    void RefData::clearDirty()
+    {
+        mDirty = false;
+    }
+
     bool RefData::activateByScript()
     {
         bool ret = (mFlags & Flag_ActivationBuffered);
+        mDirty = true;
         mFlags &= ~(Flag_SuppressActivate|Flag_OnActivate);
         return ret;
     }
@@ -255,6 +290,7 @@ namespace MWWorld
         if (mFlags & Flag_SuppressActivate)
         {
             mFlags |= Flag_OnActivate|Flag_ActivationBuffered;
+            mDirty = true;
             return false;
         }
         else
@@ -266,6 +302,7 @@ namespace MWWorld
     bool RefData::onActivate()
     {
         bool ret = mFlags & Flag_OnActivate;
+        mDirty = true;
         mFlags |= Flag_SuppressActivate;
         mFlags &= (~Flag_OnActivate);
         return ret;
@@ -278,6 +315,7 @@ namespace MWWorld
 
     ESM::AnimationState& RefData::getAnimationState()
     {
+        mDirty = true;
         return mAnimationState;
     }
 
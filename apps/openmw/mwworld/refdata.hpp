@@ -3,6 +3,7 @@
 
 #include <components/esm/defs.hpp>
 #include <components/esm/animationstate.hpp>
+#include <components/misc/slotmap.hpp>
 
 #include "../mwscript/locals.hpp"
 
@@ -30,6 +31,8 @@ namespace MWWorld
     {
             SceneUtil::PositionAttitudeTransform* mBaseNode;
 
+            Misc::SlotHandle mRenderHandle;
+
             MWScript::Locals mLocals;
 
             /// separate delete flag used for deletion by a content file
@@ -53,6 +56,10 @@ namespace MWWorld
 
             bool mChanged;
 
+            /// Has this RefData changed since the last call to clearDirty()?
+            /// @note Anything that gives write access to the state counts as a change.
+            bool mDirty;
+
             unsigned int mFlags;
 
         public:
@@ -87,6 +94,12 @@ namespace MWWorld
             /// Set base node (can be a null pointer).
             void setBaseNode (SceneUtil::PositionAttitudeTransform* base);
 
+            /// Return the handle the renderer finds the object's animation by (invalid while not rendered).
+            /// @note Copies of the RefData share the handle, so the renderer must check that it has the right object.
+            Misc::SlotHandle getRenderHandle() const;
+
+            void setRenderHandle (Misc::SlotHandle handle);
+
             int getCount() const;
 
             void setLocals (const ESM::Script& script);
@@ -136,6 +149,11 @@ namespace MWWorld
             bool hasChanged() const;
             ///< Has this RefData changed since it was originally loaded?
 
+            bool isDirty() const;
+            ///< Has this RefData changed since the last call to clearDirty()?
+
+            void clearDirty();
+
             const ESM::AnimationState& getAnimationState() const;
             ESM::AnimationState& getAnimationState();
     };
@@ -19,6 +19,7 @@
 #include "../mwrender/landmanager.hpp"
 
 #include "../mwphysics/physicssystem.hpp"
+#include "../mwphysics/heightfield.hpp"
 
 #include "player.hpp"
 #include "localscripts.hpp"
@@ -241,13 +242,7 @@ namespace MWWorld
 
         if ((*iter)->getCell()->isExterior())
         {
-            const ESM::Land* land =
-                MWBase::Environment::get().getWorld()->getStore().get<ESM::Land>().search(
-                    (*iter)->getCell()->getGridX(),
-                    (*iter)->getCell()->getGridY()
-                );
-            if (land && land->mDataTypes&ESM::Land::DATA_VHGT)
-                mPhysics->removeHeightField ((*iter)->getCell()->getGridX(), (*iter)->getCell()->getGridY());
+            mPhysics->removeHeightField ((*iter)->getCell()->getGridX(), (*iter)->getCell()->getGridY());
         }
 
         MWBase::Environment::get().getMechanicsManager()->drop (*iter);
@@ -269,26 +264,21 @@ namespace MWWorld
         {
             std::cout << "Loading cell " << cell->getCell()->getDescription() << std::endl;
 
-            float verts = ESM::Land::LAND_SIZE;
-            float worldsize = ESM::Land::REAL_SIZE;
-
             // Load terrain physics first...
             if (cell->getCell()->isExterior())
             {
                 int cellX = cell->getCell()->getGridX();
                 int cellY = cell->getCell()->getGridY();
-                osg::ref_ptr<const ESMTerrain::LandObject> land = mRendering.getLandManager()->getLand(cellX, cellY);
-                const ESM::Land::LandData* data = land ? land->getData(ESM::Land::DATA_VHGT) : 0;
-                if (data)
-                {
-                    mPhysics->addHeightField (data->mHeights, cellX, cell->getCell()->getGridY(), worldsize / (verts-1), verts, data->mMinHeight, data->mMaxHeight, land.get());
-                }
-                else
-                {
-                    static std::vector<float> defaultHeight;
-                    defaultHeight.resize(verts*verts, ESM::Land::DEFAULT_HEIGHT);
-                    mPhysics->addHeightField (&defaultHeight[0], cell->getCell()->getGridX(), cell->getCell()->getGridY(), worldsize / (verts-1), verts, ESM::Land::DEFAULT_HEIGHT, ESM::Land::DEFAULT_HEIGHT, land.get());
-                }
+
+                // use the height field built by the preloader if there is one, so we don't have to stall here
+                osg::ref_ptr<MWPhysics::HeightField> heightField = mPreloader->getHeightField(cell);
+                if (!heightField)
+                    heightField = MWPhysics::HeightField::create(mRendering.getLandManager()->getLand(cellX, cellY), cellX, cellY);
+
+                // cells on the edge of the grid only get collision once an actor comes near them
+                bool deferCollision = mHalfGridSize > 0
+                        && (std::abs(cellX - mGridCenterX) >= mHalfGridSize || std::abs(cellY - mGridCenterY) >= mHalfGridSize);
+                mPhysics->addHeightField(heightField, deferCollision);
             }
 
             // register local scripts
@@ -360,6 +350,9 @@ namespace MWWorld
         std::string loadingExteriorText = "#{sLoadingMessage3}";
         loadingListener->setLabel(loadingExteriorText);
 
+        mGridCenterX = X;
+        mGridCenterY = Y;
+
         CellStoreCollection::iterator active = mActiveCells.begin();
         while (active!=mActiveCells.end())
         {
@@ -478,6 +471,8 @@ namespace MWWorld
     : mCurrentCell (0), mCellChanged (false), mPhysics(physics), mRendering(rendering)
     , mPreloadTimer(0.f)
     , mHalfGridSize(Settings::Manager::getInt("exterior cell load distance", "Cells"))
+    , mGridCenterX(0)
+    , mGridCenterY(0)
     , mCellLoadingThreshold(1024.f)
     , mPreloadDistance(Settings::Manager::getInt("preload distance", "Cells"))
     , mPreloadEnabled(Settings::Manager::getBool("preload enabled", "Cells"))
@@ -747,13 +742,13 @@ namespace MWWorld
                 try
                 {
                     if (!door.getCellRef().getDestCell().empty())
-                        preloadCell(MWBase::Environment::get().getWorld()->getInterior(door.getCellRef().getDestCell()));
+                        preloadCell(MWBase::Environment::get().getWorld()->getInterior(door.getCellRef().getDestCell(), false));
                     else
                     {
                         osg::Vec3f pos = door.getCellRef().getDoorDest().asVec3();
                         int x,y;
                         MWBase::Environment::get().getWorld()->positionToIndex (pos.x(), pos.y(), x, y);
-                        preloadCell(MWBase::Environment::get().getWorld()->getExterior(x,y), true);
+                        preloadCell(MWBase::Environment::get().getWorld()->getExterior(x,y, false), true);
                         exteriorPositions.push_back(pos);
                     }
                 }
@@ -794,7 +789,7 @@ namespace MWWorld
                 float loadDist = 8192/2 + 8192 - mCellLoadingThreshold + mPreloadDistance;
 
                 if (dist < loadDist)
-                    preloadCell(MWBase::Environment::get().getWorld()->getExterior(cellX+dx, cellY+dy));
+                    preloadCell(MWBase::Environment::get().getWorld()->getExterior(cellX+dx, cellY+dy, false));
             }
         }
     }
@@ -810,7 +805,7 @@ namespace MWWorld
             {
                 for (int dy = -mHalfGridSize; dy <= mHalfGridSize; ++dy)
                 {
-                    mPreloader->preload(MWBase::Environment::get().getWorld()->getExterior(x+dx, y+dy), mRendering.getReferenceTime());
+                    mPreloader->preload(MWBase::Environment::get().getWorld()->getExterior(x+dx, y+dy, false), mRendering.getReferenceTime());
                     if (++numpreloaded >= mPreloader->getMaxCacheSize())
                         break;
                 }
@@ -872,13 +867,13 @@ namespace MWWorld
         for (std::vector<ESM::Transport::Dest>::const_iterator it = listVisitor.mList.begin(); it != listVisitor.mList.end(); ++it)
         {
             if (!it->mCellName.empty())
-                preloadCell(MWBase::Environment::get().getWorld()->getInterior(it->mCellName));
+                preloadCell(MWBase::Environment::get().getWorld()->getInterior(it->mCellName, false));
             else
             {
                 osg::Vec3f pos = it->mPos.asVec3();
                 int x,y;
                 MWBase::Environment::get().getWorld()->positionToIndex( pos.x(), pos.y(), x, y);
-                preloadCell(MWBase::Environment::get().getWorld()->getExterior(x,y), true);
+                preloadCell(MWBase::Environment::get().getWorld()->getExterior(x,y, false), true);
                 exteriorPositions.push_back(pos);
             }
         }
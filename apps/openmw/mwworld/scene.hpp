@@ -60,6 +60,8 @@ namespace MWWorld
             std::unique_ptr<CellPreloader> mPreloader;
             float mPreloadTimer;
             int mHalfGridSize;
+            int mGridCenterX;
+            int mGridCenterY;
             float mCellLoadingThreshold;
             float mPreloadDistance;
             bool mPreloadEnabled;
@@ -0,0 +1,263 @@
+#ifndef GAME_MWWORLD_SEGMENTEDLIST_H
+#define GAME_MWWORLD_SEGMENTEDLIST_H
+
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace MWWorld
+{
+    /// \brief Sequence container with stable element addresses, allocating its elements from chunks
+    ///
+    /// Elements are linked in insertion order like in a std::list, but live in chunks of doubling size
+    /// (1, 2, 4, ... elements) instead of in separate heap allocations, so elements that were added one
+    /// after another are adjacent in memory. Small lists stay small, and a copy is made in a single chunk.
+    /// Erased elements go to a free list and their memory is reused for later insertions. Iterators and
+    /// references stay valid until the element is erased.
+    template <typename T>
+    class SegmentedList
+    {
+            struct Node
+            {
+                typename std::aligned_storage<sizeof (T), std::alignment_of<T>::value>::type mStorage;
+                Node *mPrev;
+                Node *mNext; // next free node, while on the free list
+
+                T& get() { return *reinterpret_cast<T *> (&mStorage); }
+            };
+
+        public:
+
+            template <typename Value>
+            class Iterator
+            {
+                    friend class SegmentedList;
+
+                    const SegmentedList *mList;
+                    Node *mNode; // NULL for end()
+
+                    Iterator (const SegmentedList *list, Node *node) : mList (list), mNode (node) {}
+
+                public:
+
+                    typedef std::bidirectional_iterator_tag iterator_category;
+                    typedef Value value_type;
+                    typedef std::ptrdiff_t difference_type;
+                    typedef Value *pointer;
+                    typedef Value& reference;
+
+                    Iterator() : mList (NULL), mNode (NULL) {}
+
+                    /// Allow conversion from iterator to const_iterator.
+                    template <typename OtherValue>
+                    Iterator (const Iterator<OtherValue>& other,
+                        typename std::enable_if<std::is_same<const OtherValue, Value>::value>::type * = 0)
+                        : mList (other.mList), mNode (other.mNode) {}
+
+                    Value& operator*() const { return mNode->get(); }
+
+                    Value *operator->() const { return &mNode->get(); }
+
+                    Iterator& operator++()
+                    {
+                        mNode = mNode->mNext;
+                        return *this;
+                    }
+
+                    Iterator operator++ (int)
+                    {
+                        Iterator iter (*this);
+                        ++*this;
+                        return iter;
+                    }
+
+                    Iterator& operator--()
+                    {
+                        mNode = mNode ? mNode->mPrev : mList->mTail;
+                        return *this;
+                    }
+
+                    Iterator operator-- (int)
+                    {
+                        Iterator iter (*this);
+                        --*this;
+                        return iter;
+                    }
+
+                    bool operator== (const Iterator& other) const
+                    {
+                        return mNode==other.mNode && mList==other.mList;
+                    }
+
+                    bool operator!= (const Iterator& other) const
+                    {
+                        return !(*this==other);
+                    }
+
+                    template <typename OtherValue>
+                    friend class Iterator;
+            };
+
+            typedef T value_type;
+            typedef Iterator<T> iterator;
+            typedef Iterator<const T> const_iterator;
+
+            SegmentedList() : mChunkSize (0), mUsed (0), mFree (NULL), mHead (NULL), mTail (NULL), mSize (0) {}
+
+            SegmentedList (const SegmentedList& other)
+                : mChunkSize (0), mUsed (0), mFree (NULL), mHead (NULL), mTail (NULL), mSize (0)
+            {
+                *this = other;
+            }
+
+            ~SegmentedList()
+            {
+                clear();
+            }
+
+            SegmentedList& operator= (const SegmentedList& other)
+            {
+                if (this!=&other)
+                {
+                    clear();
+
+                    if (other.mSize)
+                        addChunk (other.mSize);
+
+                    for (Node *node = other.mHead; node; node = node->mNext)
+                        push_back (node->get());
+                }
+
+                return *this;
+            }
+
+            iterator begin() { return iterator (this, mHead); }
+            iterator end() { return iterator (this, NULL); }
+            const_iterator begin() const { return const_iterator (this, mHead); }
+            const_iterator end() const { return const_iterator (this, NULL); }
+
+            bool empty() const { return mSize==0; }
+            std::size_t size() const { return mSize; }
+
+            T& front() { return mHead->get(); }
+            const T& front() const { return mHead->get(); }
+            T& back() { return mTail->get(); }
+            const T& back() const { return mTail->get(); }
+
+            void push_back (const T& value)
+            {
+                Node *node = allocate();
+
+                try
+                {
+                    new (&node->mStorage) T (value);
+                }
+                catch (...)
+                {
+                    release (node);
+                    throw;
+                }
+
+                node->mPrev = mTail;
+                node->mNext = NULL;
+
+                if (mTail)
+                    mTail->mNext = node;
+                else
+                    mHead = node;
+
+                mTail = node;
+                ++mSize;
+            }
+
+            /// Get an iterator to \a element, which must be an element of this list.
+            iterator iteratorTo (T& element)
+            {
+                // mStorage is the first member of Node
+                return iterator (this, reinterpret_cast<Node *> (&element));
+            }
+
+            /// @return iterator to the element following the erased one
+            iterator erase (iterator iter)
+            {
+                Node *node = iter.mNode;
+                Node *next = node->mNext;
+
+                if (node->mPrev)
+                    node->mPrev->mNext = next;
+                else
+                    mHead = next;
+
+                if (next)
+                    next->mPrev = node->mPrev;
+                else
+                    mTail = node->mPrev;
+
+                node->get().~T();
+                release (node);
+                --mSize;
+
+                return iterator (this, next);
+            }
+
+            /// Destroy all elements and free the chunks.
+            void clear()
+            {
+                for (Node *node = mHead; node; node = node->mNext)
+                    node->get().~T();
+
+                for (typename std::vector<Node *>::iterator iter (mChunks.begin()); iter!=mChunks.end(); ++iter)
+                    delete[] *iter;
+
+                mChunks.clear();
+                mChunkSize = 0;
+                mUsed = 0;
+                mFree = NULL;
+                mHead = mTail = NULL;
+                mSize = 0;
+            }
+
+        private:
+
+            Node *allocate()
+            {
+                if (mFree)
+                {
+                    Node *node = mFree;
+                    mFree = node->mNext;
+                    return node;
+                }
+
+                if (mUsed==mChunkSize)
+                    addChunk (mChunkSize ? mChunkSize * 2 : 1);
+
+                return &mChunks.back()[mUsed++];
+            }
+
+            void addChunk (std::size_t size)
+            {
+                mChunks.reserve (mChunks.size()+1);
+                mChunks.push_back (new Node[size]);
+                mChunkSize = size;
+                mUsed = 0;
+            }
+
+            void release (Node *node)
+            {
+                node->mNext = mFree;
+                mFree = node;
+            }
+
+            std::vector<Node *> mChunks;
+            std::size_t mChunkSize; // nodes in the last chunk
+            std::size_t mUsed; // nodes handed out from the last chunk
+            Node *mFree;
+            Node *mHead;
+            Node *mTail;
+            std::size_t mSize;
+    };
+}
+
+#endif
@@ -147,7 +147,7 @@ namespace MWWorld
         const std::vector<std::string>& contentFiles,
         ToUTF8::Utf8Encoder* encoder, const std::map<std::string,std::string>& fallbackMap,
         int activationDistanceOverride, const std::string& startCell, const std::string& startupScript,
-            const std::string& resourcePath, const std::string& userDataPath)
+            const std::string& resourcePath, const std::string& userDataPath, const std::string& cachePath)
     : mResourceSystem(resourceSystem), mFallback(fallbackMap), mLocalScripts (mStore),
       mSky (true), mCells (mStore, mEsm),
       mGodMode(false), mScriptsEnabled(true), mContentFiles (contentFiles), mUserDataPath(userDataPath),
@@ -187,6 +187,8 @@ namespace MWWorld
         mStore.setUp();
         mStore.movePlayerRecord();
 
+        mRendering->setupTerrainCache(cachePath, contentFiles);
+
         mSwimHeightScale = mStore.get<ESM::GameSetting>().find("fSwimHeightScale")->getFloat();
 
         mWeatherManager.reset(new MWWorld::WeatherManager(*mRendering, mFallback, mStore));
@@ -335,7 +337,7 @@ namespace MWWorld
         return mCells.countSavedGameRecords();
     }
 
-    void World::write (ESM::ESMWriter& writer, Loading::Listener& progress) const
+    void World::write (ESM::ESMWriter& writer, Loading::Listener& progress)
     {
         // Active cells could have a dirty fog of war, sync it to the CellStore first
         for (Scene::CellStoreCollection::const_iterator iter (mWorldScene->getActiveCells().begin());
@@ -521,14 +523,14 @@ namespace MWWorld
         return &mFallback;
     }
 
-    CellStore *World::getExterior (int x, int y)
+    CellStore *World::getExterior (int x, int y, bool load)
     {
-        return mCells.getExterior (x, y);
+        return mCells.getExterior (x, y, load);
     }
 
-    CellStore *World::getInterior (const std::string& name)
+    CellStore *World::getInterior (const std::string& name, bool load)
     {
-        return mCells.getInterior (name);
+        return mCells.getInterior (name, load);
     }
 
     CellStore *World::getCell (const ESM::CellId& id)
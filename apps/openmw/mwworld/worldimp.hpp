@@ -186,7 +186,8 @@ namespace MWWorld
                 const Files::Collections& fileCollections,
                 const std::vector<std::string>& contentFiles,
                 ToUTF8::Utf8Encoder* encoder, const std::map<std::string,std::string>& fallbackMap,
-                int activationDistanceOverride, const std::string& startCell, const std::string& startupScript, const std::string& resourcePath, const std::string& userDataPath);
+                int activationDistanceOverride, const std::string& startCell, const std::string& startupScript, const std::string& resourcePath, const std::string& userDataPath,
+                const std::string& cachePath);
 
             virtual ~World();
 
@@ -198,14 +199,14 @@ namespace MWWorld
             int countSavedGameRecords() const override;
             int countSavedGameCells() const override;
 
-            void write (ESM::ESMWriter& writer, Loading::Listener& progress) const override;
+            void write (ESM::ESMWriter& writer, Loading::Listener& progress) override;
 
             void readRecord (ESM::ESMReader& reader, uint32_t type,
                 const std::map<int, int>& contentFileMap) override;
 
-            CellStore *getExterior (int x, int y) override;
+            CellStore *getExterior (int x, int y, bool load = true) override;
 
-            CellStore *getInterior (const std::string& name) override;
+            CellStore *getInterior (const std::string& name, bool load = true) override;
 
             CellStore *getCell (const ESM::CellId& id) override;
 
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "components/esm/savecompression.hpp"
+
+namespace
+{
+    struct SaveCompressionTest : public ::testing::Test
+    {
+        std::string mData;
+        std::string mFilename;
+
+        virtual void SetUp()
+        {
+            // Enough data for a few chunks, with the last one partially filled
+            for (unsigned int i = 0; mData.size() < 3 * ESM::SaveCompression::sChunkSize + 1234; ++i)
+            {
+                std::ostringstream stream;
+                stream << "record " << i * 7919 % 100003 << ";";
+                mData += stream.str();
+            }
+
+            mFilename = "test_savecompression.omwsave";
+
+            std::ofstream file (mFilename.c_str(), std::ios::binary);
+            ESM::SaveCompression::write (file, mData.data(), mData.size(), 6);
+        }
+
+        virtual void TearDown()
+        {
+            std::remove (mFilename.c_str());
+        }
+    };
+
+    TEST_F(SaveCompressionTest, compressed_file_should_be_detected)
+    {
+        Files::IStreamPtr stream = Files::openConstrainedFileStream (mFilename.c_str());
+        EXPECT_TRUE (ESM::SaveCompression::isCompressed (*stream));
+        EXPECT_EQ (0, stream->tellg());
+
+        std::istringstream plain ("TES3");
+        EXPECT_FALSE (ESM::SaveCompression::isCompressed (plain));
+    }
+
+    TEST_F(SaveCompressionTest, decompressed_stream_should_match_original)
+    {
+        Files::IStreamPtr stream = ESM::SaveCompression::openFile (mFilename);
+
+        stream->seekg (0, std::ios_base::end);
+        EXPECT_EQ (static_cast<std::streamoff> (mData.size()), static_cast<std::streamoff> (stream->tellg()));
+        stream->seekg (0, std::ios_base::beg);
+
+        std::string data (mData.size(), '\0');
+        stream->read (&data[0], data.size());
+        EXPECT_TRUE (data == mData);
+
+        char extra;
+        stream->read (&extra, 1);
+        EXPECT_TRUE (stream->eof());
+    }
+
+    TEST_F(SaveCompressionTest, decompressed_stream_should_seek_across_chunks)
+    {
+        Files::IStreamPtr stream = ESM::SaveCompression::openFile (mFilename);
+
+        const size_t offsets[] = { ESM::SaveCompression::sChunkSize * 2 + 5, 10, ESM::SaveCompression::sChunkSize - 3 };
+        for (size_t i = 0; i < sizeof (offsets) / sizeof (offsets[0]); ++i)
+        {
+            stream->seekg (offsets[i]);
+            EXPECT_EQ (static_cast<std::streamoff> (offsets[i]), static_cast<std::streamoff> (stream->tellg()));
+
+            char data[16];
+            stream->read (data, sizeof (data));
+            EXPECT_EQ (mData.substr (offsets[i], sizeof (data)), std::string (data, sizeof (data)));
+        }
+    }
+
+    TEST_F(SaveCompressionTest, compressing_from_stream_should_match_compressing_from_memory)
+    {
+        std::ostringstream fromMemory;
+        ESM::SaveCompression::write (fromMemory, mData.data(), mData.size(), 6);
+
+        std::istringstream source (mData);
+        std::ostringstream fromStream;
+        ESM::SaveCompression::write (fromStream, source, mData.size(), 6);
+
+        EXPECT_TRUE (fromMemory.str() == fromStream.str());
+    }
+}
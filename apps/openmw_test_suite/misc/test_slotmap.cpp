@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <set>
+#include <string>
+
+#include "components/misc/slotmap.hpp"
+
+namespace
+{
+    typedef Misc::SlotMap<std::string> Map;
+}
+
+TEST(SlotMapTest, finds_elements_by_handle)
+{
+    Map map;
+    Misc::SlotHandle a = map.insert("a");
+    Misc::SlotHandle b = map.insert("b");
+
+    ASSERT_TRUE(map.find(a) != NULL);
+    ASSERT_TRUE(map.find(b) != NULL);
+    EXPECT_EQ(*map.find(a), "a");
+    EXPECT_EQ(*map.find(b), "b");
+    EXPECT_EQ(map.size(), 2u);
+}
+
+TEST(SlotMapTest, invalid_handle_finds_nothing)
+{
+    Map map;
+    map.insert("a");
+
+    EXPECT_FALSE(Misc::SlotHandle().isValid());
+    EXPECT_TRUE(map.find(Misc::SlotHandle()) == NULL);
+}
+
+TEST(SlotMapTest, erase_keeps_other_handles_valid)
+{
+    Map map;
+    Misc::SlotHandle a = map.insert("a");
+    Misc::SlotHandle b = map.insert("b");
+    Misc::SlotHandle c = map.insert("c");
+
+    EXPECT_TRUE(map.erase(a));
+    EXPECT_FALSE(map.erase(a));
+
+    EXPECT_TRUE(map.find(a) == NULL);
+    EXPECT_EQ(*map.find(b), "b");
+    EXPECT_EQ(*map.find(c), "c");
+
+    std::set<std::string> values;
+    for (std::size_t i = 0; i < map.size(); ++i)
+    {
+        values.insert(map[i]);
+        EXPECT_EQ(map.getHandle(i), map[i] == "b" ? b : c);
+    }
+    EXPECT_EQ(values, std::set<std::string>({"b", "c"}));
+}
+
+TEST(SlotMapTest, reused_slot_does_not_match_old_handle)
+{
+    Map map;
+    Misc::SlotHandle a = map.insert("a");
+    map.erase(a);
+    Misc::SlotHandle b = map.insert("b");
+
+    EXPECT_EQ(a.mIndex, b.mIndex);
+    EXPECT_NE(a, b);
+    EXPECT_TRUE(map.find(a) == NULL);
+    EXPECT_EQ(*map.find(b), "b");
+}
+
+TEST(SlotMapTest, clear_invalidates_handles)
+{
+    Map map;
+    Misc::SlotHandle a = map.insert("a");
+    Misc::SlotHandle b = map.insert("b");
+    map.clear();
+
+    EXPECT_TRUE(map.empty());
+    EXPECT_TRUE(map.find(a) == NULL);
+    EXPECT_TRUE(map.find(b) == NULL);
+
+    Misc::SlotHandle c = map.insert("c");
+    EXPECT_EQ(*map.find(c), "c");
+    EXPECT_EQ(map.size(), 1u);
+}
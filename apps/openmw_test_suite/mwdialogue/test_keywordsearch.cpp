@@ -1,4 +1,10 @@
 #include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <iostream>
+
 #include "apps/openmw/mwdialogue/keywordsearch.hpp"
 
 struct KeywordSearchTest : public ::testing::Test
@@ -65,3 +71,176 @@ TEST_F(KeywordSearchTest, keyword_test_conflict_resolution3)
     ASSERT_TRUE (matches.size() == 1);
     ASSERT_TRUE (std::string(matches.front().mBeg, matches.front().mEnd) == "bar lock");
 }
+
+TEST_F(KeywordSearchTest, keyword_test_case_insensitive_word_start)
+{
+    MWDialogue::KeywordSearch<std::string, int> search;
+    search.seed("vivec", 1);
+    search.seed("ash", 2);
+
+    std::string text = "Lord Vivec forbids trash and ashlanders.";
+
+    std::vector<MWDialogue::KeywordSearch<std::string, int>::Match> matches;
+    search.highlightKeywords(text.begin(), text.end(), matches);
+
+    // "ash" within "trash" doesn't start a word, but the one starting "ashlanders" does
+    ASSERT_TRUE (matches.size() == 2);
+    ASSERT_TRUE (std::string(matches.front().mBeg, matches.front().mEnd) == "Vivec");
+    ASSERT_TRUE (matches.front().mValue == 1);
+    ASSERT_TRUE (std::string(matches.rbegin()->mBeg, matches.rbegin()->mEnd) == "ash");
+    ASSERT_TRUE (matches.rbegin()->mBeg - text.begin() == 29);
+}
+
+TEST_F(KeywordSearchTest, keyword_test_longest_at_same_start)
+{
+    MWDialogue::KeywordSearch<std::string, int> search;
+    search.seed("morrowind", 0);
+    search.seed("morrowind lore", 1);
+    search.seed("lore", 2);
+
+    std::string text = "some morrowind lore";
+
+    std::vector<MWDialogue::KeywordSearch<std::string, int>::Match> matches;
+    search.highlightKeywords(text.begin(), text.end(), matches);
+
+    ASSERT_TRUE (matches.size() == 1);
+    ASSERT_TRUE (matches.front().mValue == 1);
+    ASSERT_TRUE (std::string(matches.front().mBeg, matches.front().mEnd) == "morrowind lore");
+}
+
+TEST_F(KeywordSearchTest, keyword_test_seed_after_search)
+{
+    MWDialogue::KeywordSearch<std::string, int> search;
+    search.seed("balmora", 0);
+
+    std::string text = "from balmora to ald'ruhn";
+
+    std::vector<MWDialogue::KeywordSearch<std::string, int>::Match> matches;
+    search.highlightKeywords(text.begin(), text.end(), matches);
+    ASSERT_TRUE (matches.size() == 1);
+
+    search.seed("ald'ruhn", 1);
+    matches.clear();
+    search.highlightKeywords(text.begin(), text.end(), matches);
+    ASSERT_TRUE (matches.size() == 2);
+    ASSERT_TRUE (matches.rbegin()->mValue == 1);
+
+    int value = -1;
+    ASSERT_TRUE (search.containsKeyword("Ald'ruhn", value));
+    ASSERT_TRUE (value == 1);
+    ASSERT_FALSE (search.containsKeyword("ald", value));
+
+    search.clear();
+    matches.clear();
+    search.highlightKeywords(text.begin(), text.end(), matches);
+    ASSERT_TRUE (matches.empty());
+}
+
+TEST_F(KeywordSearchTest, keyword_test_matches_brute_force_scan)
+{
+    // keywords of a single word each, so every word start has at most the longest keyword that prefixes it
+    MWDialogue::KeywordSearch<std::string, int> search;
+    std::vector<std::string> words;
+    unsigned int seed = 1;
+    for (int i = 0; i < 300; ++i)
+    {
+        std::string word;
+        int length = 2 + i % 6;
+        for (int c = 0; c < length; ++c)
+        {
+            seed = seed * 1103515245 + 12345;
+            word += static_cast<char>('a' + (seed >> 16) % 4);
+        }
+        if (std::find(words.begin(), words.end(), word) != words.end())
+            continue;
+        words.push_back(word);
+        search.seed(word, static_cast<int>(words.size()) - 1);
+    }
+
+    std::string text;
+    for (int i = 0; text.size() < 20000; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        std::string word = words[(seed >> 16) % words.size()];
+        if (i % 4 == 0)
+            word[0] = static_cast<char>(std::toupper(word[0]));
+        text += word;
+        text += (i % 3) ? " " : "ing. ";
+    }
+
+    std::vector<MWDialogue::KeywordSearch<std::string, int>::Match> matches;
+    search.highlightKeywords(text.begin(), text.end(), matches);
+
+    std::vector<std::pair<size_t, int> > expected;
+    for (size_t start = 0; start < text.size(); ++start)
+    {
+        if (start != 0 && std::isalpha(text[start-1]))
+            continue;
+
+        int longest = -1;
+        for (size_t w = 0; w < words.size(); ++w)
+        {
+            if (text.size() - start < words[w].size()
+                    || (longest != -1 && words[w].size() <= words[longest].size()))
+                continue;
+            if (Misc::StringUtils::ciEqual(text.substr(start, words[w].size()), words[w]))
+                longest = static_cast<int>(w);
+        }
+        if (longest != -1)
+            expected.push_back(std::make_pair(start, longest));
+    }
+
+    std::vector<std::pair<size_t, int> > found;
+    for (size_t i = 0; i < matches.size(); ++i)
+    {
+        ASSERT_TRUE (matches[i].mEnd - matches[i].mBeg == static_cast<int>(words[matches[i].mValue].size()));
+        found.push_back(std::make_pair(static_cast<size_t>(matches[i].mBeg - text.begin()), matches[i].mValue));
+    }
+
+    ASSERT_FALSE (expected.empty());
+    ASSERT_TRUE (found == expected);
+}
+
+/// Throughput of highlighting a long text with a few thousand known topics.
+/// Disabled by default, as it only prints a timing; run with --gtest_also_run_disabled_tests.
+TEST_F(KeywordSearchTest, DISABLED_keyword_test_benchmark)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    MWDialogue::KeywordSearch<std::string, int> search;
+    std::vector<std::string> words;
+    unsigned int seed = 1;
+    for (int i = 0; i < 3000; ++i)
+    {
+        std::string word;
+        int length = 3 + i % 9;
+        for (int c = 0; c < length; ++c)
+        {
+            seed = seed * 1103515245 + 12345;
+            word += static_cast<char>('a' + (seed >> 16) % 8);
+        }
+        if (std::find(words.begin(), words.end(), word) != words.end())
+            continue;
+        words.push_back(word);
+        search.seed(word, i);
+    }
+
+    std::string text;
+    for (int i = 0; text.size() < 1000000; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        text += words[(seed >> 16) % words.size()];
+        text += (i % 3) ? " " : "ing. ";
+    }
+
+    Clock::time_point start = Clock::now();
+    std::vector<MWDialogue::KeywordSearch<std::string, int>::Match> matches;
+    search.highlightKeywords(text.begin(), text.end(), matches);
+    Clock::time_point end = Clock::now();
+
+    ASSERT_FALSE (matches.empty());
+
+    std::cout << "keyword search benchmark: " << text.size() << " bytes, " << words.size() << " keywords, "
+              << matches.size() << " matches in "
+              << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << "us" << std::endl;
+}
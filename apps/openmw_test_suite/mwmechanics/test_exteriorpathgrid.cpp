@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <map>
+
+#include <components/esm/loadland.hpp>
+#include <components/esm/loadpgrd.hpp>
+
+#include "apps/openmw/mwmechanics/exteriorpathgrid.hpp"
+
+namespace
+{
+    const int sPointsX[] = { 512, 2048, 4096, 6144, 7680 };
+    const int sNumPoints = sizeof(sPointsX) / sizeof(sPointsX[0]);
+
+    /// Pathgrid of a row of points across the middle of a cell, connected in both directions
+    ESM::Pathgrid makeRow()
+    {
+        ESM::Pathgrid grid;
+        grid.blank();
+
+        for (int i = 0; i < sNumPoints; ++i)
+            grid.mPoints.push_back(ESM::Pathgrid::Point(sPointsX[i], 4096, 0));
+
+        for (int i = 0; i + 1 < sNumPoints; ++i)
+        {
+            ESM::Pathgrid::Edge edge;
+            edge.mV0 = i;
+            edge.mV1 = i + 1;
+            grid.mEdges.push_back(edge);
+            edge.mV0 = i + 1;
+            edge.mV1 = i;
+            grid.mEdges.push_back(edge);
+        }
+
+        return grid;
+    }
+
+    struct ExteriorPathgridGraphTest : public ::testing::Test
+    {
+        std::map<std::pair<int, int>, ESM::Pathgrid> mPathgrids;
+        int mLookups;
+
+        ExteriorPathgridGraphTest() : mLookups(0)
+        {
+            for (int x = 0; x < 3; ++x)
+                mPathgrids[std::make_pair(x, 0)] = makeRow();
+        }
+
+        const ESM::Pathgrid* lookup(int x, int y)
+        {
+            ++mLookups;
+            std::map<std::pair<int, int>, ESM::Pathgrid>::const_iterator found = mPathgrids.find(std::make_pair(x, y));
+            return found != mPathgrids.end() ? &found->second : NULL;
+        }
+
+        MWMechanics::ExteriorPathgridGraph::PathgridLookup getLookup()
+        {
+            return std::bind(&ExteriorPathgridGraphTest::lookup, this, std::placeholders::_1, std::placeholders::_2);
+        }
+    };
+
+    ESM::Pathgrid::Point worldPoint(int cellX, int localX)
+    {
+        return ESM::Pathgrid::Point(cellX * ESM::Land::REAL_SIZE + localX, 4096, 0);
+    }
+}
+
+TEST_F(ExteriorPathgridGraphTest, route_should_pass_through_cells_in_between)
+{
+    MWMechanics::ExteriorPathgridGraph graph(getLookup());
+
+    ESM::Pathgrid::PointList path;
+    ASSERT_TRUE(graph.findRoute(worldPoint(0, 1000), worldPoint(2, 7000), path));
+
+    ASSERT_EQ(path.size(), static_cast<size_t>(3 * sNumPoints));
+    for (int cell = 0; cell < 3; ++cell)
+        for (int i = 0; i < sNumPoints; ++i)
+        {
+            const ESM::Pathgrid::Point& point = path[cell * sNumPoints + i];
+            EXPECT_EQ(point.mX, worldPoint(cell, sPointsX[i]).mX);
+            EXPECT_EQ(point.mY, 4096);
+        }
+}
+
+TEST_F(ExteriorPathgridGraphTest, route_should_be_cached)
+{
+    MWMechanics::ExteriorPathgridGraph graph(getLookup());
+
+    ESM::Pathgrid::PointList first;
+    ASSERT_TRUE(graph.findRoute(worldPoint(2, 7000), worldPoint(0, 1000), first));
+    int lookups = mLookups;
+
+    ESM::Pathgrid::PointList second;
+    ASSERT_TRUE(graph.findRoute(worldPoint(2, 7100), worldPoint(0, 900), second));
+    EXPECT_EQ(mLookups, lookups);
+    ASSERT_EQ(first.size(), second.size());
+    EXPECT_EQ(first.front().mX, worldPoint(2, 7680).mX);
+    EXPECT_EQ(first.back().mX, worldPoint(0, 512).mX);
+}
+
+TEST_F(ExteriorPathgridGraphTest, no_route_through_cell_without_pathgrid)
+{
+    mPathgrids.erase(std::make_pair(1, 0));
+    MWMechanics::ExteriorPathgridGraph graph(getLookup());
+
+    ESM::Pathgrid::PointList path;
+    EXPECT_FALSE(graph.findRoute(worldPoint(0, 1000), worldPoint(2, 7000), path));
+    EXPECT_TRUE(path.empty());
+}
+
+TEST_F(ExteriorPathgridGraphTest, no_route_within_one_cell)
+{
+    MWMechanics::ExteriorPathgridGraph graph(getLookup());
+
+    ESM::Pathgrid::PointList path;
+    EXPECT_FALSE(graph.findRoute(worldPoint(1, 1000), worldPoint(1, 7000), path));
+}
+
+TEST_F(ExteriorPathgridGraphTest, cut_off_route_should_not_be_cached)
+{
+    // one search within a cell per call is not enough for the route, but the costs found are kept
+    MWMechanics::ExteriorPathgridGraph graph(getLookup(), 1);
+
+    ESM::Pathgrid::PointList path;
+    EXPECT_FALSE(graph.findRoute(worldPoint(0, 1000), worldPoint(2, 7000), path));
+    EXPECT_TRUE(path.empty());
+
+    int calls = 1;
+    while (!graph.findRoute(worldPoint(0, 1000), worldPoint(2, 7000), path) && calls < 100)
+        ++calls;
+
+    EXPECT_LT(calls, 100);
+    EXPECT_EQ(path.size(), static_cast<size_t>(3 * sNumPoints));
+}
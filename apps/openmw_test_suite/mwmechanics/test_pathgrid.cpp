@@ -0,0 +1,291 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <sstream>
+
+#include <components/esm/esmreader.hpp>
+#include <components/esm/defs.hpp>
+#include <components/esm/loadpgrd.hpp>
+
+#include "apps/openmw/mwmechanics/pathgrid.hpp"
+
+namespace
+{
+    /// Must match the edge cost used by PathgridGraph
+    float cost (const ESM::Pathgrid::Point& a, const ESM::Pathgrid::Point& b)
+    {
+        return 300.0f * (std::abs(a.mX - b.mX) + std::abs(a.mY - b.mY) + std::abs(a.mZ - b.mZ));
+    }
+
+    void addEdge (ESM::Pathgrid& grid, int from, int to)
+    {
+        ESM::Pathgrid::Edge edge;
+        edge.mV0 = from;
+        edge.mV1 = to;
+        grid.mEdges.push_back (edge);
+        edge.mV0 = to;
+        edge.mV1 = from;
+        grid.mEdges.push_back (edge);
+    }
+
+    /// A size x size lattice with jittered points and some edges left out
+    ESM::Pathgrid makeGrid (int size, unsigned int seed)
+    {
+        std::mt19937 random (seed);
+        std::uniform_int_distribution<int> jitter (-100, 100);
+        std::uniform_int_distribution<int> percent (0, 99);
+
+        ESM::Pathgrid grid;
+        grid.blank();
+        for (int y = 0; y < size; ++y)
+            for (int x = 0; x < size; ++x)
+                grid.mPoints.push_back (ESM::Pathgrid::Point (x * 512 + jitter (random), y * 512 + jitter (random), jitter (random)));
+
+        for (int y = 0; y < size; ++y)
+            for (int x = 0; x < size; ++x)
+            {
+                int index = y * size + x;
+                if (x + 1 < size && percent (random) < 85)
+                    addEdge (grid, index, index + 1);
+                if (y + 1 < size && percent (random) < 85)
+                    addEdge (grid, index, index + size);
+            }
+
+        return grid;
+    }
+
+    /// Cost of the cheapest path, by Dijkstra's algorithm
+    float cheapestPathCost (const ESM::Pathgrid& grid, int start, int goal)
+    {
+        std::vector<float> costs (grid.mPoints.size(), -1);
+        typedef std::pair<float, int> Entry;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > queue;
+        queue.push (Entry (0, start));
+
+        while (!queue.empty())
+        {
+            Entry entry = queue.top();
+            queue.pop();
+            if (costs[entry.second] >= 0)
+                continue;
+            costs[entry.second] = entry.first;
+            if (entry.second == goal)
+                break;
+
+            for (ESM::Pathgrid::EdgeList::const_iterator edge = grid.mEdges.begin(); edge != grid.mEdges.end(); ++edge)
+                if (edge->mV0 == entry.second && costs[edge->mV1] < 0)
+                    queue.push (Entry (entry.first + cost (grid.mPoints[edge->mV0], grid.mPoints[edge->mV1]), edge->mV1));
+        }
+
+        return costs[goal];
+    }
+
+    bool samePoint (const ESM::Pathgrid::Point& a, const ESM::Pathgrid::Point& b)
+    {
+        return a.mX == b.mX && a.mY == b.mY && a.mZ == b.mZ;
+    }
+
+    float distance2 (const ESM::Pathgrid::Point& point, const osg::Vec3f& pos)
+    {
+        osg::Vec3f delta (point.mX - pos.x(), point.mY - pos.y(), point.mZ - pos.z());
+        return delta.length2();
+    }
+
+    /// Pathgrids of the content files listed in OPENMW_TEST_CONTENT, separated by ';'
+    std::vector<ESM::Pathgrid> loadContentPathgrids()
+    {
+        std::vector<ESM::Pathgrid> grids;
+
+        const char* files = std::getenv ("OPENMW_TEST_CONTENT");
+        if (!files)
+            return grids;
+
+        std::istringstream stream (files);
+        std::string file;
+        while (std::getline (stream, file, ';'))
+        {
+            ESM::ESMReader reader;
+            reader.open (file);
+
+            while (reader.hasMoreRecs())
+            {
+                ESM::NAME name = reader.getRecName();
+                reader.getRecHeader();
+
+                if (name.intval == ESM::REC_PGRD)
+                {
+                    ESM::Pathgrid grid;
+                    bool isDeleted = false;
+                    grid.load (reader, isDeleted);
+                    if (!isDeleted && !grid.mPoints.empty())
+                        grids.push_back (grid);
+                }
+                else
+                    reader.skipRecord();
+            }
+        }
+
+        return grids;
+    }
+}
+
+TEST(PathgridGraphTest, paths_should_be_connected_and_cheapest)
+{
+    ESM::Pathgrid grid = makeGrid (12, 1);
+    MWMechanics::PathgridGraph graph (&grid);
+    MWMechanics::PathgridGraph::SearchState state;
+
+    std::mt19937 random (2);
+    std::uniform_int_distribution<int> point (0, static_cast<int> (grid.mPoints.size()) - 1);
+
+    int found = 0;
+    for (int i = 0; i < 200; ++i)
+    {
+        int start = point (random);
+        int goal = point (random);
+
+        ESM::Pathgrid::PointList path;
+        graph.aStarSearch (start, goal, path, state);
+
+        if (!graph.isPointConnected (start, goal))
+        {
+            EXPECT_TRUE (path.empty());
+            continue;
+        }
+
+        ASSERT_FALSE (path.empty());
+        EXPECT_TRUE (samePoint (path.front(), grid.mPoints[start]));
+        EXPECT_TRUE (samePoint (path.back(), grid.mPoints[goal]));
+
+        float pathCost = 0;
+        for (size_t j = 1; j < path.size(); ++j)
+            pathCost += cost (path[j-1], path[j]);
+
+        EXPECT_NEAR (pathCost, cheapestPathCost (grid, start, goal), 1.f);
+        ++found;
+    }
+
+    EXPECT_GT (found, 0);
+}
+
+TEST(PathgridGraphTest, search_should_append_to_path)
+{
+    ESM::Pathgrid grid = makeGrid (3, 3);
+    MWMechanics::PathgridGraph graph (&grid);
+
+    ESM::Pathgrid::PointList path (1, ESM::Pathgrid::Point (1, 2, 3));
+    graph.aStarSearch (4, 4, path);
+
+    ASSERT_EQ (path.size(), 2u);
+    EXPECT_TRUE (samePoint (path[0], ESM::Pathgrid::Point (1, 2, 3)));
+    EXPECT_TRUE (samePoint (path[1], grid.mPoints[4]));
+}
+
+TEST(PathgridGraphTest, state_should_be_reusable_across_graphs)
+{
+    ESM::Pathgrid large = makeGrid (10, 4);
+    ESM::Pathgrid small = makeGrid (2, 5);
+    small.mEdges.clear();
+    addEdge (small, 0, 1);
+    addEdge (small, 1, 3);
+
+    MWMechanics::PathgridGraph largeGraph (&large);
+    MWMechanics::PathgridGraph smallGraph (&small);
+    MWMechanics::PathgridGraph::SearchState state;
+
+    ESM::Pathgrid::PointList path;
+    largeGraph.aStarSearch (0, 99, path, state);
+
+    path.clear();
+    smallGraph.aStarSearch (0, 3, path, state);
+    ASSERT_EQ (path.size(), 3u);
+    EXPECT_TRUE (samePoint (path[1], small.mPoints[1]));
+
+    path.clear();
+    smallGraph.aStarSearch (0, 2, path, state);
+    EXPECT_TRUE (path.empty());
+}
+
+TEST(PathgridGraphTest, point_index_should_match_full_scan)
+{
+    ESM::Pathgrid grid = makeGrid (20, 6);
+    MWMechanics::PathgridGraph graph (&grid);
+    const MWMechanics::PathgridPointIndex& index = graph.getPointIndex();
+
+    std::mt19937 random (7);
+    std::uniform_real_distribution<float> coordinate (-2000.f, 12000.f);
+    std::uniform_real_distribution<float> radius (0.f, 3000.f);
+
+    for (int i = 0; i < 500; ++i)
+    {
+        osg::Vec3f pos (coordinate (random), coordinate (random), coordinate (random) / 20.f);
+
+        int closest = 0;
+        for (size_t j = 1; j < grid.mPoints.size(); ++j)
+            if (distance2 (grid.mPoints[j], pos) < distance2 (grid.mPoints[closest], pos))
+                closest = static_cast<int> (j);
+        EXPECT_EQ (index.getClosestPoint (pos), closest);
+
+        float range = radius (random);
+        std::vector<int> expected;
+        for (size_t j = 0; j < grid.mPoints.size(); ++j)
+            if (distance2 (grid.mPoints[j], pos) <= range * range)
+                expected.push_back (static_cast<int> (j));
+
+        std::vector<int> found;
+        index.getPointsInRange (pos, range, found);
+        EXPECT_EQ (found, expected);
+    }
+}
+
+/// Search between sampled pairs of points on every pathgrid of the content files in OPENMW_TEST_CONTENT,
+/// or on generated pathgrids if it is not set. Disabled by default, as it only prints a timing; run with
+/// --gtest_also_run_disabled_tests.
+TEST(PathgridGraphTest, DISABLED_benchmark)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    std::vector<ESM::Pathgrid> grids = loadContentPathgrids();
+    if (grids.empty())
+    {
+        for (unsigned int i = 0; i < 50; ++i)
+            grids.push_back (makeGrid (16, i));
+    }
+
+    std::vector<MWMechanics::PathgridGraph> graphs;
+    graphs.reserve (grids.size());
+    for (std::vector<ESM::Pathgrid>::const_iterator it = grids.begin(); it != grids.end(); ++it)
+        graphs.push_back (MWMechanics::PathgridGraph (&*it));
+
+    MWMechanics::PathgridGraph::SearchState state;
+    ESM::Pathgrid::PointList path;
+    size_t searches = 0;
+    size_t points = 0;
+
+    Clock::time_point start = Clock::now();
+
+    for (size_t i = 0; i < graphs.size(); ++i)
+    {
+        int size = static_cast<int> (grids[i].mPoints.size());
+        int step = std::max (1, size / 32);
+        for (int from = 0; from < size; from += step)
+            for (int to = 0; to < size; to += step)
+            {
+                path.clear();
+                graphs[i].aStarSearch (from, to, path, state);
+                points += path.size();
+                ++searches;
+            }
+    }
+
+    Clock::time_point end = Clock::now();
+
+    std::cout << "pathgrid A* benchmark: " << grids.size() << " pathgrids, " << searches << " searches, "
+              << points << " path points in "
+              << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << "us" << std::endl;
+}
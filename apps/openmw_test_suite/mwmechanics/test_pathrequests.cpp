@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include <components/esm/loadcell.hpp>
+#include <components/esm/loadpgrd.hpp>
+
+#include "apps/openmw/mwmechanics/pathgrid.hpp"
+#include "apps/openmw/mwmechanics/pathrequests.hpp"
+
+namespace
+{
+    const int sPointsX[] = { 0, 1000, 2000, 3000 };
+    const int sNumPoints = sizeof(sPointsX) / sizeof(sPointsX[0]);
+
+    struct PathRequestQueueTest : public ::testing::Test
+    {
+        ESM::Cell mCell;
+        ESM::Pathgrid mPathgrid;
+
+        /// An interior cell with a row of pathgrid points, connected in both directions
+        PathRequestQueueTest()
+        {
+            mCell.mData.mFlags = ESM::Cell::Interior;
+            mCell.mData.mX = 0;
+            mCell.mData.mY = 0;
+
+            mPathgrid.blank();
+            for (int i = 0; i < sNumPoints; ++i)
+                mPathgrid.mPoints.push_back(ESM::Pathgrid::Point(sPointsX[i], 0, 0));
+
+            for (int i = 0; i + 1 < sNumPoints; ++i)
+            {
+                ESM::Pathgrid::Edge edge;
+                edge.mV0 = i;
+                edge.mV1 = i + 1;
+                mPathgrid.mEdges.push_back(edge);
+                edge.mV0 = i + 1;
+                edge.mV1 = i;
+                mPathgrid.mEdges.push_back(edge);
+            }
+        }
+    };
+}
+
+TEST_F(PathRequestQueueTest, completed_request_should_deliver_path_along_pathgrid)
+{
+    MWMechanics::PathgridGraph graph(&mPathgrid);
+    MWMechanics::PathRequestQueue queue(1);
+
+    const ESM::Pathgrid::Point end(2990, 0, 0);
+    osg::ref_ptr<MWMechanics::PathRequest> request = queue.request(ESM::Pathgrid::Point(10, 0, 0), end, &mCell, graph);
+    request->waitTillDone();
+
+    ASSERT_TRUE(request->isDone());
+    const std::deque<ESM::Pathgrid::Point>& path = request->getPath();
+    ASSERT_EQ(path.size(), static_cast<size_t>(sNumPoints + 1));
+    for (int i = 0; i < sNumPoints; ++i)
+        EXPECT_EQ(path[i].mX, sPointsX[i]);
+    EXPECT_EQ(path.back().mX, end.mX);
+
+    queue.update();
+    EXPECT_EQ(queue.getNumCompleted(), 1u);
+    EXPECT_EQ(queue.getNumPending(), 0u);
+}
+
+TEST_F(PathRequestQueueTest, aborted_request_should_not_deliver_path)
+{
+    MWMechanics::PathgridGraph graph(&mPathgrid);
+    // no worker threads, so the request stays queued until we run it like a worker would
+    MWMechanics::PathRequestQueue queue(0);
+
+    osg::ref_ptr<MWMechanics::PathRequest> request = queue.request(ESM::Pathgrid::Point(10, 0, 0),
+                                                                   ESM::Pathgrid::Point(2990, 0, 0), &mCell, graph);
+    EXPECT_EQ(queue.getNumPending(), 1u);
+
+    request->abort();
+    request->doWork();
+    request->signalDone();
+
+    EXPECT_TRUE(request->getPath().empty());
+
+    queue.update();
+    EXPECT_EQ(queue.getNumCompleted(), 0u);
+    EXPECT_EQ(queue.getNumPending(), 0u);
+}
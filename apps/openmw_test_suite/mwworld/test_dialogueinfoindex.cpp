@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+#include <components/esm/loaddial.hpp>
+#include <components/misc/stringops.hpp>
+
+#include "apps/openmw/mwdialogue/selectwrapper.hpp"
+#include "apps/openmw/mwworld/dialogueinfoindex.hpp"
+#include "apps/openmw/mwworld/store.hpp"
+
+namespace
+{
+    const char* sRaces[] = { "Dark Elf", "Nord", "Imperial", "Khajiit" };
+    const char* sClasses[] = { "Guard", "Trader", "Mage", "Thief", "Agent" };
+    const char* sFactions[] = { "Fighters Guild", "Mages Guild", "Hlaalu", "Redoran", "Temple", "Imperial Legion" };
+
+    std::string makeId (const char* prefix, int index)
+    {
+        std::ostringstream stream;
+        stream << prefix << index;
+        return stream.str();
+    }
+
+    /// Mirror of the static checks done by MWDialogue::Filter::testActor
+    bool matchesStatic (const ESM::DialInfo& info, const MWWorld::DialogueInfoIndex::Speaker& speaker)
+    {
+        if (!info.mActor.empty())
+        {
+            if (!Misc::StringUtils::ciEqual (info.mActor, speaker.mId))
+                return false;
+        }
+        else if (speaker.mIsCreature)
+            return false;
+
+        if (speaker.mIsCreature)
+            return true;
+
+        if (!info.mRace.empty() && !Misc::StringUtils::ciEqual (info.mRace, speaker.mRace))
+            return false;
+        if (!info.mClass.empty() && !Misc::StringUtils::ciEqual (info.mClass, speaker.mClass))
+            return false;
+        if (info.mFactionLess)
+            return speaker.mFaction.empty();
+        if (!info.mFaction.empty() && !Misc::StringUtils::ciEqual (info.mFaction, speaker.mFaction))
+            return false;
+        return true;
+    }
+
+    /// Add \a numDialogues synthetic topics with \a numInfos infos each, spread over \a numActors actor IDs
+    void addDialogues (MWWorld::Store<ESM::Dialogue>& store, int numDialogues, int numInfos, int numActors)
+    {
+        unsigned int seed = 1;
+        for (int d = 0; d < numDialogues; ++d)
+        {
+            ESM::Dialogue dialogue;
+            dialogue.mId = makeId ("Topic", d);
+            dialogue.mType = ESM::Dialogue::Topic;
+
+            for (int i = 0; i < numInfos; ++i)
+            {
+                seed = seed * 1103515245 + 12345;
+                int roll = static_cast<int>((seed >> 16) & 0x7fff);
+
+                ESM::DialInfo info;
+                info.mId = makeId ("Info", d * numInfos + i);
+                info.mFactionLess = false;
+                info.mData.mRank = -1;
+                if (roll % 7 == 0)
+                    info.mActor = makeId ("NPC", roll % numActors);
+                if (roll % 3 == 0)
+                    info.mRace = sRaces[roll % 4];
+                if (roll % 5 == 0)
+                    info.mClass = sClasses[roll % 5];
+                if (roll % 11 == 0)
+                    info.mFactionLess = true;
+                else if (roll % 2 == 0)
+                    info.mFaction = sFactions[roll % 6];
+                if (roll % 13 == 0)
+                {
+                    ESM::DialInfo::SelectStruct select;
+                    select.mSelectRule = "04JX0Some_Quest";
+                    select.mValue.setType (ESM::VT_Int);
+                    select.mValue.setInteger (roll % 100);
+                    info.mSelects.push_back (select);
+                }
+                dialogue.mInfo.push_back (info);
+            }
+
+            store.insertStatic (dialogue);
+        }
+    }
+
+    /// Make \a numSpeakers speakers, with actor IDs \a actorStep apart
+    std::vector<MWWorld::DialogueInfoIndex::Speaker> makeSpeakers (int numSpeakers, int actorStep)
+    {
+        std::vector<MWWorld::DialogueInfoIndex::Speaker> speakers;
+        for (int i = 0; i < numSpeakers; ++i)
+        {
+            MWWorld::DialogueInfoIndex::Speaker speaker;
+            speaker.mId = Misc::StringUtils::lowerCase (makeId ("NPC", i * actorStep));
+            speaker.mIsCreature = (i % 5 == 4);
+            if (!speaker.mIsCreature)
+            {
+                speaker.mRace = Misc::StringUtils::lowerCase (sRaces[i % 4]);
+                speaker.mClass = Misc::StringUtils::lowerCase (sClasses[i % 5]);
+                if (i % 3 != 0)
+                    speaker.mFaction = Misc::StringUtils::lowerCase (sFactions[i % 6]);
+            }
+            speakers.push_back (speaker);
+        }
+        return speakers;
+    }
+
+    struct DialogueInfoIndexTest : public ::testing::Test
+    {
+        MWWorld::Store<ESM::Dialogue> mStore;
+        MWWorld::DialogueInfoIndex mIndex;
+        std::vector<MWWorld::DialogueInfoIndex::Speaker> mSpeakers;
+
+        /// Synthetic data set of 8 topics with 40 infos each
+        virtual void SetUp()
+        {
+            addDialogues (mStore, 8, 40, 10);
+            mIndex.build (mStore);
+            mSpeakers = makeSpeakers (10, 1);
+        }
+    };
+
+    TEST_F(DialogueInfoIndexTest, candidates_should_contain_all_matching_infos_in_order)
+    {
+        for (const MWWorld::DialogueInfoIndex::Speaker& speaker : mSpeakers)
+        {
+            for (MWWorld::Store<ESM::Dialogue>::iterator it = mStore.begin(); it != mStore.end(); ++it)
+            {
+                std::vector<const ESM::DialInfo *> candidates;
+                ASSERT_TRUE (mIndex.getCandidates (*it, speaker, candidates));
+
+                std::vector<const ESM::DialInfo *> matching;
+                for (const ESM::DialInfo& info : it->mInfo)
+                    if (matchesStatic (info, speaker))
+                        matching.push_back (&info);
+
+                std::vector<const ESM::DialInfo *> filtered;
+                for (const ESM::DialInfo *info : candidates)
+                    if (matchesStatic (*info, speaker))
+                        filtered.push_back (info);
+
+                EXPECT_EQ (matching, filtered);
+            }
+        }
+    }
+
+    TEST_F(DialogueInfoIndexTest, unknown_dialogue_should_not_be_indexed)
+    {
+        ESM::Dialogue dialogue;
+        std::vector<const ESM::DialInfo *> candidates;
+        EXPECT_FALSE (mIndex.getCandidates (dialogue, mSpeakers.front(), candidates));
+    }
+
+    TEST_F(DialogueInfoIndexTest, selects_should_be_decoded)
+    {
+        for (MWWorld::Store<ESM::Dialogue>::iterator it = mStore.begin(); it != mStore.end(); ++it)
+        {
+            for (const ESM::DialInfo& info : it->mInfo)
+            {
+                const std::vector<MWDialogue::SelectWrapper> *selects = mIndex.getSelects (info);
+                ASSERT_TRUE (selects != 0);
+                ASSERT_EQ (info.mSelects.size(), selects->size());
+
+                for (const MWDialogue::SelectWrapper& select : *selects)
+                {
+                    int value = info.mSelects.front().mValue.getInteger();
+                    EXPECT_EQ (MWDialogue::SelectWrapper::Function_Journal, select.getFunction());
+                    EXPECT_EQ (MWDialogue::SelectWrapper::Type_Integer, select.getType());
+                    EXPECT_EQ ("some_quest", select.getName());
+                    EXPECT_TRUE (select.selectCompare (value));
+                    EXPECT_FALSE (select.selectCompare (value + 1));
+                }
+            }
+        }
+
+        ESM::DialInfo info;
+        EXPECT_TRUE (mIndex.getSelects (info) == 0);
+    }
+
+    /// Compare looking up candidates to testing all infos, over 500 topics with 100 infos each.
+    /// Disabled by default, as it only prints timings; run with --gtest_also_run_disabled_tests.
+    TEST(DialogueInfoIndexBenchmark, DISABLED_candidates_versus_all_infos)
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        MWWorld::Store<ESM::Dialogue> store;
+        addDialogues (store, 500, 100, 200);
+        MWWorld::DialogueInfoIndex index;
+        index.build (store);
+        const std::vector<MWWorld::DialogueInfoIndex::Speaker> speakers = makeSpeakers (20, 7);
+
+        size_t tested = 0;
+        Clock::time_point start = Clock::now();
+        for (const MWWorld::DialogueInfoIndex::Speaker& speaker : speakers)
+            for (MWWorld::Store<ESM::Dialogue>::iterator it = store.begin(); it != store.end(); ++it)
+                for (const ESM::DialInfo& info : it->mInfo)
+                    tested += matchesStatic (info, speaker);
+        Clock::time_point bruteForce = Clock::now();
+
+        size_t indexed = 0;
+        std::vector<const ESM::DialInfo *> candidates;
+        for (const MWWorld::DialogueInfoIndex::Speaker& speaker : speakers)
+            for (MWWorld::Store<ESM::Dialogue>::iterator it = store.begin(); it != store.end(); ++it)
+            {
+                candidates.clear();
+                index.getCandidates (*it, speaker, candidates);
+                for (const ESM::DialInfo *info : candidates)
+                    indexed += matchesStatic (*info, speaker);
+            }
+        Clock::time_point end = Clock::now();
+
+        EXPECT_EQ (tested, indexed);
+
+        std::cout << "dialogue info index benchmark: all infos "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(bruteForce - start).count() << "us, indexed "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(end - bruteForce).count() << "us" << std::endl;
+    }
+}
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "apps/openmw/mwworld/segmentedlist.hpp"
+
+namespace
+{
+    typedef MWWorld::SegmentedList<std::string> List;
+
+    std::vector<std::string> toVector (const List& list)
+    {
+        return std::vector<std::string> (list.begin(), list.end());
+    }
+
+    std::string makeValue (int index)
+    {
+        return std::string (1, static_cast<char> ('a' + index % 26)) + std::to_string (index);
+    }
+}
+
+TEST(SegmentedListTest, keeps_insertion_order)
+{
+    List list;
+    std::vector<std::string> expected;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        list.push_back (makeValue (i));
+        expected.push_back (makeValue (i));
+    }
+
+    EXPECT_EQ(list.size(), 100u);
+    EXPECT_EQ(toVector (list), expected);
+    EXPECT_EQ(list.front(), expected.front());
+    EXPECT_EQ(*--list.end(), expected.back());
+}
+
+TEST(SegmentedListTest, addresses_stay_valid_when_adding)
+{
+    List list;
+    std::vector<const std::string*> addresses;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        list.push_back (makeValue (i));
+        addresses.push_back (&list.back());
+    }
+
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_EQ(*addresses[i], makeValue (i));
+}
+
+TEST(SegmentedListTest, erase_returns_next_and_reuses_memory)
+{
+    List list;
+    for (int i = 0; i < 20; ++i)
+        list.push_back (makeValue (i));
+
+    List::iterator iter = std::find (list.begin(), list.end(), makeValue (5));
+    const std::string* erased = &*iter;
+
+    iter = list.erase (iter);
+    EXPECT_EQ(*iter, makeValue (6));
+    EXPECT_EQ(list.size(), 19u);
+    EXPECT_TRUE(std::find (list.begin(), list.end(), makeValue (5)) == list.end());
+
+    // a new element is still added at the end, in the erased element's memory
+    list.push_back ("new");
+    EXPECT_EQ(&list.back(), erased);
+    EXPECT_EQ(*--list.end(), "new");
+}
+
+TEST(SegmentedListTest, erase_first_and_last)
+{
+    List list;
+    for (int i = 0; i < 3; ++i)
+        list.push_back (makeValue (i));
+
+    list.erase (list.begin());
+    list.erase (--list.end());
+
+    ASSERT_EQ(list.size(), 1u);
+    EXPECT_EQ(list.front(), makeValue (1));
+    EXPECT_EQ(list.back(), makeValue (1));
+
+    list.erase (list.begin());
+    EXPECT_TRUE(list.empty());
+    EXPECT_TRUE(list.begin() == list.end());
+}
+
+TEST(SegmentedListTest, iterator_to_element_can_erase_it)
+{
+    List list;
+    for (int i = 0; i < 10; ++i)
+        list.push_back (makeValue (i));
+
+    std::string& element = *std::find (list.begin(), list.end(), makeValue (3));
+    List::iterator iter = list.iteratorTo (element);
+    EXPECT_EQ(&*iter, &element);
+
+    iter = list.erase (iter);
+    EXPECT_EQ(*iter, makeValue (4));
+    EXPECT_EQ(*--iter, makeValue (2));
+    EXPECT_EQ(list.size(), 9u);
+}
+
+TEST(SegmentedListTest, copy_is_independent)
+{
+    List list;
+    for (int i = 0; i < 10; ++i)
+        list.push_back (makeValue (i));
+
+    List copy (list);
+    EXPECT_EQ(toVector (copy), toVector (list));
+    EXPECT_NE(&copy.front(), &list.front());
+
+    copy.erase (copy.begin());
+    EXPECT_EQ(list.size(), 10u);
+    EXPECT_EQ(copy.size(), 9u);
+
+    list = copy;
+    EXPECT_EQ(toVector (copy), toVector (list));
+}
+
+TEST(SegmentedListTest, iterator_converts_to_const_iterator)
+{
+    List list;
+    list.push_back ("a");
+
+    List::const_iterator iter = list.begin();
+    EXPECT_EQ(*iter, "a");
+    EXPECT_TRUE(++iter == static_cast<const List&> (list).end());
+}
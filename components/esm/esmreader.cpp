@@ -2,6 +2,8 @@
 
 #include <stdexcept>
 
+#include "savecompression.hpp"
+
 namespace ESM
 {
 
@@ -71,7 +73,7 @@ void ESMReader::openRaw(Files::IStreamPtr _esm, const std::string& name)
 
 void ESMReader::openRaw(const std::string& filename)
 {
-    openRaw(Files::openConstrainedFileStream(filename.c_str()), filename);
+    openRaw(SaveCompression::openFile(filename), filename);
 }
 
 void ESMReader::open(Files::IStreamPtr _esm, const std::string &name)
@@ -88,7 +90,7 @@ void ESMReader::open(Files::IStreamPtr _esm, const std::string &name)
 
 void ESMReader::open(const std::string &file)
 {
-    open (Files::openConstrainedFileStream (file.c_str ()), file);
+    open (SaveCompression::openFile (file), file);
 }
 
 int64_t ESMReader::getHNLong(const char *name)
@@ -286,6 +288,15 @@ void ESMReader::skipRecord()
     mCtx.subCached = false;
 }
 
+void ESMReader::getRawRecord(std::vector<char> &data)
+{
+    data.resize(mCtx.leftRec);
+    if (!data.empty())
+        getExact(&data[0], static_cast<int>(data.size()));
+    mCtx.leftRec = 0;
+    mCtx.subCached = false;
+}
+
 void ESMReader::getRecHeader(uint32_t &flags)
 {
     // General error checking
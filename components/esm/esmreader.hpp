@@ -69,6 +69,7 @@ public:
   /// currently open file first, if any.
   void open(Files::IStreamPtr _esm, const std::string &name);
 
+  /// Open a file by name. Compressed saved games are decompressed transparently.
   void open(const std::string &file);
 
   void openRaw(const std::string &filename);
@@ -227,6 +228,10 @@ public:
   // already been read
   void skipRecord();
 
+  // Read the rest of this record without parsing it. Assumes the name
+  // and header have already been read
+  void getRawRecord(std::vector<char> &data);
+
   /* Read record header. This updatesleftFile BEYOND the data that
      follows the header, ie beyond the entire record. You should use
      leftRec to orient yourself inside the record itself.
@@ -262,6 +267,7 @@ public:
 
   /// Sets font encoder for ESM strings
   void setEncoder(ToUTF8::Utf8Encoder* encoder);
+  ToUTF8::Utf8Encoder* getEncoder() const { return mEncoder; }
 
   /// Get record flags of last record
   unsigned int getRecordFlags() { return mRecordFlags; }
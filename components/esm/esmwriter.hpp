@@ -52,6 +52,9 @@ class ESMWriter
         void save(std::ostream& file);
         ///< Start saving a file by writing the TES3 header.
 
+        void saveRecords(std::ostream& file);
+        ///< Start writing to \a file without a TES3 header, e.g. to keep the data of a record for writing it later on.
+
         void close();
         ///< \note Does not close the stream.
 
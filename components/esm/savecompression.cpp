@@ -0,0 +1,269 @@
+#include "savecompression.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <vector>
+#include <algorithm>
+
+#include <zlib.h>
+
+namespace
+{
+    const char sMagic[4] = { 'O', 'M', 'W', 'Z' };
+
+    template<typename T>
+    void writeValue (std::ostream& stream, T value)
+    {
+        stream.write (reinterpret_cast<const char *> (&value), sizeof (T));
+    }
+
+    template<typename T>
+    void readValue (std::istream& stream, T& value)
+    {
+        stream.read (reinterpret_cast<char *> (&value), sizeof (T));
+        if (!stream)
+            throw std::runtime_error ("unexpected end of compressed save");
+    }
+
+    /// Decompresses the chunk containing the current read position on demand.
+    class InflatingStreamBuf : public std::streambuf
+    {
+            struct Chunk
+            {
+                std::streamoff mSourceOffset;
+                uint32_t mCompressedSize;
+                uint64_t mStart;
+                uint32_t mSize;
+            };
+
+            Files::IStreamPtr mSource;
+            std::vector<Chunk> mChunks;
+            std::vector<char> mCompressed;
+            std::vector<char> mBuffer;
+            size_t mCurrent;
+            uint64_t mSize;
+
+            void loadChunk (size_t index)
+            {
+                const Chunk& chunk = mChunks[index];
+
+                mCompressed.resize (chunk.mCompressedSize);
+                mSource->clear();
+                mSource->seekg (chunk.mSourceOffset);
+                mSource->read (&mCompressed[0], chunk.mCompressedSize);
+                if (!*mSource)
+                    throw std::runtime_error ("unexpected end of compressed save");
+
+                mBuffer.resize (chunk.mSize);
+                uLongf size = chunk.mSize;
+                if (uncompress (reinterpret_cast<Bytef *> (&mBuffer[0]), &size,
+                    reinterpret_cast<const Bytef *> (&mCompressed[0]), chunk.mCompressedSize) != Z_OK || size != chunk.mSize)
+                    throw std::runtime_error ("corrupted compressed save");
+
+                mCurrent = index;
+                setg (&mBuffer[0], &mBuffer[0], &mBuffer[0] + mBuffer.size());
+            }
+
+            uint64_t getPosition() const
+            {
+                if (mCurrent == mChunks.size())
+                    return 0;
+
+                return mChunks[mCurrent].mStart + (gptr() - eback());
+            }
+
+        public:
+
+            InflatingStreamBuf (Files::IStreamPtr source)
+                : mSource (source), mCurrent (0), mSize (0)
+            {
+                char magic[sizeof (sMagic)];
+                mSource->read (magic, sizeof (magic));
+
+                uint32_t version = 0;
+                readValue (*mSource, version);
+                if (std::memcmp (magic, sMagic, sizeof (sMagic)) != 0 || version > ESM::SaveCompression::sVersion)
+                    throw std::runtime_error ("unsupported compressed save");
+
+                readValue (*mSource, mSize);
+
+                // Build the chunk table by skipping over the compressed data
+                uint64_t start = 0;
+                while (start < mSize)
+                {
+                    Chunk chunk;
+                    readValue (*mSource, chunk.mSize);
+                    readValue (*mSource, chunk.mCompressedSize);
+                    chunk.mSourceOffset = mSource->tellg();
+                    chunk.mStart = start;
+
+                    if (chunk.mSize == 0)
+                        throw std::runtime_error ("corrupted compressed save");
+
+                    mChunks.push_back (chunk);
+                    start += chunk.mSize;
+
+                    mSource->seekg (chunk.mCompressedSize, std::ios_base::cur);
+                }
+
+                mCurrent = mChunks.size();
+            }
+
+        protected:
+
+            virtual int_type underflow()
+            {
+                if (gptr() < egptr())
+                    return traits_type::to_int_type (*gptr());
+
+                size_t next = mCurrent == mChunks.size() ? 0 : mCurrent + 1;
+                if (next >= mChunks.size())
+                    return traits_type::eof();
+
+                loadChunk (next);
+                return traits_type::to_int_type (*gptr());
+            }
+
+            virtual pos_type seekoff (off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+            {
+                if (dir == std::ios_base::cur)
+                    off += static_cast<off_type> (getPosition());
+                else if (dir == std::ios_base::end)
+                    off += static_cast<off_type> (mSize);
+
+                return seekpos (off, which);
+            }
+
+            virtual pos_type seekpos (pos_type pos, std::ios_base::openmode which)
+            {
+                off_type offset = pos;
+                if (offset < 0 || static_cast<uint64_t> (offset) > mSize || !(which & std::ios_base::in))
+                    return pos_type (off_type (-1));
+
+                if (static_cast<uint64_t> (offset) == mSize)
+                {
+                    // At the end; leave an empty get area so the next read hits EOF
+                    if (!mChunks.empty() && mCurrent != mChunks.size() - 1)
+                        loadChunk (mChunks.size() - 1);
+                    if (!mChunks.empty())
+                        setg (eback(), egptr(), egptr());
+                    return pos;
+                }
+
+                size_t index = 0;
+                while (index + 1 < mChunks.size() && mChunks[index + 1].mStart <= static_cast<uint64_t> (offset))
+                    ++index;
+
+                if (index != mCurrent)
+                    loadChunk (index);
+
+                setg (eback(), eback() + (offset - mChunks[index].mStart), egptr());
+                return pos;
+            }
+    };
+
+    class DecompressingStream : public std::istream
+    {
+            InflatingStreamBuf mBuf;
+
+        public:
+
+            DecompressingStream (Files::IStreamPtr source)
+                : std::istream (NULL), mBuf (source)
+            {
+                rdbuf (&mBuf);
+            }
+    };
+}
+
+namespace ESM
+{
+    const unsigned int SaveCompression::sVersion = 1;
+    const unsigned int SaveCompression::sChunkSize = 256 * 1024;
+
+    bool SaveCompression::isCompressed (std::istream& stream)
+    {
+        std::streampos position = stream.tellg();
+
+        char magic[sizeof (sMagic)];
+        stream.read (magic, sizeof (magic));
+        bool compressed = stream.gcount() == sizeof (magic) && std::memcmp (magic, sMagic, sizeof (sMagic)) == 0;
+
+        stream.clear();
+        stream.seekg (position);
+        return compressed;
+    }
+
+    void SaveCompression::write (std::ostream& stream, const char *data, size_t size, int level)
+    {
+        writeHeader (stream, size);
+
+        std::vector<char> compressed (compressBound (sChunkSize));
+
+        for (size_t offset = 0; offset < size; offset += sChunkSize)
+            writeChunk (stream, data + offset, std::min<size_t> (sChunkSize, size - offset), compressed, level);
+
+        if (stream.fail())
+            throw std::runtime_error ("failed to write compressed saved game");
+    }
+
+    void SaveCompression::write (std::ostream& stream, std::istream& source, size_t size, int level)
+    {
+        writeHeader (stream, size);
+
+        std::vector<char> chunk (sChunkSize);
+        std::vector<char> compressed (compressBound (sChunkSize));
+
+        for (size_t offset = 0; offset < size; offset += sChunkSize)
+        {
+            size_t chunkSize = std::min<size_t> (sChunkSize, size - offset);
+            source.read (&chunk[0], chunkSize);
+            if (!source)
+                throw std::runtime_error ("failed to read saved game to compress");
+
+            writeChunk (stream, &chunk[0], chunkSize, compressed, level);
+        }
+
+        if (stream.fail())
+            throw std::runtime_error ("failed to write compressed saved game");
+    }
+
+    void SaveCompression::writeHeader (std::ostream& stream, size_t size)
+    {
+        stream.write (sMagic, sizeof (sMagic));
+        writeValue<uint32_t> (stream, sVersion);
+        writeValue<uint64_t> (stream, size);
+    }
+
+    void SaveCompression::writeChunk (std::ostream& stream, const char *data, size_t size, std::vector<char>& compressed, int level)
+    {
+        uLongf compressedSize = static_cast<uLongf> (compressed.size());
+
+        if (compress2 (reinterpret_cast<Bytef *> (&compressed[0]), &compressedSize,
+            reinterpret_cast<const Bytef *> (data), static_cast<uLong> (size), level) != Z_OK)
+            throw std::runtime_error ("failed to compress saved game");
+
+        writeValue<uint32_t> (stream, static_cast<uint32_t> (size));
+        writeValue<uint32_t> (stream, static_cast<uint32_t> (compressedSize));
+        stream.write (&compressed[0], compressedSize);
+    }
+
+    Files::IStreamPtr SaveCompression::openDecompressed (Files::IStreamPtr stream)
+    {
+        return Files::IStreamPtr (new DecompressingStream (stream));
+    }
+
+    Files::IStreamPtr SaveCompression::openFile (const std::string& filename)
+    {
+        Files::IStreamPtr stream = Files::openConstrainedFileStream (filename.c_str());
+
+        if (isCompressed (*stream))
+            return openDecompressed (stream);
+
+        return stream;
+    }
+}
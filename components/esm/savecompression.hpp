@@ -0,0 +1,50 @@
+#ifndef OPENMW_ESM_SAVECOMPRESSION_H
+#define OPENMW_ESM_SAVECOMPRESSION_H
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+#include <components/files/constrainedfilestream.hpp>
+
+namespace ESM
+{
+    /// @brief Compressed saved games wrap a regular ESM file in independently zlib-compressed chunks.
+    ///
+    /// Layout: the magic "OMWZ", the container version (uint32), the uncompressed size (uint64), then
+    /// each chunk as its uncompressed size (uint32), compressed size (uint32) and compressed data.
+    /// Since the chunks are independent, the ESM data can be read and seeked without decompressing
+    /// the whole file.
+    struct SaveCompression
+    {
+        static const unsigned int sVersion;
+        static const unsigned int sChunkSize;
+
+        /// Is the data at the current position of \a stream a compressed save? The position is left unchanged.
+        static bool isCompressed (std::istream& stream);
+
+        /// Compress an ESM file held in memory into \a stream.
+        /// @param level zlib compression level, -1 for the zlib default
+        /// @note Throws on failure.
+        static void write (std::ostream& stream, const char *data, size_t size, int level = -1);
+
+        /// Compress the next \a size bytes of \a source into \a stream, one chunk at a time.
+        /// @param level zlib compression level, -1 for the zlib default
+        /// @note Throws on failure.
+        static void write (std::ostream& stream, std::istream& source, size_t size, int level = -1);
+
+        /// Open \a stream, which must hold a compressed save, for reading the decompressed ESM data.
+        static Files::IStreamPtr openDecompressed (Files::IStreamPtr stream);
+
+        /// Open a file for reading its ESM data, decompressing it if it is a compressed save.
+        static Files::IStreamPtr openFile (const std::string& filename);
+
+    private:
+        static void writeHeader (std::ostream& stream, size_t size);
+
+        /// @param compressed Scratch buffer of at least compressBound(size) bytes
+        static void writeChunk (std::ostream& stream, const char *data, size_t size, std::vector<char>& compressed, int level);
+    };
+}
+
+#endif
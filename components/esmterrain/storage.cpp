@@ -1,6 +1,7 @@
 #include "storage.hpp"
 
 #include <set>
+#include <cstring>
 #include <iostream>
 
 #include <OpenThreads/ScopedLock>
@@ -431,33 +432,87 @@ namespace ESMTerrain
         // Second iteration - create and fill in the blend maps
         const int blendmapSize = (realTextureSize-1) * chunkSize + 1;
 
+        GLenum format = pack ? GL_RGBA : GL_ALPHA;
+
         for (int i=0; i<numBlendmaps; ++i)
         {
-            GLenum format = pack ? GL_RGBA : GL_ALPHA;
-
             osg::ref_ptr<osg::Image> image (new osg::Image);
             image->allocateImage(blendmapSize, blendmapSize, 1, format, GL_UNSIGNED_BYTE);
-            unsigned char* pData = image->data();
+            memset(image->data(), 0, image->getTotalDataSize());
+            blendmaps.push_back(image);
+        }
+
+        // Every texel belongs to exactly one layer, so fill all blend maps in one sweep
+        // instead of revisiting every texel for each blend map.
+        for (int y=0; y<blendmapSize; ++y)
+        {
+            for (int x=0; x<blendmapSize; ++x)
+            {
+                UniqueTextureId id = getVtexIndexAt(cellX, cellY, x+rowStart, y+colStart, cache);
+                assert(textureIndicesMap.find(id) != textureIndicesMap.end());
+                int layerIndex = textureIndicesMap.find(id)->second;
+                if (layerIndex == 0)
+                    continue; // base layer doesn't need blending
+
+                int blendIndex = pack ? (layerIndex - 1) / 4 : layerIndex - 1;
+                int channel = pack ? (layerIndex - 1) % 4 : 0;
+
+                unsigned char* pData = blendmaps[blendIndex]->data();
+                pData[(blendmapSize - y - 1)*blendmapSize*channels + x*channels + channel] = 255;
+            }
+        }
+    }
 
-            for (int y=0; y<blendmapSize; ++y)
+    namespace
+    {
+        // FNV-1a, which unlike std::hash is guaranteed to give the same result across sessions and platforms
+        void hashData(unsigned long long& hash, const void* data, size_t size)
+        {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            for (size_t i=0; i<size; ++i)
             {
-                for (int x=0; x<blendmapSize; ++x)
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+        }
+    }
+
+    bool Storage::getTextureHash(float chunkSize, const osg::Vec2f &chunkCenter, unsigned long long &hash)
+    {
+        osg::Vec2f origin = chunkCenter - osg::Vec2f(chunkSize/2.f, chunkSize/2.f);
+        int cellX = static_cast<int>(std::floor(origin.x()));
+        int cellY = static_cast<int>(std::floor(origin.y()));
+
+        int realTextureSize = ESM::Land::LAND_TEXTURE_SIZE+1; // add 1 to wrap around next cell
+
+        // Same texel range as getBlendmaps
+        int rowStart = (origin.x() - cellX) * realTextureSize;
+        int colStart = (origin.y() - cellY) * realTextureSize;
+        int rowEnd = rowStart + chunkSize * (realTextureSize-1) + 1;
+        int colEnd = colStart + chunkSize * (realTextureSize-1) + 1;
+
+        hash = 14695981039346656037ull;
+
+        LandCache cache;
+        std::map<UniqueTextureId, int> textureIndices;
+
+        for (int y=colStart; y<colEnd; ++y)
+            for (int x=rowStart; x<rowEnd; ++x)
+            {
+                UniqueTextureId id = getVtexIndexAt(cellX, cellY, x, y, cache);
+                std::map<UniqueTextureId, int>::iterator found = textureIndices.find(id);
+                if (found == textureIndices.end())
                 {
-                    UniqueTextureId id = getVtexIndexAt(cellX, cellY, x+rowStart, y+colStart, cache);
-                    assert(textureIndicesMap.find(id) != textureIndicesMap.end());
-                    int layerIndex = textureIndicesMap.find(id)->second;
-                    int blendIndex = (pack ? static_cast<int>(std::floor((layerIndex - 1) / 4.f)) : layerIndex - 1);
-                    int channel = pack ? std::max(0, (layerIndex-1) % 4) : 0;
-
-                    if (blendIndex == i)
-                        pData[(blendmapSize - y - 1)*blendmapSize*channels + x*channels + channel] = 255;
-                    else
-                        pData[(blendmapSize - y - 1)*blendmapSize*channels + x*channels + channel] = 0;
+                    // Texture names, rather than indices, identify the texture across content file changes
+                    int index = textureIndices.size();
+                    found = textureIndices.insert(std::make_pair(id, index)).first;
+                    std::string name = getTextureName(id);
+                    hashData(hash, name.c_str(), name.size()+1);
                 }
+                hashData(hash, &found->second, sizeof(int));
             }
 
-            blendmaps.push_back(image);
-        }
+        return true;
     }
 
     float Storage::getHeightAt(const osg::Vec3f &worldPos)
@@ -92,6 +92,10 @@ namespace ESMTerrain
                            ImageVector& blendmaps,
                            std::vector<Terrain::LayerInfo>& layerList);
 
+        /// Compute a hash of the texture indices and texture names used by a terrain chunk.
+        /// @note May be called from background threads.
+        virtual bool getTextureHash (float chunkSize, const osg::Vec2f& chunkCenter, unsigned long long& hash);
+
         virtual float getHeightAt (const osg::Vec3f& worldPos);
 
         virtual Terrain::LayerInfo getDefaultLayer();
@@ -0,0 +1,178 @@
+#ifndef MISC_SLOTMAP_H
+#define MISC_SLOTMAP_H
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace Misc
+{
+    /// \brief Handle to an element of a SlotMap
+    ///
+    /// Stays valid until the element is erased. Afterwards, the SlotMap does not find the element by the handle
+    /// anymore, even when the slot has been reused for another element. A default constructed handle is invalid.
+    struct SlotHandle
+    {
+        SlotHandle() : mIndex(0), mGeneration(0) {}
+
+        unsigned int mIndex;
+        unsigned int mGeneration; ///< 0 for invalid handles
+
+        bool isValid() const { return mGeneration != 0; }
+
+        bool operator==(const SlotHandle& other) const
+        {
+            return mIndex == other.mIndex && mGeneration == other.mGeneration;
+        }
+
+        bool operator!=(const SlotHandle& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    /// \brief Container that gives out stable handles to its elements, for lookups by array indexing
+    ///
+    /// The elements are kept in a dense array, so iterating over them is as fast as over a std::vector. Handles
+    /// refer to slots, which in turn refer to the position of the element in the dense array. Erasing an element
+    /// moves the last element into its position; this changes the order of the elements and invalidates
+    /// references to them, but not handles.
+    template <typename T>
+    class SlotMap
+    {
+        public:
+
+            SlotMap() : mFreeSlot(sNoSlot) {}
+
+            /// Add \a value, returning the handle to find it by.
+            SlotHandle insert(const T& value)
+            {
+                unsigned int index;
+                if (mFreeSlot != sNoSlot)
+                {
+                    index = mFreeSlot;
+                    mFreeSlot = mSlots[index].mPosition;
+                }
+                else
+                {
+                    index = static_cast<unsigned int>(mSlots.size());
+                    mSlots.push_back(Slot());
+                }
+
+                Slot& slot = mSlots[index];
+                slot.mPosition = static_cast<unsigned int>(mValues.size());
+                mValues.push_back(value);
+                mSlotOfValue.push_back(index);
+
+                SlotHandle handle;
+                handle.mIndex = index;
+                handle.mGeneration = slot.mGeneration;
+                return handle;
+            }
+
+            /// Get the element of \a handle, or NULL if it was erased.
+            T* find(const SlotHandle& handle)
+            {
+                return contains(handle) ? &mValues[mSlots[handle.mIndex].mPosition] : NULL;
+            }
+
+            const T* find(const SlotHandle& handle) const
+            {
+                return contains(handle) ? &mValues[mSlots[handle.mIndex].mPosition] : NULL;
+            }
+
+            bool contains(const SlotHandle& handle) const
+            {
+                return handle.mIndex < mSlots.size() && handle.mGeneration != 0
+                        && mSlots[handle.mIndex].mGeneration == handle.mGeneration;
+            }
+
+            /// Erase the element of \a handle.
+            /// @return Was the element found?
+            bool erase(const SlotHandle& handle)
+            {
+                if (!contains(handle))
+                    return false;
+
+                Slot& slot = mSlots[handle.mIndex];
+                const unsigned int position = slot.mPosition;
+                const unsigned int last = static_cast<unsigned int>(mValues.size()) - 1;
+                if (position != last)
+                {
+                    mValues[position] = mValues[last];
+                    mSlotOfValue[position] = mSlotOfValue[last];
+                    mSlots[mSlotOfValue[position]].mPosition = position;
+                }
+                mValues.pop_back();
+                mSlotOfValue.pop_back();
+
+                // skip 0 when wrapping around, as it marks invalid handles
+                if (++slot.mGeneration == 0)
+                    slot.mGeneration = 1;
+                slot.mPosition = mFreeSlot;
+                mFreeSlot = handle.mIndex;
+                return true;
+            }
+
+            /// Erase all elements. Handles given out before stay invalid.
+            void clear()
+            {
+                for (std::size_t i = 0; i < mSlotOfValue.size(); ++i)
+                {
+                    Slot& slot = mSlots[mSlotOfValue[i]];
+                    if (++slot.mGeneration == 0)
+                        slot.mGeneration = 1;
+                    slot.mPosition = mFreeSlot;
+                    mFreeSlot = mSlotOfValue[i];
+                }
+                mValues.clear();
+                mSlotOfValue.clear();
+            }
+
+            std::size_t size() const { return mValues.size(); }
+
+            bool empty() const { return mValues.empty(); }
+
+            /// Access the element at \a position of the dense array, for iterating over all elements.
+            /// @note Positions change when elements are erased.
+            T& operator[](std::size_t position)
+            {
+                assert(position < mValues.size());
+                return mValues[position];
+            }
+
+            const T& operator[](std::size_t position) const
+            {
+                assert(position < mValues.size());
+                return mValues[position];
+            }
+
+            /// Get the handle of the element at \a position of the dense array.
+            SlotHandle getHandle(std::size_t position) const
+            {
+                SlotHandle handle;
+                handle.mIndex = mSlotOfValue[position];
+                handle.mGeneration = mSlots[handle.mIndex].mGeneration;
+                return handle;
+            }
+
+        private:
+
+            static const unsigned int sNoSlot = ~0u;
+
+            struct Slot
+            {
+                Slot() : mPosition(0), mGeneration(1) {}
+
+                unsigned int mPosition; ///< in mValues, or the next free slot while the slot is free
+                unsigned int mGeneration;
+            };
+
+            std::vector<Slot> mSlots;
+            std::vector<T> mValues;
+            std::vector<unsigned int> mSlotOfValue; ///< parallel to mValues
+            unsigned int mFreeSlot;
+    };
+}
+
+#endif
@@ -249,6 +249,14 @@ namespace Resource
         node->accept(*shaderVisitor);
     }
 
+    void SceneManager::createInstancingShaders(osg::ref_ptr<osg::Node> node, int maxInstances)
+    {
+        osg::ref_ptr<Shader::ShaderVisitor> shaderVisitor(createShaderVisitor());
+        shaderVisitor->setForceShaders(true);
+        shaderVisitor->setInstancing(maxInstances);
+        node->accept(*shaderVisitor);
+    }
+
     void SceneManager::setClampLighting(bool clamp)
     {
         mClampLighting = clamp;
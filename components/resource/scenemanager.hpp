@@ -52,6 +52,10 @@ namespace Resource
         /// Re-create shaders for this node, need to call this if texture stages or vertex color mode have changed.
         void recreateShaders(osg::ref_ptr<osg::Node> node);
 
+        /// Add shaders to this node for drawing it with instanced draw calls, regardless of the force shaders setting.
+        /// @see ShaderVisitor::setInstancing
+        void createInstancingShaders(osg::ref_ptr<osg::Node> node, int maxInstances);
+
         /// @see ShaderVisitor::setForceShaders
         void setForceShaders(bool force);
         bool getForceShaders() const;
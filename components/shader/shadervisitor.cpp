@@ -44,6 +44,7 @@ namespace Shader
         , mAllowedToModifyStateSets(true)
         , mAutoUseNormalMaps(false)
         , mAutoUseSpecularMaps(false)
+        , mInstancing(0)
         , mShaderManager(shaderManager)
         , mImageManager(imageManager)
         , mDefaultVsTemplate(defaultVsTemplate)
@@ -295,6 +296,8 @@ namespace Shader
 
         defineMap["parallax"] = reqs.mNormalHeight ? "1" : "0";
 
+        defineMap["instancing"] = std::to_string(mInstancing);
+
         osg::ref_ptr<osg::Shader> vertexShader (mShaderManager.getShader(mDefaultVsTemplate, defineMap, osg::Shader::VERTEX));
         osg::ref_ptr<osg::Shader> fragmentShader (mShaderManager.getShader(mDefaultFsTemplate, defineMap, osg::Shader::FRAGMENT));
 
@@ -425,4 +428,9 @@ namespace Shader
         mSpecularMapPattern = pattern;
     }
 
+    void ShaderVisitor::setInstancing(int maxInstances)
+    {
+        mInstancing = maxInstances;
+    }
+
 }
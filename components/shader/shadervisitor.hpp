@@ -45,6 +45,10 @@ namespace Shader
 
         void setSpecularMapPattern(const std::string& pattern);
 
+        /// Create shaders for geometry drawn with instanced draw calls of up to \a maxInstances instances. The transform of each
+        /// instance is taken from the "instanceTransforms" uniform array, see objects_vertex.glsl. 0 (default) for regular geometry.
+        void setInstancing(int maxInstances);
+
         virtual void apply(osg::Node& node);
 
         virtual void apply(osg::Drawable& drawable);
@@ -68,6 +72,8 @@ namespace Shader
         bool mAutoUseSpecularMaps;
         std::string mSpecularMapPattern;
 
+        int mInstancing;
+
         ShaderManager& mShaderManager;
         Resource::ImageManager& mImageManager;
 
@@ -17,6 +17,7 @@
 #include "storage.hpp"
 #include "texturemanager.hpp"
 #include "compositemaprenderer.hpp"
+#include "compositemapcache.hpp"
 
 namespace Terrain
 {
@@ -27,8 +28,10 @@ ChunkManager::ChunkManager(Storage *storage, Resource::SceneManager *sceneMgr, T
     , mSceneManager(sceneMgr)
     , mTextureManager(textureManager)
     , mCompositeMapRenderer(renderer)
+    , mVertexPool(new VertexPool)
     , mCompositeMapSize(512)
     , mCullingActive(true)
+    , mPackBlendmaps(false)
 {
 
 }
@@ -53,6 +56,7 @@ osg::ref_ptr<osg::Node> ChunkManager::getChunk(float size, const osg::Vec2f &cen
 void ChunkManager::reportStats(unsigned int frameNumber, osg::Stats *stats) const
 {
     stats->setAttribute(frameNumber, "Terrain Chunk", mCache->getCacheSize());
+    stats->setAttribute(frameNumber, "Terrain Pool", mVertexPool->getNumFreeArrays());
 }
 
 void ChunkManager::clearCache()
@@ -60,12 +64,14 @@ void ChunkManager::clearCache()
     ResourceManager::clearCache();
 
     mBufferCache.clearCache();
+    mVertexPool->clearCache();
 }
 
 void ChunkManager::releaseGLObjects(osg::State *state)
 {
     ResourceManager::releaseGLObjects(state);
     mBufferCache.releaseGLObjects(state);
+    mVertexPool->releaseGLObjects(state);
 }
 
 void ChunkManager::setCullingActive(bool active)
@@ -73,6 +79,27 @@ void ChunkManager::setCullingActive(bool active)
     mCullingActive = active;
 }
 
+void ChunkManager::setPackBlendmaps(bool pack)
+{
+    mPackBlendmaps = pack;
+}
+
+void ChunkManager::setCompositeMapCache(CompositeMapCache *cache)
+{
+    mCompositeMapCache = cache;
+}
+
+std::string ChunkManager::getCompositeMapCacheKey(float chunkSize, const osg::Vec2f &chunkCenter)
+{
+    unsigned long long hash;
+    if (!mStorage->getTextureHash(chunkSize, chunkCenter, hash))
+        return std::string();
+
+    std::ostringstream stream;
+    stream << chunkSize << "_" << chunkCenter.x() << "_" << chunkCenter.y() << "_" << mCompositeMapSize << "_" << std::hex << hash;
+    return stream.str();
+}
+
 osg::ref_ptr<osg::Texture2D> ChunkManager::createCompositeMapRTT()
 {
     osg::ref_ptr<osg::Texture2D> texture = new osg::Texture2D;
@@ -120,14 +147,17 @@ void ChunkManager::createCompositeMapGeometry(float chunkSize, const osg::Vec2f&
 
 std::vector<osg::ref_ptr<osg::StateSet> > ChunkManager::createPasses(float chunkSize, const osg::Vec2f &chunkCenter, bool forCompositeMap)
 {
-    std::vector<LayerInfo> layerList;
-    std::vector<osg::ref_ptr<osg::Image> > blendmaps;
-    mStorage->getBlendmaps(chunkSize, chunkCenter, false, blendmaps, layerList);
-
     bool useShaders = mSceneManager->getForceShaders();
     if (!mSceneManager->getClampLighting())
         useShaders = true; // always use shaders when lighting is unclamped, this is to avoid lighting seams between a terrain chunk with normal maps and one without normal maps
 
+    // Packed blendmaps can only be used by shaders, so only pack when we already know shaders will be used
+    bool pack = mPackBlendmaps && useShaders && !forCompositeMap;
+
+    std::vector<LayerInfo> layerList;
+    std::vector<osg::ref_ptr<osg::Image> > blendmaps;
+    mStorage->getBlendmaps(chunkSize, chunkCenter, pack, blendmaps, layerList);
+
     std::vector<TextureLayer> layers;
     {
         for (std::vector<LayerInfo>::const_iterator it = layerList.begin(); it != layerList.end(); ++it)
@@ -165,7 +195,7 @@ std::vector<osg::ref_ptr<osg::StateSet> > ChunkManager::createPasses(float chunk
     float blendmapScale = mStorage->getBlendmapScale(chunkSize);
 
     return ::Terrain::createPasses(useShaders, mSceneManager->getForcePerPixelLighting(),
-                                     mSceneManager->getClampLighting(), &mSceneManager->getShaderManager(), layers, blendmapTextures, blendmapScale, blendmapScale);
+                                     mSceneManager->getClampLighting(), &mSceneManager->getShaderManager(), layers, blendmapTextures, blendmapScale, blendmapScale, pack);
 }
 
 osg::ref_ptr<osg::Node> ChunkManager::createChunk(float chunkSize, const osg::Vec2f &chunkCenter, int lod, unsigned int lodFlags)
@@ -174,18 +204,22 @@ osg::ref_ptr<osg::Node> ChunkManager::createChunk(float chunkSize, const osg::Ve
     osg::ref_ptr<SceneUtil::PositionAttitudeTransform> transform (new SceneUtil::PositionAttitudeTransform);
     transform->setPosition(osg::Vec3f(worldCenter.x(), worldCenter.y(), 0.f));
 
-    osg::ref_ptr<osg::Vec3Array> positions (new osg::Vec3Array);
-    osg::ref_ptr<osg::Vec3Array> normals (new osg::Vec3Array);
-    osg::ref_ptr<osg::Vec4Array> colors (new osg::Vec4Array);
+    unsigned int numVerts = (mStorage->getCellVertices()-1) * chunkSize / (1 << lod) + 1;
 
-    osg::ref_ptr<osg::VertexBufferObject> vbo (new osg::VertexBufferObject);
-    positions->setVertexBufferObject(vbo);
-    normals->setVertexBufferObject(vbo);
-    colors->setVertexBufferObject(vbo);
+    VertexPool::VertexArrays arrays = mVertexPool->acquire(numVerts);
+    osg::ref_ptr<osg::Vec3Array> positions = arrays.mPositions;
+    osg::ref_ptr<osg::Vec3Array> normals = arrays.mNormals;
+    osg::ref_ptr<osg::Vec4Array> colors = arrays.mColours;
 
     mStorage->fillVertexBuffers(lod, chunkSize, chunkCenter, positions, normals, colors);
 
+    // Recycled arrays may already have been uploaded for a previous chunk
+    positions->dirty();
+    normals->dirty();
+    colors->dirty();
+
     osg::ref_ptr<TerrainDrawable> geometry (new TerrainDrawable);
+    geometry->setVertexPool(mVertexPool);
     geometry->setVertexArray(positions);
     geometry->setNormalArray(normals, osg::Array::BIND_PER_VERTEX);
     geometry->setColorArray(colors, osg::Array::BIND_PER_VERTEX);
@@ -195,8 +229,6 @@ osg::ref_ptr<osg::Node> ChunkManager::createChunk(float chunkSize, const osg::Ve
     if (chunkSize <= 2.f)
         geometry->setLightListCallback(new SceneUtil::LightListCallback);
 
-    unsigned int numVerts = (mStorage->getCellVertices()-1) * chunkSize / (1 << lod) + 1;
-
     geometry->addPrimitiveSet(mBufferCache.getIndexBuffer(numVerts, lodFlags));
 
     bool useCompositeMap = chunkSize >= 1.f;
@@ -210,9 +242,29 @@ osg::ref_ptr<osg::Node> ChunkManager::createChunk(float chunkSize, const osg::Ve
         osg::ref_ptr<CompositeMap> compositeMap = new CompositeMap;
         compositeMap->mTexture = createCompositeMapRTT();
 
-        createCompositeMapGeometry(chunkSize, chunkCenter, osg::Vec4f(0,0,1,1), *compositeMap);
+        std::string cacheKey;
+        osg::ref_ptr<osg::Image> cachedImage;
+        if (mCompositeMapCache)
+        {
+            cacheKey = getCompositeMapCacheKey(chunkSize, chunkCenter);
+            if (!cacheKey.empty())
+                cachedImage = mCompositeMapCache->load(cacheKey);
+        }
 
-        mCompositeMapRenderer->addCompositeMap(compositeMap.get(), false);
+        if (cachedImage)
+            compositeMap->mTexture->setImage(cachedImage);
+        else
+        {
+            createCompositeMapGeometry(chunkSize, chunkCenter, osg::Vec4f(0,0,1,1), *compositeMap);
+
+            if (!cacheKey.empty())
+            {
+                compositeMap->mCache = mCompositeMapCache;
+                compositeMap->mCacheKey = cacheKey;
+            }
+
+            mCompositeMapRenderer->addCompositeMap(compositeMap.get(), false);
+        }
 
         transform->getOrCreateUserDataContainer()->setUserData(compositeMap);
 
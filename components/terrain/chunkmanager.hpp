@@ -4,6 +4,7 @@
 #include <components/resource/resourcemanager.hpp>
 
 #include "buffercache.hpp"
+#include "vertexpool.hpp"
 
 namespace osg
 {
@@ -23,6 +24,7 @@ namespace Terrain
     class CompositeMapRenderer;
     class Storage;
     class CompositeMap;
+    class CompositeMapCache;
 
     /// @brief Handles loading and caching of terrain chunks
     class ChunkManager : public Resource::ResourceManager
@@ -40,6 +42,12 @@ namespace Terrain
 
         void setCullingActive(bool active);
 
+        /// Pack the blend values of up to 4 layers into one blendmap, so that shaders can render several layers in one pass.
+        void setPackBlendmaps(bool pack);
+
+        /// Load composite maps from, and store newly rendered composite maps in the given cache.
+        void setCompositeMapCache(CompositeMapCache* cache);
+
     private:
         osg::ref_ptr<osg::Node> createChunk(float size, const osg::Vec2f& center, int lod, unsigned int lodFlags);
 
@@ -49,15 +57,22 @@ namespace Terrain
 
         std::vector<osg::ref_ptr<osg::StateSet> > createPasses(float chunkSize, const osg::Vec2f& chunkCenter, bool forCompositeMap);
 
+        /// @return An empty string if the composite map for this chunk can't be cached.
+        std::string getCompositeMapCacheKey(float chunkSize, const osg::Vec2f& chunkCenter);
+
         Terrain::Storage* mStorage;
         Resource::SceneManager* mSceneManager;
         TextureManager* mTextureManager;
         CompositeMapRenderer* mCompositeMapRenderer;
+        osg::ref_ptr<CompositeMapCache> mCompositeMapCache;
         BufferCache mBufferCache;
+        osg::ref_ptr<VertexPool> mVertexPool;
 
         unsigned int mCompositeMapSize;
 
         bool mCullingActive;
+
+        bool mPackBlendmaps;
     };
 
 }
@@ -0,0 +1,106 @@
+#include "compositemapcache.hpp"
+
+#include <iostream>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <osg/Image>
+
+#include <osgDB/Registry>
+
+#include <components/sceneutil/workqueue.hpp>
+
+namespace
+{
+
+    class WriteCompositeMapItem : public SceneUtil::WorkItem
+    {
+    public:
+        WriteCompositeMapItem(const boost::filesystem::path& path, osg::ref_ptr<osg::Image> image)
+            : mPath(path)
+            , mImage(image)
+        {
+        }
+
+        virtual void doWork()
+        {
+            osgDB::ReaderWriter* readerwriter = osgDB::Registry::instance()->getReaderWriterForExtension("png");
+            if (!readerwriter)
+            {
+                std::cerr << "Error: Can't write composite map: no png readerwriter found" << std::endl;
+                return;
+            }
+
+            try
+            {
+                boost::filesystem::create_directories(mPath.parent_path());
+
+                // Write to a temporary file first, so that a loading thread never sees a partially written image
+                boost::filesystem::path tempPath = mPath;
+                tempPath += ".tmp";
+                {
+                    boost::filesystem::ofstream stream (tempPath, std::ios::binary);
+                    osgDB::ReaderWriter::WriteResult result = readerwriter->writeImage(*mImage, stream);
+                    if (!result.success())
+                    {
+                        std::cerr << "Error: Can't write composite map: " << result.message() << " code " << result.status() << std::endl;
+                        return;
+                    }
+                }
+                boost::filesystem::rename(tempPath, mPath);
+            }
+            catch (std::exception& e)
+            {
+                std::cerr << "Error: Can't write composite map " << mPath.string() << ": " << e.what() << std::endl;
+            }
+        }
+
+    private:
+        boost::filesystem::path mPath;
+        osg::ref_ptr<osg::Image> mImage;
+    };
+
+}
+
+namespace Terrain
+{
+
+CompositeMapCache::CompositeMapCache(const std::string &path, SceneUtil::WorkQueue *workQueue)
+    : mPath(path)
+    , mWorkQueue(workQueue)
+{
+}
+
+osg::ref_ptr<osg::Image> CompositeMapCache::load(const std::string &key) const
+{
+    boost::filesystem::path path = mPath / (key + ".png");
+
+    boost::system::error_code ec;
+    if (!boost::filesystem::exists(path, ec))
+        return NULL;
+
+    osgDB::ReaderWriter* readerwriter = osgDB::Registry::instance()->getReaderWriterForExtension("png");
+    if (!readerwriter)
+        return NULL;
+
+    boost::filesystem::ifstream stream (path, std::ios::binary);
+    if (!stream.is_open())
+        return NULL;
+
+    osgDB::ReaderWriter::ReadResult result = readerwriter->readImage(stream);
+    if (!result.success())
+    {
+        std::cerr << "Error: Failed to read cached composite map " << path.string() << ": " << result.message() << std::endl;
+        return NULL;
+    }
+
+    return result.getImage();
+}
+
+void CompositeMapCache::store(const std::string &key, osg::ref_ptr<osg::Image> image)
+{
+    mWorkQueue->addWorkItem(new WriteCompositeMapItem(mPath / (key + ".png"), image));
+}
+
+}
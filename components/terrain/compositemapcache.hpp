@@ -0,0 +1,50 @@
+#ifndef OPENMW_COMPONENTS_TERRAIN_COMPOSITEMAPCACHE_H
+#define OPENMW_COMPONENTS_TERRAIN_COMPOSITEMAPCACHE_H
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+
+#include <boost/filesystem/path.hpp>
+
+#include <string>
+
+namespace osg
+{
+    class Image;
+}
+
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
+namespace Terrain
+{
+
+    /**
+     * @brief Stores rendered composite maps on disk, so they don't have to be rendered again in later sessions.
+     * @note Thread safe.
+     */
+    class CompositeMapCache : public osg::Referenced
+    {
+    public:
+        /// @param path Directory to keep the cached composite maps in. Created on demand.
+        /// @param workQueue Queue used for writing composite maps in the background.
+        CompositeMapCache(const std::string& path, SceneUtil::WorkQueue* workQueue);
+
+        /// Load the composite map stored under the given key.
+        /// @return NULL if there is no valid composite map for this key.
+        osg::ref_ptr<osg::Image> load(const std::string& key) const;
+
+        /// Compress and write the given composite map to disk in the background.
+        void store(const std::string& key, osg::ref_ptr<osg::Image> image);
+
+    private:
+        boost::filesystem::path mPath;
+
+        osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+    };
+
+}
+
+#endif
@@ -5,6 +5,9 @@
 #include <osg/FrameBufferObject>
 #include <osg/Texture2D>
 #include <osg/RenderInfo>
+#include <osg/Image>
+
+#include "compositemapcache.hpp"
 
 namespace Terrain
 {
@@ -76,7 +79,7 @@ void CompositeMapRenderer::compile(CompositeMap &compositeMap, osg::RenderInfo &
 
     osg::FrameBufferAttachment attach (compositeMap.mTexture);
     mFBO->setAttachment(osg::Camera::COLOR_BUFFER, attach);
-    mFBO->apply(state, osg::FrameBufferObject::DRAW_FRAMEBUFFER);
+    mFBO->apply(state, osg::FrameBufferObject::READ_DRAW_FRAMEBUFFER);
 
     GLenum status = ext->glCheckFramebufferStatus(GL_FRAMEBUFFER_EXT);
 
@@ -120,6 +123,16 @@ void CompositeMapRenderer::compile(CompositeMap &compositeMap, osg::RenderInfo &
         }
     }
 
+    if (compositeMap.mCache && compositeMap.mCompiled >= compositeMap.mDrawables.size())
+    {
+        // Read back the finished composite map, so we don't have to render it again next session.
+        // This stalls the pipeline, but only happens once per composite map.
+        osg::ref_ptr<osg::Image> image (new osg::Image);
+        image->readPixels(0, 0, compositeMap.mTexture->getTextureWidth(), compositeMap.mTexture->getTextureHeight(), GL_RGB, GL_UNSIGNED_BYTE);
+        compositeMap.mCache->store(compositeMap.mCacheKey, image);
+        compositeMap.mCache = NULL;
+    }
+
     state.haveAppliedAttribute(osg::StateAttribute::VIEWPORT);
 
     GLuint fboId = state.getGraphicsContext() ? state.getGraphicsContext()->getDefaultFboId() : 0;
@@ -6,6 +6,7 @@
 #include <OpenThreads/Mutex>
 
 #include <set>
+#include <string>
 
 namespace osg
 {
@@ -17,6 +18,8 @@ namespace osg
 namespace Terrain
 {
 
+    class CompositeMapCache;
+
     class CompositeMap : public osg::Referenced
     {
     public:
@@ -25,6 +28,10 @@ namespace Terrain
         std::vector<osg::ref_ptr<osg::Drawable> > mDrawables;
         osg::ref_ptr<osg::Texture2D> mTexture;
         unsigned int mCompiled;
+
+        /// If set, the composite map will be read back and stored in this cache once it is fully rendered
+        osg::ref_ptr<CompositeMapCache> mCache;
+        std::string mCacheKey;
     };
 
     /**
@@ -1,6 +1,7 @@
 #include "material.hpp"
 
 #include <stdexcept>
+#include <sstream>
 
 #include <osg/Depth>
 #include <osg/TexEnvCombine>
@@ -57,16 +58,60 @@ namespace Terrain
         return depth;
     }
 
+    std::vector<osg::ref_ptr<osg::Texture2D> > unpackBlendmaps(const std::vector<osg::ref_ptr<osg::Texture2D> > &blendmaps, unsigned int numLayers)
+    {
+        std::vector<osg::ref_ptr<osg::Texture2D> > unpacked;
+        for (unsigned int layer=1; layer<numLayers; ++layer)
+        {
+            const osg::Image* packedImage = blendmaps.at((layer-1)/4)->getImage();
+            unsigned int channel = (layer-1)%4;
+
+            osg::ref_ptr<osg::Image> image (new osg::Image);
+            image->allocateImage(packedImage->s(), packedImage->t(), 1, GL_ALPHA, GL_UNSIGNED_BYTE);
+            const unsigned char* src = packedImage->data();
+            unsigned char* dest = image->data();
+            unsigned int numTexels = packedImage->s() * packedImage->t();
+            for (unsigned int i=0; i<numTexels; ++i)
+                dest[i] = src[i*4 + channel];
+
+            osg::ref_ptr<osg::Texture2D> texture (new osg::Texture2D(image));
+            texture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+            texture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+            texture->setResizeNonPowerOfTwoHint(false);
+            unpacked.push_back(texture);
+        }
+        return unpacked;
+    }
+
+    bool canBatchLayer(const TextureLayer& layer)
+    {
+        return !layer.mNormalMap && !layer.mSpecular;
+    }
+
     std::vector<osg::ref_ptr<osg::StateSet> > createPasses(bool useShaders, bool forcePerPixelLighting, bool clampLighting, Shader::ShaderManager* shaderManager, const std::vector<TextureLayer> &layers,
-                                                           const std::vector<osg::ref_ptr<osg::Texture2D> > &blendmaps, int blendmapScale, float layerTileSize)
+                                                           const std::vector<osg::ref_ptr<osg::Texture2D> > &blendmaps, int blendmapScale, float layerTileSize, bool packedBlendmaps)
     {
+        if (packedBlendmaps && !useShaders)
+            return createPasses(false, forcePerPixelLighting, clampLighting, shaderManager, layers, unpackBlendmaps(blendmaps, layers.size()), blendmapScale, layerTileSize, false);
+
         std::vector<osg::ref_ptr<osg::StateSet> > passes;
 
         bool firstLayer = true;
-        unsigned int blendmapIndex = 0;
         unsigned int passIndex = 0;
         for (std::vector<TextureLayer>::const_iterator it = layers.begin(); it != layers.end(); ++it)
         {
+            unsigned int layerIndex = it - layers.begin();
+
+            // With packed blendmaps, consecutive layers without normal or specular maps that share a blendmap are rendered in one pass.
+            unsigned int batchSize = 1;
+            if (useShaders && packedBlendmaps && canBatchLayer(*it))
+            {
+                unsigned int group = firstLayer ? 0 : (layerIndex-1)/4;
+                while (layerIndex + batchSize < layers.size() && (layerIndex + batchSize - 1)/4 == group
+                       && canBatchLayer(layers[layerIndex + batchSize]))
+                    ++batchSize;
+            }
+
             osg::ref_ptr<osg::StateSet> stateset (new osg::StateSet);
 
             if (!firstLayer)
@@ -77,7 +122,60 @@ namespace Terrain
 
             int texunit = 0;
 
-            if (useShaders)
+            if (batchSize > 1)
+            {
+                stateset->setTextureAttributeAndModes(texunit, it->mDiffuseMap);
+
+                if (layerTileSize != 1.f)
+                    stateset->setTextureAttributeAndModes(texunit, getLayerTexMat(layerTileSize), osg::StateAttribute::ON);
+
+                stateset->addUniform(new osg::Uniform("diffuseMap0", texunit));
+
+                ++texunit;
+                stateset->setTextureAttributeAndModes(texunit, blendmaps.at(firstLayer ? 0 : (layerIndex-1)/4).get());
+                stateset->setTextureAttributeAndModes(texunit, getBlendmapTexMat(blendmapScale));
+                stateset->addUniform(new osg::Uniform("blendMap", texunit));
+
+                for (unsigned int i=1; i<batchSize; ++i)
+                {
+                    ++texunit;
+                    stateset->setTextureAttributeAndModes(texunit, layers[layerIndex+i].mDiffuseMap);
+
+                    std::ostringstream uniformName;
+                    uniformName << "diffuseMap" << i;
+                    stateset->addUniform(new osg::Uniform(uniformName.str().c_str(), texunit));
+                }
+
+                std::ostringstream numLayers;
+                numLayers << batchSize;
+
+                // The batch may start in the middle of a packed blendmap, so rotate its channels to line up with the layers
+                std::string blendMapChannels;
+                for (unsigned int i=0; i<4; ++i)
+                    blendMapChannels += "rgba"[(firstLayer ? i : layerIndex-1+i) % 4];
+
+                Shader::ShaderManager::DefineMap defineMap;
+                defineMap["forcePPL"] = forcePerPixelLighting ? "1" : "0";
+                defineMap["clamp"] = clampLighting ? "1" : "0";
+                defineMap["normalMap"] = "0";
+                defineMap["colorMode"] = "2";
+                defineMap["numLayers"] = numLayers.str();
+                defineMap["baseLayer"] = firstLayer ? "1" : "0";
+                defineMap["blendMapChannels"] = blendMapChannels;
+
+                osg::ref_ptr<osg::Shader> vertexShader = shaderManager->getShader("terrain_vertex.glsl", defineMap, osg::Shader::VERTEX);
+                osg::ref_ptr<osg::Shader> fragmentShader = shaderManager->getShader("terrain_batch_fragment.glsl", defineMap, osg::Shader::FRAGMENT);
+                if (!vertexShader || !fragmentShader)
+                {
+                    // Try again without shader. Error already logged by above
+                    return createPasses(false, forcePerPixelLighting, clampLighting, shaderManager, layers, blendmaps, blendmapScale, layerTileSize, packedBlendmaps);
+                }
+
+                stateset->setAttributeAndModes(shaderManager->getProgram(vertexShader, fragmentShader));
+
+                it += batchSize-1;
+            }
+            else if (useShaders)
             {
                 stateset->setTextureAttributeAndModes(texunit, it->mDiffuseMap);
 
@@ -89,7 +187,7 @@ namespace Terrain
                 if(!firstLayer)
                 {
                     ++texunit;
-                    osg::ref_ptr<osg::Texture2D> blendmap = blendmaps.at(blendmapIndex++);
+                    osg::ref_ptr<osg::Texture2D> blendmap = blendmaps.at(packedBlendmaps ? (layerIndex-1)/4 : layerIndex-1);
 
                     stateset->setTextureAttributeAndModes(texunit, blendmap.get());
 
@@ -109,6 +207,7 @@ namespace Terrain
                 defineMap["clamp"] = clampLighting ? "1" : "0";
                 defineMap["normalMap"] = (it->mNormalMap) ? "1" : "0";
                 defineMap["blendMap"] = !firstLayer ? "1" : "0";
+                defineMap["blendMapChannel"] = packedBlendmaps && !firstLayer ? std::string(1, "rgba"[(layerIndex-1)%4]) : "a";
                 defineMap["colorMode"] = "2";
                 defineMap["specularMap"] = it->mSpecular ? "1" : "0";
                 defineMap["parallax"] = (it->mNormalMap && it->mParallax) ? "1" : "0";
@@ -118,7 +217,7 @@ namespace Terrain
                 if (!vertexShader || !fragmentShader)
                 {
                     // Try again without shader. Error already logged by above
-                    return createPasses(false, forcePerPixelLighting, clampLighting, shaderManager, layers, blendmaps, blendmapScale, layerTileSize);
+                    return createPasses(false, forcePerPixelLighting, clampLighting, shaderManager, layers, blendmaps, blendmapScale, layerTileSize, packedBlendmaps);
                 }
 
                 stateset->setAttributeAndModes(shaderManager->getProgram(vertexShader, fragmentShader));
@@ -127,7 +226,7 @@ namespace Terrain
             {
                 if(!firstLayer)
                 {
-                    osg::ref_ptr<osg::Texture2D> blendmap = blendmaps.at(blendmapIndex++);
+                    osg::ref_ptr<osg::Texture2D> blendmap = blendmaps.at(layerIndex-1);
 
                     stateset->setTextureAttributeAndModes(texunit, blendmap.get());
 
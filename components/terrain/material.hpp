@@ -26,9 +26,12 @@ namespace Terrain
         bool mSpecular;
     };
 
+    /// @param packedBlendmaps Whether the blend values of up to 4 layers are packed into the channels of each blendmap.
+    ///        Layers sharing a packed blendmap are then rendered in a single pass where possible.
     std::vector<osg::ref_ptr<osg::StateSet> > createPasses(bool useShaders, bool forcePerPixelLighting, bool clampLighting, Shader::ShaderManager* shaderManager,
                                                            const std::vector<TextureLayer>& layers,
-                                                           const std::vector<osg::ref_ptr<osg::Texture2D> >& blendmaps, int blendmapScale, float layerTileSize);
+                                                           const std::vector<osg::ref_ptr<osg::Texture2D> >& blendmaps, int blendmapScale, float layerTileSize,
+                                                           bool packedBlendmaps = false);
 
 }
 
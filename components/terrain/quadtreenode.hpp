@@ -24,6 +24,14 @@ namespace Terrain
         virtual ~LodCallback() {}
 
         virtual bool isSufficientDetail(QuadTreeNode *node, const osg::Vec3f& eyePoint) = 0;
+
+        /// Like isSufficientDetail, but also reports how far the eye point can move before the result might change.
+        /// @param stableDistance The distance will be written here.
+        virtual bool isSufficientDetail(QuadTreeNode *node, const osg::Vec3f& eyePoint, float& stableDistance)
+        {
+            stableDistance = 0.f;
+            return isSufficientDetail(node, eyePoint);
+        }
     };
 
     class ViewDataMap;
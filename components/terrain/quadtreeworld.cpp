@@ -1,8 +1,12 @@
 #include "quadtreeworld.hpp"
 
+#include <OpenThreads/ScopedLock>
+
 #include <osgUtil/CullVisitor>
 
 #include <sstream>
+#include <limits>
+#include <cmath>
 
 #include "quadtreenode.hpp"
 #include "storage.hpp"
@@ -78,11 +82,27 @@ public:
     }
 
     virtual bool isSufficientDetail(QuadTreeNode* node, const osg::Vec3f& eyePoint)
+    {
+        float stableDistance;
+        return isSufficientDetail(node, eyePoint, stableDistance);
+    }
+
+    virtual bool isSufficientDetail(QuadTreeNode* node, const osg::Vec3f& eyePoint, float& stableDistance)
     {
         float dist = distanceToBox(node->getBoundingBox(), eyePoint);
         int nativeLodLevel = Log2(static_cast<unsigned int>(node->getSize()/mMinSize));
         int lodLevel = Log2(static_cast<unsigned int>(dist/(8192*mMinSize)));
 
+        if (nativeLodLevel == 0)
+            stableDistance = std::numeric_limits<float>::max(); // always sufficient
+        else
+        {
+            // The result flips where the distance crosses this threshold. The distance to a box changes
+            // at most as much as the eye point moves, so the result holds while the eye stays closer than that.
+            float threshold = (1 << nativeLodLevel) * 8192 * mMinSize;
+            stableDistance = std::abs(dist - threshold);
+        }
+
         return nativeLodLevel <= lodLevel;
     }
 
@@ -239,6 +259,7 @@ QuadTreeWorld::QuadTreeWorld(osg::Group *parent, osg::Group *compileRoot, Resour
     : World(parent, compileRoot, resourceSystem, storage, nodeMask, preCompileMask)
     , mViewDataMap(new ViewDataMap)
     , mQuadTreeBuilt(false)
+    , mNumTraversedNodes(0)
 {
     // No need for culling on the Drawable / Transform level as the quad tree performs the culling already.
     mChunkManager->setCullingActive(false);
@@ -251,23 +272,49 @@ QuadTreeWorld::~QuadTreeWorld()
 }
 
 
-void traverse(QuadTreeNode* node, ViewData* vd, osg::NodeVisitor* nv, LodCallback* lodCallback, const osg::Vec3f& eyePoint, bool visible)
+void traverse(QuadTreeNode* node, ViewData* vd, osg::NodeVisitor* nv, LodCallback* lodCallback, const osg::Vec3f& eyePoint, bool visible, float& stableDistance, unsigned int& numTraversed)
 {
     if (!node->hasValidBounds())
         return;
 
+    ++numTraversed;
+
     if (nv && nv->getVisitorType() == osg::NodeVisitor::CULL_VISITOR)
         visible = visible && !static_cast<osgUtil::CullVisitor*>(nv)->isCulled(node->getBoundingBox());
 
-    bool stopTraversal = (lodCallback && lodCallback->isSufficientDetail(node, eyePoint)) || !node->getNumChildren();
+    float nodeStableDistance = std::numeric_limits<float>::max();
+    bool stopTraversal = (lodCallback && lodCallback->isSufficientDetail(node, eyePoint, nodeStableDistance)) || !node->getNumChildren();
+    stableDistance = std::min(stableDistance, nodeStableDistance);
 
     if (stopTraversal)
         vd->add(node, visible);
     else
     {
         for (unsigned int i=0; i<node->getNumChildren(); ++i)
-            traverse(node->getChild(i), vd, nv, lodCallback, eyePoint, visible);
+            traverse(node->getChild(i), vd, nv, lodCallback, eyePoint, visible, stableDistance, numTraversed);
+    }
+}
+
+/// Select the nodes to render for this eye point. The LOD decisions of the previous traversal are reused for as long as
+/// no decision can have changed, in which case only the visibility of the selected nodes has to be updated.
+/// @return The number of nodes that had to be evaluated.
+unsigned int traverseLod(QuadTreeNode* rootNode, ViewData* vd, osg::NodeVisitor* nv, LodCallback* lodCallback, const osg::Vec3f& eyePoint, bool visible)
+{
+    osgUtil::CullVisitor* cv = (nv && nv->getVisitorType() == osg::NodeVisitor::CULL_VISITOR) ? static_cast<osgUtil::CullVisitor*>(nv) : NULL;
+
+    if (vd->getNumEntries() == 0 && vd->hasLodSelection(eyePoint))
+    {
+        const std::vector<QuadTreeNode*>& selection = vd->getLodSelection();
+        for (std::vector<QuadTreeNode*>::const_iterator it = selection.begin(); it != selection.end(); ++it)
+            vd->add(*it, visible && !(cv && cv->isCulled((*it)->getBoundingBox())));
+        return selection.size();
     }
+
+    float stableDistance = std::numeric_limits<float>::max();
+    unsigned int numTraversed = 0;
+    traverse(rootNode, vd, nv, lodCallback, eyePoint, visible, stableDistance, numTraversed);
+    vd->setLodSelection(eyePoint, stableDistance);
+    return numTraversed;
 }
 
 void traverseToCell(QuadTreeNode* node, ViewData* vd, int cellX, int cellY)
@@ -359,10 +406,16 @@ void QuadTreeWorld::accept(osg::NodeVisitor &nv)
             int x,y;
             stream >> x;
             stream >> y;
+            vd->clearLodSelection();
             traverseToCell(mRootNode.get(), vd, x,y);
         }
         else
-            traverse(mRootNode.get(), vd, cv, mRootNode->getLodCallback(), cv->getEyePoint(), true);
+        {
+            unsigned int numTraversed = traverseLod(mRootNode.get(), vd, cv, mRootNode->getLodCallback(), cv->getEyePoint(), true);
+
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mStatsMutex);
+            mNumTraversedNodes += numTraversed;
+        }
     }
     else
         mRootNode->traverse(nv);
@@ -423,6 +476,7 @@ void QuadTreeWorld::cacheCell(View *view, int x, int y)
 {
     ensureQuadTreeBuilt();
     ViewData* vd = static_cast<ViewData*>(view);
+    vd->clearLodSelection();
     traverseToCell(mRootNode.get(), vd, x, y);
 
     for (unsigned int i=0; i<vd->getNumEntries(); ++i)
@@ -442,7 +496,7 @@ void QuadTreeWorld::preload(View *view, const osg::Vec3f &eyePoint)
     ensureQuadTreeBuilt();
 
     ViewData* vd = static_cast<ViewData*>(view);
-    traverse(mRootNode.get(), vd, NULL, mRootNode->getLodCallback(), eyePoint, false);
+    traverseLod(mRootNode.get(), vd, NULL, mRootNode->getLodCallback(), eyePoint, false);
 
     for (unsigned int i=0; i<vd->getNumEntries(); ++i)
     {
@@ -454,6 +508,10 @@ void QuadTreeWorld::preload(View *view, const osg::Vec3f &eyePoint)
 void QuadTreeWorld::reportStats(unsigned int frameNumber, osg::Stats *stats)
 {
     stats->setAttribute(frameNumber, "Composite", mCompositeMapRenderer->getCompileSetSize());
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mStatsMutex);
+    stats->setAttribute(frameNumber, "Terrain Nodes", mNumTraversedNodes);
+    mNumTraversedNodes = 0;
 }
 
 void QuadTreeWorld::setDefaultViewer(osg::Object *obj)
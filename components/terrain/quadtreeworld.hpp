@@ -44,6 +44,10 @@ namespace Terrain
 
         OpenThreads::Mutex mQuadTreeMutex;
         bool mQuadTreeBuilt;
+
+        /// Number of quad tree nodes evaluated by culling traversals since the last reportStats
+        unsigned int mNumTraversedNodes;
+        OpenThreads::Mutex mStatsMutex;
     };
 
 }
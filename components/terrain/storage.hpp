@@ -70,6 +70,15 @@ namespace Terrain
                            ImageVector& blendmaps,
                            std::vector<LayerInfo>& layerList) = 0;
 
+        /// Compute a hash of all data that determines the layer textures and blending of a terrain chunk.
+        /// Used to detect whether a composite map stored in a previous session is still valid.
+        /// @note May be called from background threads.
+        /// @param chunkSize size of the terrain chunk in cell units
+        /// @param chunkCenter center of the chunk in cell units
+        /// @param hash the hash will be written here
+        /// @return false if this storage doesn't support hashing its texture data
+        virtual bool getTextureHash (float chunkSize, const osg::Vec2f& chunkCenter, unsigned long long& hash) { return false; }
+
         virtual float getHeightAt (const osg::Vec3f& worldPos) = 0;
 
         virtual LayerInfo getDefaultLayer() = 0;
@@ -4,6 +4,8 @@
 
 #include <components/sceneutil/lightmanager.hpp>
 
+#include "vertexpool.hpp"
+
 namespace Terrain
 {
 
@@ -15,8 +17,15 @@ TerrainDrawable::TerrainDrawable(const TerrainDrawable &copy, const osg::CopyOp
     : osg::Geometry(copy, copyop)
     , mPasses(copy.mPasses)
     , mLightListCallback(copy.mLightListCallback)
+    , mVertexPool(copy.mVertexPool)
 {
+}
 
+TerrainDrawable::~TerrainDrawable()
+{
+    if (mVertexPool)
+        mVertexPool->release(static_cast<osg::Vec3Array*>(getVertexArray()), static_cast<osg::Vec3Array*>(getNormalArray()),
+                             static_cast<osg::Vec4Array*>(getColorArray()));
 }
 
 void TerrainDrawable::accept(osg::NodeVisitor &nv)
@@ -74,6 +83,11 @@ void TerrainDrawable::setLightListCallback(SceneUtil::LightListCallback *lightLi
     mLightListCallback = lightListCallback;
 }
 
+void TerrainDrawable::setVertexPool(VertexPool *pool)
+{
+    mVertexPool = pool;
+}
+
 void TerrainDrawable::compileGLObjects(osg::RenderInfo &renderInfo) const
 {
     for (PassVector::const_iterator it = mPasses.begin(); it != mPasses.end(); ++it)
@@ -16,6 +16,8 @@ namespace SceneUtil
 namespace Terrain
 {
 
+    class VertexPool;
+
     /**
      * Subclass of Geometry that supports built in multi-pass rendering and built in LightListCallback.
      */
@@ -30,6 +32,7 @@ namespace Terrain
 
         TerrainDrawable();
         TerrainDrawable(const TerrainDrawable& copy, const osg::CopyOp& copyop);
+        ~TerrainDrawable();
 
         virtual void accept(osg::NodeVisitor &nv);
         void cull(osgUtil::CullVisitor* cv);
@@ -39,12 +42,17 @@ namespace Terrain
 
         void setLightListCallback(SceneUtil::LightListCallback* lightListCallback);
 
+        /// Hand the vertex, normal and colour arrays back to this pool when the drawable is destroyed.
+        void setVertexPool(VertexPool* pool);
+
         virtual void compileGLObjects(osg::RenderInfo& renderInfo) const;
 
     private:
         PassVector mPasses;
 
         osg::ref_ptr<SceneUtil::LightListCallback> mLightListCallback;
+
+        osg::ref_ptr<VertexPool> mVertexPool;
     };
 
 }
@@ -0,0 +1,95 @@
+#include "vertexpool.hpp"
+
+#include <OpenThreads/ScopedLock>
+
+namespace
+{
+    // Upper bound for the number of arrays kept around for each vertex count, to limit the memory used by idle arrays.
+    const unsigned int sMaxFreeArrays = 64;
+}
+
+namespace Terrain
+{
+
+VertexPool::VertexPool()
+    : mNumFreeArrays(0)
+{
+}
+
+VertexPool::VertexArrays VertexPool::acquire(unsigned int numVerts)
+{
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        FreeMap::iterator found = mFreeArrays.find(numVerts*numVerts);
+        if (found != mFreeArrays.end() && !found->second.empty())
+        {
+            VertexArrays arrays = found->second.back();
+            found->second.pop_back();
+            --mNumFreeArrays;
+            return arrays;
+        }
+    }
+
+    VertexArrays arrays;
+    arrays.mPositions = new osg::Vec3Array(numVerts*numVerts);
+    arrays.mNormals = new osg::Vec3Array(numVerts*numVerts);
+    arrays.mColours = new osg::Vec4Array(numVerts*numVerts);
+
+    osg::ref_ptr<osg::VertexBufferObject> vbo (new osg::VertexBufferObject);
+    arrays.mPositions->setVertexBufferObject(vbo);
+    arrays.mNormals->setVertexBufferObject(vbo);
+    arrays.mColours->setVertexBufferObject(vbo);
+    return arrays;
+}
+
+void VertexPool::release(osg::Vec3Array *positions, osg::Vec3Array *normals, osg::Vec4Array *colours)
+{
+    if (!positions || !normals || !colours)
+        return;
+
+    // shallow copies of the chunk are still drawing the arrays
+    if (positions->referenceCount() > 1 || normals->referenceCount() > 1 || colours->referenceCount() > 1)
+        return;
+
+    // deep copies of the arrays don't share the vertex buffer object
+    osg::VertexBufferObject* vbo = positions->getVertexBufferObject();
+    if (!vbo || normals->getVertexBufferObject() != vbo || colours->getVertexBufferObject() != vbo)
+        return;
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+    std::vector<VertexArrays>& freeArrays = mFreeArrays[positions->size()];
+    if (freeArrays.size() >= sMaxFreeArrays)
+        return;
+
+    VertexArrays arrays;
+    arrays.mPositions = positions;
+    arrays.mNormals = normals;
+    arrays.mColours = colours;
+    freeArrays.push_back(arrays);
+    ++mNumFreeArrays;
+}
+
+unsigned int VertexPool::getNumFreeArrays() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+    return mNumFreeArrays;
+}
+
+void VertexPool::clearCache()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+    mFreeArrays.clear();
+    mNumFreeArrays = 0;
+}
+
+void VertexPool::releaseGLObjects(osg::State *state)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+    for (FreeMap::iterator it = mFreeArrays.begin(); it != mFreeArrays.end(); ++it)
+    {
+        for (std::vector<VertexArrays>::iterator arrays = it->second.begin(); arrays != it->second.end(); ++arrays)
+            arrays->mPositions->getVertexBufferObject()->releaseGLObjects(state);
+    }
+}
+
+}
@@ -0,0 +1,62 @@
+#ifndef OPENMW_COMPONENTS_TERRAIN_VERTEXPOOL_H
+#define OPENMW_COMPONENTS_TERRAIN_VERTEXPOOL_H
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+#include <osg/Array>
+
+#include <OpenThreads/Mutex>
+
+#include <map>
+#include <vector>
+
+namespace osg
+{
+    class State;
+}
+
+namespace Terrain
+{
+
+    /// @brief Recycles the vertex arrays of terrain chunks together with their vertex buffer object.
+    /// @par Chunks are created and destroyed all the time while moving around, but only use a handful of different vertex counts.
+    /// Handing the arrays of a destroyed chunk to the next chunk of the same size avoids reallocating the arrays, and lets
+    /// the GL buffer be updated in place instead of being deleted and created again.
+    /// @note Thread safe.
+    class VertexPool : public osg::Referenced
+    {
+    public:
+        VertexPool();
+
+        struct VertexArrays
+        {
+            osg::ref_ptr<osg::Vec3Array> mPositions;
+            osg::ref_ptr<osg::Vec3Array> mNormals;
+            osg::ref_ptr<osg::Vec4Array> mColours;
+        };
+
+        /// Get a set of arrays for a chunk of \a numVerts * \a numVerts vertices, sharing one vertex buffer object.
+        /// @note The contents of recycled arrays are undefined. Call dirty() on the arrays after filling them.
+        VertexArrays acquire(unsigned int numVerts);
+
+        /// Hand the arrays of a destroyed chunk back for reuse. The caller must hold the only other reference to the arrays,
+        /// otherwise they are still in use by a copy of the chunk and are not recycled.
+        void release(osg::Vec3Array* positions, osg::Vec3Array* normals, osg::Vec4Array* colours);
+
+        unsigned int getNumFreeArrays() const;
+
+        void clearCache();
+
+        void releaseGLObjects(osg::State* state);
+
+    private:
+        typedef std::map<unsigned int, std::vector<VertexArrays> > FreeMap;
+        FreeMap mFreeArrays;
+        unsigned int mNumFreeArrays;
+
+        mutable OpenThreads::Mutex mMutex;
+    };
+
+}
+
+#endif
@@ -8,6 +8,7 @@ ViewData::ViewData()
     , mFrameLastUsed(0)
     , mChanged(false)
     , mHasEyePoint(false)
+    , mLodStableDistance(-1.f)
 {
 
 }
@@ -60,6 +61,26 @@ const osg::Vec3f& ViewData::getEyePoint() const
     return mEyePoint;
 }
 
+void ViewData::setLodSelection(const osg::Vec3f &eyePoint, float stableDistance)
+{
+    mLodSelection.resize(mNumEntries);
+    for (unsigned int i=0; i<mNumEntries; ++i)
+        mLodSelection[i] = mEntries[i].mNode;
+    mLodEyePoint = eyePoint;
+    mLodStableDistance = stableDistance;
+}
+
+bool ViewData::hasLodSelection(const osg::Vec3f &eyePoint) const
+{
+    return (eyePoint - mLodEyePoint).length2() < mLodStableDistance * mLodStableDistance && mLodStableDistance > 0.f;
+}
+
+void ViewData::clearLodSelection()
+{
+    mLodSelection.clear();
+    mLodStableDistance = -1.f;
+}
+
 void ViewData::reset(unsigned int frame)
 {
     // clear any unused entries
@@ -80,6 +101,7 @@ void ViewData::clear()
     mNumEntries = 0;
     mFrameLastUsed = 0;
     mChanged = false;
+    clearLodSelection();
 }
 
 bool ViewData::contains(QuadTreeNode *node)
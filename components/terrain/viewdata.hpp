@@ -57,6 +57,17 @@ namespace Terrain
         void setEyePoint(const osg::Vec3f& eye);
         const osg::Vec3f& getEyePoint() const;
 
+        /// Remember the nodes added since the last reset as the LOD selection for the given eye point.
+        /// @param stableDistance How far the eye point can move before the selection might change.
+        void setLodSelection(const osg::Vec3f& eyePoint, float stableDistance);
+
+        /// @return Is the LOD selection made for an earlier eye point still valid for this eye point?
+        bool hasLodSelection(const osg::Vec3f& eyePoint) const;
+
+        const std::vector<QuadTreeNode*>& getLodSelection() const { return mLodSelection; }
+
+        void clearLodSelection();
+
     private:
         std::vector<Entry> mEntries;
         unsigned int mNumEntries;
@@ -65,6 +76,10 @@ namespace Terrain
         osg::ref_ptr<osg::Object> mViewer;
         osg::Vec3f mEyePoint;
         bool mHasEyePoint;
+
+        std::vector<QuadTreeNode*> mLodSelection;
+        osg::Vec3f mLodEyePoint;
+        float mLodStableDistance;
     };
 
     class ViewDataMap : public osg::Referenced
@@ -75,6 +75,16 @@ void World::updateTextureFiltering()
     mTextureManager->updateTextureFiltering();
 }
 
+void World::setBatchLayers(bool batch)
+{
+    mChunkManager->setPackBlendmaps(batch);
+}
+
+void World::setCompositeMapCache(CompositeMapCache *cache)
+{
+    mChunkManager->setCompositeMapCache(cache);
+}
+
 void World::clearAssociatedCaches()
 {
     mChunkManager->clearCache();
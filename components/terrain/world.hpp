@@ -29,6 +29,7 @@ namespace Terrain
     class TextureManager;
     class ChunkManager;
     class CompositeMapRenderer;
+    class CompositeMapCache;
 
     /**
      * @brief A View is a collection of rendering objects that are visible from a given camera/intersection.
@@ -61,6 +62,14 @@ namespace Terrain
         /// @note Thread safe.
         void updateTextureFiltering();
 
+        /// Render up to 5 terrain layers per pass using packed blendmaps, when terrain shaders are in use.
+        /// @note Only affects chunks created after this call.
+        void setBatchLayers(bool batch);
+
+        /// Keep rendered composite maps in the given cache, so that later sessions can load them instead of rendering them again.
+        /// @note Only affects chunks created after this call.
+        void setCompositeMapCache(CompositeMapCache* cache);
+
         float getHeightAt (const osg::Vec3f& worldPos);
 
         /// Clears the cached land and landtexture data.
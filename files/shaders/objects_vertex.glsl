@@ -1,5 +1,12 @@
 #version 120
 
+#if @instancing
+#extension GL_ARB_draw_instanced : require
+
+// affine transforms of the instances, stored as their first three columns
+uniform vec4 instanceTransforms[@instancing * 3];
+#endif
+
 #if @diffuseMap
 varying vec2 diffuseMapUV;
 #endif
@@ -49,12 +56,23 @@ varying vec3 passNormal;
 
 void main(void)
 {
-    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+#if @instancing
+    int instance = gl_InstanceIDARB * 3;
+    vec4 vertex = vec4(dot(instanceTransforms[instance], gl_Vertex), dot(instanceTransforms[instance+1], gl_Vertex),
+                       dot(instanceTransforms[instance+2], gl_Vertex), gl_Vertex.w);
+    vec3 normal = vec3(dot(instanceTransforms[instance].xyz, gl_Normal), dot(instanceTransforms[instance+1].xyz, gl_Normal),
+                       dot(instanceTransforms[instance+2].xyz, gl_Normal));
+#else
+    vec4 vertex = gl_Vertex;
+    vec3 normal = gl_Normal;
+#endif
+
+    gl_Position = gl_ModelViewProjectionMatrix * vertex;
     depth = gl_Position.z;
 
-    vec4 viewPos = (gl_ModelViewMatrix * gl_Vertex);
+    vec4 viewPos = (gl_ModelViewMatrix * vertex);
     gl_ClipVertex = viewPos;
-    vec3 viewNormal = normalize((gl_NormalMatrix * gl_Normal).xyz);
+    vec3 viewNormal = normalize((gl_NormalMatrix * normal).xyz);
 
 #if @envMap
     vec3 viewVec = normalize(viewPos.xyz);
@@ -85,8 +103,13 @@ void main(void)
 
 #if @normalMap
     normalMapUV = (gl_TextureMatrix[@normalMapUV] * gl_MultiTexCoord@normalMapUV).xy;
+#if @instancing
+    passTangent = vec4(dot(instanceTransforms[instance].xyz, gl_MultiTexCoord7.xyz), dot(instanceTransforms[instance+1].xyz, gl_MultiTexCoord7.xyz),
+                       dot(instanceTransforms[instance+2].xyz, gl_MultiTexCoord7.xyz), gl_MultiTexCoord7.w);
+#else
     passTangent = gl_MultiTexCoord7.xyzw;
 #endif
+#endif
 
 #if @specularMap
     specularMapUV = (gl_TextureMatrix[@specularMapUV] * gl_MultiTexCoord@specularMapUV).xy;
@@ -98,5 +121,5 @@ void main(void)
     passColor = gl_Color;
 #endif
     passViewPos = viewPos.xyz;
-    passNormal = gl_Normal.xyz;
+    passNormal = normal;
 }
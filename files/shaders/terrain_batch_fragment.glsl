@@ -0,0 +1,103 @@
+#version 120
+
+varying vec2 uv;
+
+uniform sampler2D diffuseMap0;
+#if @numLayers > 1
+uniform sampler2D diffuseMap1;
+#endif
+#if @numLayers > 2
+uniform sampler2D diffuseMap2;
+#endif
+#if @numLayers > 3
+uniform sampler2D diffuseMap3;
+#endif
+#if @numLayers > 4
+uniform sampler2D diffuseMap4;
+#endif
+
+#define NUM_BLENDED_LAYERS (@numLayers - @baseLayer)
+
+#if NUM_BLENDED_LAYERS > 0
+uniform sampler2D blendMap;
+#endif
+
+varying float depth;
+
+#define PER_PIXEL_LIGHTING @forcePPL
+
+#if !PER_PIXEL_LIGHTING
+varying vec4 lighting;
+#else
+varying vec4 passColor;
+#endif
+varying vec3 passViewPos;
+varying vec3 passNormal;
+
+#include "lighting.glsl"
+
+// Composites one layer over the layers below it, using premultiplied colour.
+void addLayer(inout vec3 color, inout float alpha, vec3 layerColor, float layerAlpha)
+{
+    color = mix(color, layerColor, layerAlpha);
+    alpha += layerAlpha * (1.0 - alpha);
+}
+
+void main()
+{
+    vec2 adjustedUV = (gl_TextureMatrix[0] * vec4(uv, 0.0, 1.0)).xy;
+
+#if NUM_BLENDED_LAYERS > 0
+    vec2 blendMapUV = (gl_TextureMatrix[1] * vec4(uv, 0.0, 1.0)).xy;
+    // Blend values of up to 4 layers are packed into the channels of one blendmap, in layer order
+    vec4 blend = texture2D(blendMap, blendMapUV).@blendMapChannels;
+#endif
+
+    vec3 color = vec3(0.0);
+    float alpha = 0.0;
+
+#if @baseLayer
+    color = texture2D(diffuseMap0, adjustedUV).xyz;
+    alpha = 1.0;
+#if @numLayers > 1
+    addLayer(color, alpha, texture2D(diffuseMap1, adjustedUV).xyz, blend.r);
+#endif
+#if @numLayers > 2
+    addLayer(color, alpha, texture2D(diffuseMap2, adjustedUV).xyz, blend.g);
+#endif
+#if @numLayers > 3
+    addLayer(color, alpha, texture2D(diffuseMap3, adjustedUV).xyz, blend.b);
+#endif
+#if @numLayers > 4
+    addLayer(color, alpha, texture2D(diffuseMap4, adjustedUV).xyz, blend.a);
+#endif
+#else
+    addLayer(color, alpha, texture2D(diffuseMap0, adjustedUV).xyz, blend.r);
+#if @numLayers > 1
+    addLayer(color, alpha, texture2D(diffuseMap1, adjustedUV).xyz, blend.g);
+#endif
+#if @numLayers > 2
+    addLayer(color, alpha, texture2D(diffuseMap2, adjustedUV).xyz, blend.b);
+#endif
+#if @numLayers > 3
+    addLayer(color, alpha, texture2D(diffuseMap3, adjustedUV).xyz, blend.a);
+#endif
+#endif
+
+    // Undo the premultiplication so that blending this pass over the previous ones gives the same result
+    // as rendering each layer in its own pass.
+    gl_FragData[0] = vec4(color / max(alpha, 0.0001), alpha);
+
+    vec3 viewNormal = normalize(gl_NormalMatrix * passNormal);
+
+#if !PER_PIXEL_LIGHTING
+    gl_FragData[0] *= lighting;
+#else
+    gl_FragData[0] *= doLighting(passViewPos, normalize(viewNormal), passColor);
+#endif
+
+    gl_FragData[0].xyz += getSpecular(normalize(viewNormal), normalize(passViewPos), gl_FrontMaterial.shininess, gl_FrontMaterial.specular.xyz);
+
+    float fogValue = clamp((depth - gl_Fog.start) * gl_Fog.scale, 0.0, 1.0);
+    gl_FragData[0].xyz = mix(gl_FragData[0].xyz, gl_Fog.color.xyz, fogValue);
+}
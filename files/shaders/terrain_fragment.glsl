@@ -61,7 +61,7 @@ void main()
 
 #if @blendMap
     vec2 blendMapUV = (gl_TextureMatrix[1] * vec4(uv, 0.0, 1.0)).xy;
-    gl_FragData[0].a *= texture2D(blendMap, blendMapUV).a;
+    gl_FragData[0].a *= texture2D(blendMap, blendMapUV).@blendMapChannel;
 #endif
 
 #if !PER_PIXEL_LIGHTING